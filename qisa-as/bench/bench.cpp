@@ -0,0 +1,638 @@
+/**
+ * Throughput benchmark for the QISA Assembler.
+ *
+ * A synthetic QISA program is generated, with a configurable size and mix of
+ * classic instructions, SMIS/SMIT instructions and quantum bundles, label
+ * density and ratio of forward branches.
+ * This program is assembled, saved, disassembled and formatted a number of
+ * times, using one QISA_Driver. The time taken by each phase is measured
+ * separately; the best time of all runs is reported. The resolution of deferred
+ * labels, which is part of the assembly, is reported as a phase of its own.
+ *
+ * The results are written as JSON: per phase the time, instructions/s and
+ * MB/s, the statistics of the driver (see QISA_Driver::getStats()) and the
+ * peak resident set size of the process.
+ *
+ * Usage: qisa-as-bench [OPTIONS]
+ *        (see usage() for the options)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "qisa_driver.h"
+
+// Parameters of the generated program.
+struct ProgramSpec
+{
+  // Number of instructions.
+  unsigned nrOfInstructions;
+
+  // Relative weights of the kinds of instructions.
+  double classicWeight;
+  double maskWeight;
+  double bundleWeight;
+
+  // Fraction of the classic instructions that is a branch.
+  double branchRatio;
+
+  // Fraction of the instructions that has a label.
+  double labelDensity;
+
+  // Fraction of the branches that jumps forward.
+  double forwardBranchRatio;
+
+  unsigned seed;
+};
+
+// Target-control pairs of the surface-7 topology (see surface7_topology.txt).
+static const int TC_PAIRS[][2] =
+{
+  {2, 0}, {0, 3}, {3, 1}, {1, 4}, {2, 5}, {5, 3}, {3, 6}, {6, 4},
+  {0, 2}, {3, 0}, {1, 3}, {4, 1}, {5, 2}, {3, 5}, {6, 3}, {4, 6}
+};
+static const unsigned NR_OF_TC_PAIRS = sizeof(TC_PAIRS) / sizeof(TC_PAIRS[0]);
+static const unsigned NR_OF_QUBITS = 7;
+
+static const char* const BRANCH_CONDITIONS[] =
+{
+  "ALWAYS", "EQ", "NE", "LT", "LE", "GT", "GE", "LTU", "LEU", "GTU", "GEU"
+};
+
+static const char* const ST_INSTRUCTIONS[] =
+{
+  "CW_01", "CW_02", "CW_03", "MeasZ", "CW_08", "CW_09"
+};
+
+static const char* const TT_INSTRUCTIONS[] =
+{
+  "CNOT", "CZ", "SWAP"
+};
+
+template <typename T, size_t N>
+static const T&
+pick(const T (&array)[N], std::mt19937& rng)
+{
+  return array[rng() % N];
+}
+
+static std::string
+generateClassicInstruction(std::mt19937& rng)
+{
+  std::ostringstream ss;
+
+  const unsigned rd = rng() % 32;
+  const unsigned rs = rng() % 32;
+  const unsigned rt = rng() % 32;
+
+  switch (rng() % 10)
+  {
+    case 0: ss << "LDI r" << rd << ", " << static_cast<int>(rng() % 100000) - 50000; break;
+    case 1: ss << "LDUI r" << rd << ", " << rng() % 32768; break;
+    case 2: ss << "ADD r" << rd << ", r" << rs << ", r" << rt; break;
+    case 3: ss << "SUB r" << rd << ", r" << rs << ", r" << rt; break;
+    case 4: ss << "AND r" << rd << ", r" << rs << ", r" << rt; break;
+    case 5: ss << "OR r" << rd << ", r" << rs << ", r" << rt; break;
+    case 6: ss << "XOR r" << rd << ", r" << rs << ", r" << rt; break;
+    case 7: ss << "NOT r" << rd << ", r" << rs; break;
+    case 8: ss << "CMP r" << rs << ", r" << rt; break;
+    default: ss << "QWAIT " << 1 + rng() % 1000; break;
+  }
+
+  return ss.str();
+}
+
+static std::string
+generateMaskInstruction(std::mt19937& rng)
+{
+  std::ostringstream ss;
+
+  if (rng() % 2)
+  {
+    ss << "SMIS s" << rng() % 32 << ", {";
+
+    bool first = true;
+    for (unsigned qubit = 0; qubit < NR_OF_QUBITS; qubit++)
+    {
+      if (rng() % 2)
+      {
+        ss << (first ? "" : ", ") << qubit;
+        first = false;
+      }
+    }
+
+    if (first)
+    {
+      ss << rng() % NR_OF_QUBITS;
+    }
+    ss << "}";
+  }
+  else
+  {
+    // Up to two pairs, that may not share a qubit.
+    const int* pair1 = TC_PAIRS[rng() % NR_OF_TC_PAIRS];
+    const int* pair2 = TC_PAIRS[rng() % NR_OF_TC_PAIRS];
+
+    ss << "SMIT t" << rng() % 64 << ", {(" << pair1[0] << ", " << pair1[1] << ")";
+    if ((pair2[0] != pair1[0]) && (pair2[0] != pair1[1]) &&
+        (pair2[1] != pair1[0]) && (pair2[1] != pair1[1]))
+    {
+      ss << ", (" << pair2[0] << ", " << pair2[1] << ")";
+    }
+    ss << "}";
+  }
+
+  return ss.str();
+}
+
+static std::string
+generateBundle(std::mt19937& rng)
+{
+  std::ostringstream ss;
+
+  ss << "BS " << rng() % 8;
+
+  const unsigned nrOfOperations = 1 + rng() % 3;
+  for (unsigned i = 0; i < nrOfOperations; i++)
+  {
+    ss << ((i == 0) ? " " : " | ");
+
+    switch (rng() % 8)
+    {
+      case 0:
+        ss << "QNOP";
+        break;
+
+      case 1:
+      case 2:
+        ss << pick(TT_INSTRUCTIONS, rng) << " t" << rng() % 64;
+        break;
+
+      default:
+        ss << pick(ST_INSTRUCTIONS, rng) << " s" << rng() % 32;
+        break;
+    }
+  }
+
+  return ss.str();
+}
+
+static std::string
+generateProgram(const ProgramSpec& spec)
+{
+  std::mt19937 rng(spec.seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  const unsigned n = spec.nrOfInstructions;
+
+  // First decide which instructions have a label, such that branches can refer
+  // to labels that are defined further on.
+  std::vector<bool> hasLabel(n);
+  std::vector<unsigned> labelPositions;
+  for (unsigned i = 0; i < n; i++)
+  {
+    hasLabel[i] = (uniform(rng) < spec.labelDensity);
+    if (hasLabel[i])
+    {
+      labelPositions.push_back(i);
+    }
+  }
+
+  const double totalWeight = spec.classicWeight + spec.maskWeight + spec.bundleWeight;
+
+  std::ostringstream ss;
+  size_t nrOfLabelsBefore = 0;
+
+  for (unsigned i = 0; i < n; i++)
+  {
+    if (hasLabel[i])
+    {
+      ss << "label_" << i << ":";
+      nrOfLabelsBefore++;
+    }
+    ss << "    ";
+
+    const double kind = uniform(rng) * totalWeight;
+
+    if (kind < spec.classicWeight)
+    {
+      const size_t nrOfLabelsAfter = labelPositions.size() - nrOfLabelsBefore;
+
+      bool forward = (uniform(rng) < spec.forwardBranchRatio);
+      if (forward && (nrOfLabelsAfter == 0))
+      {
+        forward = false;
+      }
+      else if (!forward && (nrOfLabelsBefore == 0))
+      {
+        forward = true;
+      }
+
+      const bool canBranch = forward ? (nrOfLabelsAfter != 0) : (nrOfLabelsBefore != 0);
+
+      if (canBranch && (uniform(rng) < spec.branchRatio))
+      {
+        const size_t labelIndex = forward ?
+          nrOfLabelsBefore + rng() % nrOfLabelsAfter :
+          rng() % nrOfLabelsBefore;
+
+        ss << "BR " << pick(BRANCH_CONDITIONS, rng) << ", label_" << labelPositions[labelIndex];
+      }
+      else
+      {
+        ss << generateClassicInstruction(rng);
+      }
+    }
+    else if (kind < spec.classicWeight + spec.maskWeight)
+    {
+      ss << generateMaskInstruction(rng);
+    }
+    else
+    {
+      ss << generateBundle(rng);
+    }
+
+    ss << "\n";
+  }
+
+  ss << "    STOP\n";
+
+  return ss.str();
+}
+
+// Returns the peak resident set size of this process, in kilobytes.
+static uint64_t
+getPeakRssKiloBytes()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return counters.PeakWorkingSetSize / 1024;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+#ifdef __APPLE__
+    // On macOS, ru_maxrss is given in bytes.
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+  return 0;
+#endif
+}
+
+// Best time of all runs of one phase, and the amount of data it processed.
+struct PhaseResult
+{
+  PhaseResult(const char* name)
+    : name(name)
+    , seconds(std::numeric_limits<double>::max())
+    , nrOfBytes(0)
+  {}
+
+  void
+  addRun(double runSeconds)
+  {
+    if (runSeconds < seconds)
+    {
+      seconds = runSeconds;
+    }
+  }
+
+  const char* name;
+  double seconds;
+
+  // Number of bytes of input (for the assembler: the source; otherwise the binary
+  // instructions) or output (for getDisassemblyOutput(): the disassembly text).
+  uint64_t nrOfBytes;
+};
+
+class Stopwatch
+{
+public:
+  Stopwatch()
+    : _start(std::chrono::steady_clock::now())
+  {}
+
+  double
+  elapsed() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point _start;
+};
+
+static std::string
+usage(const char* progName)
+{
+  std::ostringstream ss;
+
+  ss << "Usage: " << progName << " [OPTIONS]" << std::endl;
+  ss << "Generates a QISA program, and measures the throughput of the assembler and disassembler on it." << std::endl;
+  ss << std::endl;
+  ss << "Options:" << std::endl;
+  ss << "  -n N                   Number of instructions in the generated program, default = 100000" << std::endl;
+  ss << "  --classic W            Relative weight of classic instructions, default = 4" << std::endl;
+  ss << "  --masks W              Relative weight of SMIS/SMIT instructions, default = 1" << std::endl;
+  ss << "  --bundles W            Relative weight of quantum bundles, default = 3" << std::endl;
+  ss << "  --branches R           Fraction of the classic instructions that is a branch, default = 0.1" << std::endl;
+  ss << "  --label-density R      Fraction of the instructions that has a label, default = 0.05" << std::endl;
+  ss << "  --forward-branches R   Fraction of the branches that jumps forward, default = 0.5" << std::endl;
+  ss << "  --seed N               Seed for the program generator, default = 1" << std::endl;
+  ss << "  --runs N               Number of times each phase is run, default = 5" << std::endl;
+  ss << "  --topology FILE        Quantum layout information to use, default = surface7_topology.txt" << std::endl;
+  ss << "  --work-dir DIR         Directory in which the generated program and the output files are written," << std::endl;
+  ss << "                         default = current directory" << std::endl;
+  ss << "  -o FILE                Write the results to FILE instead of to standard output" << std::endl;
+  ss << "  -h, --help             Show this help message and exit" << std::endl;
+
+  return ss.str();
+}
+
+int
+main(const int argc, const char **argv)
+{
+  ProgramSpec spec;
+  spec.nrOfInstructions = 100000;
+  spec.classicWeight = 4.0;
+  spec.maskWeight = 1.0;
+  spec.bundleWeight = 3.0;
+  spec.branchRatio = 0.1;
+  spec.labelDensity = 0.05;
+  spec.forwardBranchRatio = 0.5;
+  spec.seed = 1;
+
+  unsigned nrOfRuns = 5;
+  std::string topologyFilename = QISA_AS_BENCH_TOPOLOGY_FILE;
+  std::string workDirectory = ".";
+  std::string resultsFilename;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = (i + 1 < argc);
+
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+    {
+      std::cout << usage(argv[0]);
+      return EXIT_SUCCESS;
+    }
+    else if (!strcmp(arg, "-n") && hasValue)
+    {
+      spec.nrOfInstructions = atoi(argv[++i]);
+    }
+    else if (!strcmp(arg, "--classic") && hasValue)
+    {
+      spec.classicWeight = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--masks") && hasValue)
+    {
+      spec.maskWeight = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--bundles") && hasValue)
+    {
+      spec.bundleWeight = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--branches") && hasValue)
+    {
+      spec.branchRatio = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--label-density") && hasValue)
+    {
+      spec.labelDensity = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--forward-branches") && hasValue)
+    {
+      spec.forwardBranchRatio = atof(argv[++i]);
+    }
+    else if (!strcmp(arg, "--seed") && hasValue)
+    {
+      spec.seed = atoi(argv[++i]);
+    }
+    else if (!strcmp(arg, "--runs") && hasValue)
+    {
+      nrOfRuns = atoi(argv[++i]);
+    }
+    else if (!strcmp(arg, "--topology") && hasValue)
+    {
+      topologyFilename = argv[++i];
+    }
+    else if (!strcmp(arg, "--work-dir") && hasValue)
+    {
+      workDirectory = argv[++i];
+    }
+    else if (!strcmp(arg, "-o") && hasValue)
+    {
+      resultsFilename = argv[++i];
+    }
+    else
+    {
+      std::cerr << usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ((nrOfRuns == 0) ||
+      (spec.classicWeight < 0) || (spec.maskWeight < 0) || (spec.bundleWeight < 0) ||
+      (spec.classicWeight + spec.maskWeight + spec.bundleWeight <= 0))
+  {
+    std::cerr << usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Generate the program.
+  const std::string source = generateProgram(spec);
+
+  const std::string sourceFilename = workDirectory + "/qisa_bench.qisa";
+  const std::string binaryFilename = workDirectory + "/qisa_bench.out";
+  {
+    std::ofstream out(sourceFilename, std::ios::binary);
+    out << source;
+    if (!out)
+    {
+      std::cerr << "Cannot write file '" << sourceFilename << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  QISA::QISA_Driver driver;
+  driver.read(topologyFilename);
+
+  PhaseResult assemble("assemble");
+  PhaseResult deferred("processDeferredInstructions");
+  PhaseResult save("save");
+  PhaseResult disassemble("disassemble");
+  PhaseResult disassemblyOutput("getDisassemblyOutput");
+
+  size_t nrOfInstructions = 0;
+
+  for (unsigned run = 0; run < nrOfRuns; run++)
+  {
+    Stopwatch assembleTime;
+    if (!driver.assemble(sourceFilename))
+    {
+      std::cerr << "Assembly of the generated program failed:" << std::endl
+                << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+    assemble.addRun(assembleTime.elapsed());
+
+    nrOfInstructions = driver.getInstructions().size();
+
+    Stopwatch saveTime;
+    if (!driver.save(binaryFilename))
+    {
+      std::cerr << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+    save.addRun(saveTime.elapsed());
+
+    Stopwatch disassembleTime;
+    if (!driver.disassemble(binaryFilename))
+    {
+      std::cerr << "Disassembly of the generated program failed:" << std::endl
+                << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+    disassemble.addRun(disassembleTime.elapsed());
+
+    Stopwatch disassemblyOutputTime;
+    const std::string disassembly = driver.getDisassemblyOutput();
+    disassemblyOutput.addRun(disassemblyOutputTime.elapsed());
+
+    disassemblyOutput.nrOfBytes = disassembly.size();
+  }
+
+  // The resolution of deferred labels runs inside assemble(), so it is timed by the driver,
+  // which needs statistics to be enabled. This is done in separate runs, to keep the overhead
+  // of collecting statistics out of the runs above.
+  driver.enableStats(true);
+
+  for (unsigned run = 0; run < nrOfRuns; run++)
+  {
+    const double deferredTimeBefore = driver.getStats().deferredResolutionTime;
+
+    if (!driver.assemble(sourceFilename))
+    {
+      std::cerr << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    deferred.addRun(driver.getStats().deferredResolutionTime - deferredTimeBefore);
+  }
+
+  const uint64_t binarySize = nrOfInstructions * sizeof(QISA::QISA_Driver::qisa_instruction_type);
+  assemble.nrOfBytes = source.size();
+  deferred.nrOfBytes = source.size();
+  save.nrOfBytes = binarySize;
+  disassemble.nrOfBytes = binarySize;
+
+  const PhaseResult* phases[] = { &assemble, &deferred, &save, &disassemble, &disassemblyOutput };
+
+  // One more run with statistics enabled, to break the time down per phase of the driver.
+  driver.resetStats();
+  if (!driver.assemble(sourceFilename) ||
+      !driver.save(binaryFilename) ||
+      !driver.disassemble(binaryFilename))
+  {
+    std::cerr << driver.getLastErrorMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+  driver.getDisassemblyOutput();
+
+  std::ostringstream json;
+  json << std::setprecision(6);
+  json << "{" << std::endl;
+  json << "  \"version\": \"" << QISA::QISA_Driver::getVersion() << "\"," << std::endl;
+  json << "  \"program\": {" << std::endl;
+  json << "    \"instructions\": " << spec.nrOfInstructions << "," << std::endl;
+  json << "    \"classic_weight\": " << spec.classicWeight << "," << std::endl;
+  json << "    \"mask_weight\": " << spec.maskWeight << "," << std::endl;
+  json << "    \"bundle_weight\": " << spec.bundleWeight << "," << std::endl;
+  json << "    \"branch_ratio\": " << spec.branchRatio << "," << std::endl;
+  json << "    \"label_density\": " << spec.labelDensity << "," << std::endl;
+  json << "    \"forward_branch_ratio\": " << spec.forwardBranchRatio << "," << std::endl;
+  json << "    \"seed\": " << spec.seed << "," << std::endl;
+  json << "    \"source_bytes\": " << source.size() << "," << std::endl;
+  json << "    \"encoded_instructions\": " << nrOfInstructions << std::endl;
+  json << "  }," << std::endl;
+  json << "  \"runs\": " << nrOfRuns << "," << std::endl;
+  json << "  \"phases\": {" << std::endl;
+
+  const size_t nrOfPhases = sizeof(phases) / sizeof(phases[0]);
+  for (size_t i = 0; i < nrOfPhases; i++)
+  {
+    const PhaseResult& phase = *phases[i];
+
+    // Guard against a time of zero, for very small programs.
+    const double seconds = std::max(phase.seconds, 1e-9);
+
+    json << "    \"" << phase.name << "\": {" << std::endl;
+    json << "      \"seconds\": " << phase.seconds << "," << std::endl;
+    json << "      \"instructions_per_second\": " << nrOfInstructions / seconds << "," << std::endl;
+    json << "      \"mb_per_second\": " << phase.nrOfBytes / seconds / 1e6 << std::endl;
+    json << "    }" << ((i + 1 < nrOfPhases) ? "," : "") << std::endl;
+  }
+
+  json << "  }," << std::endl;
+  json << "  \"stats\": {";
+
+  // Separates the name-value pairs of the object.
+  const char* separator = "";
+
+  driver.getStats().visit([&](const char* name, double seconds)
+                          {
+                            json << separator << std::endl << "    \"" << name << "\": " << seconds;
+                            separator = ",";
+                          },
+                          [&](const char* name, uint64_t count)
+                          {
+                            json << separator << std::endl << "    \"" << name << "\": " << count;
+                            separator = ",";
+                          });
+
+  json << std::endl << "  }," << std::endl;
+  json << "  \"peak_rss_kb\": " << getPeakRssKiloBytes() << std::endl;
+  json << "}" << std::endl;
+
+  if (resultsFilename.empty())
+  {
+    std::cout << json.str();
+  }
+  else
+  {
+    std::ofstream out(resultsFilename);
+    out << json.str();
+    if (!out)
+    {
+      std::cerr << "Cannot write file '" << resultsFilename << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -2,22 +2,55 @@
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <cstdio>
 #include <cstring>
+#include <iomanip>
+
+#include <vector>
+#include <string>
 
 #include "qisa_driver.h"
+#include "qisa_work_pool.h"
+#include "qisa_server.h"
+#include "qisa_instruction_set_image.h"
 
 std::string usage(const std::string& progName)
 {
   std::stringstream ss;
   ss << "Usage: " << progName << " [OPTIONS] INPUT_FILE" << std::endl;
+  ss << "   or: " << progName << " [OPTIONS] --jobs N [--manifest MANIFEST_FILE] [INPUT_FILE...]" << std::endl;
+  ss << "   or: " << progName << " [OPTIONS] --serve SOCKET" << std::endl;
+  ss << "   or: " << progName << " [OPTIONS] --connect SOCKET INPUT_FILE" << std::endl;
+  ss << "   or: " << progName << " --compile-qmap QMAP_FILE -o IMAGE_FILE" << std::endl;
   ss << "Assembler/Disassembler for the Quantum Instuction Set Architecture (QISA)." << std::endl;
   ss << std::endl;
   ss << "Options:" << std::endl;
-  ss << "  -q QMAP_FILE      Load quantum instructions from given QMAP_FILE." << std::endl;
+  ss << "  -q QMAP_FILE      Load quantum instructions from given QMAP_FILE (or instruction set image)." << std::endl;
+  ss << "  --compile-qmap QMAP_FILE" << std::endl;
+  ss << "                    Compile QMAP_FILE into an instruction set image, saved to OUTPUT_FILE (-o)" << std::endl;
   ss << "  --dumpspecs       Output the instruction specifications that have been configured into the assembler" << std::endl;
   ss << "  -d[ 1 | 2 ]       Disassemble the given INPUT_FILE" << std::endl;
   ss << "                    Extra integer option suffix specifies the disassembly output format, default = 1" << std::endl;
   ss << "  -o OUTPUT_FILE    Save binary assembled or textual disassembled instructions to the given OUTPUT_FILE" << std::endl;
+  ss << "  --topology FILE   Load the quantum layout information (qubits and edges) from the given FILE" << std::endl;
+  ss << "  --threads N       Disassemble using N threads (0 = one per hardware thread), default = 1" << std::endl;
+  ss << "  --cache DIR       Cache assembly results in directory DIR, to reuse them for identical input" << std::endl;
+  ss << "  -j N, --jobs N    Batch mode: process all input files using N parallel jobs (0 = one per hardware thread)" << std::endl;
+  ss << "  --manifest FILE   Batch mode: also process the input files listed in FILE, one per line" << std::endl;
+  ss << "  --serve SOCKET    Server mode: handle assemble and disassemble requests on Unix domain SOCKET" << std::endl;
+  ss << "  --connect SOCKET  Client mode: let the server listening on SOCKET handle INPUT_FILE" << std::endl;
+  ss << "  --stats[=json]    Show the time spent per phase and other statistics on stderr, as text or JSON" << std::endl;
+  ss << "  --all-errors      Report all errors in the input, instead of stopping at the first one" << std::endl;
+  ss << "  --dedup-masks     Remove SMIS/SMIT instructions that write the mask a register already holds" << std::endl;
+  ss << "  --rename-masks    As --dedup-masks, and also use another register that already holds the mask" << std::endl;
+  ss << "  --pack-vliw       Pack the quantum instructions into as few VLIWs as possible" << std::endl;
+  ss << "  --no-branch-relaxation" << std::endl;
+  ss << "                    Report branches to labels that are out of reach as errors, instead of rewriting them" << std::endl;
+  ss << "  --timeline FILE   Save the quantum timeline (cycles per basic block and per loop, bundle widths" << std::endl;
+  ss << "                    and idle gaps) of the assembled program to FILE, as JSON if FILE ends in '.json'," << std::endl;
+  ss << "                    and as CSV otherwise" << std::endl;
+  ss << "  --chrome-trace FILE" << std::endl;
+  ss << "                    Save the quantum timeline of the assembled program to FILE in the Chrome trace format" << std::endl;
   ss << "  -t                Enable scanner and parser tracing while assembling" << std::endl;
   ss << "  -V, --version     Show the program version and exit" << std::endl;
   ss << "  -v, --verbose     Show informational messages while assembling" << std::endl;
@@ -28,10 +61,466 @@ std::string usage(const std::string& progName)
   ss << "  the file specified in the environment variable QISA_AS_QMAP_FILE." << std::endl;
   ss << "  If -q is not given and QISA_AS_QMAP_FILE is not defined, the factory default quantum instruction" << std::endl;
   ss << "  set will be used instead." << std::endl;
+  ss << "  In batch mode, the output of each input file is saved next to it, using extension '.out'" << std::endl;
+  ss << "  when assembling and '.dis' when disassembling. Option -o cannot be used in batch mode." << std::endl;
+  ss << "  In batch mode, the statistics (--stats) are those of all input files together." << std::endl;
+  ss << "  In server mode, the quantum instructions and topology are loaded once, and used for all requests." << std::endl;
+  ss << "  In client mode, those of the server are used: options -q, --topology, --all-errors," << std::endl;
+  ss << "  --dedup-masks, --rename-masks, --pack-vliw and --no-branch-relaxation are ignored." << std::endl;
+  ss << "  Options --timeline and --chrome-trace can only be used when assembling a single input file." << std::endl;
 
   return ss.str();
 }
 
+// Determine the name of the file in which to save the output of the given input file in batch mode.
+// It is placed next to the input file.
+std::string batchOutputFilename(const std::string& inputFilename, bool doDisassemble)
+{
+  const std::string extension = doDisassemble ? ".dis" : ".out";
+
+  // Only consider a dot in the last path component as start of the extension.
+  size_t dotPos = inputFilename.find_last_of('.');
+  size_t sepPos = inputFilename.find_last_of("/\\");
+
+  std::string outputFilename;
+  if ((dotPos != std::string::npos) &&
+      ((sepPos == std::string::npos) || (dotPos > sepPos)))
+  {
+    outputFilename = inputFilename.substr(0, dotPos) + extension;
+  }
+  else
+  {
+    outputFilename = inputFilename + extension;
+  }
+
+  // Never overwrite the input file itself.
+  if (outputFilename == inputFilename)
+  {
+    outputFilename = inputFilename + extension;
+  }
+
+  return outputFilename;
+}
+
+// Read the names of the input files from the given manifest file.
+// Empty lines and lines starting with '#' are ignored.
+bool readManifest(const std::string& manifestFilename, std::vector<std::string>& inputFilenames)
+{
+  std::ifstream manifest(manifestFilename);
+
+  if (!manifest.is_open())
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(manifest, line))
+  {
+    // Strip leading and trailing white space (including a carriage return).
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+    {
+      continue;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    line = line.substr(first, last - first + 1);
+
+    if (line[0] == '#')
+    {
+      continue;
+    }
+
+    inputFilenames.push_back(line);
+  }
+
+  return true;
+}
+
+// Print the given statistics to the given stream, as text or as a JSON object.
+void printStats(std::ostream& os, const QISA::QISA_Stats& stats, bool asJson)
+{
+  if (asJson)
+  {
+    // Separates the name-value pairs of the object.
+    const char* separator = "{";
+
+    os << std::fixed << std::setprecision(6);
+    stats.visit([&](const char* name, double seconds)
+                {
+                  os << separator << std::endl << "  \"" << name << "\": " << seconds;
+                  separator = ",";
+                },
+                [&](const char* name, uint64_t count)
+                {
+                  os << separator << std::endl << "  \"" << name << "\": " << count;
+                  separator = ",";
+                });
+    os << std::endl << "}" << std::endl;
+  }
+  else
+  {
+    os << "Statistics:" << std::endl;
+    os << std::fixed << std::setprecision(6);
+    stats.visit([&](const char* name, double seconds)
+                {
+                  os << "  " << std::left << std::setw(30) << name << std::right << seconds << " s" << std::endl;
+                },
+                [&](const char* name, uint64_t count)
+                {
+                  os << "  " << std::left << std::setw(30) << name << std::right << count << std::endl;
+                });
+  }
+}
+
+// Disassemble the given input file straight into the given output file,
+// without keeping the disassembly in memory.
+// Returns the exit status of the program.
+int disassembleToFile(QISA::QISA_Driver& driver,
+                      const std::string& inputFilename,
+                      const std::string& outputFilename)
+{
+  std::ofstream outputStream(outputFilename, std::ios::out);
+
+  if (outputStream.fail())
+  {
+    std::cerr << "Cannot open file '" << outputFilename << "' for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!driver.disassembleTo(inputFilename, outputStream))
+  {
+    std::cerr << driver.getLastErrorMessage() << std::endl;
+    std::cerr << "Disassembly terminated with errors." << std::endl;
+
+    // Do not leave incomplete output behind.
+    outputStream.close();
+    std::remove(outputFilename.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Save the quantum timeline of the assembled program to the given files; a file name may be null.
+// Returns the exit status of the program.
+int saveTimeline(QISA::QISA_Driver& driver,
+                 const char* timelineFilename,
+                 const char* chromeTraceFilename)
+{
+  QISA::QISA_Timeline timeline;
+
+  if (!driver.analyzeTimeline(timeline))
+  {
+    std::cerr << driver.getLastErrorMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (timelineFilename != 0)
+  {
+    std::ofstream outputStream(timelineFilename, std::ios::out);
+
+    if (outputStream.fail())
+    {
+      std::cerr << "Cannot open file '" << timelineFilename << "' for writing" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    const std::string filename = timelineFilename;
+    const std::string jsonExtension = ".json";
+
+    if ((filename.size() >= jsonExtension.size()) &&
+        (filename.compare(filename.size() - jsonExtension.size(), jsonExtension.size(), jsonExtension) == 0))
+    {
+      timeline.writeJson(outputStream);
+    }
+    else
+    {
+      timeline.writeCsv(outputStream);
+    }
+  }
+
+  if (chromeTraceFilename != 0)
+  {
+    std::ofstream outputStream(chromeTraceFilename, std::ios::out);
+
+    if (outputStream.fail())
+    {
+      std::cerr << "Cannot open file '" << chromeTraceFilename << "' for writing" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    timeline.writeChromeTrace(outputStream);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Let the server that listens on the given socket assemble or disassemble the given input file.
+// The output is handled in the same way as when the input file is processed locally.
+// Returns the exit status of the program.
+int runClient(const std::string& progName,
+              const std::string& socketPath,
+              const std::string& inputFilename,
+              const char* outputFilename,
+              bool doDisassemble,
+              int disassemblyFormatId)
+{
+  std::ifstream inputStream(inputFilename, std::ios::in | std::ios::binary);
+  if (!inputStream.is_open())
+  {
+    std::cerr << progName << ": Cannot open file '" << inputFilename << "'" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream input;
+  input << inputStream.rdbuf();
+
+  QISA::QISA_Server::RequestKind kind;
+  if (doDisassemble)
+  {
+    kind = QISA::QISA_Server::REQUEST_DISASSEMBLE;
+  }
+  else if (outputFilename != 0)
+  {
+    kind = QISA::QISA_Server::REQUEST_ASSEMBLE;
+  }
+  else
+  {
+    kind = QISA::QISA_Server::REQUEST_ASSEMBLE_HEX;
+  }
+
+  bool success;
+  std::string output;
+  std::string errorMessage;
+
+  if (!QISA::QISA_Server::sendRequest(socketPath, kind, disassemblyFormatId, input.str(),
+                                      success, output, errorMessage))
+  {
+    std::cerr << progName << ": " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!success)
+  {
+    std::cerr << output << std::endl;
+
+    if (doDisassemble)
+    {
+      std::cerr<< "Disassembly terminated with errors." << std::endl;
+    }
+    else
+    {
+      std::cerr << "Assembly terminated with errors." << std::endl;
+    }
+
+    return EXIT_FAILURE;
+  }
+
+  if (outputFilename == 0)
+  {
+    if (doDisassemble)
+    {
+      std::cout << "Disassembly output:" << std::endl;
+    }
+    else
+    {
+      std::cout << "Generated assembly (hex):" << std::endl;
+    }
+    std::cout << output;
+  }
+  else
+  {
+    std::ofstream outputStream(outputFilename, std::ios::out | std::ios::binary);
+
+    outputStream << output;
+    if (outputStream.fail())
+    {
+      std::cerr << "Saving terminated with errors:" << std::endl;
+      std::cerr << "Cannot write file '" << outputFilename << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Assemble or disassemble all given input files, using nrOfJobs parallel jobs.
+// Each job uses its own driver, configured from the given prototype driver.
+// Returns the exit status of the program.
+int runBatch(const std::string& progName,
+             const QISA::QISA_Driver& prototype,
+             const std::vector<std::string>& inputFilenames,
+             unsigned nrOfJobs,
+             bool doDisassemble,
+             int disassemblyFormatId,
+             bool enableTrace,
+             bool enableVerbose,
+             bool doPrintStats,
+             bool statsAsJson)
+{
+  QISA::QISA_WorkPool pool(nrOfJobs);
+
+  // One driver per worker, such that they can be reused for subsequent files.
+  std::vector<QISA::QISA_Driver> drivers(pool.nrOfThreads());
+  for (auto& driver : drivers)
+  {
+    driver.configureFrom(prototype);
+    driver.setVerbose(enableVerbose);
+    driver.enableScannerTracing(enableTrace);
+    driver.enableParserTracing(enableTrace);
+    driver.setDisassemblyFormat(disassemblyFormatId);
+    driver.enableStats(doPrintStats);
+  }
+
+  // Result per input file.
+  std::vector<bool> succeeded(inputFilenames.size(), false);
+  std::vector<std::string> errorMessages(inputFilenames.size());
+
+  pool.run(inputFilenames.size(), [&](size_t fileIndex, unsigned workerIndex)
+  {
+    QISA::QISA_Driver& driver = drivers[workerIndex];
+    const std::string& inputFilename = inputFilenames[fileIndex];
+
+    bool success = doDisassemble ? driver.disassemble(inputFilename)
+                                 : driver.assemble(inputFilename);
+
+    if (success)
+    {
+      success = driver.save(batchOutputFilename(inputFilename, doDisassemble));
+    }
+
+    succeeded[fileIndex] = success;
+    if (!success)
+    {
+      errorMessages[fileIndex] = driver.getLastErrorMessage();
+    }
+  });
+
+  // Report the results in the order in which the input files were given.
+  size_t nrOfFailures = 0;
+  for (size_t i = 0; i < inputFilenames.size(); i++)
+  {
+    if (succeeded[i])
+    {
+      if (enableVerbose)
+      {
+        std::cout << inputFilenames[i] << ": OK -> "
+                  << batchOutputFilename(inputFilenames[i], doDisassemble) << std::endl;
+      }
+    }
+    else
+    {
+      nrOfFailures++;
+      std::cerr << inputFilenames[i] << ": FAILED" << std::endl;
+      std::cerr << errorMessages[i] << std::endl;
+    }
+  }
+
+  if (enableVerbose || (nrOfFailures != 0))
+  {
+    std::ostream& os = (nrOfFailures != 0) ? std::cerr : std::cout;
+    os << progName << ": " << inputFilenames.size() << " file(s) processed using "
+       << pool.nrOfThreads() << " job(s), " << nrOfFailures << " failed." << std::endl;
+  }
+
+  if (doPrintStats)
+  {
+    QISA::QISA_Stats stats;
+    for (const auto& driver : drivers)
+    {
+      stats.add(driver.getStats());
+    }
+
+    printStats(std::cerr, stats, statsAsJson);
+  }
+
+  return (nrOfFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Assemble or disassemble the given input file, and show or save the output.
+// Returns the exit status of the program.
+int processFile(QISA::QISA_Driver& driver,
+                const char* inputFilename,
+                const char* outputFilename,
+                bool doDisassemble,
+                int disassemblyFormatId,
+                unsigned nrOfDisassemblyThreads)
+{
+  /* Parse the file. */
+  bool success;
+
+  if (doDisassemble)
+  {
+    success = driver.setDisassemblyFormat(disassemblyFormatId);
+    if (success)
+    {
+      if ((outputFilename != 0) && (nrOfDisassemblyThreads == 1))
+      {
+        // The disassembly is only needed in the output file, so stream it there.
+        return disassembleToFile(driver, inputFilename, outputFilename);
+      }
+
+      driver.setDisassemblyThreads(nrOfDisassemblyThreads);
+      success = driver.disassemble(inputFilename);
+    }
+  }
+  else
+  {
+    success = driver.assemble(inputFilename);
+  }
+
+  if (success)
+  {
+    if (outputFilename == 0)
+    {
+      if (doDisassemble)
+      {
+        std::cout << "Disassembly output:" << std::endl;
+        std::cout << driver.getDisassemblyOutput();
+      }
+      else
+      {
+        std::cout << "Generated assembly (hex):" << std::endl;
+
+        std::vector<std::string> hexStrings = driver.getInstructionsAsHexStrings(true);
+        for (auto it = hexStrings.begin(); it != hexStrings.end(); ++it)
+        {
+          std::cout << *it << std::endl;
+        }
+      }
+    }
+    else
+    {
+
+      bool save_result = driver.save(outputFilename);
+
+      if (!save_result)
+      {
+        std::cerr << "Saving terminated with errors:" << std::endl;
+        std::cerr << driver.getLastErrorMessage();
+        return EXIT_FAILURE;
+      }
+    }
+
+    return EXIT_SUCCESS;
+  }
+  else
+  {
+    std::cerr << driver.getLastErrorMessage() << std::endl;
+
+    if (doDisassemble)
+    {
+      std::cerr<< "Disassembly terminated with errors." << std::endl;
+    }
+    else
+    {
+      std::cerr << "Assembly terminated with errors." << std::endl;
+    }
+
+    return EXIT_FAILURE;
+  }
+}
+
 int
 main(const int argc, const char **argv)
 {
@@ -43,6 +532,25 @@ main(const int argc, const char **argv)
   const char* inputFilename = 0;
   const char* outputFilename = 0;
   const char* qmapFilename = 0;
+  const char* topologyFilename = 0;
+  const char* manifestFilename = 0;
+  const char* cacheDirectory = 0;
+  const char* compileQmapFilename = 0;
+  const char* timelineFilename = 0;
+  const char* chromeTraceFilename = 0;
+  std::vector<std::string> inputFilenames;
+  bool doBatch = false;
+  unsigned nrOfJobs = 0;
+  unsigned nrOfDisassemblyThreads = 1;
+  const char* serveSocketPath = 0;
+  const char* connectSocketPath = 0;
+  bool doPrintStats = false;
+  bool doReportAllErrors = false;
+  bool doDedupMasks = false;
+  bool doRenameMasks = false;
+  bool doPackVliw = false;
+  bool doRelaxBranches = true;
+  bool statsAsJson = false;
 
   int disassemblyFormatId = 1;
 
@@ -122,6 +630,101 @@ main(const int argc, const char **argv)
       {
         doDumpSpecs = true;
       }
+      else if (!std::strcmp(arg, "--topology") && (i + 1 < argc))
+      {
+        topologyFilename = argv[++i];
+      }
+      else if ((!std::strcmp(arg, "-j") ||
+                !std::strcmp(arg, "--jobs")) && (i + 1 < argc))
+      {
+        const char* jobsArg = argv[++i];
+        char* endPtr;
+        long jobs = std::strtol(jobsArg, &endPtr, 10);
+
+        if ((*jobsArg == '\0') || (*endPtr != '\0') || (jobs < 0))
+        {
+          std::cerr << progName << ": Invalid number of jobs: '" << jobsArg << "'" << std::endl
+                    << "Try " << progName << " --help for more information." << std::endl;
+          return EXIT_FAILURE;
+        }
+
+        doBatch = true;
+        nrOfJobs = static_cast<unsigned>(jobs);
+      }
+      else if (!std::strcmp(arg, "--threads") && (i + 1 < argc))
+      {
+        const char* threadsArg = argv[++i];
+        char* endPtr;
+        long threads = std::strtol(threadsArg, &endPtr, 10);
+
+        if ((*threadsArg == '\0') || (*endPtr != '\0') || (threads < 0))
+        {
+          std::cerr << progName << ": Invalid number of threads: '" << threadsArg << "'" << std::endl
+                    << "Try " << progName << " --help for more information." << std::endl;
+          return EXIT_FAILURE;
+        }
+
+        nrOfDisassemblyThreads = static_cast<unsigned>(threads);
+      }
+      else if (!std::strcmp(arg, "--manifest") && (i + 1 < argc))
+      {
+        manifestFilename = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--cache") && (i + 1 < argc))
+      {
+        cacheDirectory = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--compile-qmap") && (i + 1 < argc))
+      {
+        compileQmapFilename = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--serve") && (i + 1 < argc))
+      {
+        serveSocketPath = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--connect") && (i + 1 < argc))
+      {
+        connectSocketPath = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--stats"))
+      {
+        doPrintStats = true;
+        statsAsJson = false;
+      }
+      else if (!std::strcmp(arg, "--stats=json"))
+      {
+        doPrintStats = true;
+        statsAsJson = true;
+      }
+      else if (!std::strcmp(arg, "--all-errors"))
+      {
+        doReportAllErrors = true;
+      }
+      else if (!std::strcmp(arg, "--dedup-masks"))
+      {
+        doDedupMasks = true;
+      }
+      else if (!std::strcmp(arg, "--rename-masks"))
+      {
+        doDedupMasks = true;
+        doRenameMasks = true;
+      }
+      else if (!std::strcmp(arg, "--pack-vliw"))
+      {
+        doPackVliw = true;
+      }
+      else if (!std::strcmp(arg, "--no-branch-relaxation"))
+      {
+        doRelaxBranches = false;
+      }
+      else if (!std::strcmp(arg, "--timeline") && (i + 1 < argc))
+      {
+        timelineFilename = argv[++i];
+      }
+      else if (!std::strcmp(arg, "--chrome-trace") && (i + 1 < argc))
+      {
+        chromeTraceFilename = argv[++i];
+      }
       else
       {
         std::cerr << progName << ": Unrecognized option: '" << arg << "'" << std::endl
@@ -132,24 +735,138 @@ main(const int argc, const char **argv)
     else
     {
       // This command line argument is not an option.
-      // Assume that this is the input filename.
-      // Issue an error if an input filename has already been specified.
-      if (inputFilename != 0)
+      // Assume that this is an input filename.
+      // Only in batch mode, more than one input file may be given;
+      // this is checked after all options have been seen.
+      if (inputFilename == 0)
       {
-        std::cerr << progName << ": Too many input files specified" << std::endl
-                  << "Try " << progName << " --help for more information." << std::endl;
-        return EXIT_FAILURE;
+        inputFilename = arg;
       }
 
-      inputFilename = arg;
+      inputFilenames.push_back(arg);
+    }
+  }
+
+  if (manifestFilename != 0)
+  {
+    if (!doBatch)
+    {
+      std::cerr << progName << ": Option --manifest can only be used in batch mode (--jobs)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!readManifest(manifestFilename, inputFilenames))
+    {
+      std::cerr << progName << ": Cannot open manifest file '" << manifestFilename << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ((timelineFilename != 0) || (chromeTraceFilename != 0))
+  {
+    if (doDisassemble || doBatch || (serveSocketPath != 0) || (connectSocketPath != 0) ||
+        (compileQmapFilename != 0))
+    {
+      std::cerr << progName << ": Options --timeline and --chrome-trace can only be used "
+                   "when assembling a single input file" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
     }
   }
 
+  if ((serveSocketPath != 0) || (connectSocketPath != 0))
+  {
+    if ((serveSocketPath != 0) && (connectSocketPath != 0))
+    {
+      std::cerr << progName << ": Options --serve and --connect cannot be combined" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (doBatch)
+    {
+      std::cerr << progName << ": Options --serve and --connect cannot be used in batch mode (--jobs)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (doPrintStats)
+    {
+      std::cerr << progName << ": Option --stats cannot be used in server or client mode (--serve, --connect)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if ((connectSocketPath != 0) && doDumpSpecs)
+    {
+      std::cerr << progName << ": Option --dumpspecs cannot be used in client mode (--connect)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (serveSocketPath != 0)
+  {
+    if (!inputFilenames.empty() || (outputFilename != 0))
+    {
+      std::cerr << progName << ": No input or output file can be given in server mode (--serve)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else if (doBatch)
+  {
+    if (outputFilename != 0)
+    {
+      std::cerr << progName << ": Option -o cannot be used in batch mode (--jobs)" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (inputFilenames.empty() && !doDumpSpecs)
+    {
+      std::cerr << progName << ": No input files specified?" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The input files are checked one by one while processing them.
+    inputFilename = 0;
+  }
+  else if (inputFilenames.size() > 1)
+  {
+    std::cerr << progName << ": Too many input files specified" << std::endl
+              << "Try " << progName << " --help for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (compileQmapFilename != 0)
+  {
+    if ((outputFilename == 0) || !inputFilenames.empty())
+    {
+      std::cerr << progName << ": Option --compile-qmap requires an output file (-o) and no input files" << std::endl
+                << "Try " << progName << " --help for more information." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The QMAP file is validated while loading it, so the image only contains valid instructions.
+    QISA::QISA_Driver driver;
+
+    if (!driver.loadQuantumInstructions(compileQmapFilename) ||
+        !driver.saveQuantumInstructionsImage(outputFilename))
+    {
+      std::cerr << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
 
   if (inputFilename == 0)
   {
     // If doDumpSpecs is specified, it is not necessary to specify an input filename.
-    if (!doDumpSpecs)
+    if (!doDumpSpecs && !doBatch && (serveSocketPath == 0))
     {
       std::cerr << progName << ": No input file specified?" << std::endl
                 << "Try " << progName << " --help for more information." << std::endl;
@@ -169,12 +886,46 @@ main(const int argc, const char **argv)
     }
   }
 
+  if (connectSocketPath != 0)
+  {
+    // The server has already set up its driver, so skip that here.
+    return runClient(progName, connectSocketPath, inputFilename, outputFilename,
+                     doDisassemble, disassemblyFormatId);
+  }
+
   QISA::QISA_Driver driver;
 
-  //driver.read();
+  if (topologyFilename != 0)
+  {
+    // Check if the given topology file can be opened for reading.
+    std::ifstream tstFileStream(topologyFilename);
+    if (tstFileStream.fail())
+    {
+      std::cerr << progName << ": Cannot open topology file '" << topologyFilename << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!driver.read(topologyFilename))
+    {
+      std::cerr << driver.getLastErrorMessage() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   driver.enableScannerTracing(enableTrace);
   driver.enableParserTracing(enableTrace);
   driver.setVerbose(enableVerbose);
+  driver.enableStats(doPrintStats);
+  driver.setErrorRecovery(doReportAllErrors);
+  driver.setMaskDeduplication(doDedupMasks);
+  driver.setMaskRegisterRenaming(doRenameMasks);
+  driver.setVliwPacking(doPackVliw);
+  driver.setBranchRelaxation(doRelaxBranches);
+
+  if (cacheDirectory != 0)
+  {
+    driver.setAssemblyCacheDirectory(cacheDirectory);
+  }
 
   if (!doLoadQmap)
   {
@@ -207,7 +958,10 @@ main(const int argc, const char **argv)
   if (doLoadQmap)
   {
 
-    bool success = driver.loadQuantumInstructions(qmapFilename);
+    // Instruction set images are recognized by their contents.
+    bool success = QISA::QISA_InstructionSetImage::isImage(qmapFilename)
+                   ? driver.loadQuantumInstructionsImage(qmapFilename)
+                   : driver.loadQuantumInstructions(qmapFilename);
 
     if (!success)
     {
@@ -223,71 +977,43 @@ main(const int argc, const char **argv)
     return EXIT_SUCCESS;
   }
 
-  /* Parse the file. */
-  bool success;
-
-  if (doDisassemble)
+  if (serveSocketPath != 0)
   {
-    success = driver.setDisassemblyFormat(disassemblyFormatId);
-    if (success)
-    {
-      success = driver.disassemble(inputFilename);
-    }
-  }
-  else
-  {
-    success = driver.assemble(inputFilename);
-  }
-
-  if (success)
-  {
-    if (outputFilename == 0)
-    {
-      if (doDisassemble)
-      {
-        std::cout << "Disassembly output:" << std::endl;
-        std::cout << driver.getDisassemblyOutput();
-      }
-      else
-      {
-        std::cout << "Generated assembly (hex):" << std::endl;
+    // The driver that has been configured above serves as prototype
+    // for the drivers that handle the requests.
+    QISA::QISA_Server server(driver);
+    server.setVerbose(enableVerbose);
 
-        std::vector<std::string> hexStrings = driver.getInstructionsAsHexStrings(true);
-        for (auto it = hexStrings.begin(); it != hexStrings.end(); ++it)
-        {
-          std::cout << *it << std::endl;
-        }
-      }
-    }
-    else
+    if (!server.serve(serveSocketPath))
     {
-
-      bool save_result = driver.save(outputFilename);
-
-      if (!save_result)
-      {
-        std::cerr << "Saving terminated with errors:" << std::endl;
-        std::cerr << driver.getLastErrorMessage();
-        return EXIT_FAILURE;
-      }
+      std::cerr << progName << ": " << server.getErrorMessage() << std::endl;
+      return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
   }
-  else
+
+  if (doBatch)
   {
-    std::cerr << driver.getLastErrorMessage() << std::endl;
+    // The driver that has been configured above serves as prototype
+    // for the drivers that are used by the parallel jobs.
+    return runBatch(progName, driver, inputFilenames, nrOfJobs,
+                    doDisassemble, disassemblyFormatId,
+                    enableTrace, enableVerbose, doPrintStats, statsAsJson);
+  }
 
-    if (doDisassemble)
-    {
-      std::cerr<< "Disassembly terminated with errors." << std::endl;
-    }
-    else
-    {
-      std::cerr << "Assembly terminated with errors." << std::endl;
-    }
+  int exitStatus = processFile(driver, inputFilename, outputFilename,
+                               doDisassemble, disassemblyFormatId, nrOfDisassemblyThreads);
 
-    return EXIT_FAILURE;
+  if ((exitStatus == EXIT_SUCCESS) && ((timelineFilename != 0) || (chromeTraceFilename != 0)))
+  {
+    exitStatus = saveTimeline(driver, timelineFilename, chromeTraceFilename);
+  }
+
+  if (doPrintStats)
+  {
+    printStats(std::cerr, driver.getStats(), statsAsJson);
   }
 
+  return exitStatus;
 }
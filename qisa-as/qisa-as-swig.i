@@ -7,8 +7,142 @@
 %module pyQisaAs
 %{
 #include "qisa_driver.h"
+
+// Releases the GIL for the lifetime of this object, such that other Python
+// threads can run while the given driver is busy. Meanwhile, the use mutex
+// of the driver is held, so that a driver that is shared by several Python
+// threads is used by one of them at a time.
+// The GIL is released before locking the mutex, to avoid a deadlock with a
+// thread that holds the mutex and waits for the GIL.
+class QISA_ReleaseGIL
+{
+public:
+
+  explicit QISA_ReleaseGIL(QISA::QISA_Driver* driver)
+    : _threadState(PyEval_SaveThread())
+    , _lock(driver->getUseMutex())
+  {
+  }
+
+  ~QISA_ReleaseGIL()
+  {
+    _lock.unlock();
+    PyEval_RestoreThread(_threadState);
+  }
+
+private:
+
+  PyThreadState* _threadState;
+  std::unique_lock<std::mutex> _lock;
+};
+
+typedef std::shared_ptr<const std::vector<QISA::QISA_Driver::qisa_instruction_type>> QISA_SharedInstructions;
+
+// Python object that exports instructions shared by a driver (see
+// QISA_Driver::shareInstructions()) through the buffer protocol.
+// Each view of its buffer holds a reference to it, and so keeps the
+// instructions alive, whatever happens to the driver meanwhile.
+struct QISA_InstructionsExporter
+{
+  PyObject_HEAD
+  QISA_SharedInstructions* owner;
+  char* data;
+  Py_ssize_t size;
+};
+
+static int
+QISA_InstructionsExporter_getBuffer(PyObject* self, Py_buffer* view, int flags)
+{
+  QISA_InstructionsExporter* exporter = reinterpret_cast<QISA_InstructionsExporter*>(self);
+
+  // Sets view->obj to a new reference to the exporter.
+  return PyBuffer_FillInfo(view, self, exporter->data, exporter->size, 1 /* read-only */, flags);
+}
+
+static void
+QISA_InstructionsExporter_dealloc(PyObject* self)
+{
+  delete reinterpret_cast<QISA_InstructionsExporter*>(self)->owner;
+  Py_TYPE(self)->tp_free(self);
+}
+
+// @return The type of QISA_InstructionsExporter, or NULL (with a Python exception set)
+//         if it cannot be initialized.
+static PyTypeObject*
+QISA_InstructionsExporter_type()
+{
+  static PyBufferProcs bufferProcs = { QISA_InstructionsExporter_getBuffer, NULL };
+  static PyTypeObject type = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+  if (type.tp_name == NULL)
+  {
+    type.tp_name = "pyQisaAs.InstructionsExporter";
+    type.tp_doc = "Owner of instructions exported by QISA_Driver.getInstructionsBuffer().";
+    type.tp_basicsize = sizeof(QISA_InstructionsExporter);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_dealloc = QISA_InstructionsExporter_dealloc;
+    type.tp_as_buffer = &bufferProcs;
+
+    if (PyType_Ready(&type) < 0)
+    {
+      type.tp_name = NULL;
+      return NULL;
+    }
+  }
+
+  return &type;
+}
 %}
 
+// Calls of the given driver method do not hold the GIL (see QISA_ReleaseGIL).
+// Note that the arguments and the result are converted while holding the GIL.
+%define QISA_RELEASE_GIL(method)
+%exception QISA::QISA_Driver::method
+{
+  QISA_ReleaseGIL releaseGIL(arg1);
+  $action
+}
+%enddef
+
+QISA_RELEASE_GIL(read)
+QISA_RELEASE_GIL(enableScannerTracing)
+QISA_RELEASE_GIL(enableParserTracing)
+QISA_RELEASE_GIL(assemble)
+QISA_RELEASE_GIL(assembleBuffer)
+QISA_RELEASE_GIL(assembleString)
+QISA_RELEASE_GIL(disassemble)
+QISA_RELEASE_GIL(disassembleBuffer)
+QISA_RELEASE_GIL(getLastErrorMessage)
+QISA_RELEASE_GIL(setVerbose)
+QISA_RELEASE_GIL(getInstructionsAsHexStrings)
+QISA_RELEASE_GIL(setDisassemblyFormat)
+QISA_RELEASE_GIL(setDisassemblyThreads)
+QISA_RELEASE_GIL(setAssemblyCacheDirectory)
+QISA_RELEASE_GIL(enableStats)
+QISA_RELEASE_GIL(getStats)
+QISA_RELEASE_GIL(resetStats)
+QISA_RELEASE_GIL(setErrorRecovery)
+QISA_RELEASE_GIL(getErrorRecovery)
+QISA_RELEASE_GIL(getDiagnostics)
+QISA_RELEASE_GIL(setMaskDeduplication)
+QISA_RELEASE_GIL(getMaskDeduplication)
+QISA_RELEASE_GIL(setMaskRegisterRenaming)
+QISA_RELEASE_GIL(getMaskRegisterRenaming)
+QISA_RELEASE_GIL(getNrOfRemovedMaskWords)
+QISA_RELEASE_GIL(setVliwPacking)
+QISA_RELEASE_GIL(getVliwPacking)
+QISA_RELEASE_GIL(getTimelineOutput)
+QISA_RELEASE_GIL(setBranchRelaxation)
+QISA_RELEASE_GIL(getBranchRelaxation)
+QISA_RELEASE_GIL(getNrOfRelaxedBranches)
+QISA_RELEASE_GIL(getDisassemblyOutput)
+QISA_RELEASE_GIL(save)
+QISA_RELEASE_GIL(dumpInstructionsSpecification)
+QISA_RELEASE_GIL(reset)
+QISA_RELEASE_GIL(loadQuantumInstructions)
+QISA_RELEASE_GIL(loadQuantumInstructionsImage)
+QISA_RELEASE_GIL(saveQuantumInstructionsImage)
+
 %include std_string.i
 using std::string;
 
@@ -22,9 +156,109 @@ namespace std {
    %template(qisa_qmap) map<string, int>;
 };
 
+// Accept a str or any object that supports the buffer protocol
+// (bytes, bytearray, memoryview, ...) as in-memory source code.
+%typemap(in) (const char* buffer, size_t size) (Py_buffer view)
+{
+  view.obj = NULL;
+  if (PyUnicode_Check($input))
+  {
+    Py_ssize_t len;
+    const char* str = PyUnicode_AsUTF8AndSize($input, &len);
+    if (str == NULL)
+    {
+      SWIG_fail;
+    }
+    $1 = str;
+    $2 = (size_t)len;
+  }
+  else
+  {
+    if (PyObject_GetBuffer($input, &view, PyBUF_SIMPLE) != 0)
+    {
+      SWIG_fail;
+    }
+    $1 = (const char*)view.buf;
+    $2 = (size_t)view.len;
+  }
+}
+
+%typemap(freearg) (const char* buffer, size_t size)
+{
+  if (view$argnum.obj != NULL)
+  {
+    PyBuffer_Release(&view$argnum);
+  }
+}
+
+// Return the statistics of a driver as a dict, which maps the names of the
+// phase times (in seconds) and counters to their values.
+%typemap(out) const QISA::QISA_Stats&
+{
+  $result = PyDict_New();
+  if ($result == NULL)
+  {
+    SWIG_fail;
+  }
+
+  PyObject* dict = $result;
+  bool ok = true;
+
+  auto setItem = [&](const char* name, PyObject* value)
+  {
+    ok = ok && (value != NULL) && (PyDict_SetItemString(dict, name, value) == 0);
+    Py_XDECREF(value);
+  };
+
+  $1->visit([&](const char* name, double seconds) { setItem(name, PyFloat_FromDouble(seconds)); },
+            [&](const char* name, uint64_t count) { setItem(name, PyLong_FromUnsignedLongLong(count)); });
+
+  if (!ok)
+  {
+    Py_DECREF($result);
+    $result = NULL;
+    SWIG_fail;
+  }
+}
+
+// Return the errors found by the last assembly as a list of dicts, one per
+// error, with the location of the error and its message.
+%typemap(out) const std::vector<QISA::QISA_Driver::Diagnostic>&
+{
+  $result = PyList_New($1->size());
+  if ($result == NULL)
+  {
+    SWIG_fail;
+  }
+
+  for (size_t i = 0; i < $1->size(); i++)
+  {
+    const QISA::QISA_Driver::Diagnostic& diagnostic = (*$1)[i];
+
+    PyObject* item = Py_BuildValue("{s:I,s:I,s:I,s:I,s:N}",
+                                   "line", diagnostic.line,
+                                   "column", diagnostic.column,
+                                   "end_line", diagnostic.endLine,
+                                   "end_column", diagnostic.endColumn,
+                                   "message", PyUnicode_DecodeUTF8(diagnostic.message.data(),
+                                                                   diagnostic.message.size(),
+                                                                   "replace"));
+    if (item == NULL)
+    {
+      Py_DECREF($result);
+      $result = NULL;
+      SWIG_fail;
+    }
+
+    PyList_SET_ITEM($result, i, item);
+  }
+}
+
 namespace QISA
 {
 
+struct QISA_Stats;
+
 class QISA_Driver
 {
 public:
@@ -35,8 +269,22 @@ public:
   %feature("autodoc");
   virtual ~QISA_Driver();
 
-  %feature("autodoc");
-  void read(std::string input_filename);
+  %feature("autodoc", "
+Read the quantum layout information (topology) from the given file:
+the number of qubits and the directed edges between them.
+
+Parameters
+----------
+input_filename: str  -- File that contains the quantum layout information.
+
+Returns
+-------
+--> bool: True on success, False if the file cannot be read, is not valid, or
+          describes a topology that does not fit in the encoding of the SMIS and
+          SMIT instructions. In that case, the current topology is kept, and
+          getLastErrorMessage() describes the problem.
+");
+  bool read(const std::string& input_filename);
 
   %feature("autodoc", "
 Return a string that represents the version of the assembler.
@@ -80,6 +328,41 @@ On error, you can use getLastErrorMessage() to get a description of that error.
 ");
   bool assemble(const std::string& filename);
 
+  %feature("autodoc", "
+Assemble QISA assembly source code that resides in memory.
+This avoids having to write the source code to a file first.
+
+Parameters
+----------
+buffer: bytes or str  -- QISA assembly source code.
+
+Returns
+-------
+--> bool: True on success, false on failure.
+
+Note
+----
+On error, you can use getLastErrorMessage() to get a description of that error.
+");
+  bool assembleBuffer(const char* buffer, size_t size);
+
+  %feature("autodoc", "
+Assemble QISA assembly source code that is given as a string.
+
+Parameters
+----------
+source: str  -- QISA assembly source code.
+
+Returns
+-------
+--> bool: True on success, false on failure.
+
+Note
+----
+On error, you can use getLastErrorMessage() to get a description of that error.
+");
+  bool assembleString(const std::string& source);
+
 %feature("autodoc", "
 Disassemble the given file.
 
@@ -93,6 +376,22 @@ Returns
 ");
   bool disassemble(const std::string& filename);
 
+%feature("autodoc", "
+Disassemble QISA instructions in binary form that reside in memory.
+This is the inverse of getInstructionsBuffer(): no file is needed.
+
+Parameters
+----------
+buffer: bytes  -- QISA instructions, in the same form as saved by save(),
+                  or any other object that supports the buffer protocol,
+                  such as the result of getInstructionsBuffer() of another driver.
+
+Returns
+-------
+--> bool: True on success, false on failure.
+");
+  bool disassembleBuffer(const char* buffer, size_t size);
+
   %feature("autodoc", "
 Returns
 -------
@@ -151,6 +450,222 @@ Returns
 ");
   bool setDisassemblyFormat(int format_id);
 
+%feature("autodoc", "
+Set the number of threads to use while disassembling.
+Large inputs are split into chunks that are disassembled in parallel.
+The disassembly output is the same as when disassembling serially.
+
+Parameters
+----------
+nrOfThreads: int Number of threads to use.
+             1 (the default) disassembles serially,
+             0 uses one thread per hardware thread.
+");
+  void setDisassemblyThreads(unsigned nrOfThreads);
+
+%feature("autodoc", "
+Enable or disable the assembly cache.
+
+When enabled, the result of each successful assembly is stored in the given
+directory, keyed on a hash of the source code, the configured instruction set,
+the quantum layout information and the assembler version.
+Assembling the same source code with the same configuration again takes the
+result from the cache, without scanning and parsing the source code.
+A cache file is only used if the source code and configuration stored in it
+are equal to the current ones.
+
+Parameters
+----------
+directory: str  Existing directory in which to store the assembly results.
+                An empty string (the default) disables the assembly cache.
+");
+  void setAssemblyCacheDirectory(const std::string& directory);
+
+%feature("autodoc", "
+Enable or disable the collection of statistics (see getStats()).
+Collecting statistics is disabled by default; when disabled, it costs nothing.
+
+Parameters
+----------
+enabled: bool  -- True to enable the collection of statistics, False to disable it.
+");
+  void enableStats(bool enabled);
+
+%feature("autodoc", "
+Retrieve the statistics that have been collected since they were enabled or last cleared.
+These accumulate over all assemblies and disassemblies.
+
+Returns
+-------
+--> dict: The time (in seconds, float) spent per phase:
+          'scan_parse_time', 'code_generation_time', 'deferred_resolution_time',
+          'mask_deduplication_time', 'branch_relaxation_time', 'disassembly_decode_time',
+          'disassembly_post_process_time' and 'output_format_time',
+          and the counters (int):
+          'tokens', 'instructions', 'bundles', 'vliw_words', 'deferred_labels',
+          'removed_mask_words', 'relaxed_branches' and 'map_lookups'.
+");
+  const QISA_Stats& getStats() const;
+
+%feature("autodoc", "
+Clear the statistics collected so far.
+");
+  void resetStats();
+
+%feature("autodoc", "
+Enable or disable error recovery while assembling.
+Without error recovery, which is the default, assembly stops at the first error.
+With error recovery, the rest of a line that contains an error is skipped and
+assembly continues on the next line, such that all errors are found in one pass.
+The assembly still fails if any error has been found.
+
+Parameters
+----------
+enabled: bool  -- True to enable error recovery, False to disable it.
+");
+  void setErrorRecovery(bool enabled);
+
+%feature("autodoc", "
+Returns
+-------
+--> bool: True if error recovery is enabled.
+");
+  bool getErrorRecovery() const;
+
+%feature("autodoc", "
+Retrieve the errors found by the last assembly, in the order in which they have been found.
+Without error recovery, there is at most one.
+
+Returns
+-------
+--> list: One dict per error, with its location in the source code:
+          'line', 'column', 'end_line' and 'end_column' (int; a line of 0 means
+          that the error has no specific location), and its 'message' (str).
+");
+  const std::vector<QISA::QISA_Driver::Diagnostic>& getDiagnostics() const;
+
+%feature("autodoc", "
+Enable or disable the removal of redundant SMIS and SMIT instructions after assembly.
+Within straight-line code, the mask that each S and T register holds is tracked.
+An SMIS or SMIT instruction word that writes the mask that its register already holds
+is removed, and the branch offsets are adjusted accordingly.
+At branch targets, the contents of the registers are considered unknown.
+This is disabled by default.
+
+Parameters
+----------
+enabled: bool  -- True to remove redundant mask writes, False to keep them.
+");
+  void setMaskDeduplication(bool enabled);
+
+%feature("autodoc", "
+Returns
+-------
+--> bool: True if redundant mask writes are removed.
+");
+  bool getMaskDeduplication() const;
+
+%feature("autodoc", "
+Enable or disable renaming of mask registers, in addition to mask deduplication.
+If an SMIS or SMIT instruction writes a mask that another register of the same kind
+already holds, the instruction is removed and the quantum instructions that use its
+register use the other register instead. This is only done within straight-line code.
+It has no effect unless mask deduplication is enabled. This is disabled by default.
+
+Parameters
+----------
+enabled: bool  -- True to rename mask registers, False to leave them.
+");
+  void setMaskRegisterRenaming(bool enabled);
+
+%feature("autodoc", "
+Returns
+-------
+--> bool: True if mask registers are renamed.
+");
+  bool getMaskRegisterRenaming() const;
+
+%feature("autodoc", "
+Returns
+-------
+--> int: The number of SMIS and SMIT instruction words that have been removed
+         from the result of the last assembly by mask deduplication.
+");
+  size_t getNrOfRemovedMaskWords() const;
+
+%feature("autodoc", "
+Enable or disable packing of quantum instructions into as few VLIWs as possible.
+Without packing, which is the default, the quantum instructions of each bundle
+are put pair-wise in VLIWs, in source order. With packing, QNOPs are left out
+of bundles, and a bundle without wait time (bs 0) fills the free slots of the
+VLIW before it. This is not done for a bundle that is referred to by a label.
+
+Parameters
+----------
+enabled: bool  -- True to pack the quantum instructions, False to put them pair-wise.
+");
+  void setVliwPacking(bool enabled);
+
+%feature("autodoc", "
+Returns
+-------
+--> bool: True if the quantum instructions are packed.
+");
+  bool getVliwPacking() const;
+
+%feature("autodoc", "
+Enable or disable relaxation of branches whose target is out of reach.
+The offset of a branch instruction is limited to +/-(2^20-1) instructions.
+With relaxation, which is the default, a branch to a label beyond that range
+is rewritten into a branch with the inverted condition over an unconditional
+branch, which reaches the label through a chain of unconditional branches.
+These are placed in islands, each of which starts with a branch over the island.
+An island is never placed between the VLIWs of a quantum bundle.
+Without relaxation, such a branch is an error.
+
+Parameters
+----------
+enabled: bool  -- True to rewrite branches that are out of reach, False to report them as errors.
+");
+  void setBranchRelaxation(bool enabled);
+
+%feature("autodoc", "
+Returns
+-------
+--> bool: True if branches that are out of reach are rewritten.
+");
+  bool getBranchRelaxation() const;
+
+%feature("autodoc", "
+Returns
+-------
+--> int: The number of branch instructions that have been rewritten by the last assembly,
+         because their target was out of reach.
+");
+  size_t getNrOfRelaxedBranches() const;
+
+%feature("autodoc", "
+Determine the static quantum timeline of the result of the last assembly.
+Time advances by the bundle separators and by the QWAIT immediates; QWAITR
+is counted as a dynamic wait. Every instruction is passed once, without
+following the branches. The timing is given for the program, for each basic
+block, and for one pass through each loop body (from a branch target up to and
+including the branch back to it): the number of cycles, bundles and operations,
+the maximum bundle width, the number of cycles at which no operation starts
+(idle cycles) and the longest run of those.
+
+Parameters
+----------
+format: str  -- 'csv' or 'json' for the timing of the program, its basic blocks and its loops,
+                or 'chrome' for the basic blocks and operations in the Chrome trace event format
+                (one cycle is shown as one microsecond).
+
+Returns
+-------
+--> str: The timeline, or an empty string on failure.
+");
+  std::string getTimelineOutput(const std::string& format);
+
 %feature("autodoc", "
 Retrieve the disassembly output as a multi-line string.
 
@@ -236,7 +751,220 @@ On error, you can use getLastErrorMessage() to get a description of that error.
                          const std::map<std::string, int>& arg_st_map,
                          const std::map<std::string, int>& arg_tt_map);
 
+  %feature("autodoc", "
+Load quantum instruction specifications from the given instruction set image.
+Such an image is written by saveQuantumInstructionsImage() or by the
+'--compile-qmap' command line option. It contains validated instructions and
+is memory mapped, so this is much faster than loading a QMAP file.
+
+Parameters
+----------
+imageFilename: str Instruction set image file.
+
+Returns
+-------
+--> bool: True on success, False if the file is not a valid image.
+
+Note
+----
+On error, you can use getLastErrorMessage() to get a description of that error.
+");
+  bool loadQuantumInstructionsImage(const std::string& imageFilename);
+
+  %feature("autodoc", "
+Save the currently loaded quantum instructions as an instruction set image.
+
+Parameters
+----------
+imageFilename: str Name of the image file to write.
+
+Returns
+-------
+--> bool: True on success, False on failure.
+");
+  bool saveQuantumInstructionsImage(const std::string& imageFilename);
+
 
 };
 
 }
+
+%extend QISA::QISA_Driver
+{
+  %feature("autodoc", "
+Assemble a number of programs in parallel, using native threads.
+Each thread uses its own driver, configured like this one: the quantum
+instructions and the quantum layout information of this driver are used.
+This driver itself is not changed. The GIL is not held while assembling.
+
+Parameters
+----------
+sources: list  -- QISA assembly source code (str or bytes), one program per element.
+nrOfThreads: int  -- Number of threads to use; 0 (the default) uses one thread
+                     per hardware thread.
+
+Returns
+-------
+--> list of tuple: The outcome per program, in the same order as the sources:
+                   (success: bool, instructions: bytes, errorMessage: str).
+                   The instructions are in the same form as saved by save(),
+                   e.g. for numpy.frombuffer(instructions, dtype=numpy.uint32).
+");
+  PyObject* assembleMany(PyObject* sources, unsigned nrOfThreads = 0)
+  {
+    PyObject* sequence = PySequence_Fast(sources, "assembleMany() expects a list of sources");
+    if (sequence == NULL)
+    {
+      return NULL;
+    }
+
+    // The sources are copied, because they are used while the GIL is not held.
+    const Py_ssize_t nrOfSources = PySequence_Fast_GET_SIZE(sequence);
+    std::vector<std::string> sourceStrings(nrOfSources);
+
+    for (Py_ssize_t i = 0; i < nrOfSources; i++)
+    {
+      PyObject* source = PySequence_Fast_GET_ITEM(sequence, i);
+
+      if (PyUnicode_Check(source))
+      {
+        Py_ssize_t length;
+        const char* data = PyUnicode_AsUTF8AndSize(source, &length);
+        if (data == NULL)
+        {
+          Py_DECREF(sequence);
+          return NULL;
+        }
+        sourceStrings[i].assign(data, length);
+      }
+      else
+      {
+        Py_buffer view;
+        if (PyObject_GetBuffer(source, &view, PyBUF_SIMPLE) != 0)
+        {
+          Py_DECREF(sequence);
+          return NULL;
+        }
+        sourceStrings[i].assign(static_cast<const char*>(view.buf), view.len);
+        PyBuffer_Release(&view);
+      }
+    }
+
+    Py_DECREF(sequence);
+
+    std::vector<QISA::QISA_Driver::AssemblyResult> results;
+    {
+      QISA_ReleaseGIL releaseGIL($self);
+      results = $self->assembleMany(sourceStrings, nrOfThreads);
+    }
+
+    PyObject* resultList = PyList_New(nrOfSources);
+    if (resultList == NULL)
+    {
+      return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < nrOfSources; i++)
+    {
+      const QISA::QISA_Driver::AssemblyResult& result = results[i];
+
+      PyObject* resultTuple = PyTuple_New(3);
+      if (resultTuple == NULL)
+      {
+        Py_DECREF(resultList);
+        return NULL;
+      }
+      PyList_SET_ITEM(resultList, i, resultTuple);
+
+      PyObject* success = PyBool_FromLong(result.success);
+      PyObject* instructions =
+        PyBytes_FromStringAndSize(reinterpret_cast<const char*>(result.instructions.data()),
+                                  result.instructions.size() * sizeof(QISA::QISA_Driver::qisa_instruction_type));
+      PyObject* errorMessage =
+        PyUnicode_DecodeUTF8(result.errorMessage.data(), result.errorMessage.size(), "replace");
+
+      PyTuple_SET_ITEM(resultTuple, 0, success);
+      PyTuple_SET_ITEM(resultTuple, 1, instructions);
+      PyTuple_SET_ITEM(resultTuple, 2, errorMessage);
+
+      if ((instructions == NULL) || (errorMessage == NULL))
+      {
+        Py_DECREF(resultList);
+        return NULL;
+      }
+    }
+
+    return resultList;
+  }
+
+  %feature("autodoc", "
+Retrieve the generated code as a read-only memoryview of unsigned 32-bit
+integers (format 'I'), one per encoded instruction.
+
+The memoryview refers directly to the instructions held by the driver, so no
+copy is made. Use it with e.g. numpy.frombuffer(view, dtype=numpy.uint32),
+or bytes(view) to get the instructions in the same form as saved by save().
+
+Returns
+-------
+--> memoryview: The generated instructions.
+
+Note
+----
+The memoryview (and any object made from it without a copy, such as a numpy
+array) owns the instructions: it remains valid and unchanged when the driver
+assembles or disassembles again, also in another thread, or is deleted.
+");
+  PyObject* getInstructionsBuffer()
+  {
+    static_assert(sizeof(QISA::QISA_Driver::qisa_instruction_type) == sizeof(unsigned int),
+                  "the instructions are exported using format 'I'");
+
+    QISA_SharedInstructions owner;
+    char* data;
+    Py_ssize_t size;
+
+    {
+      QISA_ReleaseGIL releaseGIL($self);
+
+      owner = $self->shareInstructions();
+
+      const std::vector<QISA::QISA_Driver::qisa_instruction_type>& instructions = $self->getInstructions();
+
+      // The memory of an empty vector may not exist, so use a static placeholder.
+      static char empty;
+      data = instructions.empty()
+             ? &empty
+             : const_cast<char*>(reinterpret_cast<const char*>(instructions.data()));
+      size = instructions.size() * sizeof(QISA::QISA_Driver::qisa_instruction_type);
+    }
+
+    PyTypeObject* exporterType = QISA_InstructionsExporter_type();
+    if (exporterType == NULL)
+    {
+      return NULL;
+    }
+
+    QISA_InstructionsExporter* exporter = PyObject_New(QISA_InstructionsExporter, exporterType);
+    if (exporter == NULL)
+    {
+      return NULL;
+    }
+
+    exporter->owner = new QISA_SharedInstructions(owner);
+    exporter->data = data;
+    exporter->size = size;
+
+    PyObject* bytesView = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(exporter));
+    Py_DECREF(exporter);
+    if (bytesView == NULL)
+    {
+      return NULL;
+    }
+
+    // Let the view present the bytes as instructions.
+    PyObject* view = PyObject_CallMethod(bytesView, "cast", "s", "I");
+    Py_DECREF(bytesView);
+    return view;
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace QISA
+{
+
+/**
+ * Region allocator for small objects that live as long as one assembly run.
+ *
+ * Objects are placed one after the other in fixed size chunks. They are never
+ * freed individually: clear() releases all of them at once, after which the
+ * chunks are reused. This avoids a heap allocation (and, compared to
+ * std::shared_ptr, the reference counting) per object.
+ *
+ * Only trivially destructible types are supported, since no destructors are run.
+ */
+template <typename T, size_t CHUNK_SIZE = 256>
+class QISA_Arena
+{
+  static_assert(std::is_trivially_destructible<T>::value,
+                "QISA_Arena does not run destructors");
+
+public:
+
+  QISA_Arena()
+    : _nextChunk(0)
+    , _current(nullptr)
+    , _used(CHUNK_SIZE)
+  {
+  }
+
+  // The objects are referred to by address, so the arena cannot be copied or moved.
+  QISA_Arena(const QISA_Arena&) = delete;
+  QISA_Arena& operator=(const QISA_Arena&) = delete;
+
+  /**
+   * Construct a new object in the arena.
+   *
+   * @return Pointer to the object, which remains valid until clear() is called.
+   */
+  template <typename... Args>
+  T*
+  create(Args&&... args)
+  {
+    if (_used == CHUNK_SIZE)
+    {
+      if (_nextChunk == _chunks.size())
+      {
+        _chunks.emplace_back(new Storage[CHUNK_SIZE]);
+      }
+
+      _current = _chunks[_nextChunk++].get();
+      _used = 0;
+    }
+
+    return new (&_current[_used++]) T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Release all objects.
+   * The memory is kept, to be reused by subsequent calls to create().
+   */
+  void
+  clear()
+  {
+    _nextChunk = 0;
+    _current = nullptr;
+    _used = CHUNK_SIZE;
+  }
+
+  /**
+   * @return The number of chunks that have been allocated.
+   */
+  size_t
+  getNrOfChunks() const
+  {
+    return _chunks.size();
+  }
+
+private:
+
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+  std::vector<std::unique_ptr<Storage[]> > _chunks;
+
+  // Index of the chunk that will be used when the current one is full.
+  size_t _nextChunk;
+
+  // Chunk in which objects are currently being created.
+  Storage* _current;
+
+  // Number of objects in the current chunk.
+  size_t _used;
+};
+
+} // namespace QISA
@@ -3,6 +3,12 @@
 #include <iomanip>
 #include <iostream>
 #include <cstring>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
 
 #include "qisa_driver.h"
 #include "qisa_version.h"
@@ -10,22 +16,45 @@
 #include "qisa_opcode_defs.inc"
 
 #include "qisa_qmap_parser.h"
+#include "qisa_mapped_file.h"
+#include "qisa_work_pool.h"
+#include "qisa_hash.h"
+#include "qisa_instruction_set_image.h"
+#include "qisa_scanner.h"
 
 namespace QISA
 {
 
 // Set the prefix that denotes a label in the disassembly.
-const char* QISA_Driver::DISASSEMBLY_LABEL_PREFIX = "label_";
+const char* const QISA_Driver::DISASSEMBLY_LABEL_PREFIX = "label_";
 
 QISA_Driver::QISA_Driver()
     : _traceScanning(false)
     , _traceParsing(false)
     , _verbose(false)
     , _hadEOF(false)
-    , _totalNrOfQubits(0)
+    , _sourceIsBuffer(false)
+    , _scanSourceFile(false)
+    , _assemblyCacheHits(0)
+    , _assemblyCacheMisses(0)
+    , _statsEnabled(false)
+    , _errorRecovery(false)
+    , _unrecordedErrorsStart(0)
+    , _lastTokenKind(0)
+    , _maskDeduplication(false)
+    , _maskRegisterRenaming(false)
+    , _nrOfRemovedMaskWords(0)
+    , _vliwPacking(false)
+    , _branchRelaxation(true)
+    , _nrOfRelaxedBranches(0)
+    , pos_number_s(1)
+    , pos_number_t(3)
     , _max_bs_val(0)
     , _disassemblyFormatId(1)
+    , _nrOfDisassemblyThreads(1)
     , _disassemblyLabelStringLength(0)
+    , _disassemblyMaxInstructionLength(0)
+    , _disassemblyMaxBranchLength(0)
     , _disassemblyStartedQuantumBundle(false)
     , _maxQuantumOpcodeVal(Q_INST_OPCODE_MASK) // 8 bits for the quantum instruction opcode.
     , _lastDriverAction(DRIVER_ACTION_NONE)
@@ -33,6 +62,10 @@ QISA_Driver::QISA_Driver()
   // Bring in the opcodes that have been defined for the qisa instructions.
   setOpcodes();
 
+  // Prepare the tables that are used to decode instructions while disassembling.
+  buildClassicDecodeTable();
+  buildQuantumDecodeTable();
+
   // Number of registers per kind of register.
   _nrOfRegisters[Q_REGISTER] = 7;
   _nrOfRegisters[R_REGISTER] = 32;
@@ -44,8 +77,6 @@ QISA_Driver::QISA_Driver()
   _registerName[S_REGISTER] = 'S';
   _registerName[T_REGISTER] = 'T';
 
-  _totalNrOfQubits = 0;
-
   // Maximum value to specify as bundle separator.
   // The width of this field is currently 3 bits, so the maximum value is set to 7.
   _max_bs_val = 7;
@@ -73,187 +104,77 @@ QISA_Driver::QISA_Driver()
   _branchConditionAliases["EQZ"]      = 0xa;
   _branchConditionAliases["NEZ"]      = 0xb;
 
-  /*
-  // Valid target-control pairs: 'left-to-right' direction
-  _valid_target_control_pairs[std::make_pair(2,0)] =  0;
-  _valid_target_control_pairs[std::make_pair(0,3)] =  1;
-  _valid_target_control_pairs[std::make_pair(4,1)] =  2;
-  _valid_target_control_pairs[std::make_pair(1,5)] =  3;
-  _valid_target_control_pairs[std::make_pair(5,2)] =  4;
-  _valid_target_control_pairs[std::make_pair(2,6)] =  5;
-  _valid_target_control_pairs[std::make_pair(6,3)] =  6;
-  _valid_target_control_pairs[std::make_pair(4,7)] =  7;
-  _valid_target_control_pairs[std::make_pair(7,5)] =  8;
-  _valid_target_control_pairs[std::make_pair(5,8)] =  9;
-  _valid_target_control_pairs[std::make_pair(8,6)] =  10;
-  _valid_target_control_pairs[std::make_pair(6,9)] =  11;
-  _valid_target_control_pairs[std::make_pair(7,10)] =  12;
-  _valid_target_control_pairs[std::make_pair(10,8)] =  13;
-  _valid_target_control_pairs[std::make_pair(8,11)] =  14;
-  _valid_target_control_pairs[std::make_pair(11,9)] =  15;
-  _valid_target_control_pairs[std::make_pair(9,12)] =  16;
-  _valid_target_control_pairs[std::make_pair(13,10)] =  17;
-  _valid_target_control_pairs[std::make_pair(10,14)] =  18;
-  _valid_target_control_pairs[std::make_pair(14,11)] =  19;
-  _valid_target_control_pairs[std::make_pair(11,15)] =  20;
-  _valid_target_control_pairs[std::make_pair(15,12)] =  21;
-  _valid_target_control_pairs[std::make_pair(13,16)] =  22;
-  _valid_target_control_pairs[std::make_pair(16,14)] =  23;
-
-  // Valid target-control pairs: opposite direction
-  _valid_target_control_pairs[std::make_pair(0,2)] =  24;
-  _valid_target_control_pairs[std::make_pair(3,0)] =  25;
-  _valid_target_control_pairs[std::make_pair(1,4)] =  26;
-  _valid_target_control_pairs[std::make_pair(5,1)] =  27;
-  _valid_target_control_pairs[std::make_pair(2,5)] =  28;
-  _valid_target_control_pairs[std::make_pair(6,2)] =  29;
-  _valid_target_control_pairs[std::make_pair(3,6)] =  30;
-  _valid_target_control_pairs[std::make_pair(7,4)] =  31;
-  _valid_target_control_pairs[std::make_pair(5,7)] =  32;
-  _valid_target_control_pairs[std::make_pair(8,5)] =  33;
-  _valid_target_control_pairs[std::make_pair(6,8)] =  34;
-  _valid_target_control_pairs[std::make_pair(9,6)] =  35;
-  _valid_target_control_pairs[std::make_pair(10,7)] =  36;
-  _valid_target_control_pairs[std::make_pair(8,10)] =  37;
-  _valid_target_control_pairs[std::make_pair(11,8)] =  38;
-  _valid_target_control_pairs[std::make_pair(9,11)] =  39;
-  _valid_target_control_pairs[std::make_pair(12,9)] =  40;
-  _valid_target_control_pairs[std::make_pair(10,13)] =  41;
-  _valid_target_control_pairs[std::make_pair(14,10)] =  42;
-  _valid_target_control_pairs[std::make_pair(11,14)] =  43;
-  _valid_target_control_pairs[std::make_pair(15,11)] =  44;
-  _valid_target_control_pairs[std::make_pair(12,15)] =  45;
-  _valid_target_control_pairs[std::make_pair(16,13)] =  46;
-  _valid_target_control_pairs[std::make_pair(14,16)] =  47;
-  */
-
-  // Lookup table to go from bit number to target-control pair.
-  _bit2tc_pair[ 0] = std::make_pair(2,0);
-  _bit2tc_pair[ 1] = std::make_pair(0,3);
-  _bit2tc_pair[ 2] = std::make_pair(3,1);
-  _bit2tc_pair[ 3] = std::make_pair(1,4);
-  _bit2tc_pair[ 4] = std::make_pair(2,5);
-  _bit2tc_pair[ 5] = std::make_pair(5,3);
-  _bit2tc_pair[ 6] = std::make_pair(3,6);
-  _bit2tc_pair[ 7] = std::make_pair(6,4);
-  _bit2tc_pair[ 8] = std::make_pair(0,2);
-  _bit2tc_pair[ 9] = std::make_pair(3,0);
-  _bit2tc_pair[10] = std::make_pair(1,3);
-  _bit2tc_pair[11] = std::make_pair(4,1);
-  _bit2tc_pair[12] = std::make_pair(5,2);
-  _bit2tc_pair[13] = std::make_pair(3,5);
-  _bit2tc_pair[14] = std::make_pair(6,3);
-  _bit2tc_pair[15] = std::make_pair(4,6);
-
 }
 
-void
-QISA_Driver::read(std::string input_filename)
+QISA_Driver::~QISA_Driver()
 {
-    std::ifstream                           in;
-    //std::string                             input_filename;
-    std::string                            line;
-
-    std::pair <int, int> one[48];
-    std::pair <uint8_t, uint8_t> two[48];
-    int             i = 0;
-    int             qubit_num = 0;
-    int             num_edge_address = 0;
-    bool read_qubit_num, read_edge_list, read_num_nn_edge = false;
-
-    //input_filename = "D:\\Projects\\QuMA_Sim\\scripts\\quantum_layout_information.txt";
-
-    in.open(input_filename);
-    //std::cout << "opening file..." << std::endl;
-
-    if (!in) {
-        std::cerr << "Error while open quantum layout information file" << std::endl;
-    }
-
-    while (getline(in, line))
-    {
-        std::istringstream iss(line);
-        int num_qubits;
-        int edge_number, left_operation, right_operation;
-        char buff;
-
-        //std::cout << line << std::endl;
-        /***********************Read number of qubits****************************/
-        if (strcmp(line.c_str(), ".EndNumQubits") == 0) {
-            read_qubit_num = false;
-            //std::cout << "End reading number of qubits" << std::endl;
-        }
-
-        if (read_qubit_num == true) {
-            iss >> num_qubits;
-            qubit_num = num_qubits;
-            //std::cout << "There are " << num_qubits << " qubits" << std::endl;
-        }
-
-        if (strcmp(line.c_str(), ".NumQubits") == 0) {
-            read_qubit_num = true;
-            //std::cout << "Start reading number of qubits" << std::endl;
-        }
-
-        /***********************Read number of direct edge address*********************/
-        if (strcmp(line.c_str(), ".EndNumDirEdge") == 0) {
-            read_num_nn_edge = false;
-            //std::cout << "End reading number of direct edge address" << std::endl;
-        }
-
-        if (read_num_nn_edge == true) {
-            iss >> num_edge_address;
-            //std::cout << "There are " << num_edge_address << " edge addresses there" << std::endl;
-        }
-
-        if (strcmp(line.c_str(), ".NumDirEdge") == 0) {
-            read_num_nn_edge = true;
-            //std::cout << "\nStart reading number of direct edge address" << std::endl;
-        }
+  // Instructions that have been shared outlive the driver.
+  releaseSharedInstructions();
+}
 
-        /***********************Read edge list information***********************/
-        if (strcmp(line.c_str(), ".EndEdgeList") == 0) {
-            read_edge_list = false;
-            //std::cout << "End reading edge list" << std::endl;
-        }
+bool
+QISA_Driver::read(const std::string& input_filename)
+{
+  QISA_Topology topology;
 
-        if (read_edge_list == true) {
-            if (!(iss >> edge_number >> buff >> left_operation >> buff >> right_operation)) { break; } // error
-
-            iss >> edge_number >> buff >> left_operation >> buff >> right_operation;
-            //if (!check_range(left_operation, min, max) {
-
-            //}
-            uint8_t a = static_cast<uint8_t>(left_operation);
-            uint8_t b = right_operation;
-            //std::cout << a << b << std::endl;
-            //printf("%d, %d\n", a, b);
-            one[i] = std::make_pair(left_operation, right_operation);
-            two[i] = std::make_pair(a, b);
-            //std::cout << one[i].first << ", " << one[i].second << std::endl;
-            i++;
-        }
+  if (!topology.read(input_filename))
+  {
+    error(topology.getErrorMessage());
+    return false;
+  }
 
-        if (strcmp(line.c_str(), ".EdgeList") == 0) {
-            read_edge_list = true;
-            //std::cout << "Start reading edge list" << std::endl;
-        }
+  // In the QCC assembler, one binary instruction is generated for SMIS and three for SMIT.
+  // These determine how many qubits and edges can be addressed.
+  const int nrOfSMaskBits = pos_number_s * static_cast<int>(std::bitset<32>(S_MASK_MASK).count());
+  const int nrOfTMaskBits = pos_number_t * static_cast<int>(std::bitset<32>(T_MASK_MASK).count());
 
-    }
+  if (topology.nrOfQubits() > nrOfSMaskBits)
+  {
+    _errorStream << input_filename << ": the topology has " << topology.nrOfQubits()
+                 << " qubits, but an s_mask can address at most " << nrOfSMaskBits << std::endl;
+    _errorLoc = location();
+    return false;
+  }
 
-    in.close();
+  if (topology.nrOfEdges() > static_cast<size_t>(nrOfTMaskBits))
+  {
+    _errorStream << input_filename << ": the topology has " << topology.nrOfEdges()
+                 << " edges, but a t_mask can address at most " << nrOfTMaskBits << std::endl;
+    _errorLoc = location();
+    return false;
+  }
 
-    //initiate target_control_pairs
-    for (int j = 0; j < num_edge_address; j++) {
-        _valid_target_control_pairs[two[j]] = j;
-    }
-    _totalNrOfQubits = qubit_num;
-    _NrOfEdgeAdress = num_edge_address;
+  _topology = topology;
 
-    //In the QCC assembler, one binary instruction generated for SMIS and three binary instructions generated for SMIT
-    pos_number_s = 1;
-    pos_number_t = 3;
+  return true;
+}
 
+void
+QISA_Driver::configureFrom(const QISA_Driver& prototype)
+{
+  // Quantum instruction set.
+  _q_inst_arg_none_opcodes = prototype._q_inst_arg_none_opcodes;
+  _q_inst_arg_st_opcodes = prototype._q_inst_arg_st_opcodes;
+  _q_inst_arg_tt_opcodes = prototype._q_inst_arg_tt_opcodes;
+  _quantumOpcode2instName = prototype._quantumOpcode2instName;
+  buildQuantumDecodeTable();
+
+  // Quantum layout information.
+  _topology = prototype._topology;
+  pos_number_s = prototype.pos_number_s;
+  pos_number_t = prototype.pos_number_t;
+
+  // Assembly cache.
+  _assemblyCacheDirectory = prototype._assemblyCacheDirectory;
+
+  // Error handling.
+  _errorRecovery = prototype._errorRecovery;
+
+  // Optimization.
+  _maskDeduplication = prototype._maskDeduplication;
+  _maskRegisterRenaming = prototype._maskRegisterRenaming;
+  _vliwPacking = prototype._vliwPacking;
+  _branchRelaxation = prototype._branchRelaxation;
 }
 
 void
@@ -262,6 +183,14 @@ QISA_Driver::reset()
   _hadEOF = false;
   _filename.clear();
 
+  _sourceIsBuffer = false;
+  _sourceBuffer.clear();
+
+  _sourceLines.clear();
+  _sourceFile.close();
+  _scanSourceFile = false;
+
+  releaseSharedInstructions();
   _instructions.clear();
 
   _disassembledInstructions.clear();
@@ -269,7 +198,10 @@ QISA_Driver::reset()
   _disassemblyStartedQuantumBundle = false;
 
   _disassemblyLabels.clear();
+  _disassemblyMaxInstructionLength = 0;
+  _disassemblyMaxBranchLength = 0;
   _labels.clear();
+  _lastLabelAddress = static_cast<uint64_t>(-1);
 
   _registerAliases[0].clear();
   _registerAliases[1].clear();
@@ -280,11 +212,21 @@ QISA_Driver::reset()
 
   _strSymbols.clear();
 
+  _qInstructionArena.clear();
+
   _deferredInstructions.clear();
+  _longBranches.clear();
 
   _errorStream.str(""); // Clear the accumulated error messages.
   _errorStream.clear(); // Clear state flags.
 
+  _diagnostics.clear();
+  _unrecordedErrorsStart = 0;
+  _lastTokenKind = 0;
+
+  _nrOfRemovedMaskWords = 0;
+  _nrOfRelaxedBranches = 0;
+
   _lastDriverAction = DRIVER_ACTION_NONE;
 
   _errorLoc = location();
@@ -296,2834 +238,5130 @@ QISA_Driver::assemble(const std::string &filename)
   // First, reset the driver to get a clean start.
   reset();
 
-  yyscan_t flex_scanner;
-
   _filename = filename;
-  bool success = scanBegin(&flex_scanner);
-
-  if (!success)
-  {
-    return false;
-  }
-
-  if(_totalNrOfQubits == 0) {
-    std::cout << "\nError: the quantum layout information is not read into assembler" << std::endl;
-    success = false;
-  }
-
-  QISA_Parser parser (*this, flex_scanner);
-  parser.set_debug_level (_traceParsing);
-
-  int parser_result = parser.parse ();
-  scanEnd(flex_scanner);
-
-  if (parser_result == 0)
-  {
-    success = processDeferredInstructions();
-  }
-  else
-  {
-    success = false;
-  }
 
-  // This is for save() to know it has to save binary assembly output.
-  _lastDriverAction = DRIVER_ACTION_PARSE;
-  return success;
+  return parseInput();
 }
 
 bool
-QISA_Driver::disassemble(const std::string& filename)
+QISA_Driver::assembleBuffer(const char* buffer, size_t size)
 {
-  // First reset the driver to get a clean start.
+  // First, reset the driver to get a clean start.
   reset();
 
-  std::ifstream inputFile (filename, std::ios::in | std::ios::binary);
-
-  // Assume no errors while disassembling.
-  bool result = true;
-
-  if (inputFile.is_open())
-  {
-
-    // Check if the input file is empty.
-    // If so, bail out with an error.
-
-    if (inputFile.peek() == std::ifstream::traits_type::eof())
-    {
-      error("File '" + filename + "' is empty!");
-      return false;
-    }
-
-
-    // Read the instructions one at a time.
-    qisa_instruction_type inst;
-
-    // Used to keep track of the current instruction within the input file.
-    size_t disassemblyInstructionCounter = 0;
-
-    while(inputFile.read((char*)&inst, sizeof(qisa_instruction_type)))
-    {
-      if (_verbose)
-      {
-        std::bitset<sizeof(qisa_instruction_type)*8> binary(inst);
-        std::cout << "Input instruction: " << getHex(inst, 8)
-                  << " (" << binary << ")" << std::endl;
-      }
-
-      DisassembledInstruction disassembledInstruction;
-      disassembledInstruction.address = disassemblyInstructionCounter;
-      disassembledInstruction.hexCode = getHex(inst, 8);
-      if (!disassembleInstruction(inst, disassembledInstruction))
-      {
-        _errorStream << "Error while disassembling instruction "
-                     << getHex(inst, 8)
-                     <<  ", instructionCount = " << disassemblyInstructionCounter;
-        _errorLoc = location();
-        result = false;
-      }
+  // This name is used in the error messages instead of a file name.
+  _filename = "<buffer>";
 
-      _disassembledInstructions[disassemblyInstructionCounter] = disassembledInstruction;
-
-      disassemblyInstructionCounter++;
-    }
-    postProcessDisassembly();
-  }
-  else
-  {
-    error("Cannot open file '" + filename + "'.");
-    return false;
-  }
+  _sourceIsBuffer = true;
+  _sourceBuffer.assign(buffer, size);
 
-  // This is for save() to know it has to save disassembly output.
-  _lastDriverAction = DRIVER_ACTION_DISASSEMBLE;
-  return result;
+  return parseInput();
 }
 
-void
-QISA_Driver::postProcessDisassembly()
+bool
+QISA_Driver::assembleString(const std::string& source)
 {
-  if (_verbose)
-    std::cout << "DISASSEMBLY POST-PROCESS" << std::endl;
+  return assembleBuffer(source.data(), source.size());
+}
 
-  // This will be set to the actual label length in case branch
-  // instructions are used.
-  _disassemblyLabelStringLength = 0;
+std::vector<QISA_Driver::AssemblyResult>
+QISA_Driver::assembleMany(const std::vector<std::string>& sources, unsigned nrOfThreads) const
+{
+  QISA_WorkPool pool(nrOfThreads);
 
-  // Only do the following in case labels have been used.
-  if (!_disassemblyLabels.empty())
+  // One driver per worker, such that they can be reused for subsequent programs.
+  std::vector<QISA_Driver> workers(pool.nrOfThreads());
+  for (auto& worker : workers)
   {
-    // Create a map from the used branch destination to label with an index.
-
-    std::map<uint64_t, std::string> dest2LabelMap;
-    int labelCounter = 0;
+    worker.configureFrom(*this);
+  }
 
-    // Calculate the number of digits needed to print the labels.
-    // Source: https://stackoverflow.com/a/1489861
-    int nrOfDigitsPerLabel = 0;
+  std::vector<AssemblyResult> results(sources.size());
 
-    size_t nrOfLabels = _disassemblyLabels.size();
-    while (nrOfLabels != 0)
-    {
-      nrOfLabels /= 10;
-      nrOfDigitsPerLabel++;
-    }
+  pool.run(sources.size(), [&](size_t sourceIndex, unsigned workerIndex)
+  {
+    QISA_Driver& worker = workers[workerIndex];
+    AssemblyResult& result = results[sourceIndex];
 
-    // Used to get the correct indentation in case there is no label.
-    // The extra spaces (+ 2) are for the ": " that come after a 'full' label.
-    _disassemblyLabelStringLength = strlen(DISASSEMBLY_LABEL_PREFIX) + nrOfDigitsPerLabel + 2;
-    std::string emptyLabel(_disassemblyLabelStringLength, ' ');
+    result.success = worker.assembleString(sources[sourceIndex]);
 
-    // Determine the name of the labels.
-    for (auto it = _disassemblyLabels.begin(); it != _disassemblyLabels.end(); ++it)
+    if (result.success)
     {
-      std::ostringstream ssLabel;
-
-      ssLabel << DISASSEMBLY_LABEL_PREFIX << std::setw(nrOfDigitsPerLabel) << std::setfill('0') << labelCounter;
-      dest2LabelMap[it->first] = ssLabel.str();
-      labelCounter++;
+      result.instructions.swap(worker._instructions);
     }
-
-    // Create a map that maps a branch instruction to its branch destination.
-    std::map<uint64_t, uint64_t> branchInstr2destAddrMap;
-
-    for (auto it = _disassemblyLabels.begin(); it != _disassemblyLabels.end(); ++it)
+    else
     {
-      for (auto branchIt = it->second.begin(); branchIt != it->second.end(); ++branchIt)
-      {
-        branchInstr2destAddrMap[*branchIt] = it->first;
-      }
+      result.errorMessage = worker.getLastErrorMessage();
     }
+  });
 
-    if (_verbose)
-      std::cout << "Processing " << branchInstr2destAddrMap.size() << " branch instructions..." << std::endl;
-
-    for (auto itInstr = _disassembledInstructions.begin(); itInstr != _disassembledInstructions.end(); ++itInstr)
-    {
-      // If this is a branch destination, prepend the label instruction;
-      auto itDest = _disassemblyLabels.find(itInstr->second.address);
-      if (itDest != _disassemblyLabels.end())
-      {
-        itInstr->second.label = dest2LabelMap[itDest->first] + ": ";
-      }
-      else
-      {
-        // Else, just use spaces instead.
-        itInstr->second.label = emptyLabel;
-      }
+  return results;
+}
 
-      auto itBranchInstr = branchInstr2destAddrMap.find(itInstr->second.address);
-      // If this is a branch instruction, emit its corresponding label and offset as comment.
-      if (itBranchInstr != branchInstr2destAddrMap.end())
-      {
-        const int64_t offset = itBranchInstr->second - itInstr->second.address;
+std::mutex&
+QISA_Driver::getUseMutex()
+{
+  return _useMutex;
+}
 
-        std::ostringstream ssNewInstruction;
-        ssNewInstruction << itInstr->second.instruction << ", " << dest2LabelMap[itBranchInstr->second]
-                  << " # offset(" << std::showpos << offset << std::noshowpos << ")";
-        itInstr->second.instruction = ssNewInstruction.str();
-      }
-    }
-  }
+bool
+QISA_Driver::scanBegin(yyscan_t* scanner)
+{
+#ifdef QISA_AS_FAST_SCANNER
+  return fastScanBegin(scanner);
+#else
+  return flexScanBegin(scanner);
+#endif
 }
 
-std::string
-QISA_Driver::getHex(uint64_t val, int nDigits)
+void
+QISA_Driver::scanEnd(yyscan_t scanner)
 {
-  std::ostringstream ss;
-  ss << "0x" << std::hex << std::setfill('0') << std::setw(nDigits) << val;
-  return ss.str();
+#ifdef QISA_AS_FAST_SCANNER
+  fastScanEnd(scanner);
+#else
+  flexScanEnd(scanner);
+#endif
 }
 
 bool
-QISA_Driver::disassembleInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
+QISA_Driver::parseInput()
 {
-  if (inst & (1L << DBL_INST_FORMAT_BIT_OFFSET))
-  {
-    return disassembleQuantumInstruction(inst, disassembledInst);
-  }
-  else
+  // Try to take the result from the assembly cache.
+  // This is done first, such that the scanner is not even started on a hit.
+  std::string cacheConfiguration;
+  uint64_t cacheKey = 0;
+  const bool useCache = !_assemblyCacheDirectory.empty() && getAssemblyCacheKey(cacheConfiguration, cacheKey);
+
+  if (useCache && loadCachedAssembly(cacheConfiguration, cacheKey))
   {
-    // A quantum bundle ends when a non-bundle instruction is encountered.
-    if (_disassemblyStartedQuantumBundle)
+    if (_statsEnabled)
     {
-      _disassemblyStartedQuantumBundle = false;
+      _stats.nrOfRelaxedBranches += _nrOfRelaxedBranches;
+      _stats.nrOfRemovedMaskWords += _nrOfRemovedMaskWords;
+      _stats.nrOfInstructions += _instructions.size();
     }
 
-    return disassembleClassicInstruction(inst, disassembledInst);
+    // This is for save() to know it has to save binary assembly output.
+    _lastDriverAction = DRIVER_ACTION_PARSE;
+    return true;
   }
-}
 
-bool
-QISA_Driver::disassembleClassicInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
-{
-  int opc= (inst >> OPCODE_OFFSET) & OPCODE_MASK;
+  yyscan_t flex_scanner;
 
-  // We don't deal with source code here, but want to use the checking
-  // functions that are also used within the parser.
-  // Define an empty location that we will use with these checking functions.
-  location errLoc = location();
+  bool success = scanBegin(&flex_scanner);
 
-  if (_classicOpcode2instName.find(opc) == _classicOpcode2instName.end())
+  if (!success)
   {
-    _errorStream << "Unknown opcode: " << getHex(opc, 2);
-    _errorLoc = errLoc;
+    recordDiagnostic();
     return false;
   }
 
-  std::string inst_name = _classicOpcode2instName[opc];
-
-  // Might use a hashing function to speed things up if necessary.
-  // Possible implementation: http://www.cse.yorku.ca/~oz/hash.html
-  //
-  // Djb2:
-  //
-  //  unsigned long
-  //  hash(unsigned char *str)
-  //  {
-  //      unsigned long hash = 5381;
-  //      int c;
-
-  //      while (c = *str++)
-  //          hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-
-  //      return hash;
-  //  }
+  if(_topology.nrOfQubits() == 0) {
+    std::cout << "\nError: the quantum layout information is not read into assembler" << std::endl;
+    success = false;
+  }
 
-  std::ostringstream ssInst;
+  QISA_Parser parser (*this, flex_scanner);
+  parser.set_debug_level (_traceParsing);
 
-  if ((inst_name == "NOP") ||
-      (inst_name == "STOP"))
-  {
-    ssInst << inst_name;
-  }
-  else if ((inst_name == "ADD")  ||
-           (inst_name == "ADDC") ||
-           (inst_name == "SUB")  ||
-           (inst_name == "SUBC") ||
-           (inst_name == "AND")  ||
-           (inst_name == "OR")   ||
-           (inst_name == "XOR"))
+  int parser_result;
   {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+    // The time spent in the generate_ functions is accounted to code generation.
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::scanParseTime);
+    parser_result = parser.parse ();
 
-    const int rs = (inst >> RS_OFFSET) & RS_MASK;
-    if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
+    if (_errorRecovery)
+    {
+      // The parser stops at the first error. To find the errors on the next lines,
+      // skip the rest of the line that contains the error, and restart the parser
+      // from there. The driver keeps the labels, symbols and register aliases that
+      // have been declared so far.
+      bool hadParseError = (parser_result != 0);
 
-    const int rt = (inst >> RT_OFFSET) & RT_MASK;
-    if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+      while (parser_result != 0)
+      {
+        recordDiagnostic();
 
-    ssInst << inst_name << " R" << rd << ", R" << rs << ", R" << rt;
-  }
-  else if (inst_name == "NOT")
-  {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+        if (!skipToNextLine(flex_scanner))
+        {
+          break;
+        }
 
-    const int rt = (inst >> RT_OFFSET) & RT_MASK;
-    if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+        parser_result = parser.parse ();
+      }
 
-    ssInst << inst_name << " R" << rd << ", R" << rt;
+      if (hadParseError)
+      {
+        parser_result = 1;
+      }
+    }
   }
-  else if (inst_name == "CMP")
-  {
-    const int rs = (inst >> RS_OFFSET) & RS_MASK;
-    if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
-
-    const int rt = (inst >> RT_OFFSET) & RT_MASK;
-    if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+  scanEnd(flex_scanner);
 
-    ssInst << inst_name << " R" << rs << ", R" << rt;
-  }
-  else if (inst_name == "BR")
+  // With error recovery, the deferred labels are also resolved after a parse error,
+  // such that undefined labels are reported as well.
+  if ((parser_result == 0) || _errorRecovery)
   {
-    const int cond = inst & COND_MASK;
-
-    if (_branchConditionNames.find(cond) == _branchConditionNames.end())
+    if (_statsEnabled)
     {
-      _errorStream << "Unknown branch condition: " << getHex(cond, 2);
-      _errorLoc = location();
-      return false;
+      _stats.nrOfDeferredLabels += _deferredInstructions.size();
     }
 
-    const int addr = (inst >> ADDR_OFFSET) & ADDR_MASK;
-
-    // Sign extend the address, which is an offset relative to the current instruction counter.
-    // Source: http://graphics.stanford.edu/~seander/bithacks.html#FixedSignExtend
-    struct {signed int x:21;} s;
-    const int addr_offset = s.x = addr;
-
-    const uint64_t dest_address = disassembledInst.address + addr_offset;
-
-    // Mark the fact that this instruction is a branch instruction
-    // that will need to address a label.
-    _disassemblyLabels[dest_address].push_back(disassembledInst.address);
-
-    // The labels will be added afterwards.
-    ssInst << inst_name << " " << _branchConditionNames[cond];
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::deferredResolutionTime);
+    success = processDeferredInstructions() && (parser_result == 0);
   }
-  else if (inst_name == "LDI")
+  else
   {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
-
-    const int imm = inst & IMM20_MASK;
-
-    // Sign extend the immediate value.
-    struct {signed int x:20;} s;
-    const int signed_imm= s.x = imm;
-
-    ssInst << inst_name << " R" << rd << ", "
-           << getHex(signed_imm, 5) << " # dec("
-           << signed_imm << ")";
+    success = false;
   }
-  else if (inst_name == "LDUI")
-  {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
-
-    const int imm = inst & U_IMM15_MASK;
 
-    ssInst << inst_name << " R" << rd << ", "
-           << getHex(imm, 4) << " # dec("
-           << imm << ")";
-  }
-  else if (inst_name == "FBR")
+  if (success && !_longBranches.empty())
   {
-    const int cond = inst & COND_MASK;
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::branchRelaxationTime);
+    success = relaxBranches();
 
-    if (_branchConditionNames.find(cond) == _branchConditionNames.end())
+    if (success && _statsEnabled)
     {
-      _errorStream << "Unknown branch condition: " << getHex(cond, 2);
-      _errorLoc = location();
-      return false;
+      _stats.nrOfRelaxedBranches += _nrOfRelaxedBranches;
     }
-
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-
-    ssInst << inst_name << " " << _branchConditionNames[cond] << ", R" << rd;
   }
-  else if (inst_name == "FMR")
-  {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
 
-    const int qs = inst & QS_MASK;
-    if (!checkRegisterNumber(qs, errLoc, Q_REGISTER)) return false;
-
-    ssInst << inst_name << " R" << rd << ", Q" << qs;
-  }
-  else if (inst_name == "SMIS")
+  if (success && _maskDeduplication)
   {
-    const int sd = (inst >> SD_OFFSET) & SD_MASK;
-    if (!checkRegisterNumber(sd, errLoc, S_REGISTER)) return false;
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::maskDeduplicationTime);
+    _nrOfRemovedMaskWords = deduplicateMasks();
 
-    uint64_t s_mask_bits = (inst & S_MASK_MASK);
-
-    auto s_mask = bits2s_mask(s_mask_bits);
-    ssInst << inst_name << " S" << sd << ", " << get_s_mask_str(s_mask);
+    if (_statsEnabled)
+    {
+      _stats.nrOfRemovedMaskWords += _nrOfRemovedMaskWords;
+    }
   }
-  else if (inst_name == "SMIT")
-  {
-    const int td = (inst >> TD_OFFSET) & TD_MASK;
-    if (!checkRegisterNumber(td, errLoc, T_REGISTER)) return false;
 
-    uint64_t t_mask_bits = (inst & T_MASK_MASK);
-
-    auto t_mask = bits2t_mask(t_mask_bits);
-    ssInst << inst_name << " T" << td << ", " << get_t_mask_str(t_mask);
-  }
-  else if (inst_name == "QWAIT")
+  if (!success)
   {
-    const int rd = (inst >> RD_OFFSET) & RD_MASK;
-    if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
-
-    const int u_imm = inst & U_IMM20_MASK;
-
-    ssInst << inst_name << " " << u_imm;
+    recordDiagnostic();
   }
-  else if (inst_name == "QWAITR")
-  {
-    const int rs = (inst >> RS_OFFSET) & RS_MASK;
-    if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
 
-    ssInst << inst_name << " R" << rs;
-  }
-  else
+  if (_statsEnabled)
   {
-    ssInst << "<Not yet supported: '"
-           << _classicOpcode2instName[opc] << "'>" << std::endl;
+    _stats.nrOfInstructions += _instructions.size();
   }
 
-  disassembledInst.instruction = ssInst.str();
+  if (useCache && success)
+  {
+    storeCachedAssembly(cacheConfiguration, cacheKey);
+  }
 
-  return true;
+  // This is for save() to know it has to save binary assembly output.
+  _lastDriverAction = DRIVER_ACTION_PARSE;
+  return success;
 }
 
 bool
-QISA_Driver::disassembleQuantumInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
+QISA_Driver::skipToNextLine(yyscan_t scanner)
 {
-  int bs = inst & BS_MASK;
+  const int newlineKind = QISA_Parser::make_NEWLINE(location()).type_get();
+  const int endKind = QISA_Parser::make_END(location()).type_get();
 
-  std::ostringstream ssInst;
+  // The parser may have stopped before or after reading the new-line at the end of the
+  // line that contains the error, depending on where in the line the error was found.
+  while ((_lastTokenKind != newlineKind) && (_lastTokenKind != endKind))
+  {
+    yylex(*this, scanner);
+  }
 
-  ssInst << "BS " << bs << " ";
+  // After the new-line that the scanner appends at the end of file, only the end of input follows.
+  return (_lastTokenKind == newlineKind) && !_hadEOF;
+}
 
-#if 0 // Hold on to this for the high-level disassembly, if we will handle that.
-  if (bs > 0)
-  {
-    // If a previous bundle was started, we have to issue a new-line to
-    // terminate before starting a new one.
-    if (_disassemblyStartedQuantumBundle)
-    {
-      _disassemblyOutput << std::endl;
-    }
-    // Now we start a new quantum bundle.
-    _disassemblyOutput << "BS " << bs << " ";
+void
+QISA_Driver::enableStats(bool enabled)
+{
+  _statsEnabled = enabled;
+}
 
-    _disassemblyStartedQuantumBundle = true;
+const QISA_Stats&
+QISA_Driver::getStats() const
+{
+  return _stats;
+}
+
+void
+QISA_Driver::resetStats()
+{
+  _stats.clear();
+}
+
+void
+QISA_Driver::getSourceCode(const char*& data, size_t& size) const
+{
+  if (_sourceIsBuffer)
+  {
+    data = _sourceBuffer.data();
+    size = _sourceBuffer.size();
   }
   else
   {
-    if (_disassemblyStartedQuantumBundle)
+    data = _sourceFile.data();
+    size = _sourceFile.size();
+  }
+}
+
+// Append an integer value to the configuration of an assembly, independent of the byte order of the host.
+static void
+addToConfiguration(std::string& configuration, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    configuration += static_cast<char>(value >> (8 * i));
+  }
+}
+
+// Append a string to the configuration of an assembly.
+// Its length is added as well, such that e.g. "ab" + "c" and "a" + "bc" differ.
+static void
+addToConfiguration(std::string& configuration, const std::string& str)
+{
+  addToConfiguration(configuration, static_cast<uint64_t>(str.size()));
+  configuration += str;
+}
+
+bool
+QISA_Driver::getAssemblyCacheKey(std::string& configuration, uint64_t& key)
+{
+  // Map the source file once, and let the scanner take the source code from there.
+  // Otherwise, if the file changes before it is scanned, the result of assembling
+  // the new contents would be stored under the key of the old contents.
+  if (!_sourceIsBuffer)
+  {
+    if (!_sourceFile.open(_filename))
     {
-      // If we already started a bundle, add this one to the set.
-      _disassemblyOutput << " | ";
+      return false;
     }
-    else
-    {
-      // Otherwise we start a new quantum bundle with 0 as wait time.
-      _disassemblyOutput << "BS " << bs << " ";
 
-      _disassemblyStartedQuantumBundle = true;
-    }
+    _scanSourceFile = true;
   }
-#endif
 
-  // Quantum instructions are put pair-wise in a
-  // 'very large instruction word' (VLIW).
+  configuration.clear();
 
-  // Handle the first quantum instruction of the VLIW.
-  // Last parameter contains the disassembled instruction.
-  std::string q_0_str;
-  if (!decode_q_instr((inst >> VLIW_INST_0_OFFSET) & VLIW_Q_INST_MASK, q_0_str))
+  // Assembler version, since the encoding may change between versions.
+  addToConfiguration(configuration, getVersion());
+
+  // Instruction set.
+  const q_map_t* opcodeMaps[] = { &_opcodes,
+                                  &_q_inst_arg_none_opcodes,
+                                  &_q_inst_arg_st_opcodes,
+                                  &_q_inst_arg_tt_opcodes };
+
+  for (const q_map_t* opcodeMap : opcodeMaps)
   {
-    // Return false if the binary value could not be decoded as a valid quantum instruction.
-    return false;
+    addToConfiguration(configuration, static_cast<uint64_t>(opcodeMap->size()));
+    for (const auto& it : *opcodeMap)
+    {
+      addToConfiguration(configuration, it.first);
+      addToConfiguration(configuration, static_cast<uint64_t>(it.second));
+    }
   }
 
-  std::string q_1_str;
-  // Handle the second quantum instruction of the VLIW.
-  if (!decode_q_instr((inst >> VLIW_INST_1_OFFSET) & VLIW_Q_INST_MASK, q_1_str))
+  // Optimization, which changes the generated instructions.
+  addToConfiguration(configuration, static_cast<uint64_t>(_maskDeduplication));
+  addToConfiguration(configuration, static_cast<uint64_t>(_maskDeduplication && _maskRegisterRenaming));
+  addToConfiguration(configuration, static_cast<uint64_t>(_vliwPacking));
+  addToConfiguration(configuration, static_cast<uint64_t>(_branchRelaxation));
+
+  // Quantum layout information.
+  addToConfiguration(configuration, static_cast<uint64_t>(_topology.nrOfQubits()));
+  addToConfiguration(configuration, static_cast<uint64_t>(pos_number_s));
+  addToConfiguration(configuration, static_cast<uint64_t>(pos_number_t));
+
+  addToConfiguration(configuration, static_cast<uint64_t>(_topology.nrOfEdges()));
+  for (size_t edgeId = 0; edgeId < _topology.nrOfEdges(); edgeId++)
   {
-    // Return false if the binary value could not be decoded as a valid quantum instruction.
-    return false;
+    addToConfiguration(configuration, static_cast<uint64_t>(_topology.getEdge(edgeId).first));
+    addToConfiguration(configuration, static_cast<uint64_t>(_topology.getEdge(edgeId).second));
   }
 
-  // QNOPs are mostly hidden, unless both instructions of a VLIW are QNOPs.
-  // If both instructions are QNOPs, issue one QNOP in total.
-  // If only one is a QNOP, issue the non-QNOP instruction.
-  // If neither instructions are QNOP, issue both instructions separated by a vertical bar.
+  const char* source;
+  size_t sourceSize;
+  getSourceCode(source, sourceSize);
 
-  const bool q_0_is_nop = (q_0_str == "QNOP");
-  const bool q_1_is_nop = (q_1_str == "QNOP");
+  // The key only selects the cache file. Since the configuration and the source code
+  // are stored in the cache file as well, a collision leads to a cache miss.
+  QISA_Hash hash;
+  hash.add(configuration);
+  hash.add(static_cast<uint64_t>(sourceSize));
+  hash.add(source, sourceSize);
 
-  if (q_0_is_nop &&
-      q_1_is_nop)
+  key = hash.value();
+  return true;
+}
+
+std::string
+QISA_Driver::getAssemblyCacheFilename(uint64_t key)
+{
+  return _assemblyCacheDirectory + "/" + getHex(key, 16).substr(2) + ".qisa-cache";
+}
+
+// Identifies an assembly cache file.
+// It is followed by the key, the number of instructions, the number of removed
+// mask words, the number of relaxed branches, the size of the configuration and
+// the size of the source code, and then by the configuration, the source code
+// and the instructions themselves.
+static const char ASSEMBLY_CACHE_MAGIC[8] = { 'Q', 'I', 'S', 'A', 'C', 'A', 'C', '3' };
+
+bool
+QISA_Driver::loadCachedAssembly(const std::string& configuration, uint64_t key)
+{
+  const std::string cacheFilename = getAssemblyCacheFilename(key);
+
+  QISA_MappedFile cacheFile;
+  bool hit = cacheFile.open(cacheFilename);
+
+  // The values that follow the magic.
+  enum { HEADER_KEY, HEADER_NR_OF_INSTRUCTIONS, HEADER_NR_OF_REMOVED_MASK_WORDS,
+         HEADER_NR_OF_RELAXED_BRANCHES, HEADER_CONFIGURATION_SIZE, HEADER_SOURCE_SIZE,
+         HEADER_SIZE };
+
+  const size_t headerSize = sizeof(ASSEMBLY_CACHE_MAGIC) + HEADER_SIZE * sizeof(uint64_t);
+  uint64_t header[HEADER_SIZE] = { 0 };
+  const uint64_t& storedKey = header[HEADER_KEY];
+  const uint64_t& nrOfInstructions = header[HEADER_NR_OF_INSTRUCTIONS];
+
+  const char* source;
+  size_t sourceSize;
+  getSourceCode(source, sourceSize);
+
+  const size_t instructionsOffset = headerSize + configuration.size() + sourceSize;
+
+  if (hit && (cacheFile.size() >= headerSize))
   {
-    ssInst << q_0_str;
+    memcpy(header, cacheFile.data() + sizeof(ASSEMBLY_CACHE_MAGIC), sizeof(header));
+
+    // Reject cache files that are damaged or that have been written by another kind of host.
+    // Also reject cache files of another configuration or source code with the same key.
+    hit = !memcmp(cacheFile.data(), ASSEMBLY_CACHE_MAGIC, sizeof(ASSEMBLY_CACHE_MAGIC)) &&
+          (storedKey == key) &&
+          (header[HEADER_CONFIGURATION_SIZE] == configuration.size()) &&
+          (header[HEADER_SOURCE_SIZE] == sourceSize) &&
+          (cacheFile.size() == instructionsOffset + nrOfInstructions * sizeof(qisa_instruction_type)) &&
+          !memcmp(cacheFile.data() + headerSize, configuration.data(), configuration.size()) &&
+          !memcmp(cacheFile.data() + headerSize + configuration.size(), source, sourceSize);
   }
-  else if (q_0_is_nop)
+  else
   {
-    ssInst << q_1_str;
+    hit = false;
   }
-  else if (q_1_is_nop)
+
+  if (hit)
   {
-    ssInst << q_0_str;
+    _instructions.resize(nrOfInstructions);
+    if (nrOfInstructions != 0)
+    {
+      memcpy(&_instructions[0], cacheFile.data() + instructionsOffset,
+             nrOfInstructions * sizeof(qisa_instruction_type));
+    }
+    _nrOfRemovedMaskWords = header[HEADER_NR_OF_REMOVED_MASK_WORDS];
+    _nrOfRelaxedBranches = header[HEADER_NR_OF_RELAXED_BRANCHES];
+    _assemblyCacheHits++;
   }
   else
   {
-    ssInst << q_0_str << " | " << q_1_str;
+    _assemblyCacheMisses++;
   }
 
-  disassembledInst.instruction = ssInst.str();
+  if (_verbose)
+  {
+    std::cout << "QISA-AS: Assembly cache " << (hit ? "hit" : "miss")
+              << " for '" << _filename << "' (" << _assemblyCacheHits << " hits, "
+              << _assemblyCacheMisses << " misses)." << std::endl;
+  }
 
-  return true;
+  return hit;
 }
 
-
-std::string
-QISA_Driver::getLastErrorMessage()
+void
+QISA_Driver::storeCachedAssembly(const std::string& configuration, uint64_t key)
 {
-  std::ostringstream ss;
-  // Start with a new-line, so all lines will be indented properly.
-  ss << std::endl;
-  ss << getErrorSourceLine();
-  ss << std::endl;
-  ss << _errorStream.str();
-  ss << std::endl;
+  const std::string cacheFilename = getAssemblyCacheFilename(key);
 
-  return ss.str();
-}
+  // Write to a temporary file first, and then move it in place.
+  // This way, other drivers (possibly in other processes) never see a partially written file.
+  std::ostringstream ssTmpFilename;
+  ssTmpFilename << cacheFilename << ".tmp"
+                << std::hash<std::thread::id>()(std::this_thread::get_id()) << "-"
+                << std::chrono::steady_clock::now().time_since_epoch().count();
+  const std::string tmpFilename = ssTmpFilename.str();
 
-// Lookup the error location in the source file and return its contents.
-std::string
-QISA_Driver::getErrorSourceLine()
-{
-  unsigned int start_error_line = _errorLoc.begin.line;
-  unsigned int end_error_line = _errorLoc.end.line;
-  unsigned int start_error_column = _errorLoc.begin.column;
-  unsigned int end_error_column = _errorLoc.end.column;
+  std::ofstream cacheFile(tmpFilename, std::ios::out | std::ios::binary);
 
-  if ((start_error_line == 1) &&
-      (end_error_line == 1) &&
-      (start_error_column == 1) &&
-      (end_error_column == 1))
+  const char* source;
+  size_t sourceSize;
+  getSourceCode(source, sourceSize);
+
+  const uint64_t nrOfInstructions = _instructions.size();
+  const uint64_t header[] = { key, nrOfInstructions, _nrOfRemovedMaskWords, _nrOfRelaxedBranches,
+                              configuration.size(), sourceSize };
+
+  cacheFile.write(ASSEMBLY_CACHE_MAGIC, sizeof(ASSEMBLY_CACHE_MAGIC));
+  cacheFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+  cacheFile.write(configuration.data(), configuration.size());
+  cacheFile.write(source, sourceSize);
+  if (nrOfInstructions != 0)
   {
-    // The location has not been initialized.
-    // Return an empty string.
-    return "";
+    cacheFile.write(reinterpret_cast<const char*>(&_instructions[0]),
+                    nrOfInstructions * sizeof(qisa_instruction_type));
   }
+  cacheFile.close();
 
-  bool error_was_on_prev_line = false;
-  if (_errorStream.str().find("syntax error, unexpected NEWLINE") != std::string::npos)
+  if (cacheFile.fail() || (std::rename(tmpFilename.c_str(), cacheFilename.c_str()) != 0))
   {
-    error_was_on_prev_line = true;
-    if ((start_error_line > 1) && (end_error_line > 1))
+    std::remove(tmpFilename.c_str());
+
+    if (_verbose)
     {
-      if (start_error_line == end_error_line)
-      {
-        end_error_line--;
-      }
-      start_error_line--;
+      std::cout << "QISA-AS: Cannot store assembly result in cache file '" << cacheFilename << "'." << std::endl;
     }
   }
+}
 
-  // Add context lines
-  int start_context_line = start_error_line - NUM_CONTEXT_LINES_IN_ERROR_MSG;
-  int end_context_line = end_error_line + NUM_CONTEXT_LINES_IN_ERROR_MSG;
+bool
+QISA_Driver::disassemble(const std::string& filename)
+{
+  // First reset the driver to get a clean start.
+  reset();
 
-  // Adjust start_context_line if it is too small.
-  if (start_context_line < 1)
-    start_context_line = 1;
+  // The input file is mapped into memory (if possible), such that the
+  // instructions can be decoded without copying them first.
+  QISA_MappedFile inputFile;
 
-  // Note that end_context_line may extend past the end of the file...
+  if (!inputFile.open(filename))
+  {
+    error("Cannot open file '" + filename + "'.");
+    return false;
+  }
 
-  std::ostringstream ss;
+  // Check if the input file is empty.
+  // If so, bail out with an error.
+  if (inputFile.size() == 0)
+  {
+    error("File '" + filename + "' is empty!");
+    return false;
+  }
 
-  std::ostringstream ss_pre_context;
-  std::ostringstream ss_error_lines;
-  std::ostringstream ss_marker_line;
-  std::ostringstream ss_post_context;
+  return disassembleInput(inputFile.data(), inputFile.size());
+}
 
-  std::string line;
-  std::string last_error_source_line;
-  size_t line_counter = 0;
+bool
+QISA_Driver::disassembleBuffer(const char* buffer, size_t size)
+{
+  // First reset the driver to get a clean start.
+  reset();
 
-  std::ifstream srcFile (_filename);
-  if (srcFile.is_open())
+  if (size == 0)
   {
-    while ( std::getline (srcFile,line) )
-    {
-      line_counter++;
+    error("Buffer is empty!");
+    return false;
+  }
 
-      if ((line_counter >= (size_t)start_context_line) &&
-          (line_counter <= (size_t)end_context_line))
-      {
-        if (line_counter < start_error_line)
-        {
-          ss_pre_context << std::setfill(' ') << std::setw(8) << line_counter << ": ";
-          ss_pre_context << line << std::endl;
-        }
-        else
-          if ((line_counter >= start_error_line) &&
-              (line_counter <= end_error_line))
-          {
-            last_error_source_line = line;
-            ss_error_lines << std::setfill(' ') << std::setw(8) << line_counter << ": ";
-            ss_error_lines << line << std::endl;
-          }
-          else
-          {
-            ss_post_context << std::setfill(' ') << std::setw(8) << line_counter << ": ";
-            ss_post_context << line << std::endl;
-          }
-      }
-      if (line_counter > (size_t)end_context_line)
-      {
-        break;
-      }
-    }
-    srcFile.close();
+  return disassembleInput(buffer, size);
+}
 
+bool
+QISA_Driver::disassembleInput(const char* input, size_t size)
+{
+  // Note that trailing bytes that do not form a complete instruction are ignored.
+  const size_t nrOfWords = size / sizeof(qisa_instruction_type);
 
-    // Insert a set of carets (^) to show the exact location of the error.
+  bool result;
+  {
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::disassemblyDecodeTime);
 
-    // Special case for when the error was an unexpected NEWLINE.
-    // In that case, we want the error marker (^) to point to the
-    // last valid position on the previous line.
-    if (error_was_on_prev_line)
+    if ((_nrOfDisassemblyThreads != 1) && !_verbose)
     {
-      start_error_column = last_error_source_line.size() + 1;
-
-      // Check if there is a comment character (#) in this line.
-      // Discard everything after that character.
-      size_t comment_pos = last_error_source_line.find("#");
-      if (comment_pos != std::string::npos)
-      {
-        start_error_column = comment_pos + 1;
-      }
-
-      end_error_column = start_error_column + 1;
+      result = disassembleWordsParallel(input, nrOfWords);
     }
-
-    for (unsigned int i = 1; i < end_error_column; i++)
+    else
     {
-      if (i < start_error_column)
-      {
-        if (last_error_source_line[i-1] == '\t')
-        {
-          ss_marker_line << "\t";
-        }
-        else
-        {
-          ss_marker_line << " ";
-        }
-      }
-      else
-      {
-        ss_marker_line << "^";
-      }
+      result = disassembleWords(input, nrOfWords);
     }
-    ss_marker_line << std::endl;
-
-    ss << ss_pre_context.str();
-    ss << "-------------------------------" << std::endl;
-    ss << ss_error_lines.str();
-    // Note: add 10 spaces to account for the line number.
-    ss << "          " << ss_marker_line.str();
-    ss << "-------------------------------" << std::endl;
-    ss << ss_post_context.str();
+  }
 
+  {
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::disassemblyPostProcessTime);
+    postProcessDisassembly();
   }
-  else
+
+  if (_statsEnabled)
   {
-    ss << "<Could not read from file: " << _filename << ">";
+    _stats.nrOfInstructions += nrOfWords;
   }
 
-  return ss.str();
+  // This is for save() to know it has to save disassembly output.
+  _lastDriverAction = DRIVER_ACTION_DISASSEMBLE;
+  return result;
 }
 
-std::string
-QISA_Driver::getVersion()
+bool
+QISA_Driver::disassembleWords(const char* words, size_t nrOfWords, uint64_t firstAddress)
 {
-  return QISA_VERSION_STRING;
-}
-
-std::string
-QISA_Driver::dumpInstructionsSpecification()
-{
-  if (_opcodes.empty())
-  {
-    setOpcodes();
-  }
-
-  std::ostringstream ss;
-  ss << "##################################################" << std::endl;
-  ss << "#                                                #" << std::endl;
-  ss << "#            QISA Opcode Specification           #" << std::endl;
-  ss << "#                                                #" << std::endl;
-  ss << "# Compilation-date: " << __DATE__ << "                  #" << std::endl;
-  ss << "# Compilation-time: " << __TIME__ << "                     #" << std::endl;
-  ss << "#                                                #" << std::endl;
-  ss << "##################################################" << std::endl;
-  ss << std::endl;
-  ss << "#" << std::endl;
-  ss << "# Compiled-in classic instructions" << std::endl;
-  ss << "# (Single Instruction Format)" << std::endl;
-  ss << "#" << std::endl;
-  ss << std::endl;
-
-  std::string opc_str;
-
-  for (auto it : _opcodes)
-  {
-    opc_str = "def_opcode['" + it.first+ "']";
-    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
-  }
-
-  ss << std::endl;
-  ss << "#" << std::endl;
-  ss << "# Configured quantum instructions" << std::endl;
-  ss << "# (Double Instruction Format)" << std::endl;
-  ss << "#" << std::endl;
+  // Assume no errors while disassembling.
+  bool result = true;
 
-  ss << std::endl;
-  ss << "# No arguments" << std::endl;
-  ss << "# (def_q_arg_none)" << std::endl;
+  // The disassembled instructions are stored by address.
+  _disassembledInstructions.resize(nrOfWords);
 
-  for (auto it : _q_inst_arg_none_opcodes)
+  for (size_t i = 0; i < nrOfWords; i++)
   {
-    opc_str = "def_q_arg_none['" + it.first + "']";
-    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
-  }
+    const uint64_t address = firstAddress + i;
 
-  ss << std::endl;
-  ss << "# Uses 'S' register as parameter" << std::endl;
-  ss << "# (def_q_arg_st)" << std::endl;
+    // The words are not necessarily aligned, so copy them out.
+    qisa_instruction_type inst;
+    memcpy(&inst, words + i * sizeof(qisa_instruction_type), sizeof(qisa_instruction_type));
 
-  for (auto it : _q_inst_arg_st_opcodes)
-  {
-    opc_str = "def_q_arg_st['" + it.first + "']";
-    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
-  }
+    if (_verbose)
+    {
+      std::bitset<sizeof(qisa_instruction_type)*8> binary(inst);
+      std::cout << "Input instruction: " << getHex(inst, 8)
+                << " (" << binary << ")" << std::endl;
+    }
 
-  ss << std::endl;
-  ss << "# Uses 'T' register as parameter" << std::endl;
-  ss << "# (def_q_arg_tt)" << std::endl;
+    DisassembledInstruction& disassembledInstruction = _disassembledInstructions[i];
 
-  for (auto it : _q_inst_arg_tt_opcodes)
-  {
-    opc_str = "def_q_arg_tt['" + it.first + "']";
-    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
+    if (decodeWord(inst, address, disassembledInstruction))
+    {
+      recordDisassembledInstruction(disassembledInstruction);
+    }
+    else
+    {
+      result = false;
+    }
   }
 
-  return ss.str();
+  return result;
 }
 
-
-
-void
-QISA_Driver::enableScannerTracing(bool enabled)
+bool
+QISA_Driver::decodeWord(qisa_instruction_type inst, uint64_t address, DisassembledInstruction& disassembledInstruction)
 {
-  _traceScanning = enabled;
-}
+  disassembledInstruction.address = address;
+  disassembledInstruction.hexCode = getHex(inst, 8);
+  disassembledInstruction.label.clear();
+  disassembledInstruction.instruction.clear();
+  disassembledInstruction.isBranch = false;
+  disassembledInstruction.branchDestination = 0;
+
+  if (!disassembleInstruction(inst, disassembledInstruction))
+  {
+    _errorStream << "Error while disassembling instruction "
+                 << disassembledInstruction.hexCode
+                 <<  ", instructionCount = " << address;
+    _errorLoc = location();
+    return false;
+  }
 
-void
-QISA_Driver::enableParserTracing(bool enabled)
-{
-  _traceParsing = enabled;
+  return true;
 }
 
 void
-QISA_Driver::setVerbose(bool verbose)
+QISA_Driver::recordDisassembledInstruction(const DisassembledInstruction& disassembledInstruction)
 {
-  _verbose = verbose;
-}
+  const size_t instructionLength = disassembledInstruction.instruction.size();
 
-void
-QISA_Driver::error(const location& l, const std::string& m)
-{
-  _errorStream << _filename << ":" << l << ": " << m << std::endl;
-  _errorLoc = l;
-}
+  if (disassembledInstruction.isBranch)
+  {
+    _disassemblyLabels[disassembledInstruction.branchDestination].push_back(disassembledInstruction.address);
 
-void
-QISA_Driver::error(const std::string& m)
-{
-  _errorStream << m << std::endl;
-  _errorLoc = location();
+    // The name of the label is not known yet, but all labels have the same length.
+    // So leave it out here, it is added by getDisassemblyLineLength().
+    const int64_t offset = disassembledInstruction.branchDestination - disassembledInstruction.address;
+    const size_t branchLength = instructionLength + getBranchLabelComment("", offset).size();
+
+    if (_disassemblyMaxBranchLength < branchLength)
+    {
+      _disassemblyMaxBranchLength = branchLength;
+    }
+  }
+  else if (_disassemblyMaxInstructionLength < instructionLength)
+  {
+    _disassemblyMaxInstructionLength = instructionLength;
+  }
 }
 
-void
-QISA_Driver::addSpecificErrorMessage(const std::string& msg)
+std::string
+QISA_Driver::getBranchLabelComment(const std::string& labelName, int64_t offset)
 {
-  _errorStream << msg << std::endl;
+  return ", " + labelName + " # offset(" + (offset >= 0 ? "+" : "") + std::to_string(offset) + ")";
 }
 
-void
-QISA_Driver::addExpectationErrorMessage(const std::string& expected_item)
+size_t
+QISA_Driver::getDisassemblyLineLength()
 {
-  if (_errorStream.str().find(", expecting") == std::string::npos)
+  // Only output format 2 aligns the instruction hex code comment.
+  if (_disassemblyFormatId != 2)
   {
-    addSpecificErrorMessage("ERROR DETECTED: Expected " + expected_item + " here");
+    return 0;
   }
-}
 
-void
-QISA_Driver::addExpectedConditionErrorMessage()
-{
-  if (_errorStream.str().find(", expecting") == std::string::npos)
+  size_t maxDisassemblyLineLength = _disassemblyMaxInstructionLength;
+
+  if (!_disassemblyLabels.empty())
   {
-    std::ostringstream ss;
-    ss << std::endl;
-    ss << "ERROR DETECTED: Expected a CONDITION here." << std::endl;
-    ss << "Valid conditions are:" << std::endl;
-    for (auto it = _branchConditionNames.begin(); it != _branchConditionNames.end(); ++it)
-    {
-      ss << "  " << it->second << std::endl;
-    }
-    ss << std::endl;
-    ss << "Valid condition ALIASES are:" << std::endl;
-    for (auto it = _branchConditionAliases.begin(); it != _branchConditionAliases.end(); ++it)
+    // Add the length of the label names to the branch instructions.
+    // Leave out the ": " that follows a label.
+    const size_t labelNameLength = _disassemblyLabelStringLength - 2;
+
+    if (maxDisassemblyLineLength < _disassemblyMaxBranchLength + labelNameLength)
     {
-      ss << "  " << std::setw(9) << std::left << it->first << ": aliased to: " << _branchConditionNames[it->second] << std::endl;
+      maxDisassemblyLineLength = _disassemblyMaxBranchLength + labelNameLength;
     }
-
-    addSpecificErrorMessage(ss.str());
   }
-}
-
-
-void
-QISA_Driver::add_symbol(const std::string& symbol_name,
-                        const QISA::location& symbol_name_loc,
-                        int64_t symbol_value,
-                        const QISA::location& symbol_value_loc)
-{
-  if (_verbose)
-      std::cout <<  "          "
-                << "ADD_SYMBOL[int](name='" << symbol_name << "', val=" << symbol_value << ");" << std::endl;
 
-  // Note that if a symbol already exists, its value will be overwritten.
-  _intSymbols[symbol_name] = symbol_value;
+  // Add 4 to leave some space between the end of the instruction text
+  // and the start of the hex code.
+  maxDisassemblyLineLength += 4;
+  // Add the label string length to it.
+  // This will be zero when no branch instructions were used.
+  maxDisassemblyLineLength += _disassemblyLabelStringLength;
 
+  return maxDisassemblyLineLength;
 }
 
 bool
-QISA_Driver::get_symbol(const std::string& symbol_name,
-                        const QISA::location& symbol_name_loc,
-                        int64_t& imm_val)
+QISA_Driver::disassembleTo(const std::string& filename, std::ostream& os)
 {
-  if (_verbose)
-      std::cout <<  "          "
-                << "GET_SYMBOL[int](name='" << symbol_name << "');" << std::endl;
+  // First reset the driver to get a clean start.
+  reset();
 
-  auto findIt = _intSymbols.find(symbol_name);
+  QISA_MappedFile inputFile;
 
-  if (findIt == _intSymbols.end())
+  if (!inputFile.open(filename))
   {
-    _errorStream << symbol_name_loc << ": symbol '" << symbol_name << "' not found" << std::endl;
-    _errorLoc = symbol_name_loc;
+    error("Cannot open file '" + filename + "'.");
     return false;
   }
 
-  imm_val = findIt->second;
-  return true;
-}
+  // Check if the input file is empty.
+  // If so, bail out with an error.
+  if (inputFile.size() == 0)
+  {
+    error("File '" + filename + "' is empty!");
+    return false;
+  }
 
-// Add a string valued symbol (not used yet).
-void
-QISA_Driver::add_symbol(const std::string& symbol_name,
-                        const QISA::location& symbol_name_loc,
-                        const std::string&  symbol_value,
-                        const QISA::location& symbol_value_loc)
-{
-  if (_verbose)
-      std::cout <<  "          "
-                << "ADD_SYMBOL[str](name='" << symbol_name << "', val=" << symbol_value << ");" << std::endl;
-  _strSymbols[symbol_name] = symbol_value;
-}
+  // Note that trailing bytes that do not form a complete instruction are ignored.
+  const char* words = inputFile.data();
+  const size_t nrOfWords = inputFile.size() / sizeof(qisa_instruction_type);
 
+  // Assume no errors while disassembling.
+  bool result = true;
 
-bool
-QISA_Driver::get_symbol(const std::string& symbol_name,
-                        const QISA::location& symbol_name_loc,
-                        std::string& imm_val)
-{
-  if (_verbose)
-      std::cout <<  "          "
-                << "GET_SYMBOL[str](name='" << symbol_name << "');" << std::endl;
+  // Only one instruction is kept in memory at a time.
+  DisassembledInstruction disassembledInstruction;
+  qisa_instruction_type inst;
 
-  auto findIt = _strSymbols.find(symbol_name);
+  // First pass: find the branch destinations and the width of the instruction texts.
+  {
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::disassemblyDecodeTime);
+
+    for (size_t address = 0; address < nrOfWords; address++)
+    {
+      memcpy(&inst, words + address * sizeof(qisa_instruction_type), sizeof(qisa_instruction_type));
+
+      if (_verbose)
+      {
+        std::bitset<sizeof(qisa_instruction_type)*8> binary(inst);
+        std::cout << "Input instruction: " << getHex(inst, 8)
+                  << " (" << binary << ")" << std::endl;
+      }
+
+      if (decodeWord(inst, address, disassembledInstruction))
+      {
+        recordDisassembledInstruction(disassembledInstruction);
+      }
+      else
+      {
+        result = false;
+      }
+    }
+  }
 
-  if (findIt == _strSymbols.end())
+  std::map<uint64_t, std::string> dest2LabelMap;
   {
-    _errorStream << symbol_name_loc << ": symbol '" << symbol_name << "' not found" << std::endl;
-    _errorLoc = symbol_name_loc;
-    return false;
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::disassemblyPostProcessTime);
+    nameDisassemblyLabels(dest2LabelMap);
   }
+  const std::string emptyLabel(_disassemblyLabelStringLength, ' ');
 
-  imm_val = findIt->second;
-  return true;
-}
+  const size_t maxDisassemblyLineLength = getDisassemblyLineLength();
 
-// Add a register definition.
-// This is used to give a register a meaningful name.
-bool
-QISA_Driver::add_register_definition(const std::string& register_name,
-                                     const QISA::location& register_name_loc,
-                                     uint8_t reg_nr,
-                                     const QISA::location& reg_nr_loc,
-                                     RegisterKind register_kind)
-{
-  if (_verbose)
-      std::cout << "          "
-                << "DEFINE_REG(name='" << register_name
-                << "', reg=" << _registerName[register_kind] << (int)reg_nr << ");" << std::endl;
+  // Second pass: decode the instructions again and write them out.
+  // The errors have already been reported by the first pass.
+  const std::string errors = _errorStream.str();
 
-  if (!checkRegisterNumber(reg_nr, reg_nr_loc, register_kind))
   {
-    return false;
+    QISA_StatsTimer timer(activeStats(), &QISA_Stats::outputFormatTime);
+
+    for (size_t address = 0; address < nrOfWords; address++)
+    {
+      memcpy(&inst, words + address * sizeof(qisa_instruction_type), sizeof(qisa_instruction_type));
+
+      decodeWord(inst, address, disassembledInstruction);
+
+      if (!_disassemblyLabels.empty())
+      {
+        applyDisassemblyLabel(disassembledInstruction, dest2LabelMap, emptyLabel);
+      }
+
+      writeDisassembledInstruction(os, disassembledInstruction, maxDisassemblyLineLength);
+    }
   }
 
-  _registerAliases[register_kind][register_name] = reg_nr;
-  return true;
+  _errorStream.str("");
+  _errorStream << errors;
+
+  if (_statsEnabled)
+  {
+    _stats.nrOfInstructions += nrOfWords;
+  }
+
+  if (os.fail())
+  {
+    error("Error occurred while writing disassembly output to output stream");
+    return false;
+  }
 
+  return result;
 }
 
 bool
-QISA_Driver::get_register_nr(const std::string& register_name,
-                             const QISA::location& register_name_loc,
-                             RegisterKind register_kind,
-                             uint8_t& result)
+QISA_Driver::disassembleWordsParallel(const char* words, size_t nrOfWords)
 {
-  if (_verbose)
-      std::cout <<  "          "
-                << "GET_REG(name='" << register_name << "');" << std::endl;
+  QISA_WorkPool pool(_nrOfDisassemblyThreads);
 
-  auto findIt = _registerAliases[register_kind].find(register_name);
+  // Splitting only pays off for large inputs.
+  static const size_t MIN_WORDS_PER_CHUNK = 16384;
 
-  if (findIt == _registerAliases[register_kind].end())
+  if ((pool.nrOfThreads() == 1) || (nrOfWords < 2 * MIN_WORDS_PER_CHUNK))
   {
-    _errorStream << register_name_loc << ": '"
-                 << _registerName[register_kind]
-                 << "' register named '" << register_name
-                 << "' not found" << std::endl;
-    _errorLoc = register_name_loc;
-    return false;
+    return disassembleWords(words, nrOfWords);
   }
 
-  result = findIt->second;
-  return true;
-}
+  // Use a few chunks per thread, to keep all threads busy until the end.
+  size_t nrOfChunks = 4 * pool.nrOfThreads();
+  if (nrOfWords / nrOfChunks < MIN_WORDS_PER_CHUNK)
+  {
+    nrOfChunks = nrOfWords / MIN_WORDS_PER_CHUNK;
+  }
 
-void
-QISA_Driver::add_label(const std::string& label_name,
-                       const QISA::location& label_name_loc)
-{
-  if (_verbose)
-      std::cout <<  "          "
-                << "ADD_LABEL(name='" << label_name << "') -> addr=" << _instructions.size() << ";" << std::endl;
-  _labels[label_name] = _instructions.size();
-}
+  // The results of a chunk, which are merged after all chunks have been decoded.
+  struct ChunkResult
+  {
+    bool result;
+    std::vector<DisassembledInstruction> instructions;
+    std::map<uint64_t, std::vector<uint64_t> > labels;
+    std::string errors;
+  };
 
-int64_t
-QISA_Driver::get_label_address(const std::string& label_name,
-                               const QISA::location& label_name_loc,
-                               bool get_offset)
-{
-  if (_verbose)
-      std::cout <<  "          "
-                << "GET_LABEL_ADDRESS(name='" << label_name << "');" << std::endl;
+  std::vector<ChunkResult> chunkResults(nrOfChunks);
 
+  // Each worker decodes its chunks with its own driver, such that the
+  // decoding state (labels, error messages) is not shared between threads.
+  std::vector<QISA_Driver> workers(pool.nrOfThreads());
+  for (auto& worker : workers)
+  {
+    worker.configureFrom(*this);
+  }
 
-  const uint64_t programCounter = _instructions.size();
+  pool.run(nrOfChunks, [&](size_t chunkIndex, unsigned workerIndex)
+  {
+    QISA_Driver& worker = workers[workerIndex];
+    ChunkResult& chunkResult = chunkResults[chunkIndex];
 
-  int64_t result;
+    const size_t first = (nrOfWords * chunkIndex) / nrOfChunks;
+    const size_t last = (nrOfWords * (chunkIndex + 1)) / nrOfChunks;
 
-  auto findIt = _labels.find(label_name);
+    chunkResult.result = worker.disassembleWords(words + first * sizeof(qisa_instruction_type),
+                                                 last - first, first);
+
+    // Take over the results, leaving the worker clean for its next chunk.
+    chunkResult.instructions.swap(worker._disassembledInstructions);
+    chunkResult.labels.swap(worker._disassemblyLabels);
+    chunkResult.errors = worker._errorStream.str();
 
-  if (findIt == _labels.end())
+    worker._disassembledInstructions.clear();
+    worker._disassemblyLabels.clear();
+    worker._errorStream.str("");
+  });
+
+  // The widths of the instruction texts are kept per worker.
+  for (const auto& worker : workers)
   {
-    // This label has not yet been defined.
-    // Record all information that is necessary to assemble the instruction that uses this label after the
-    // whole source file has been processed.
+    _disassemblyMaxInstructionLength = std::max(_disassemblyMaxInstructionLength,
+                                                worker._disassemblyMaxInstructionLength);
+    _disassemblyMaxBranchLength = std::max(_disassemblyMaxBranchLength,
+                                           worker._disassemblyMaxBranchLength);
+  }
 
-    DeferredLabelUse deferred;
+  // Merge the results of the chunks, in address order.
+  bool result = true;
 
-    // The instruction type (token) and programCounter will be set when the instruction
-    // on the current line will be handled.
-    deferred.is_offset = get_offset;
-    deferred.label_name = label_name;
-    deferred.label_name_loc = label_name_loc;
+  _disassembledInstructions.clear();
+  _disassembledInstructions.reserve(nrOfWords);
 
-    // Check if a label has already been used in the current instruction.
-    auto itDeferred = _deferredInstructions.find(label_name_loc);
+  for (auto& chunkResult : chunkResults)
+  {
+    result = result && chunkResult.result;
 
-    if (itDeferred == _deferredInstructions.end())
-    {
-      // If not, add this deferred label use to the deferred instruction map.
+    std::move(chunkResult.instructions.begin(), chunkResult.instructions.end(),
+              std::back_inserter(_disassembledInstructions));
 
-      _deferredInstructions[label_name_loc] = std::move(deferred);
-    }
-    else
+    // Branches in later chunks have higher addresses, so appending keeps
+    // the branch instructions per destination in order.
+    for (auto& label : chunkResult.labels)
     {
-      // Another label has already been used in this instruction.
-      // To indicate this error, modify the original label name and set the location to the offending label.
-      itDeferred->second.label_name = "<<MULTI_LABEL_ERROR>>";
-      itDeferred->second.label_name_loc = label_name_loc;
+      std::vector<uint64_t>& branches = _disassemblyLabels[label.first];
+      branches.insert(branches.end(), label.second.begin(), label.second.end());
     }
 
-    // This should be a non-sensical return value...
-    result = std::numeric_limits<int64_t>::min();
-
-    if (_verbose)
-        std::cout << "          "
-                  << "    GET_LABEL_ADDRESS didn't find label '" << label_name << "' (yet)" << std::endl;
+    _errorStream << chunkResult.errors;
   }
-  else
+
+  if (!result)
   {
-    if (_verbose)
-        std::cout << "          "
-                  << "    GET_LABEL_ADDRESS found label: '" << findIt->first << "', address=: " << findIt->second << std::endl;
-    if (get_offset)
-    {
-      result = findIt->second - programCounter;
-    }
-    else
-    {
-      result = findIt->second;
-    }
+    _errorLoc = location();
   }
 
   return result;
 }
 
-bool
-QISA_Driver::get_opcode(const std::string& instruction_name,
-                        const QISA::location& instruction_name_loc,
-                        int& opcode,
-                        QISA_InstructionKind instruction_kind)
+void
+QISA_Driver::postProcessDisassembly()
 {
-  const std::map<std::string, int>* opCodeMap;
-
-  switch (instruction_kind) {
-  case IK_SINGLE_FORMAT:
-    opCodeMap = &_opcodes;
-    break;
-  case IK_DF_ARG_NONE:
-    opCodeMap = &_q_inst_arg_none_opcodes;
-    break;
-  case IK_DF_ARG_ST:
-    opCodeMap = &_q_inst_arg_st_opcodes;
-    break;
-  case IK_DF_ARG_TT:
-    opCodeMap = &_q_inst_arg_tt_opcodes;
-    break;
-  }
-
-  std::string searchString(instruction_name);
-
-  // Make the instruction name uppercase.
-  // https://stackoverflow.com/a/17793588
-  for (auto & c: searchString) c = toupper((unsigned char)c);
+  if (_verbose)
+    std::cout << "DISASSEMBLY POST-PROCESS" << std::endl;
 
-  auto findIt = opCodeMap->find(searchString);
+  // Create a map from the used branch destination to label with an index.
+  std::map<uint64_t, std::string> dest2LabelMap;
+  nameDisassemblyLabels(dest2LabelMap);
 
-  if (findIt == opCodeMap->end())
+  // Only do the following in case labels have been used.
+  if (!_disassemblyLabels.empty())
   {
-    // The opcode of the requested instruction kind has not been found.
-    // Check if it is specified in one of the other opcode maps.
-    // If so, the user has mixed up his parameters, so give him a hint about that.
+    // Used to get the correct indentation in case there is no label.
+    std::string emptyLabel(_disassemblyLabelStringLength, ' ');
 
-    if ((instruction_kind != IK_SINGLE_FORMAT) &&
-        _opcodes.find(searchString) != _opcodes.end())
-    {
-      _errorStream << instruction_name_loc << ": "
-                   << "Classic instruction '" << instruction_name
-                   << "' used instead of a quantum instruction. "
-                   << std::endl;
-    }
-    else if ((instruction_kind != IK_DF_ARG_NONE) &&
-        _q_inst_arg_none_opcodes.find(searchString) != _q_inst_arg_none_opcodes.end())
+    if (_verbose)
     {
-      _errorStream << instruction_name_loc << ": "
-                   << "Instruction '" << instruction_name
-                   << "' takes no parameters."
-                   << std::endl;
+      size_t nrOfBranchInstructions = 0;
+      for (const auto& it : _disassemblyLabels)
+      {
+        nrOfBranchInstructions += it.second.size();
+      }
 
+      std::cout << "Processing " << nrOfBranchInstructions << " branch instructions..." << std::endl;
     }
-    else if ((instruction_kind != IK_DF_ARG_ST) &&
-        _q_inst_arg_st_opcodes.find(searchString) != _q_inst_arg_st_opcodes.end())
-    {
-      _errorStream << instruction_name_loc << ": "
-                   << "Instruction '" << instruction_name
-                   << "' needs an S-register argument."
-                   << std::endl;
-    }
-    else if ((instruction_kind != IK_DF_ARG_TT) &&
-        _q_inst_arg_tt_opcodes.find(searchString) != _q_inst_arg_tt_opcodes.end())
-    {
-      _errorStream << instruction_name_loc << ": "
-                   << "Instruction '" << instruction_name
-                   << "' needs a T-register argument."
-                   << std::endl;
-    }
-    else
+
+    // Add the labels to the instructions in range [first, last).
+    // The map is only read here, so several ranges can be processed in parallel.
+    auto addLabels = [&](size_t first, size_t last)
     {
-      _errorStream << instruction_name_loc << ": opcode for '" << instruction_name << "' not found" << std::endl;
-    }
+      for (size_t i = first; i < last; i++)
+      {
+        applyDisassemblyLabel(_disassembledInstructions[i], dest2LabelMap, emptyLabel);
+      }
+    };
 
-    _errorLoc = instruction_name_loc;
-    return false;
+    forEachDisassemblyRange(addLabels);
   }
-
-  opcode = findIt->second;
-  return true;
 }
 
-// Assembly generation functions.
-
-/* nop */
-bool
-QISA_Driver::generate_NOP(const QISA::location& inst_loc)
+void
+QISA_Driver::nameDisassemblyLabels(std::map<uint64_t, std::string>& dest2LabelMap)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "NOP();" << std::endl;
-  int opcode;
+  // This will be set to the actual label length in case branch
+  // instructions are used.
+  _disassemblyLabelStringLength = 0;
 
-  if (!get_opcode("NOP", inst_loc, opcode))
+  if (_disassemblyLabels.empty())
   {
-    return false;
+    return;
   }
 
-  qisa_instruction_type instruction = (((opcode & OPCODE_MASK) & OPCODE_MASK) << OPCODE_OFFSET);
-
-  _instructions.emplace_back(instruction);
-  return true;
-}
+  int labelCounter = 0;
 
+  const int nrOfDigitsPerLabel = getNrOfDisassemblyLabelDigits(_disassemblyLabels.size());
 
-/* stop */
-bool
-QISA_Driver::generate_STOP(const QISA::location& inst_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "STOP();" << std::endl;
-  int opcode;
+  // Used to get the correct indentation in case there is no label.
+  // The extra spaces (+ 2) are for the ": " that come after a 'full' label.
+  _disassemblyLabelStringLength = strlen(DISASSEMBLY_LABEL_PREFIX) + nrOfDigitsPerLabel + 2;
 
-  if (!get_opcode("STOP", inst_loc, opcode))
+  // Determine the name of the labels.
+  for (const auto& it : _disassemblyLabels)
   {
-    return false;
-  }
+    std::ostringstream ssLabel;
 
-  qisa_instruction_type instruction = (((opcode & OPCODE_MASK) & OPCODE_MASK) << OPCODE_OFFSET);
-
-  _instructions.emplace_back(instruction);
-  return true;
+    ssLabel << DISASSEMBLY_LABEL_PREFIX << std::setw(nrOfDigitsPerLabel) << std::setfill('0') << labelCounter;
+    dest2LabelMap.emplace_hint(dest2LabelMap.end(), it.first, ssLabel.str());
+    labelCounter++;
+  }
 }
 
-/* add rd, rs, rt */
-/* sub rd, rs, rt */
-/* and rd, rs, rt */
-/* or  rd, rs, rt */
-/* xor rd, rs, rt */
-bool
-QISA_Driver::generate_XXX_rd_rs_rt(const std::string& inst_name,
-                                   const QISA::location& inst_loc,
-                                   uint8_t rd,
-                                   const QISA::location& rd_loc,
-                                   uint8_t rs,
-                                   const QISA::location& rs_loc,
-                                   uint8_t rt,
-                                   const QISA::location& rt_loc)
+int
+QISA_Driver::getNrOfDisassemblyLabelDigits(size_t nrOfLabels)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << inst_name << "(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
-
-  int opcode;
+  // Calculate the number of digits needed to print the labels.
+  // Source: https://stackoverflow.com/a/1489861
+  int nrOfDigitsPerLabel = 0;
 
-  if (!get_opcode(inst_name, inst_loc, opcode))
+  while (nrOfLabels != 0)
   {
-    return false;
+    nrOfLabels /= 10;
+    nrOfDigitsPerLabel++;
   }
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
-  {
-    return false;
-  }
-  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  return nrOfDigitsPerLabel;
+}
+
+void
+QISA_Driver::applyDisassemblyLabel(DisassembledInstruction& disassembledInstruction,
+                                   const std::map<uint64_t, std::string>& dest2LabelMap,
+                                   const std::string& emptyLabel)
+{
+  // If this is a branch destination, prepend the label instruction;
+  auto itDest = dest2LabelMap.find(disassembledInstruction.address);
+  if (itDest != dest2LabelMap.end())
   {
-    return false;
+    disassembledInstruction.label = itDest->second + ": ";
   }
-  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+  else
   {
-    return false;
+    // Else, just use spaces instead.
+    disassembledInstruction.label = emptyLabel;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | ((rs & RS_MASK) << RS_OFFSET)
-                                      | ((rt & RT_MASK) << RT_OFFSET);
+  // If this is a branch instruction, emit its corresponding label and offset as comment.
+  if (disassembledInstruction.isBranch)
+  {
+    const int64_t offset = disassembledInstruction.branchDestination - disassembledInstruction.address;
 
-  _instructions.emplace_back(instruction);
-  return true;
+    disassembledInstruction.instruction +=
+      getBranchLabelComment(dest2LabelMap.at(disassembledInstruction.branchDestination), offset);
+  }
 }
 
-/* not rd, rt */
-bool QISA_Driver::generate_NOT(const location& inst_loc,
-                               uint8_t rd,
-                               const location& rd_loc,
-                               uint8_t rt,
-                               const location& rt_loc)
+void
+QISA_Driver::forEachDisassemblyRange(const std::function<void(size_t, size_t)>& process)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "NOT(rd=" << (int)rd << ",rt=" << (int)rt << ");" << std::endl;
+  const size_t nrOfInstructions = _disassembledInstructions.size();
 
-  int opcode;
+  QISA_WorkPool pool(_nrOfDisassemblyThreads);
 
-  if (!get_opcode("NOT", inst_loc, opcode))
-  {
-    return false;
-  }
+  // Splitting only pays off for large inputs.
+  static const size_t MIN_INSTRUCTIONS_PER_RANGE = 16384;
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  if ((pool.nrOfThreads() == 1) || (nrOfInstructions < 2 * MIN_INSTRUCTIONS_PER_RANGE))
   {
-    return false;
+    process(0, nrOfInstructions);
+    return;
   }
-  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+
+  size_t nrOfRanges = 4 * pool.nrOfThreads();
+  if (nrOfInstructions / nrOfRanges < MIN_INSTRUCTIONS_PER_RANGE)
   {
-    return false;
+    nrOfRanges = nrOfInstructions / MIN_INSTRUCTIONS_PER_RANGE;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | ((rt & RT_MASK) << RT_OFFSET);
-
-  _instructions.emplace_back(instruction);
-  return true;
-
+  pool.run(nrOfRanges, [&](size_t rangeIndex, unsigned)
+  {
+    process((nrOfInstructions * rangeIndex) / nrOfRanges,
+            (nrOfInstructions * (rangeIndex + 1)) / nrOfRanges);
+  });
 }
 
-/* cmp rs,rt */
-bool
-QISA_Driver::generate_CMP(const QISA::location& inst_loc,
-                          uint8_t rs,
-                          const QISA::location& rs_loc,
-                          uint8_t rt,
-                          const QISA::location& rt_loc)
+std::string
+QISA_Driver::getHex(uint64_t val, int nDigits)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "CMP(rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
-
-  int opcode;
+  static const char hexDigits[] = "0123456789abcdef";
 
-  if (!get_opcode("CMP", inst_loc, opcode))
+  // Number of digits needed to represent the value.
+  int nrOfDigits = 1;
+  for (uint64_t rest = val >> 4; rest != 0; rest >>= 4)
   {
-    return false;
+    nrOfDigits++;
   }
 
-  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  // Pad with zeroes up to the requested number of digits.
+  if (nrOfDigits < nDigits)
   {
-    return false;
+    nrOfDigits = nDigits;
   }
-  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+
+  std::string result(2 + nrOfDigits, '0');
+  result[1] = 'x';
+
+  for (int i = 1 + nrOfDigits; val != 0; i--)
   {
-    return false;
+    result[i] = hexDigits[val & 0xf];
+    val >>= 4;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rs & RS_MASK) << RS_OFFSET)
-                                      | ((rt & RT_MASK) << RT_OFFSET);
-
-  _instructions.emplace_back(instruction);
-  return true;
+  return result;
 }
 
-/* br cond, addr */
 bool
-QISA_Driver::generate_BR(const location& inst_loc,
-                         uint8_t cond,
-                         const location& cond_loc,
-                         int64_t addr,
-                         const location& addr_loc,
-                         bool is_alias)
+QISA_Driver::disassembleInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "BR(cond='" << _branchConditionNames[cond] << "',addr=" << addr << ");" << std::endl;
+  if (inst & (1L << DBL_INST_FORMAT_BIT_OFFSET))
+  {
+    return disassembleQuantumInstruction(inst, disassembledInst);
+  }
+  else
+  {
+    // A quantum bundle ends when a non-bundle instruction is encountered.
+    if (_disassemblyStartedQuantumBundle)
+    {
+      _disassemblyStartedQuantumBundle = false;
+    }
 
-  int opcode;
+    return disassembleClassicInstruction(inst, disassembledInst);
+  }
+}
 
-  if (!get_opcode("BR", inst_loc, opcode))
+bool
+QISA_Driver::disassembleClassicInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
+{
+  int opc= (inst >> OPCODE_OFFSET) & OPCODE_MASK;
+
+  // We don't deal with source code here, but want to use the checking
+  // functions that are also used within the parser.
+  // Define an empty location that we will use with these checking functions.
+  location errLoc = location();
+
+  // The decode table tells how to decode the instruction, without having to
+  // look up and compare its name.
+  const ClassicDecodeEntry& decodeEntry = _classicDecodeTable[opc];
+
+  if (decodeEntry.kind == CLASSIC_DECODE_UNKNOWN)
   {
+    _errorStream << "Unknown opcode: " << getHex(opc, 2);
+    _errorLoc = errLoc;
     return false;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | (cond & COND_MASK);
+  const std::string& inst_name = decodeEntry.name;
 
+  std::string instText;
 
-  // Handle the label part.
-  // If the label is not yet defined, we will handle it later.
-  if (addr != std::numeric_limits<int64_t>::min())
+  switch (decodeEntry.kind)
   {
-    // The offset is based on the current program counter.
+    case CLASSIC_DECODE_NO_ARGS:
+    {
+      instText = inst_name;
+      break;
+    }
 
-    // An offset is encoded using 21 bits (signed).
-    // Check if the given value is within this range.
+    case CLASSIC_DECODE_RD_RS_RT:
+    {
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
 
-    const int64_t minOffset = -(1LL<<20) + 1;
-    const int64_t maxOffset =  (1LL<<20) - 1;
+      const int rs = (inst >> RS_OFFSET) & RS_MASK;
+      if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
 
-    if (!checkValueRange(addr, minOffset, maxOffset, "addr", addr_loc))
+      const int rt = (inst >> RT_OFFSET) & RT_MASK;
+      if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+
+      instText = inst_name + " R" + std::to_string(rd) +
+                 ", R" + std::to_string(rs) +
+                 ", R" + std::to_string(rt);
+      break;
+    }
+
+    case CLASSIC_DECODE_NOT:
     {
-      return false;
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+
+      const int rt = (inst >> RT_OFFSET) & RT_MASK;
+      if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+
+      instText = inst_name + " R" + std::to_string(rd) + ", R" + std::to_string(rt);
+      break;
     }
 
-    if (is_alias)
+    case CLASSIC_DECODE_CMP:
     {
-      // Correct for the implicit CMP instruction that precedes the actual branch instruction.
-      if (addr < 0)
+      const int rs = (inst >> RS_OFFSET) & RS_MASK;
+      if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
+
+      const int rt = (inst >> RT_OFFSET) & RT_MASK;
+      if (!checkRegisterNumber(rt, errLoc, R_REGISTER)) return false;
+
+      instText = inst_name + " R" + std::to_string(rs) + ", R" + std::to_string(rt);
+      break;
+    }
+
+    case CLASSIC_DECODE_BR:
+    {
+      const int cond = inst & COND_MASK;
+
+      if (_branchConditionNames.find(cond) == _branchConditionNames.end())
       {
-        addr--;
+        _errorStream << "Unknown branch condition: " << getHex(cond, 2);
+        _errorLoc = location();
+        return false;
       }
-      else
+
+      const int addr = (inst >> ADDR_OFFSET) & ADDR_MASK;
+
+      // Sign extend the address, which is an offset relative to the current instruction counter.
+      // Source: http://graphics.stanford.edu/~seander/bithacks.html#FixedSignExtend
+      struct {signed int x:21;} s;
+      const int addr_offset = s.x = addr;
+
+      const uint64_t dest_address = disassembledInst.address + addr_offset;
+
+      // Mark the fact that this instruction is a branch instruction
+      // that will need to address a label.
+      disassembledInst.isBranch = true;
+      disassembledInst.branchDestination = dest_address;
+
+      // The labels will be added afterwards.
+      instText = inst_name + " " + _branchConditionNames[cond];
+      break;
+    }
+
+    case CLASSIC_DECODE_LDI:
+    {
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+
+      const int imm = inst & IMM20_MASK;
+
+      // Sign extend the immediate value.
+      struct {signed int x:20;} s;
+      const int signed_imm= s.x = imm;
+
+      instText = inst_name + " R" + std::to_string(rd) + ", " +
+                 getHex(signed_imm, 5) + " # dec(" +
+                 std::to_string(signed_imm) + ")";
+      break;
+    }
+
+    case CLASSIC_DECODE_LDUI:
+    {
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+
+      const int imm = inst & U_IMM15_MASK;
+
+      instText = inst_name + " R" + std::to_string(rd) + ", " +
+                 getHex(imm, 4) + " # dec(" +
+                 std::to_string(imm) + ")";
+      break;
+    }
+
+    case CLASSIC_DECODE_FBR:
+    {
+      const int cond = inst & COND_MASK;
+
+      if (_branchConditionNames.find(cond) == _branchConditionNames.end())
       {
-        // The positive case is already been handled implicitely by the fact that
-        // the program counter already advanced by one due to the CMP instruction.
+        _errorStream << "Unknown branch condition: " << getHex(cond, 2);
+        _errorLoc = location();
+        return false;
       }
-    }
 
-    instruction |= ((addr & ADDR_MASK) << ADDR_OFFSET);
-  }
-  else
-  {
-    // A deferred instruction has been created in the attempt to resolve a label.
-    // Locate this and set the instruction type.
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
 
-    auto findIt = _deferredInstructions.find(addr_loc);
-    if (findIt == _deferredInstructions.end())
+      instText = inst_name + " " + _branchConditionNames[cond] + ", R" + std::to_string(rd);
+      break;
+    }
+
+    case CLASSIC_DECODE_FMR:
     {
-      // This should not happen.
-      _errorStream << "INTERNAL ASSEMBLER ERROR <BR:DEFER>, location=" << addr_loc << std::endl;
-      _errorLoc = addr_loc;
-      return false;
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
+
+      const int qs = inst & QS_MASK;
+      if (!checkRegisterNumber(qs, errLoc, Q_REGISTER)) return false;
+
+      instText = inst_name + " R" + std::to_string(rd) + ", Q" + std::to_string(qs);
+      break;
     }
-    else
+
+    case CLASSIC_DECODE_SMIS:
     {
-      findIt->second.instruction = QISA_Parser::token::TOK_BR;
-      findIt->second.programCounter = _instructions.size();
+      const int sd = (inst >> SD_OFFSET) & SD_MASK;
+      if (!checkRegisterNumber(sd, errLoc, S_REGISTER)) return false;
+
+      uint64_t s_mask_bits = (inst & S_MASK_MASK);
+
+      auto s_mask = bits2s_mask(s_mask_bits);
+      instText = inst_name + " S" + std::to_string(sd) + ", " + get_s_mask_str(s_mask);
+      break;
     }
-  }
 
-  _instructions.emplace_back(instruction);
+    case CLASSIC_DECODE_SMIT:
+    {
+      const int td = (inst >> TD_OFFSET) & TD_MASK;
+      if (!checkRegisterNumber(td, errLoc, T_REGISTER)) return false;
 
-  return true;
-}
+      uint64_t t_mask_bits = (inst & T_MASK_MASK);
 
-/* ldi rd, imm */
-bool QISA_Driver::generate_LDI(const location& inst_loc,
-                               uint8_t rd,
-                               const location& rd_loc,
-                               int64_t imm,
-                               const location& imm_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "LDI(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
+      auto t_mask = bits2t_mask(t_mask_bits);
+      instText = inst_name + " T" + std::to_string(td) + ", " + get_t_mask_str(t_mask);
+      break;
+    }
 
-  int opcode;
+    case CLASSIC_DECODE_QWAIT:
+    {
+      const int rd = (inst >> RD_OFFSET) & RD_MASK;
+      if (!checkRegisterNumber(rd, errLoc, R_REGISTER)) return false;
 
-  if (!get_opcode("LDI", inst_loc, opcode))
-  {
-    return false;
-  }
+      const int u_imm = inst & U_IMM20_MASK;
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
-  {
-    return false;
-  }
+      instText = inst_name + " " + std::to_string(u_imm);
+      break;
+    }
 
-  // The 'imm' value is encoded using 20 bits (signed).
-  // Check if the given value is within this range.
+    case CLASSIC_DECODE_QWAITR:
+    {
+      const int rs = (inst >> RS_OFFSET) & RS_MASK;
+      if (!checkRegisterNumber(rs, errLoc, R_REGISTER)) return false;
 
-  const int64_t minImm = -(1LL<<19) + 1;
-  const int64_t maxImm =  (1LL<<19) - 1;
+      instText = inst_name + " R" + std::to_string(rs);
+      break;
+    }
 
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
-  {
-    return false;
+    default:
+    {
+      instText = "<Not yet supported: '" + inst_name + "'>\n";
+      break;
+    }
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | (imm & IMM20_MASK);
+  disassembledInst.instruction = instText;
 
-  _instructions.emplace_back(instruction);
   return true;
 }
 
-/* ldui rd, u_imm */
-bool QISA_Driver::generate_LDUI(const location& inst_loc,
-                               uint8_t rd,
-                                const location& rd_loc,
-                               int64_t imm,
-                                const location& imm_loc)
+void
+QISA_Driver::buildClassicDecodeTable()
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "LDUI(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
-
-  int opcode;
+  // Maps the name of a classic instruction to the way it is decoded.
+  static const struct
+  {
+    const char* name;
+    ClassicDecodeKind kind;
+  } decodeKinds[] =
+  {
+    { "NOP",    CLASSIC_DECODE_NO_ARGS  },
+    { "STOP",   CLASSIC_DECODE_NO_ARGS  },
+    { "ADD",    CLASSIC_DECODE_RD_RS_RT },
+    { "ADDC",   CLASSIC_DECODE_RD_RS_RT },
+    { "SUB",    CLASSIC_DECODE_RD_RS_RT },
+    { "SUBC",   CLASSIC_DECODE_RD_RS_RT },
+    { "AND",    CLASSIC_DECODE_RD_RS_RT },
+    { "OR",     CLASSIC_DECODE_RD_RS_RT },
+    { "XOR",    CLASSIC_DECODE_RD_RS_RT },
+    { "NOT",    CLASSIC_DECODE_NOT      },
+    { "CMP",    CLASSIC_DECODE_CMP      },
+    { "BR",     CLASSIC_DECODE_BR       },
+    { "LDI",    CLASSIC_DECODE_LDI      },
+    { "LDUI",   CLASSIC_DECODE_LDUI     },
+    { "FBR",    CLASSIC_DECODE_FBR      },
+    { "FMR",    CLASSIC_DECODE_FMR      },
+    { "SMIS",   CLASSIC_DECODE_SMIS     },
+    { "SMIT",   CLASSIC_DECODE_SMIT     },
+    { "QWAIT",  CLASSIC_DECODE_QWAIT    },
+    { "QWAITR", CLASSIC_DECODE_QWAITR   }
+  };
+
+  for (auto& entry : _classicDecodeTable)
+  {
+    entry.kind = CLASSIC_DECODE_UNKNOWN;
+    entry.name.clear();
+  }
+
+  for (const auto& it : _classicOpcode2instName)
+  {
+    ClassicDecodeEntry& entry = _classicDecodeTable[it.first & OPCODE_MASK];
+
+    entry.name = it.second;
+    entry.kind = CLASSIC_DECODE_OTHER;
+
+    for (const auto& decodeKind : decodeKinds)
+    {
+      if (it.second == decodeKind.name)
+      {
+        entry.kind = decodeKind.kind;
+        break;
+      }
+    }
+  }
+}
 
-  if (!get_opcode("LDUI", inst_loc, opcode))
+void
+QISA_Driver::buildQuantumDecodeTable()
+{
+  for (auto& entry : _quantumDecodeTable)
   {
-    return false;
+    entry.kind = QUANTUM_DECODE_UNKNOWN;
+    entry.name.clear();
   }
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  for (const auto& it : _quantumOpcode2instName)
   {
-    return false;
-  }
+    QuantumDecodeEntry& entry = _quantumDecodeTable[it.first & Q_INST_OPCODE_MASK];
 
-  // The 'imm' value is encoded using 15 bits (unsigned).
-  // Check if the given value is within this range.
+    entry.name = it.second;
 
-  const int64_t minImm = 0;
-  const int64_t maxImm = (1LL<<15) - 1;
+    if (_q_inst_arg_st_opcodes.find(it.second) != _q_inst_arg_st_opcodes.end())
+    {
+      entry.kind = QUANTUM_DECODE_ARG_ST;
+    }
+    else if (_q_inst_arg_tt_opcodes.find(it.second) != _q_inst_arg_tt_opcodes.end())
+    {
+      entry.kind = QUANTUM_DECODE_ARG_TT;
+    }
+    else
+    {
+      // If it is neither an st nor a tt instruction, it must be one without an argument.
+      entry.kind = QUANTUM_DECODE_ARG_NONE;
+    }
+  }
 
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  _quantumMnemonics.clear();
+
+  for (const auto& it : _q_inst_arg_none_opcodes)
   {
-    return false;
+    _quantumMnemonics[it.first].opcodes[IK_DF_ARG_NONE] = it.second;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | ((rd & RS_MASK) << RS_OFFSET) // Note: rs <-- rd
-                                      | (imm & U_IMM15_MASK);
+  for (const auto& it : _q_inst_arg_st_opcodes)
+  {
+    _quantumMnemonics[it.first].opcodes[IK_DF_ARG_ST] = it.second;
+  }
 
-  _instructions.emplace_back(instruction);
-  return true;
+  for (const auto& it : _q_inst_arg_tt_opcodes)
+  {
+    _quantumMnemonics[it.first].opcodes[IK_DF_ARG_TT] = it.second;
+  }
 }
 
-/* fbr cond, rd */
 bool
-QISA_Driver::generate_FBR(const location& inst_loc,
-                          uint8_t cond,
-                          const location& cond_loc,
-                          uint8_t rd,
-                          const location& rd_loc)
+QISA_Driver::disassembleQuantumInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "FBR(cond='" << _branchConditionNames[cond] << "',rd=" << (int)rd << ");" << std::endl;
+  int bs = inst & BS_MASK;
 
-  int opcode;
+  std::string instText = "BS " + std::to_string(bs) + " ";
 
-  if (!get_opcode("FBR", inst_loc, opcode))
+#if 0 // Hold on to this for the high-level disassembly, if we will handle that.
+  if (bs > 0)
   {
-    return false;
-  }
+    // If a previous bundle was started, we have to issue a new-line to
+    // terminate before starting a new one.
+    if (_disassemblyStartedQuantumBundle)
+    {
+      _disassemblyOutput << std::endl;
+    }
+    // Now we start a new quantum bundle.
+    _disassemblyOutput << "BS " << bs << " ";
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
-  {
-    return false;
+    _disassemblyStartedQuantumBundle = true;
   }
-
-
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | (cond & COND_MASK);
-
-  _instructions.emplace_back(instruction);
-
-  return true;
-}
-
-/* fmr rd, qs */
-bool
-QISA_Driver::generate_FMR(const location& inst_loc,
-                          uint8_t rd,
-                          const location& rd_loc,
-                          uint8_t qs,
-                          const location& qs_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "FMR(rd=" << (int)rd << ",qs=" << (int)qs << ");" << std::endl;
-
-  int opcode;
-
-  if (!get_opcode("FMR", inst_loc, opcode))
+  else
   {
-    return false;
+    if (_disassemblyStartedQuantumBundle)
+    {
+      // If we already started a bundle, add this one to the set.
+      _disassemblyOutput << " | ";
+    }
+    else
+    {
+      // Otherwise we start a new quantum bundle with 0 as wait time.
+      _disassemblyOutput << "BS " << bs << " ";
+
+      _disassemblyStartedQuantumBundle = true;
+    }
   }
+#endif
 
-  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  // Quantum instructions are put pair-wise in a
+  // 'very large instruction word' (VLIW).
+
+  // Handle the first quantum instruction of the VLIW.
+  // Last parameter contains the disassembled instruction.
+  std::string q_0_str;
+  if (!decode_q_instr((inst >> VLIW_INST_0_OFFSET) & VLIW_Q_INST_MASK, q_0_str))
   {
+    // Return false if the binary value could not be decoded as a valid quantum instruction.
     return false;
   }
 
-  if (!checkRegisterNumber(qs, qs_loc, Q_REGISTER))
+  std::string q_1_str;
+  // Handle the second quantum instruction of the VLIW.
+  if (!decode_q_instr((inst >> VLIW_INST_1_OFFSET) & VLIW_Q_INST_MASK, q_1_str))
   {
+    // Return false if the binary value could not be decoded as a valid quantum instruction.
     return false;
   }
 
+  // QNOPs are mostly hidden, unless both instructions of a VLIW are QNOPs.
+  // If both instructions are QNOPs, issue one QNOP in total.
+  // If only one is a QNOP, issue the non-QNOP instruction.
+  // If neither instructions are QNOP, issue both instructions separated by a vertical bar.
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rd & RD_MASK) << RD_OFFSET)
-                                      | (qs & QS_MASK);
-
-  _instructions.emplace_back(instruction);
-
-  return true;
-}
-
-/* smis sd, s_mask */
-bool
-QISA_Driver::generate_SMIS(const location& inst_loc,
-                           uint8_t sd,
-                           const location& sd_loc,
-                           const std::vector<uint8_t>& s_mask,
-                           const location& s_mask_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "SMIS(sd=" << (int)sd << ",s_mask=" << get_s_mask_str(s_mask) << ");" << std::endl;
-
-  int opcode;
+  const bool q_0_is_nop = (q_0_str == "QNOP");
+  const bool q_1_is_nop = (q_1_str == "QNOP");
 
-  if (!get_opcode("SMIS", inst_loc, opcode))
+  if (q_0_is_nop &&
+      q_1_is_nop)
   {
-    return false;
+    instText += q_0_str;
   }
-
-  if (!checkRegisterNumber(sd, sd_loc, S_REGISTER))
+  else if (q_0_is_nop)
   {
-    return false;
+    instText += q_1_str;
   }
-
-  // Construct the s_mask on bit level.
-  // NOTE: The parser already has checked the given s_mask.
-  int64_t s_mask_bits = 0;
-  for (auto it = s_mask.begin(); it != s_mask.end(); ++it)
+  else if (q_1_is_nop)
   {
-    s_mask_bits |= (1LL << *it);
+    instText += q_0_str;
+  }
+  else
+  {
+    instText += q_0_str + " | " + q_1_str;
   }
 
-  //divide it into two parts
-  //int64_t s_mask_bits = s_mask_bits & 0x1ffff;
-  int64_t s_mask_bits_array;
-  s_mask_bits_array = s_mask_bits & 0x1ffff;
-
-  //corresponding pos value
-  //No position field for SMIS
-
-  // Encode the parameters into an instruction and add it to the instruction list.
-  unsafe_generate_SMIS(opcode, sd, s_mask_bits_array);
-  //unsafe_generate_SMIS(opcode, sd, pos1, s_mask_bits1);
-  //unsafe_generate_SMIS(opcode, sd, pos2, s_mask_bits2);
+  disassembledInst.instruction = instText;
 
   return true;
 }
 
 
-std::vector<uint8_t>
-QISA_Driver::bits2s_mask(int64_t s_mask_bits)
+std::string
+QISA_Driver::getLastErrorMessage()
 {
-  std::vector<uint8_t> result;
-  const std::bitset<sizeof(s_mask_bits)> bs(s_mask_bits);
-  for (uint8_t i = 0; i < _totalNrOfQubits; i++)
+  std::ostringstream ss;
+  // Start with a new-line, so all lines will be indented properly.
+  ss << std::endl;
+
+  if (_errorRecovery)
   {
-    if (bs[i])
-    {
-      result.push_back(i);
-    }
+    // Include the errors issued after the assembly, e.g. by save().
+    recordDiagnostic();
   }
 
-  return result;
-}
-
-std::vector<QISA_Driver::TargetControlPair>
-QISA_Driver::bits2t_mask(int64_t t_mask_bits)
-{
-  std::vector<TargetControlPair>  result;
-  for (size_t i = 0; i < _valid_target_control_pairs.size(); i++)
+  if (_errorRecovery && !_diagnostics.empty())
   {
-    if (t_mask_bits & ( 1LL<< i))
+    // Show each error with its own source lines.
+    for (const Diagnostic& diagnostic : _diagnostics)
     {
-      result.push_back(_bit2tc_pair[i]);
+      location loc;
+      if (diagnostic.line != 0)
+      {
+        loc.begin.line = diagnostic.line;
+        loc.begin.column = diagnostic.column;
+        loc.end.line = diagnostic.endLine;
+        loc.end.column = diagnostic.endColumn;
+      }
+
+      ss << getErrorSourceLine(loc, diagnostic.message);
+      ss << std::endl;
+      ss << diagnostic.message;
+      ss << std::endl;
     }
+
+    ss << _diagnostics.size() << (_diagnostics.size() == 1 ? " error" : " errors") << " found." << std::endl;
+
+    return ss.str();
   }
 
-  return result;
-}
+  ss << getErrorSourceLine(_errorLoc, _errorStream.str());
+  ss << std::endl;
+  ss << _errorStream.str();
+  ss << std::endl;
 
+  return ss.str();
+}
 
-/* smis sd, imm  (NOTE: Alternative representation.) */
-bool
-QISA_Driver::generate_SMIS(const location& inst_loc,
-                           uint8_t sd,
-                           const location& sd_loc,
-                           int64_t imm,
-                           const location& imm_loc)
+void
+QISA_Driver::recordDiagnostic()
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "SMIS(sd=" << (int)sd << ",imm=" << imm << ");" << std::endl;
-
-  int opcode;
+  const std::string errors = _errorStream.str();
 
-  if (!get_opcode("SMIS", inst_loc, opcode))
+  if (errors.size() <= _unrecordedErrorsStart)
   {
-    return false;
+    // No new errors.
+    return;
   }
 
-  if (!checkRegisterNumber(sd, sd_loc, S_REGISTER))
+  Diagnostic diagnostic;
+
+  if ((_errorLoc.begin.line == 1) &&
+      (_errorLoc.end.line == 1) &&
+      (_errorLoc.begin.column == 1) &&
+      (_errorLoc.end.column == 1))
   {
-    return false;
+    // The location has not been initialized.
+    diagnostic.line = 0;
+    diagnostic.column = 0;
+    diagnostic.endLine = 0;
+    diagnostic.endColumn = 0;
   }
-
-  // The 'imm' value is encoded using 7 bits (unsigned).
-  // Check if the given value is within this range.
-
-  const int64_t minImm = 0;
-  const int64_t maxImm = (1LL<<17) - 1;
-
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  else
   {
-    return false;
+    diagnostic.line = _errorLoc.begin.line;
+    diagnostic.column = _errorLoc.begin.column;
+    diagnostic.endLine = _errorLoc.end.line;
+    diagnostic.endColumn = _errorLoc.end.column;
   }
 
-  // Encode the parameters into an instruction and add it to the instruction list.
-  unsafe_generate_SMIS(opcode, sd, imm);
+  diagnostic.message = errors.substr(_unrecordedErrorsStart);
+  _diagnostics.push_back(diagnostic);
 
-  return true;
+  _unrecordedErrorsStart = errors.size();
 }
 
+bool
+QISA_Driver::unrecordedErrorsContain(const std::string& text) const
+{
+  return _errorStream.str().find(text, _unrecordedErrorsStart) != std::string::npos;
+}
 
-
-// Used by the two flavors of generate_SMIS.
-// All arguments are supposed to have been checked.
 void
-QISA_Driver::unsafe_generate_SMIS(int opcode,
-                                  uint8_t sd,
-                                  int64_t s_mask_bits)
+QISA_Driver::setErrorRecovery(bool enabled)
 {
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((sd & SD_MASK) << SD_OFFSET)
-                                      | (s_mask_bits & S_MASK_MASK);
-
-  _instructions.emplace_back(instruction);
+  _errorRecovery = enabled;
 }
 
-
-/* smit td, t_mask */
 bool
-QISA_Driver::generate_SMIT(const location& inst_loc,
-                           uint8_t td,
-                           const location& td_loc,
-                           const std::vector<TargetControlPair>& t_mask,
-                           const location& t_mask_loc)
+QISA_Driver::getErrorRecovery() const
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "SMIT(td=" << (int)td << ",t_mask=" << get_t_mask_str(t_mask) << ");" << std::endl;
+  return _errorRecovery;
+}
 
-  int opcode;
+const std::vector<QISA_Driver::Diagnostic>&
+QISA_Driver::getDiagnostics() const
+{
+  return _diagnostics;
+}
 
-  if (!get_opcode("SMIT", inst_loc, opcode))
-  {
-    return false;
-  }
+void
+QISA_Driver::setMaskDeduplication(bool enabled)
+{
+  _maskDeduplication = enabled;
+}
 
-  if (!checkRegisterNumber(td, td_loc, T_REGISTER))
-  {
-    return false;
-  }
+bool
+QISA_Driver::getMaskDeduplication() const
+{
+  return _maskDeduplication;
+}
 
-  // Construct the t_mask on bit level.
-  // NOTE: The parser already has checked the given t_mask.
+void
+QISA_Driver::setMaskRegisterRenaming(bool enabled)
+{
+  _maskRegisterRenaming = enabled;
+}
 
-  int64_t t_mask_bits = 0;
-  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
-  {
-    const uint8_t t_mask_bit = _valid_target_control_pairs[*it];
-    t_mask_bits |= (1LL << t_mask_bit);
-  }
+bool
+QISA_Driver::getMaskRegisterRenaming() const
+{
+  return _maskRegisterRenaming;
+}
 
-  //divide the 48 bits mask value into three parts
-  //int64_t t_mask_bits1 = (t_mask_bits & 0xffff);
-  //int64_t t_mask_bits2 = (t_mask_bits & 0xffff0000) >> 16;
-  //int64_t t_mask_bits3 = (t_mask_bits & 0xffff00000000) >> 32;
-  int64_t *t_mask_bits_array;
-  t_mask_bits_array = new int64_t[pos_number_t];
-  for (int i = 0; i < pos_number_t; ++i) {
-    t_mask_bits_array[i] = (t_mask_bits >> (16 * i)) & 0xffff;
-  }
+size_t
+QISA_Driver::getNrOfRemovedMaskWords() const
+{
+  return _nrOfRemovedMaskWords;
+}
 
-  //corresponding pos value
-  //uint8_t pos1 = 0;
-  //uint8_t pos2 = 1;
-  //uint8_t pos3 = 2;
-  uint8_t *pos;
-  pos = new uint8_t[pos_number_t];
-  for (int i = 0; i < pos_number_t; ++i) {
-    pos[i] = i;
-  }
+void
+QISA_Driver::setVliwPacking(bool enabled)
+{
+  _vliwPacking = enabled;
+}
 
-  // Encode the parameters into an instruction and add it to the instruction list.
-  //unsafe_generate_SMIT(opcode, td, pos1, t_mask_bits1);
-  //unsafe_generate_SMIT(opcode, td, pos2, t_mask_bits2);
-  //unsafe_generate_SMIT(opcode, td, pos3, t_mask_bits3);
-  for (int i = 0; i < pos_number_t; ++i) {
-    unsafe_generate_SMIT(opcode, td, pos[i], t_mask_bits_array[i]);
-  }
+bool
+QISA_Driver::getVliwPacking() const
+{
+  return _vliwPacking;
+}
 
-  return true;
+void
+QISA_Driver::setBranchRelaxation(bool enabled)
+{
+  _branchRelaxation = enabled;
 }
 
-/* smit td, imm  (NOTE: Alternative representation.) */
 bool
-QISA_Driver::generate_SMIT(const location& inst_loc,
-                           uint8_t td,
-                           const location& td_loc,
-                           int64_t imm,
-                           const location& imm_loc)
+QISA_Driver::getBranchRelaxation() const
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "SMIT(td=" << (int)td << ",imm=" << imm << ");" << std::endl;
+  return _branchRelaxation;
+}
 
-  int opcode;
+size_t
+QISA_Driver::getNrOfRelaxedBranches() const
+{
+  return _nrOfRelaxedBranches;
+}
 
-  if (!get_opcode("SMIT", inst_loc, opcode))
+// Lookup the error location in the source file and return its contents.
+std::string
+QISA_Driver::getErrorSourceLine(const location& loc, const std::string& errors)
+{
+  unsigned int start_error_line = loc.begin.line;
+  unsigned int end_error_line = loc.end.line;
+  unsigned int start_error_column = loc.begin.column;
+  unsigned int end_error_column = loc.end.column;
+
+  if ((start_error_line == 1) &&
+      (end_error_line == 1) &&
+      (start_error_column == 1) &&
+      (end_error_column == 1))
   {
-    return false;
+    // The location has not been initialized.
+    // Return an empty string.
+    return "";
   }
 
-  if (!checkRegisterNumber(td, td_loc, T_REGISTER))
+  bool error_was_on_prev_line = false;
+  if (errors.find("syntax error, unexpected NEWLINE") != std::string::npos)
   {
-    return false;
+    error_was_on_prev_line = true;
+    if ((start_error_line > 1) && (end_error_line > 1))
+    {
+      if (start_error_line == end_error_line)
+      {
+        end_error_line--;
+      }
+      start_error_line--;
+    }
   }
 
-  // The 'imm' value is encoded using 16 bits (unsigned).
-  // Check if the given value is within this range.
+  // Add context lines
+  int start_context_line = start_error_line - NUM_CONTEXT_LINES_IN_ERROR_MSG;
+  int end_context_line = end_error_line + NUM_CONTEXT_LINES_IN_ERROR_MSG;
 
-  const int64_t minImm = 0;
-  const int64_t maxImm = (1LL<<48) - 1;
+  // Adjust start_context_line if it is too small.
+  if (start_context_line < 1)
+    start_context_line = 1;
 
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
-  {
-    return false;
-  }
+  // Note that end_context_line may extend past the end of the file...
 
-  // Now, we must subject this value to the same tests as done in validate_t_mask.
+  std::ostringstream ss;
 
-  // First, we will convert the given immediate value to a vector of tc_pairs.
-  auto t_mask = bits2t_mask(imm);
+  std::ostringstream ss_pre_context;
+  std::ostringstream ss_error_lines;
+  std::ostringstream ss_marker_line;
+  std::ostringstream ss_post_context;
 
-  // Now we can perform the check.
-  if (!validate_t_mask(t_mask, imm_loc))
+  std::string last_error_source_line;
+
+  // The source lines are either taken from the assembled file or from
+  // the in-memory source code.
+  if (indexSourceLines())
   {
-    return false;
-  }
+    const size_t last_context_line = std::min(static_cast<size_t>(end_context_line),
+                                              _sourceLines.nrOfLines());
 
-  // Encode the parameters into an instruction and add it to the instruction list.
-  unsafe_generate_SMIT(opcode, td, 0, imm);
+    for (size_t line_counter = start_context_line; line_counter <= last_context_line; line_counter++)
+    {
+      const std::string line = _sourceLines.getLine(line_counter);
 
-  return true;
-}
+      if (line_counter < start_error_line)
+      {
+        ss_pre_context << std::setfill(' ') << std::setw(8) << line_counter << ": ";
+        ss_pre_context << line << std::endl;
+      }
+      else
+        if ((line_counter >= start_error_line) &&
+            (line_counter <= end_error_line))
+        {
+          last_error_source_line = line;
+          ss_error_lines << std::setfill(' ') << std::setw(8) << line_counter << ": ";
+          ss_error_lines << line << std::endl;
+        }
+        else
+        {
+          ss_post_context << std::setfill(' ') << std::setw(8) << line_counter << ": ";
+          ss_post_context << line << std::endl;
+        }
+    }
 
 
+    // Insert a set of carets (^) to show the exact location of the error.
 
-// Used by the two flavors of generate_SMIT.
-// All arguments are supposed to have been checked.
-void
-QISA_Driver::unsafe_generate_SMIT(int opcode,
-                                  uint8_t td,
-                                  uint8_t pos,
-                                  int64_t t_mask_bits)
-{
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((td & TD_MASK) << TD_OFFSET)
-                                      | ((pos & POS_MASK) << POS_OFFSET)
-                                      | (t_mask_bits & T_MASK_MASK);
+    // Special case for when the error was an unexpected NEWLINE.
+    // In that case, we want the error marker (^) to point to the
+    // last valid position on the previous line.
+    if (error_was_on_prev_line)
+    {
+      start_error_column = last_error_source_line.size() + 1;
 
-  _instructions.emplace_back(instruction);
-}
+      // Check if there is a comment character (#) in this line.
+      // Discard everything after that character.
+      size_t comment_pos = last_error_source_line.find("#");
+      if (comment_pos != std::string::npos)
+      {
+        start_error_column = comment_pos + 1;
+      }
 
+      end_error_column = start_error_column + 1;
+    }
 
-/* qwait u_imm */
-bool
-QISA_Driver::generate_QWAIT(const location& inst_loc,
-                            int64_t imm,
-                            const location& imm_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "QWAIT(u_imm=" << imm << ");" << std::endl;
+    for (unsigned int i = 1; i < end_error_column; i++)
+    {
+      if (i < start_error_column)
+      {
+        if ((i <= last_error_source_line.size()) && (last_error_source_line[i-1] == '\t'))
+        {
+          ss_marker_line << "\t";
+        }
+        else
+        {
+          ss_marker_line << " ";
+        }
+      }
+      else
+      {
+        ss_marker_line << "^";
+      }
+    }
+    ss_marker_line << std::endl;
 
-  int opcode;
+    ss << ss_pre_context.str();
+    ss << "-------------------------------" << std::endl;
+    ss << ss_error_lines.str();
+    // Note: add 10 spaces to account for the line number.
+    ss << "          " << ss_marker_line.str();
+    ss << "-------------------------------" << std::endl;
+    ss << ss_post_context.str();
 
-  if (!get_opcode("QWAIT", inst_loc, opcode))
-  {
-    return false;
   }
-
-  // The 'imm' value is encoded using 20 bits (unsigned).
-  // Check if the given value is within this range.
-
-  const int64_t minImm = 0;
-  const int64_t maxImm = (1LL<<20) - 1;
-
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  else
   {
-    return false;
+    ss << "<Could not read from file: " << _filename << ">";
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | (imm & U_IMM20_MASK);
-
-  _instructions.emplace_back(instruction);
-  return true;
+  return ss.str();
 }
 
-/* qwaitr rs */
 bool
-QISA_Driver::generate_QWAITR(const QISA::location& inst_loc,
-                             uint8_t rs,
-                             const QISA::location& rs_loc)
+QISA_Driver::indexSourceLines()
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "QWAITR(rs=" << (int)rs << ");" << std::endl;
-
-  int opcode;
+  if (_sourceLines.isBuilt())
+  {
+    return true;
+  }
 
-  if (!get_opcode("QWAITR", inst_loc, opcode))
+  if (_sourceIsBuffer)
   {
-    return false;
+    _sourceLines.build(_sourceBuffer.data(), _sourceBuffer.size());
+    return true;
   }
 
-  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  // If the scanner takes the source code from _sourceFile, it is already open;
+  // opening it again would unmap the source code that is being scanned.
+  if (!_scanSourceFile && !_sourceFile.open(_filename))
   {
     return false;
   }
 
-  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
-                                      | ((rs & RS_MASK) << RS_OFFSET);
-
-  _instructions.emplace_back(instruction);
+  _sourceLines.build(_sourceFile.data(), _sourceFile.size());
   return true;
 }
 
-/* ALIAS: [SHL1 rd,rs] --> [ADD rd,rs,rs] */
-bool
-QISA_Driver::generate_SHL1(const location& inst_loc,
-                           uint8_t rd,
-                           const location& rd_loc,
-                           uint8_t rs,
-                           const location& rs_loc)
+std::string
+QISA_Driver::getVersion()
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: SHL1(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
-
-  // We leave checking the parameters up to the generation functions we call.
-
-
-
-  bool result = generate_XXX_rd_rs_rt("ADD", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+  return QISA_VERSION_STRING;
 }
 
-/* ALIAS: [NAND rd,rs,rt] --> [AND rd,rs,rt ; NOT rd,rd] */
-bool
-QISA_Driver::generate_NAND(const location& inst_loc,
-                           uint8_t rd,
-                           const location& rd_loc,
-                           uint8_t rs,
-                           const location& rs_loc,
-                           uint8_t rt,
-                           const location& rt_loc)
+std::string
+QISA_Driver::dumpInstructionsSpecification()
 {
+  if (_opcodes.empty())
+  {
+    setOpcodes();
+  }
 
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: NAND(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
-
-  // We leave checking the parameters up to the generation functions we call.
+  std::ostringstream ss;
+  ss << "##################################################" << std::endl;
+  ss << "#                                                #" << std::endl;
+  ss << "#            QISA Opcode Specification           #" << std::endl;
+  ss << "#                                                #" << std::endl;
+  ss << "# Compilation-date: " << __DATE__ << "                  #" << std::endl;
+  ss << "# Compilation-time: " << __TIME__ << "                     #" << std::endl;
+  ss << "#                                                #" << std::endl;
+  ss << "##################################################" << std::endl;
+  ss << std::endl;
+  ss << "#" << std::endl;
+  ss << "# Compiled-in classic instructions" << std::endl;
+  ss << "# (Single Instruction Format)" << std::endl;
+  ss << "#" << std::endl;
+  ss << std::endl;
 
-  bool result = generate_XXX_rd_rs_rt("AND", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
+  std::string opc_str;
 
-  if (result)
+  for (auto it : _opcodes)
   {
-    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
+    opc_str = "def_opcode['" + it.first+ "']";
+    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
   }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
-}
+  ss << std::endl;
+  ss << "#" << std::endl;
+  ss << "# Configured quantum instructions" << std::endl;
+  ss << "# (Double Instruction Format)" << std::endl;
+  ss << "#" << std::endl;
 
-/* ALIAS: [NOR rd,rs,rt] --> [OR rd,rs,rt ; NOT rd,rd] */
-bool
-QISA_Driver::generate_NOR(const location& inst_loc,
-                          uint8_t rd,
-                          const location& rd_loc,
-                          uint8_t rs,
-                          const location& rs_loc,
-                          uint8_t rt,
-                          const location& rt_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: NOR(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+  ss << std::endl;
+  ss << "# No arguments" << std::endl;
+  ss << "# (def_q_arg_none)" << std::endl;
 
-  // We leave checking the parameters up to the generation functions we call.
+  for (auto it : _q_inst_arg_none_opcodes)
+  {
+    opc_str = "def_q_arg_none['" + it.first + "']";
+    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
+  }
 
-  bool result = generate_XXX_rd_rs_rt("OR", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
+  ss << std::endl;
+  ss << "# Uses 'S' register as parameter" << std::endl;
+  ss << "# (def_q_arg_st)" << std::endl;
 
-  if (result)
+  for (auto it : _q_inst_arg_st_opcodes)
   {
-    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
+    opc_str = "def_q_arg_st['" + it.first + "']";
+    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
   }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
-}
+  ss << std::endl;
+  ss << "# Uses 'T' register as parameter" << std::endl;
+  ss << "# (def_q_arg_tt)" << std::endl;
 
-/* ALIAS: [XNOR rd,rs,rt] --> [XOR rd,rs,rt ; NOT rd,rd] */
-bool
-QISA_Driver::generate_XNOR(const location& inst_loc,
-                           uint8_t rd,
-                           const location& rd_loc,
-                           uint8_t rs,
-                           const location& rs_loc,
-                           uint8_t rt,
-                           const location& rt_loc)
-{
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: XNOR(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+  for (auto it : _q_inst_arg_tt_opcodes)
+  {
+    opc_str = "def_q_arg_tt['" + it.first + "']";
+    ss << std::setw(30) << std::left << opc_str << "= " << getHex(it.second, 2) << std::endl;
+  }
 
-  // We leave checking the parameters up to the generation functions we call.
+  return ss.str();
+}
 
-  bool result = generate_XXX_rd_rs_rt("XOR", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
 
-  if (result)
-  {
-    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
-  }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+void
+QISA_Driver::enableScannerTracing(bool enabled)
+{
+  _traceScanning = enabled;
 }
 
-/* ALIAS: [BRA addr] --> [BR always, addr] */
-bool
-QISA_Driver::generate_BRA(const location& inst_loc,
-                          int64_t addr,
-                          const location& addr_loc)
+void
+QISA_Driver::enableParserTracing(bool enabled)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: BRA(addr=" << addr << ");" << std::endl;
+  _traceParsing = enabled;
+}
 
-  // We leave checking the parameters up to the generation functions we call.
+void
+QISA_Driver::setVerbose(bool verbose)
+{
+  _verbose = verbose;
+}
 
-  bool result = generate_BR(inst_loc, COND_ALWAYS, inst_loc, addr, addr_loc);
+void
+QISA_Driver::error(const location& l, const std::string& m)
+{
+  _errorStream << _filename << ":" << l << ": " << m << std::endl;
+  _errorLoc = l;
+}
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+void
+QISA_Driver::error(const std::string& m)
+{
+  _errorStream << m << std::endl;
+  _errorLoc = location();
 }
 
-/* ALIAS: [GOTO addr] --> [BR always, addr] */
-bool
-QISA_Driver::generate_GOTO(const location& inst_loc,
-                           int64_t addr,
-                           const location& addr_loc)
+void
+QISA_Driver::addSpecificErrorMessage(const std::string& msg)
 {
-  if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: GOTO(addr=" << addr << ");" << std::endl;
+  _errorStream << msg << std::endl;
+}
 
-  // We leave checking the parameters up to the generation functions we call.
+void
+QISA_Driver::addExpectationErrorMessage(const std::string& expected_item)
+{
+  if (!unrecordedErrorsContain(", expecting"))
+  {
+    addSpecificErrorMessage("ERROR DETECTED: Expected " + expected_item + " here");
+  }
+}
 
-  bool result = generate_BR(inst_loc, COND_ALWAYS, inst_loc, addr, addr_loc);
+void
+QISA_Driver::addExpectedConditionErrorMessage()
+{
+  if (!unrecordedErrorsContain(", expecting"))
+  {
+    std::ostringstream ss;
+    ss << std::endl;
+    ss << "ERROR DETECTED: Expected a CONDITION here." << std::endl;
+    ss << "Valid conditions are:" << std::endl;
+    for (auto it = _branchConditionNames.begin(); it != _branchConditionNames.end(); ++it)
+    {
+      ss << "  " << it->second << std::endl;
+    }
+    ss << std::endl;
+    ss << "Valid condition ALIASES are:" << std::endl;
+    for (auto it = _branchConditionAliases.begin(); it != _branchConditionAliases.end(); ++it)
+    {
+      ss << "  " << std::setw(9) << std::left << it->first << ": aliased to: " << _branchConditionNames[it->second] << std::endl;
+    }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+    addSpecificErrorMessage(ss.str());
+  }
 }
 
 
-/* ALIAS: [BRN addr] --> [BR never, addr] */
-bool
-QISA_Driver::generate_BRN(const location& inst_loc,
-                          int64_t addr,
-                          const location& addr_loc)
+void
+QISA_Driver::add_symbol(const std::string& symbol_name,
+                        const QISA::location& symbol_name_loc,
+                        int64_t symbol_value,
+                        const QISA::location& symbol_value_loc)
 {
   if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: BRN(addr=" << addr << ");" << std::endl;
-
-  // We leave checking the parameters up to the generation functions we call.
+      std::cout <<  "          "
+                << "ADD_SYMBOL[int](name='" << symbol_name << "', val=" << symbol_value << ");" << std::endl;
 
-  bool result = generate_BR(inst_loc, COND_NEVER, inst_loc, addr, addr_loc);
+  // Note that if a symbol already exists, its value will be overwritten.
+  _intSymbols[symbol_name] = symbol_value;
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
 }
 
-/* BEQ   rs, rt, addr  */
-/* BNE   rs, rt, addr  */
-/* BLT   rs, rt, addr  */
-/* BLE   rs, rt, addr  */
-/* BGT   rs, rt, addr  */
-/* BGE   rs, rt, addr  */
-/* BLTU  rs, rt, addr  */
-/* BLEU  rs, rt, addr  */
-/* BGTU  rs, rt, addr  */
-/* BGEU  rs, rt, addr  */
-
-/* ALIAS: [BXX rs,rt,addr] --> [CMP rs,rt; BR XX,addr] */
 bool
-QISA_Driver::generate_BR_COND(const location& inst_loc,
-                              uint8_t rs,
-                              const location& rs_loc,
-                              uint8_t rt,
-                              const location& rt_loc,
-                              int64_t addr,
-                              const location& addr_loc,
-                              QISA_Driver::BranchCondition cond)
+QISA_Driver::get_symbol(const std::string& symbol_name,
+                        const QISA::location& symbol_name_loc,
+                        int64_t& imm_val)
 {
   if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: B" << _branchConditionNames[cond]
-                   << "(rs=" << (int)rs << ",rt=" << (int)rt << ",addr=" << addr << ");" << std::endl;
-
-  // We leave checking the parameters up to the generation functions we call.
+      std::cout <<  "          "
+                << "GET_SYMBOL[int](name='" << symbol_name << "');" << std::endl;
 
-  bool result = generate_CMP(inst_loc, rs, rs_loc, rt, rt_loc);
+  countMapLookup();
+  auto findIt = _intSymbols.find(symbol_name);
 
-  if (result)
+  if (!findIt)
   {
-    // Mark the fact that this branch is the result of an alias.
-    result = generate_BR(inst_loc, cond, inst_loc, addr, addr_loc, true);
+    _errorStream << symbol_name_loc << ": symbol '" << symbol_name << "' not found" << std::endl;
+    _errorLoc = symbol_name_loc;
+    return false;
   }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+  imm_val = findIt->second;
+  return true;
+}
+
+// Add a string valued symbol (not used yet).
+void
+QISA_Driver::add_symbol(const std::string& symbol_name,
+                        const QISA::location& symbol_name_loc,
+                        const std::string&  symbol_value,
+                        const QISA::location& symbol_value_loc)
+{
+  if (_verbose)
+      std::cout <<  "          "
+                << "ADD_SYMBOL[str](name='" << symbol_name << "', val=" << symbol_value << ");" << std::endl;
+  _strSymbols[symbol_name] = symbol_value;
 }
 
-/* ALIAS: [MOV rd,rs] --> [LDI rd,0 ; ADD rd,rs,rd] */
 
 bool
-QISA_Driver::generate_COPY(const location& inst_loc,
-                          uint8_t rd,
-                          const location& rd_loc,
-                          uint8_t rs,
-                          const location& rs_loc)
+QISA_Driver::get_symbol(const std::string& symbol_name,
+                        const QISA::location& symbol_name_loc,
+                        std::string& imm_val)
 {
   if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: COPY(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
+      std::cout <<  "          "
+                << "GET_SYMBOL[str](name='" << symbol_name << "');" << std::endl;
 
-  // We leave checking the parameters up to the generation functions we call.
-  bool result = generate_XXX_rd_rs_rt("OR", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
+  countMapLookup();
+  auto findIt = _strSymbols.find(symbol_name);
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+  if (!findIt)
+  {
+    _errorStream << symbol_name_loc << ": symbol '" << symbol_name << "' not found" << std::endl;
+    _errorLoc = symbol_name_loc;
+    return false;
+  }
+
+  imm_val = findIt->second;
+  return true;
 }
 
-bool QISA_Driver::generate_MOV(const location& inst_loc,
-                                uint8_t rd,
-                                const location& rd_loc,
-                                int64_t imm,
-                                const location& imm_loc)
+// Add a register definition.
+// This is used to give a register a meaningful name.
+bool
+QISA_Driver::add_register_definition(const std::string& register_name,
+                                     const QISA::location& register_name_loc,
+                                     uint8_t reg_nr,
+                                     const QISA::location& reg_nr_loc,
+                                     RegisterKind register_kind)
 {
   if (_verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: MOV(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
+      std::cout << "          "
+                << "DEFINE_REG(name='" << register_name
+                << "', reg=" << _registerName[register_kind] << (int)reg_nr << ");" << std::endl;
 
+  if (!checkRegisterNumber(reg_nr, reg_nr_loc, register_kind))
+  {
+    return false;
+  }
 
-  // The 'imm' value is encoded using 32 bits (signed).
-  // Check if the given value is within this range.
+  _registerAliases[register_kind][register_name] = reg_nr;
+  return true;
 
-  const int64_t minImm = -(1LL<<31) + 1;
-  const int64_t maxImm =  (1LL<<31) - 1;
+}
 
-  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+bool
+QISA_Driver::get_register_nr(const std::string& register_name,
+                             const QISA::location& register_name_loc,
+                             RegisterKind register_kind,
+                             uint8_t& result)
+{
+  if (_verbose)
+      std::cout <<  "          "
+                << "GET_REG(name='" << register_name << "');" << std::endl;
+
+  countMapLookup();
+  auto findIt = _registerAliases[register_kind].find(register_name);
+
+  if (!findIt)
   {
+    _errorStream << register_name_loc << ": '"
+                 << _registerName[register_kind]
+                 << "' register named '" << register_name
+                 << "' not found" << std::endl;
+    _errorLoc = register_name_loc;
     return false;
   }
 
-  bool result = false;
+  result = findIt->second;
+  return true;
+}
 
-  const int64_t minImm20 = -(1LL<<19) + 1;
-  const int64_t maxImm20 =  (1LL<<19) - 1;
+void
+QISA_Driver::add_label(const std::string& label_name,
+                       const QISA::location& label_name_loc)
+{
+  if (_verbose)
+      std::cout <<  "          "
+                << "ADD_LABEL(name='" << label_name << "') -> addr=" << _instructions.size() << ";" << std::endl;
+  _labels[label_name] = _instructions.size();
+  _lastLabelAddress = _instructions.size();
+}
 
-  if (imm < minImm20 || imm > maxImm20)
+int64_t
+QISA_Driver::get_label_address(const std::string& label_name,
+                               const QISA::location& label_name_loc,
+                               bool get_offset)
+{
+  if (_verbose)
+      std::cout <<  "          "
+                << "GET_LABEL_ADDRESS(name='" << label_name << "');" << std::endl;
+
+
+  const uint64_t programCounter = _instructions.size();
+
+  int64_t result;
+
+  countMapLookup();
+  auto findIt = _labels.find(label_name);
+
+  if (!findIt)
   {
-    // If the immediate doesn't fit in a 20 bit signed integer, we must split the given value into a lower and an upper part.
-    // The lower part will have 17 bits and the upper part will have the rest (15 bits).
-    const int64_t lowerPart = imm & U_IMM17_MASK;
-    const int64_t upperPart = ((imm & ~U_IMM17_MASK) >> 17) & U_IMM15_MASK;
+    // This label has not yet been defined.
+    // Record all information that is necessary to assemble the instruction that uses this label after the
+    // whole source file has been processed.
 
-    result = generate_LDI(inst_loc, rd, rd_loc, lowerPart, imm_loc);
+    DeferredLabelUse deferred;
 
-    if (result)
+    // The instruction type (token) and programCounter will be set when the instruction
+    // on the current line will be handled.
+    deferred.is_offset = get_offset;
+    deferred.label_name = label_name;
+    deferred.label_name_loc = label_name_loc;
+
+    // Check if a label has already been used in the current instruction.
+    auto itDeferred = _deferredInstructions.find(label_name_loc);
+
+    if (itDeferred == _deferredInstructions.end())
     {
-      result = generate_LDUI(inst_loc, rd, rd_loc, upperPart, imm_loc);
+      // If not, add this deferred label use to the deferred instruction map.
+
+      _deferredInstructions[label_name_loc] = std::move(deferred);
+    }
+    else
+    {
+      // Another label has already been used in this instruction.
+      // To indicate this error, modify the original label name and set the location to the offending label.
+      itDeferred->second.label_name = "<<MULTI_LABEL_ERROR>>";
+      itDeferred->second.label_name_loc = label_name_loc;
     }
+
+    // This should be a non-sensical return value...
+    result = std::numeric_limits<int64_t>::min();
+
+    if (_verbose)
+        std::cout << "          "
+                  << "    GET_LABEL_ADDRESS didn't find label '" << label_name << "' (yet)" << std::endl;
   }
   else
   {
-    // We can use the immediate value as is and we'll be done.
-    result = generate_LDI(inst_loc, rd, rd_loc, imm, imm_loc);
+    if (_verbose)
+        std::cout << "          "
+                  << "    GET_LABEL_ADDRESS found label: '" << findIt->first << "', address=: " << findIt->second << std::endl;
+    if (get_offset)
+    {
+      result = findIt->second - programCounter;
+    }
+    else
+    {
+      result = findIt->second;
+    }
   }
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-
   return result;
+}
+
+bool
+QISA_Driver::findClassicOpcode(const std::string& instruction_name, int& opcode)
+{
+  const uint32_t tableMask = CLASSIC_OPCODE_TABLE_SIZE - 1;
+  const char* name = instruction_name.data();
+  const size_t length = instruction_name.size();
+
+  const uint32_t bucket = QISA_Hash::hashName(name, length, 0) & tableMask;
+  const ClassicOpcodeSlot& slot =
+    classicOpcodeSlots[QISA_Hash::hashName(name, length, classicOpcodeDisplacements[bucket]) & tableMask];
+
+  // The slot may belong to another name, so compare the names.
+  if (!slot.name || !QISA_Hash::equalNames(name, length, slot.name, strlen(slot.name)))
+  {
+    return false;
+  }
 
+  opcode = slot.opcode;
+  return true;
 }
 
-/* ALIAS: [MULT2 rd,rs] --> [ADD rd,rs,rs] */
 bool
-QISA_Driver::generate_MULT2(const location& inst_loc,
-                            uint8_t rd,
-                            const location& rd_loc,
-                            uint8_t rs,
-                            const location& rs_loc)
+QISA_Driver::get_opcode(const std::string& instruction_name,
+                        const QISA::location& instruction_name_loc,
+                        int& opcode,
+                        QISA_InstructionKind instruction_kind)
+{
+  // Both lookups are case insensitive, so the instruction name can be used as is.
+  countMapLookup();
+  const auto quantumIt = _quantumMnemonics.find(instruction_name);
+
+  if (instruction_kind == IK_SINGLE_FORMAT)
+  {
+    countMapLookup();
+    if (findClassicOpcode(instruction_name, opcode))
+    {
+      return true;
+    }
+  }
+  else if (quantumIt && (quantumIt->second.opcodes[instruction_kind] >= 0))
+  {
+    opcode = quantumIt->second.opcodes[instruction_kind];
+    return true;
+  }
+
+  // The opcode of the requested instruction kind has not been found.
+  // Check if it is specified for one of the other instruction kinds.
+  // If so, the user has mixed up his parameters, so give him a hint about that.
+  int otherOpcode;
+
+  if ((instruction_kind != IK_SINGLE_FORMAT) &&
+      findClassicOpcode(instruction_name, otherOpcode))
+  {
+    _errorStream << instruction_name_loc << ": "
+                 << "Classic instruction '" << instruction_name
+                 << "' used instead of a quantum instruction. "
+                 << std::endl;
+  }
+  else if ((instruction_kind != IK_DF_ARG_NONE) &&
+           quantumIt && (quantumIt->second.opcodes[IK_DF_ARG_NONE] >= 0))
+  {
+    _errorStream << instruction_name_loc << ": "
+                 << "Instruction '" << instruction_name
+                 << "' takes no parameters."
+                 << std::endl;
+
+  }
+  else if ((instruction_kind != IK_DF_ARG_ST) &&
+           quantumIt && (quantumIt->second.opcodes[IK_DF_ARG_ST] >= 0))
+  {
+    _errorStream << instruction_name_loc << ": "
+                 << "Instruction '" << instruction_name
+                 << "' needs an S-register argument."
+                 << std::endl;
+  }
+  else if ((instruction_kind != IK_DF_ARG_TT) &&
+           quantumIt && (quantumIt->second.opcodes[IK_DF_ARG_TT] >= 0))
+  {
+    _errorStream << instruction_name_loc << ": "
+                 << "Instruction '" << instruction_name
+                 << "' needs a T-register argument."
+                 << std::endl;
+  }
+  else
+  {
+    _errorStream << instruction_name_loc << ": opcode for '" << instruction_name << "' not found" << std::endl;
+  }
+
+  _errorLoc = instruction_name_loc;
+  return false;
+}
+
+// Assembly generation functions.
+
+/* nop */
+bool
+QISA_Driver::generate_NOP(const QISA::location& inst_loc)
 {
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
   if (_verbose)
       std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- ALIAS: MULT2(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
+                << "NOP();" << std::endl;
+  int opcode;
 
-  // We leave checking the parameters up to the generation functions we call.
+  if (!get_opcode("NOP", inst_loc, opcode))
+  {
+    return false;
+  }
 
-  bool result = generate_XXX_rd_rs_rt("ADD", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
+  qisa_instruction_type instruction = (((opcode & OPCODE_MASK) & OPCODE_MASK) << OPCODE_OFFSET);
 
-  if (result && _verbose)
-      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-                << "-- END ALIAS" << std::endl;
-  return result;
+  _instructions.emplace_back(instruction);
+  return true;
 }
 
+
+/* stop */
 bool
-QISA_Driver::checkRegisterNumber(uint8_t reg_nr, const QISA::location& register_nr_loc, RegisterKind register_kind)
+QISA_Driver::generate_STOP(const QISA::location& inst_loc)
 {
-  if (reg_nr >= _nrOfRegisters[register_kind])
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "STOP();" << std::endl;
+  int opcode;
+
+  if (!get_opcode("STOP", inst_loc, opcode))
   {
-    _errorStream << register_nr_loc << ": register nr (" << (int)reg_nr << ") too high, max="
-                 << _nrOfRegisters[register_kind] - 1 << std::endl;
-    _errorLoc = register_nr_loc;
     return false;
   }
 
+  qisa_instruction_type instruction = (((opcode & OPCODE_MASK) & OPCODE_MASK) << OPCODE_OFFSET);
+
+  _instructions.emplace_back(instruction);
   return true;
 }
 
-
+/* add rd, rs, rt */
+/* sub rd, rs, rt */
+/* and rd, rs, rt */
+/* or  rd, rs, rt */
+/* xor rd, rs, rt */
 bool
-QISA_Driver::checkValueRange(int64_t val,
-                             int64_t minVal,
-                             int64_t maxVal,
-                             const std::string& val_name,
-                             const QISA::location& val_loc)
+QISA_Driver::generate_XXX_rd_rs_rt(const std::string& inst_name,
+                                   const QISA::location& inst_loc,
+                                   uint8_t rd,
+                                   const QISA::location& rd_loc,
+                                   uint8_t rs,
+                                   const QISA::location& rs_loc,
+                                   uint8_t rt,
+                                   const QISA::location& rt_loc)
 {
-    if ((val < minVal) || (val > maxVal))
-    {
-      _errorStream << val_loc << ": "
-                   << val_name
-                   << " (" << val << ") too large, min="
-                   << minVal << ", max=" << maxVal << std::endl;
-      _errorLoc = val_loc;
-      return false;
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << inst_name << "(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode(inst_name, inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  {
+    return false;
+  }
+  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | ((rs & RS_MASK) << RS_OFFSET)
+                                      | ((rt & RT_MASK) << RT_OFFSET);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* not rd, rt */
+bool QISA_Driver::generate_NOT(const location& inst_loc,
+                               uint8_t rd,
+                               const location& rd_loc,
+                               uint8_t rt,
+                               const location& rt_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "NOT(rd=" << (int)rd << ",rt=" << (int)rt << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("NOT", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | ((rt & RT_MASK) << RT_OFFSET);
+
+  _instructions.emplace_back(instruction);
+  return true;
+
+}
+
+/* cmp rs,rt */
+bool
+QISA_Driver::generate_CMP(const QISA::location& inst_loc,
+                          uint8_t rs,
+                          const QISA::location& rs_loc,
+                          uint8_t rt,
+                          const QISA::location& rt_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "CMP(rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("CMP", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  {
+    return false;
+  }
+  if (!checkRegisterNumber(rt, rt_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rs & RS_MASK) << RS_OFFSET)
+                                      | ((rt & RT_MASK) << RT_OFFSET);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* br cond, addr */
+bool
+QISA_Driver::generate_BR(const location& inst_loc,
+                         uint8_t cond,
+                         const location& cond_loc,
+                         int64_t addr,
+                         const location& addr_loc,
+                         bool is_alias)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "BR(cond='" << _branchConditionNames[cond] << "',addr=" << addr << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("BR", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | (cond & COND_MASK);
+
+
+  // Handle the label part.
+  // If the label is not yet defined, we will handle it later.
+  if (addr != std::numeric_limits<int64_t>::min())
+  {
+    // The offset is based on the current program counter.
+
+    // An offset is encoded using 21 bits (signed).
+    // Check if the given value is within this range.
+
+    const int64_t minOffset = -(1LL<<20) + 1;
+    const int64_t maxOffset =  (1LL<<20) - 1;
+
+    // The address is relative to the implicit CMP instruction in case of an alias.
+    const int64_t branchAddress = _instructions.size();
+    const int64_t target = branchAddress + addr - (is_alias ? 1 : 0);
+
+    if (_branchRelaxation && (addr < minOffset) && (target >= 0))
+    {
+      // The label is out of reach. The branch is rewritten once all addresses are known.
+      _longBranches.push_back({ static_cast<uint64_t>(branchAddress), static_cast<uint64_t>(target) });
+      _instructions.emplace_back(instruction);
+      return true;
+    }
+
+    if (!checkValueRange(addr, minOffset, maxOffset, "addr", addr_loc))
+    {
+      return false;
+    }
+
+    if (is_alias)
+    {
+      // Correct for the implicit CMP instruction that precedes the actual branch instruction.
+      if (addr < 0)
+      {
+        addr--;
+      }
+      else
+      {
+        // The positive case is already been handled implicitely by the fact that
+        // the program counter already advanced by one due to the CMP instruction.
+      }
+    }
+
+    instruction |= ((addr & ADDR_MASK) << ADDR_OFFSET);
+  }
+  else
+  {
+    // A deferred instruction has been created in the attempt to resolve a label.
+    // Locate this and set the instruction type.
+
+    auto findIt = _deferredInstructions.find(addr_loc);
+    if (findIt == _deferredInstructions.end())
+    {
+      // This should not happen.
+      _errorStream << "INTERNAL ASSEMBLER ERROR <BR:DEFER>, location=" << addr_loc << std::endl;
+      _errorLoc = addr_loc;
+      return false;
+    }
+    else
+    {
+      findIt->second.instruction = QISA_Parser::token::TOK_BR;
+      findIt->second.programCounter = _instructions.size();
+    }
+  }
+
+  _instructions.emplace_back(instruction);
+
+  return true;
+}
+
+/* ldi rd, imm */
+bool QISA_Driver::generate_LDI(const location& inst_loc,
+                               uint8_t rd,
+                               const location& rd_loc,
+                               int64_t imm,
+                               const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "LDI(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("LDI", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  // The 'imm' value is encoded using 20 bits (signed).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = -(1LL<<19) + 1;
+  const int64_t maxImm =  (1LL<<19) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | (imm & IMM20_MASK);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* ldui rd, u_imm */
+bool QISA_Driver::generate_LDUI(const location& inst_loc,
+                               uint8_t rd,
+                                const location& rd_loc,
+                               int64_t imm,
+                                const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "LDUI(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("LDUI", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  // The 'imm' value is encoded using 15 bits (unsigned).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = 0;
+  const int64_t maxImm = (1LL<<15) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | ((rd & RS_MASK) << RS_OFFSET) // Note: rs <-- rd
+                                      | (imm & U_IMM15_MASK);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* fbr cond, rd */
+bool
+QISA_Driver::generate_FBR(const location& inst_loc,
+                          uint8_t cond,
+                          const location& cond_loc,
+                          uint8_t rd,
+                          const location& rd_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "FBR(cond='" << _branchConditionNames[cond] << "',rd=" << (int)rd << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("FBR", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | (cond & COND_MASK);
+
+  _instructions.emplace_back(instruction);
+
+  return true;
+}
+
+/* fmr rd, qs */
+bool
+QISA_Driver::generate_FMR(const location& inst_loc,
+                          uint8_t rd,
+                          const location& rd_loc,
+                          uint8_t qs,
+                          const location& qs_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "FMR(rd=" << (int)rd << ",qs=" << (int)qs << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("FMR", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rd, rd_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(qs, qs_loc, Q_REGISTER))
+  {
+    return false;
+  }
+
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rd & RD_MASK) << RD_OFFSET)
+                                      | (qs & QS_MASK);
+
+  _instructions.emplace_back(instruction);
+
+  return true;
+}
+
+/* smis sd, s_mask */
+bool
+QISA_Driver::generate_SMIS(const location& inst_loc,
+                           uint8_t sd,
+                           const location& sd_loc,
+                           const std::vector<uint8_t>& s_mask,
+                           const location& s_mask_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "SMIS(sd=" << (int)sd << ",s_mask=" << get_s_mask_str(s_mask) << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("SMIS", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(sd, sd_loc, S_REGISTER))
+  {
+    return false;
+  }
+
+  // Construct the s_mask on bit level.
+  // NOTE: The parser already has checked the given s_mask.
+  int64_t s_mask_bits = 0;
+  for (auto it = s_mask.begin(); it != s_mask.end(); ++it)
+  {
+    s_mask_bits |= (1LL << *it);
+  }
+
+  //divide it into two parts
+  //int64_t s_mask_bits = s_mask_bits & 0x1ffff;
+  int64_t s_mask_bits_array;
+  s_mask_bits_array = s_mask_bits & 0x1ffff;
+
+  //corresponding pos value
+  //No position field for SMIS
+
+  // Encode the parameters into an instruction and add it to the instruction list.
+  unsafe_generate_SMIS(opcode, sd, s_mask_bits_array);
+  //unsafe_generate_SMIS(opcode, sd, pos1, s_mask_bits1);
+  //unsafe_generate_SMIS(opcode, sd, pos2, s_mask_bits2);
+
+  return true;
+}
+
+
+std::vector<uint8_t>
+QISA_Driver::bits2s_mask(int64_t s_mask_bits)
+{
+  std::vector<uint8_t> result;
+  for (int i = 0; (i < _topology.nrOfQubits()) && (i < 64); i++)
+  {
+    if (s_mask_bits & (1LL << i))
+    {
+      result.push_back(i);
+    }
+  }
+
+  return result;
+}
+
+std::vector<QISA_Driver::TargetControlPair>
+QISA_Driver::bits2t_mask(int64_t t_mask_bits)
+{
+  std::vector<TargetControlPair>  result;
+  for (size_t i = 0; (i < _topology.nrOfEdges()) && (i < 64); i++)
+  {
+    if (t_mask_bits & ( 1LL<< i))
+    {
+      result.push_back(_topology.getEdge(i));
+    }
+  }
+
+  return result;
+}
+
+
+/* smis sd, imm  (NOTE: Alternative representation.) */
+bool
+QISA_Driver::generate_SMIS(const location& inst_loc,
+                           uint8_t sd,
+                           const location& sd_loc,
+                           int64_t imm,
+                           const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "SMIS(sd=" << (int)sd << ",imm=" << imm << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("SMIS", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(sd, sd_loc, S_REGISTER))
+  {
+    return false;
+  }
+
+  // The 'imm' value is encoded using 7 bits (unsigned).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = 0;
+  const int64_t maxImm = (1LL<<17) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  // Encode the parameters into an instruction and add it to the instruction list.
+  unsafe_generate_SMIS(opcode, sd, imm);
+
+  return true;
+}
+
+
+
+// Used by the two flavors of generate_SMIS.
+// All arguments are supposed to have been checked.
+void
+QISA_Driver::unsafe_generate_SMIS(int opcode,
+                                  uint8_t sd,
+                                  int64_t s_mask_bits)
+{
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((sd & SD_MASK) << SD_OFFSET)
+                                      | (s_mask_bits & S_MASK_MASK);
+
+  _instructions.emplace_back(instruction);
+}
+
+
+/* smit td, t_mask */
+bool
+QISA_Driver::generate_SMIT(const location& inst_loc,
+                           uint8_t td,
+                           const location& td_loc,
+                           const std::vector<TargetControlPair>& t_mask,
+                           const location& t_mask_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "SMIT(td=" << (int)td << ",t_mask=" << get_t_mask_str(t_mask) << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("SMIT", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(td, td_loc, T_REGISTER))
+  {
+    return false;
+  }
+
+  // Construct the t_mask on bit level.
+  // NOTE: The parser already has checked the given t_mask.
+
+  int64_t t_mask_bits = 0;
+  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
+  {
+    const int t_mask_bit = _topology.findEdge(*it);
+    t_mask_bits |= (1LL << t_mask_bit);
+  }
+
+  // Encode the parameters into instructions and add them to the instruction list.
+  unsafe_generate_SMIT_parts(opcode, td, t_mask_bits);
+
+  return true;
+}
+
+/* smit td, imm  (NOTE: Alternative representation.) */
+bool
+QISA_Driver::generate_SMIT(const location& inst_loc,
+                           uint8_t td,
+                           const location& td_loc,
+                           int64_t imm,
+                           const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "SMIT(td=" << (int)td << ",imm=" << imm << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("SMIT", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(td, td_loc, T_REGISTER))
+  {
+    return false;
+  }
+
+  // The 'imm' value is encoded using 16 bits (unsigned).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = 0;
+  const int64_t maxImm = (1LL<<48) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  // Now, we must subject this value to the same tests as done in validate_t_mask.
+
+  // First, we will convert the given immediate value to a vector of tc_pairs.
+  auto t_mask = bits2t_mask(imm);
+
+  // Now we can perform the check.
+  if (!validate_t_mask(t_mask, imm_loc))
+  {
+    return false;
+  }
+
+  // Encode the parameters into an instruction and add it to the instruction list.
+  unsafe_generate_SMIT(opcode, td, 0, imm);
+
+  return true;
+}
+
+
+
+// Used by the two flavors of generate_SMIT.
+// All arguments are supposed to have been checked.
+void
+QISA_Driver::unsafe_generate_SMIT(int opcode,
+                                  uint8_t td,
+                                  uint8_t pos,
+                                  int64_t t_mask_bits)
+{
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((td & TD_MASK) << TD_OFFSET)
+                                      | ((pos & POS_MASK) << POS_OFFSET)
+                                      | (t_mask_bits & T_MASK_MASK);
+
+  _instructions.emplace_back(instruction);
+}
+
+// Used by generate_SMIT with a t_mask.
+// The t_mask is divided over pos_number_t instructions, one per value of pos.
+void
+QISA_Driver::unsafe_generate_SMIT_parts(int opcode,
+                                        uint8_t td,
+                                        int64_t t_mask_bits)
+{
+  const int nrOfTMaskBitsPerPos = std::bitset<32>(T_MASK_MASK).count();
+
+  for (int pos = 0; pos < pos_number_t; ++pos)
+  {
+    unsafe_generate_SMIT(opcode, td, pos, t_mask_bits >> (nrOfTMaskBitsPerPos * pos));
+  }
+}
+
+
+/* qwait u_imm */
+bool
+QISA_Driver::generate_QWAIT(const location& inst_loc,
+                            int64_t imm,
+                            const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "QWAIT(u_imm=" << imm << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("QWAIT", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  // The 'imm' value is encoded using 20 bits (unsigned).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = 0;
+  const int64_t maxImm = (1LL<<20) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | (imm & U_IMM20_MASK);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* qwaitr rs */
+bool
+QISA_Driver::generate_QWAITR(const QISA::location& inst_loc,
+                             uint8_t rs,
+                             const QISA::location& rs_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "QWAITR(rs=" << (int)rs << ");" << std::endl;
+
+  int opcode;
+
+  if (!get_opcode("QWAITR", inst_loc, opcode))
+  {
+    return false;
+  }
+
+  if (!checkRegisterNumber(rs, rs_loc, R_REGISTER))
+  {
+    return false;
+  }
+
+  qisa_instruction_type instruction = ((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                      | ((rs & RS_MASK) << RS_OFFSET);
+
+  _instructions.emplace_back(instruction);
+  return true;
+}
+
+/* ALIAS: [SHL1 rd,rs] --> [ADD rd,rs,rs] */
+bool
+QISA_Driver::generate_SHL1(const location& inst_loc,
+                           uint8_t rd,
+                           const location& rd_loc,
+                           uint8_t rs,
+                           const location& rs_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: SHL1(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+
+
+  bool result = generate_XXX_rd_rs_rt("ADD", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [NAND rd,rs,rt] --> [AND rd,rs,rt ; NOT rd,rd] */
+bool
+QISA_Driver::generate_NAND(const location& inst_loc,
+                           uint8_t rd,
+                           const location& rd_loc,
+                           uint8_t rs,
+                           const location& rs_loc,
+                           uint8_t rt,
+                           const location& rt_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: NAND(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_XXX_rd_rs_rt("AND", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
+
+  if (result)
+  {
+    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
+  }
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [NOR rd,rs,rt] --> [OR rd,rs,rt ; NOT rd,rd] */
+bool
+QISA_Driver::generate_NOR(const location& inst_loc,
+                          uint8_t rd,
+                          const location& rd_loc,
+                          uint8_t rs,
+                          const location& rs_loc,
+                          uint8_t rt,
+                          const location& rt_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: NOR(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_XXX_rd_rs_rt("OR", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
+
+  if (result)
+  {
+    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
+  }
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [XNOR rd,rs,rt] --> [XOR rd,rs,rt ; NOT rd,rd] */
+bool
+QISA_Driver::generate_XNOR(const location& inst_loc,
+                           uint8_t rd,
+                           const location& rd_loc,
+                           uint8_t rs,
+                           const location& rs_loc,
+                           uint8_t rt,
+                           const location& rt_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: XNOR(rd=" << (int)rd << ",rs=" << (int)rs << ",rt=" << (int)rt << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_XXX_rd_rs_rt("XOR", inst_loc, rd, rd_loc, rs, rs_loc, rt, rt_loc);
+
+  if (result)
+  {
+    result = generate_NOT(inst_loc, rd, rd_loc, rd, rd_loc);
+  }
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [BRA addr] --> [BR always, addr] */
+bool
+QISA_Driver::generate_BRA(const location& inst_loc,
+                          int64_t addr,
+                          const location& addr_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: BRA(addr=" << addr << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_BR(inst_loc, COND_ALWAYS, inst_loc, addr, addr_loc);
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [GOTO addr] --> [BR always, addr] */
+bool
+QISA_Driver::generate_GOTO(const location& inst_loc,
+                           int64_t addr,
+                           const location& addr_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: GOTO(addr=" << addr << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_BR(inst_loc, COND_ALWAYS, inst_loc, addr, addr_loc);
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+
+/* ALIAS: [BRN addr] --> [BR never, addr] */
+bool
+QISA_Driver::generate_BRN(const location& inst_loc,
+                          int64_t addr,
+                          const location& addr_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: BRN(addr=" << addr << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_BR(inst_loc, COND_NEVER, inst_loc, addr, addr_loc);
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* BEQ   rs, rt, addr  */
+/* BNE   rs, rt, addr  */
+/* BLT   rs, rt, addr  */
+/* BLE   rs, rt, addr  */
+/* BGT   rs, rt, addr  */
+/* BGE   rs, rt, addr  */
+/* BLTU  rs, rt, addr  */
+/* BLEU  rs, rt, addr  */
+/* BGTU  rs, rt, addr  */
+/* BGEU  rs, rt, addr  */
+
+/* ALIAS: [BXX rs,rt,addr] --> [CMP rs,rt; BR XX,addr] */
+bool
+QISA_Driver::generate_BR_COND(const location& inst_loc,
+                              uint8_t rs,
+                              const location& rs_loc,
+                              uint8_t rt,
+                              const location& rt_loc,
+                              int64_t addr,
+                              const location& addr_loc,
+                              QISA_Driver::BranchCondition cond)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: B" << _branchConditionNames[cond]
+                   << "(rs=" << (int)rs << ",rt=" << (int)rt << ",addr=" << addr << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_CMP(inst_loc, rs, rs_loc, rt, rt_loc);
+
+  if (result)
+  {
+    // Mark the fact that this branch is the result of an alias.
+    result = generate_BR(inst_loc, cond, inst_loc, addr, addr_loc, true);
+  }
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+/* ALIAS: [MOV rd,rs] --> [LDI rd,0 ; ADD rd,rs,rd] */
+
+bool
+QISA_Driver::generate_COPY(const location& inst_loc,
+                          uint8_t rd,
+                          const location& rd_loc,
+                          uint8_t rs,
+                          const location& rs_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: COPY(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+  bool result = generate_XXX_rd_rs_rt("OR", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+bool QISA_Driver::generate_MOV(const location& inst_loc,
+                                uint8_t rd,
+                                const location& rd_loc,
+                                int64_t imm,
+                                const location& imm_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: MOV(rd=" << (int)rd << ",imm=" << imm << ");" << std::endl;
+
+
+  // The 'imm' value is encoded using 32 bits (signed).
+  // Check if the given value is within this range.
+
+  const int64_t minImm = -(1LL<<31) + 1;
+  const int64_t maxImm =  (1LL<<31) - 1;
+
+  if (!checkValueRange(imm, minImm, maxImm, "imm", imm_loc))
+  {
+    return false;
+  }
+
+  bool result = false;
+
+  const int64_t minImm20 = -(1LL<<19) + 1;
+  const int64_t maxImm20 =  (1LL<<19) - 1;
+
+  if (imm < minImm20 || imm > maxImm20)
+  {
+    // If the immediate doesn't fit in a 20 bit signed integer, we must split the given value into a lower and an upper part.
+    // The lower part will have 17 bits and the upper part will have the rest (15 bits).
+    const int64_t lowerPart = imm & U_IMM17_MASK;
+    const int64_t upperPart = ((imm & ~U_IMM17_MASK) >> 17) & U_IMM15_MASK;
+
+    result = generate_LDI(inst_loc, rd, rd_loc, lowerPart, imm_loc);
+
+    if (result)
+    {
+      result = generate_LDUI(inst_loc, rd, rd_loc, upperPart, imm_loc);
+    }
+  }
+  else
+  {
+    // We can use the immediate value as is and we'll be done.
+    result = generate_LDI(inst_loc, rd, rd_loc, imm, imm_loc);
+  }
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+
+  return result;
+
+}
+
+/* ALIAS: [MULT2 rd,rs] --> [ADD rd,rs,rs] */
+bool
+QISA_Driver::generate_MULT2(const location& inst_loc,
+                            uint8_t rd,
+                            const location& rd_loc,
+                            uint8_t rs,
+                            const location& rs_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- ALIAS: MULT2(rd=" << (int)rd << ",rs=" << (int)rs << ");" << std::endl;
+
+  // We leave checking the parameters up to the generation functions we call.
+
+  bool result = generate_XXX_rd_rs_rt("ADD", inst_loc, rd, rd_loc, rs, rs_loc, rs, rs_loc);
+
+  if (result && _verbose)
+      std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+                << "-- END ALIAS" << std::endl;
+  return result;
+}
+
+bool
+QISA_Driver::checkRegisterNumber(uint8_t reg_nr, const QISA::location& register_nr_loc, RegisterKind register_kind)
+{
+  if (reg_nr >= _nrOfRegisters[register_kind])
+  {
+    _errorStream << register_nr_loc << ": register nr (" << (int)reg_nr << ") too high, max="
+                 << _nrOfRegisters[register_kind] - 1 << std::endl;
+    _errorLoc = register_nr_loc;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool
+QISA_Driver::checkValueRange(int64_t val,
+                             int64_t minVal,
+                             int64_t maxVal,
+                             const std::string& val_name,
+                             const QISA::location& val_loc)
+{
+    if ((val < minVal) || (val > maxVal))
+    {
+      _errorStream << val_loc << ": "
+                   << val_name
+                   << " (" << val << ") too large, min="
+                   << minVal << ", max=" << maxVal << std::endl;
+      _errorLoc = val_loc;
+      return false;
+    }
+
+    return true;
+}
+
+bool
+QISA_Driver::validate_qubit_address(uint8_t qubit_address,
+                                        const location& loc)
+{
+  if (qubit_address > (_topology.nrOfQubits() - 1))
+  {
+    _errorStream << loc << ": Invalid qubit number used. Valid range: [0-"
+                 << (_topology.nrOfQubits() - 1) << "]" << std::endl;
+    _errorLoc = loc;
+    return false;
+  }
+  return true;
+}
+
+
+bool
+QISA_Driver::validate_s_mask(const std::vector<uint8_t>& s_mask,
+                             const location& s_mask_loc)
+{
+  // A valid s_mask:
+  //   - contains at least one element,
+  //   - contains at most as many elements as there are qubits,
+  //   - has no duplicates
+
+  // It is assumed here that the qubit values given in s_mask have already been validated.
+  if (s_mask.empty())
+  {
+    _errorStream << s_mask_loc << ": Need at least one bit in s_mask" << std::endl;
+    _errorLoc = s_mask_loc;
+    return false;
+  }
+
+  if ((int)s_mask.size() > _topology.nrOfQubits())
+  {
+    _errorStream << s_mask_loc << ": to many bits in s_mask: max=" << _topology.nrOfQubits() << std::endl;
+    _errorLoc = s_mask_loc;
+    return false;
+  }
+
+  // Check for duplicates
+  QISA_Topology::QubitMask prev_values;
+  for (auto it = s_mask.begin(); it != s_mask.end(); ++it)
+  {
+    if (prev_values.test(*it))
+    {
+      _errorStream << s_mask_loc << ": duplicate entry in s_mask: " << (int)*it << std::endl;
+      _errorLoc = s_mask_loc;
+      return false;
+    }
+
+    prev_values.set(*it);
+  }
+
+  return true;
+}
+
+
+bool
+QISA_Driver::validate_t_mask(const std::vector<TargetControlPair>& t_mask,
+                             const location& t_mask_loc)
+{
+  // A valid t_mask:
+  //   - contains at least one element,
+  //   - should not exceed the number of valid pairs,
+  //   - has no duplicates
+  //   - a qubit address can appear no more than once.
+
+  // It is assumed here that the vector elements given in t_mask have already been validated.
+  if (t_mask.empty())
+  {
+    _errorStream << t_mask_loc << ": Need at least one target control pair in t_mask" << std::endl;
+    _errorLoc = t_mask_loc;
+    return false;
+  }
+
+  if (t_mask.size() > _topology.nrOfEdges())
+  {
+    _errorStream << t_mask_loc << ": too many pairs in t_mask: max="
+                 << _topology.nrOfEdges() << std::endl;
+    _errorLoc = t_mask_loc;
+    return false;
+  }
+
+  // Check for duplicates.
+  // The edge ids are the t_mask bit numbers, of which there are at most 64 (see read()).
+  uint64_t prev_edges = 0;
+  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
+  {
+    const uint64_t edge_bit = 1ULL << _topology.findEdge(*it);
+    if (prev_edges & edge_bit)
+    {
+      _errorStream << t_mask_loc << ": duplicate entry in t_mask: " << get_tc_pair_str(*it) << std::endl;
+      _errorLoc = t_mask_loc;
+      return false;
+    }
+
+    prev_edges |= edge_bit;
+  }
+
+  // Ensure that each qubit only appears once in the list.
+  QISA_Topology::QubitMask prev_qubit_uses;
+  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
+  {
+    const int edge_id = _topology.findEdge(*it);
+    const QISA_Topology::QubitMask& edge_qubits = _topology.getEdgeQubits(edge_id);
+
+    if ((prev_qubit_uses & edge_qubits).none())
+    {
+      prev_qubit_uses |= edge_qubits;
+    }
+    else
+    {
+      const bool first_used = prev_qubit_uses.test(it->first);
+      const bool second_used = prev_qubit_uses.test(it->second);
+
+      std::ostringstream ss;
+      if (first_used && second_used)
+      {
+        ss << ": qubits '" << (int)it->first << "' and '" << (int)it->second << "' are ";
+      }
+      else if (first_used)
+      {
+        ss << ": qubit '" << (int)it->first << "' is ";
+      }
+      else
+      {
+        ss << ": qubit '" << (int)it->second << "' is ";
+      }
+
+      _errorStream << t_mask_loc << ss.str()
+                   << "used in more than one target-control pair in t_mask. Offending entry: "
+                   << get_tc_pair_str(*it) << " (t_mask bit "
+                   << edge_id << ") " << std::endl;
+      _errorLoc = t_mask_loc;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool QISA_Driver::validate_target_control_pair(const TargetControlPair& target_control_pair,
+                                               const location& target_control_pair_loc)
+{
+  if (_topology.findEdge(target_control_pair) < 0)
+  {
+    _errorStream << target_control_pair_loc << ": ("
+                 << (int)target_control_pair.first << ","
+                 << (int)target_control_pair.second
+                 << ") is an invalid target-control pair" << std::endl;
+    _errorLoc = target_control_pair_loc;
+    return false;
+  }
+
+  return true;
+}
+
+bool
+QISA_Driver::validate_bundle_separator(uint8_t bs_val,
+                                       const location& bs_loc)
+{
+  if (!checkValueRange(bs_val, 0, 7, "BS", bs_loc))
+  {
+    return false;
+  }
+
+  return true;
+}
+
+QInstructionPtr
+QISA_Driver::get_q_instr_arg_none(const std::string& inst_name,
+                                  const location& inst_loc)
+{
+  int opcode;
+
+  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_NONE))
+  {
+    return NULL;
+  }
+
+  return _qInstructionArena.create(opcode);
+}
+
+QInstructionPtr
+QISA_Driver::get_q_instr_arg_st(const std::string& inst_name,
+                                const location& inst_loc,
+                                uint8_t st,
+                                const location& st_loc,
+                                bool is_conditional)
+{
+  int opcode;
+
+  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_ST))
+  {
+    return NULL;
+  }
+
+  if (!checkRegisterNumber(st, st_loc, S_REGISTER))
+  {
+    return NULL;
+  }
+
+  return _qInstructionArena.create(opcode, st, is_conditional);
+}
+
+QInstructionPtr
+QISA_Driver::get_q_instr_arg_tt(const std::string& inst_name,
+                                const location& inst_loc,
+                                uint8_t tt,
+                                const location& tt_loc)
+{
+  int opcode;
+
+  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_TT))
+  {
+    return NULL;
+  }
+
+  if (!checkRegisterNumber(tt, tt_loc, T_REGISTER))
+  {
+    return NULL;
+  }
+
+  return _qInstructionArena.create(opcode, tt);
+}
+
+QInstructionPtr
+QISA_Driver::get_q_instr_arg_one(const std::string& inst_name,
+                                 const location& inst_loc,
+                                 const std::string& reg_name,
+                                 const location& reg_name_loc)
+{
+  countMapLookup();
+  const auto quantumIt = _quantumMnemonics.find(inst_name);
+
+  if (quantumIt && (quantumIt->second.opcodes[IK_DF_ARG_ST] >= 0))
+  {
+    // This is a quantum instruction that expects an s-register.
+    // The given reg_name should be an existing s-register alias.
+
+    uint8_t reg_nr;
+    bool success = get_register_nr(reg_name, reg_name_loc, QISA::QISA_Driver::S_REGISTER, reg_nr);
+    if (success)
+    {
+      // By giving the false flag, we make sure that a s-register
+      // type quantum instruction is created.
+      return _qInstructionArena.create(quantumIt->second.opcodes[IK_DF_ARG_ST], reg_nr, false);
+    }
+    else
+    {
+      // An error message has already been given by get_register_nr().
+      // However, to keep consistent with the rest of the error messages,
+      // add another one that specifically states that an s-register is expected.
+      addExpectationErrorMessage("an S_REGISTER");
+      return NULL;
+    }
+  }
+  else
+  {
+    if (quantumIt && (quantumIt->second.opcodes[IK_DF_ARG_TT] >= 0))
+    {
+      // This is a quantum instruction that expects a t-register.
+      // The given reg_name should be an existing t-register alias.
+
+      uint8_t reg_nr;
+      bool success = get_register_nr(reg_name, reg_name_loc, QISA::QISA_Driver::T_REGISTER, reg_nr);
+      if (success)
+      {
+        return _qInstructionArena.create(quantumIt->second.opcodes[IK_DF_ARG_TT], reg_nr);
+      }
+      else
+      {
+        // An error message has already been given by get_register_nr().
+        // However, to keep consistent with the rest of the error messages,
+        // add another one that specifically states that an s-register is expected.
+        addExpectationErrorMessage("a T_REGISTER");
+        return NULL;
+      }
+    }
+    else
+    {
+      _errorStream << inst_loc << ": opcode for quantum instruction '" << inst_name << "' not found" << std::endl;
+      _errorLoc = inst_loc;
+      return NULL;
+    }
+  }
+}
+
+
+
+uint64_t
+QISA_Driver::encode_q_instr(const QInstruction& q_inst)
+{
+  uint64_t result;
+  result = (q_inst.opcode & Q_INST_OPCODE_MASK) << Q_INST_OPCODE_OFFSET;
+
+  switch (q_inst.type) {
+    case QInstruction::ARG_NONE:
+      break;
+    case QInstruction::ARG_ST:
+      result |= (q_inst.reg_nr & Q_INST_SD_MASK)
+                | (q_inst.is_conditional & 1) << Q_INST_ST_COND_OFFSET;
+      break;
+    case QInstruction::ARG_TT:
+      result |= (q_inst.reg_nr & Q_INST_TD_MASK);
+      break;
+    default:
+      // Set to 0 in case another type has been given that we
+      // don't now of yet...
+      result = 0;
+  }
+
+  return result;
+}
+
+
+bool
+QISA_Driver::decode_q_instr(uint64_t q_inst, std::string& q_inst_str)
+{
+  int opc = (q_inst >> Q_INST_OPCODE_OFFSET) & Q_INST_OPCODE_MASK;
+
+  location errLoc = location();
+
+  // The decode table tells the name of the instruction and which argument it has.
+  const QuantumDecodeEntry& decodeEntry = _quantumDecodeTable[opc];
+
+  switch (decodeEntry.kind)
+  {
+    case QUANTUM_DECODE_ARG_ST:
+    {
+      int rs = (q_inst & Q_INST_SD_MASK);
+      if (!checkRegisterNumber(rs, errLoc, S_REGISTER))
+        return false;
+
+      bool is_cond = (q_inst >> Q_INST_ST_COND_OFFSET) & 1;
+
+      q_inst_str = is_cond ? "C," : "";
+      q_inst_str += decodeEntry.name + " S" + std::to_string(rs);
+      break;
+    }
+
+    case QUANTUM_DECODE_ARG_TT:
+    {
+      int rt = (q_inst & Q_INST_TD_MASK);
+      if (!checkRegisterNumber(rt, errLoc, T_REGISTER))
+        return false;
+
+      q_inst_str = decodeEntry.name + " T" + std::to_string(rt);
+      break;
+    }
+
+    case QUANTUM_DECODE_ARG_NONE:
+    {
+      q_inst_str = decodeEntry.name;
+      break;
+    }
+
+    default:
+    {
+      _errorStream << "Unknown quantum opcode: " << getHex(opc, 2);
+      _errorLoc = errLoc;
+      q_inst_str = "<INVALID QUANTUM OPCODE: " + getHex(opc, 2) + ">";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool
+QISA_Driver::generate_q_bundle(uint8_t bs_val,
+                               const location& bs_loc,
+                               const BundledQInstructions& bundle,
+                               const location& bundle_loc)
+{
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::codeGenerationTime);
+
+  if (_verbose)
+  {
+    std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
+              << "Q_BUNDLE: bs=" << (int)bs_val
+              << ", bundle: (";
+
+    auto it = bundle.begin();
+    if (it != bundle.end())
+    {
+      std::cout << _quantumOpcode2instName[(*it)->opcode];
+    }
+    ++it;
+    for (; it != bundle.end(); ++it)
+    {
+      std::cout << "," << _quantumOpcode2instName[(*it)->opcode];
+    }
+    std::cout << ")" << std::endl;
+  }
+
+  if (_statsEnabled)
+  {
+    _stats.nrOfBundles++;
+  }
+
+  if (_vliwPacking)
+  {
+    generate_packed_q_bundle(bs_val, bundle);
+    return true;
+  }
+
+  bool issued_bs = false;
+
+  for (auto it = bundle.begin(); it != bundle.end(); ++it)
+  {
+    // Quantum instructions are put pair-wise in a
+    // 'very large instruction word' (VLIW).
+
+    // The double instruction format always start with the highest bit set.
+    qisa_instruction_type instruction = (1L << DBL_INST_FORMAT_BIT_OFFSET);
+
+    // Set the bundle separator. This comes at the last 3 bits.
+    // Only do this for the first VLIW of the bundle.
+    if (!issued_bs)
+    {
+      instruction |= (bs_val & BS_MASK);
+      issued_bs = true;
+    }
+
+    // Handle the first pair of the VLIW.
+
+    instruction |= (encode_q_instr(**it) << VLIW_INST_0_OFFSET);
+
+    // Handle the second pair of the VLIW (if there are any quantum instructions left to encode).
+    ++it;
+    if (it != bundle.end())
+    {
+      instruction |= (encode_q_instr(**it) << VLIW_INST_1_OFFSET);
+    }
+    // This VLIW is done. Save it.
+    _instructions.emplace_back(instruction);
+
+    if (_statsEnabled)
+    {
+      _stats.nrOfVliwWords++;
+    }
+
+    // Apparently, the compiler doesn't like when we mess around with the loop iterator ourselves...
+    // It will not detect the end-of-vector properly.
+    if (it == bundle.end())
+      break;
+  }
+
+  return true;
+}
+
+void
+QISA_Driver::generate_packed_q_bundle(uint8_t bs_val,
+                                      const BundledQInstructions& bundle)
+{
+  const qisa_instruction_type dblInstFormatBit = (1U << DBL_INST_FORMAT_BIT_OFFSET);
+  const int vliwOffsets[] = { VLIW_INST_0_OFFSET, VLIW_INST_1_OFFSET };
+
+  // A free slot of a VLIW holds a QNOP, which is encoded as zero.
+  auto hasFreeSlot = [&](qisa_instruction_type vliw)
+  {
+    return !((vliw >> VLIW_INST_0_OFFSET) & VLIW_Q_INST_MASK) ||
+           !((vliw >> VLIW_INST_1_OFFSET) & VLIW_Q_INST_MASK);
+  };
+
+  // Index in _instructions of the VLIW whose free slots are filled next, if any.
+  const size_t noVliw = static_cast<size_t>(-1);
+  size_t vliwIndex = noVliw;
+
+  // The instructions of a bundle without wait time are executed at the same time as
+  // those in the VLIW before it, so they can use its free slots. This is not done if
+  // a label refers to this bundle, as that would move instructions before the label.
+  const bool canJoinPreviousVliw = (bs_val == 0) &&
+                                   !_instructions.empty() &&
+                                   (_lastLabelAddress != _instructions.size()) &&
+                                   (_instructions.back() & dblInstFormatBit);
+
+  if (canJoinPreviousVliw && hasFreeSlot(_instructions.back()))
+  {
+    vliwIndex = _instructions.size() - 1;
+  }
+
+  bool issued_bs = false;
+
+  for (auto it = bundle.begin(); it != bundle.end(); ++it)
+  {
+    const qisa_instruction_type q_inst = static_cast<qisa_instruction_type>(encode_q_instr(**it));
+
+    if (q_inst == 0)
+    {
+      // A QNOP is the same as a free slot.
+      continue;
+    }
+
+    if (vliwIndex == noVliw)
+    {
+      // Start a new VLIW. Only the first VLIW of the bundle gets the bundle separator.
+      qisa_instruction_type instruction = dblInstFormatBit;
+
+      if (!issued_bs)
+      {
+        instruction |= (bs_val & BS_MASK);
+        issued_bs = true;
+      }
+
+      vliwIndex = _instructions.size();
+      _instructions.emplace_back(instruction);
+
+      if (_statsEnabled)
+      {
+        _stats.nrOfVliwWords++;
+      }
+    }
+
+    qisa_instruction_type& vliw = _instructions[vliwIndex];
+
+    for (int vliwOffset : vliwOffsets)
+    {
+      if (!((vliw >> vliwOffset) & VLIW_Q_INST_MASK))
+      {
+        vliw |= (q_inst << vliwOffset);
+        break;
+      }
+    }
+
+    if (!hasFreeSlot(vliw))
+    {
+      vliwIndex = noVliw;
+    }
+  }
+
+  // A bundle of only QNOPs can only be left out if it is executed at the same time as the
+  // VLIW before it. Otherwise, it is still needed for its wait time or its label.
+  if (!issued_bs && !canJoinPreviousVliw)
+  {
+    _instructions.emplace_back(dblInstFormatBit | (bs_val & BS_MASK));
+
+    if (_statsEnabled)
+    {
+      _stats.nrOfVliwWords++;
+    }
+  }
+}
+
+
+std::string
+QISA_Driver::get_s_mask_str(const std::vector<uint8_t>& s_mask)
+{
+  std::ostringstream ss;
+  ss << "{";
+  if (!s_mask.empty())
+  {
+    auto it = s_mask.begin();
+    ss << (int)*it;
+    it++;
+    for (;it != s_mask.end(); ++it)
+    {
+      ss << ", " << (int)*it;
+    }
+  }
+  ss << "}";
+
+  return ss.str();
+}
+
+std::string
+QISA_Driver::get_tc_pair_str(const TargetControlPair& tc_pair)
+{
+  std::ostringstream ss;
+  ss << "(" << (int)tc_pair.first << "," << (int)tc_pair.second << ")";
+  return ss.str();
+}
+
+
+std::string
+QISA_Driver::get_t_mask_str(const std::vector<QISA_Driver::TargetControlPair>& t_mask)
+{
+  std::ostringstream ss;
+  ss << "{";
+  if (!t_mask.empty())
+  {
+    auto it = t_mask.begin();
+
+    ss << get_tc_pair_str(*it);
+    it++;
+    for (;it != t_mask.end(); ++it)
+    {
+      ss << ", " << get_tc_pair_str(*it);
+    }
+  }
+  ss << "}";
+
+  return ss.str();
+}
+
+
+bool
+QISA_Driver::processDeferredInstructions()
+{
+  // Assume that there are no errors...
+  int result = true;
+
+  if (!_deferredInstructions.empty())
+  {
+    if (_verbose)
+      std::cout << "Processing deferred instructions..." << std::endl;
+  }
+
+  for (auto& itKV : _deferredInstructions)
+  {
+    if (itKV.second.label_name == "<<MULTI_LABEL_ERROR>>")
+    {
+      // An error has already been detected: an undeclared label has been used multiple times for the same instruction.
+      // This is as of yet not supported.
+      _errorStream << itKV.second.label_name_loc
+                   << ": Using multiple labels for one instruction is not supported." << std::endl;
+      _errorLoc = itKV.second.label_name_loc;
+
+      // Set return value to false to indicate an error condition.
+      result = false;
+
+      if (_errorRecovery)
+      {
+        recordDiagnostic();
+      }
+
+      // Continue with the next deferred instruction.
+      continue;
+    }
+
+    countMapLookup();
+    auto findIt = _labels.find(itKV.second.label_name);
+    if (!findIt)
+    {
+      // Label has not been defined in this program.
+      // Issue an error.
+
+      _errorStream << itKV.second.label_name_loc
+                   << ": Label '" << itKV.second.label_name << "' not found." << std::endl;
+      _errorLoc = itKV.second.label_name_loc;
+
+      // Set return value to false to indicate an error condition.
+      result = false;
+
+      // Without error recovery, only one error can be reported with its source line,
+      // so we return at the first missing label.
+      if (!_errorRecovery)
+      {
+        return result;
+      }
+
+      recordDiagnostic();
+
+      // Continue with the next deferred instruction.
+      continue;
+    }
+
+    const uint64_t label_address = findIt->second;
+
+    switch (itKV.second.instruction)
+    {
+      case QISA_Parser::token::TOK_BR:
+      {
+        int64_t offset = label_address - itKV.second.programCounter;
+
+        // Ensure that the new offset is valid.
+
+        // An offset is encoded using 21 bits (signed).
+        // Check if the given value is within this range.
+
+        const int64_t minOffset = -(1LL<<20) + 1;
+        const int64_t maxOffset =  (1LL<<20) - 1;
+
+        if (_branchRelaxation && ((offset < minOffset) || (offset > maxOffset)))
+        {
+          // The label is out of reach. The branch is rewritten by relaxBranches().
+          _longBranches.push_back({ itKV.second.programCounter, label_address });
+          break;
+        }
+
+        if (!checkValueRange(offset, minOffset, maxOffset, "addr", itKV.second.label_name_loc))
+        {
+          if (!_errorRecovery)
+          {
+            return false;
+          }
+
+          recordDiagnostic();
+          result = false;
+          break;
+        }
+
+        if (itKV.second.is_alias)
+        {
+          // Correct for the implicit CMP instruction that precedes the actual branch instruction.
+          // Normally, the branch offset will always be positive, but just to be sure we handle
+          // the negative case also.
+          if (offset < 0)
+          {
+            offset--;
+          }
+          else
+          {
+            // The positive case is already been handled implicitely by the fact that
+            // the program counter already advanced by one due to the CMP instruction.
+          }
+        }
+
+
+        // We only have to set the offset, so we 'or' the affected instruction with this offset.
+        _instructions[itKV.second.programCounter] |= ((offset & ADDR_MASK) << ADDR_OFFSET);
+
+        if (_verbose)
+        {
+          std::cout << "Resolved label offset for instruction " << itKV.second.programCounter
+                    << " to " << offset << std::endl;
+        }
+
+        break;
+      }
+      default:
+      {
+        _errorStream << itKV.second.label_name_loc
+                     << ": Use of forward defined label '" << itKV.second.label_name
+                     << "' for this instruction is not yet supported!" << std::endl;
+        _errorLoc = itKV.second.label_name_loc;
+        // Set return value to false to indicate an error condition.
+        result = false;
+
+        if (_errorRecovery)
+        {
+          recordDiagnostic();
+        }
+
+        break;
+      }
     }
+  }
 
-    return true;
+  return result;
 }
 
+
 bool
-QISA_Driver::validate_qubit_address(uint8_t qubit_address,
-                                        const location& loc)
+QISA_Driver::relaxBranches()
 {
-  if (qubit_address > (_totalNrOfQubits - 1))
-  {
-    _errorStream << loc << ": Invalid qubit number used. Valid range: [0-"
-                 << (_totalNrOfQubits - 1) << "]" << std::endl;
-    _errorLoc = loc;
-    return false;
-  }
-  return true;
-}
+  const size_t nrOfWords = _instructions.size();
+  const qisa_instruction_type quantumBit = 1U << DBL_INST_FORMAT_BIT_OFFSET;
 
+  const int64_t minOffset = -(1LL<<20) + 1;
+  const int64_t maxOffset =  (1LL<<20) - 1;
 
-bool
-QISA_Driver::validate_s_mask(const std::vector<uint8_t>& s_mask,
-                             const location& s_mask_loc)
-{
-  // A valid s_mask:
-  //   - contains at least one element,
-  //   - contains at most _totalNrOfQubits elements,
-  //   - has no duplicates
+  auto isInReach = [&](uint64_t from, uint64_t to)
+  {
+    const int64_t offset = static_cast<int64_t>(to - from);
+    return (offset >= minOffset) && (offset <= maxOffset);
+  };
 
-  // It is assumed here that the qubit values given in s_mask have already been validated.
-  if (s_mask.empty())
+  int opcode;
+  if (!get_opcode("BR", location(), opcode))
   {
-    _errorStream << s_mask_loc << ": Need at least one bit in s_mask" << std::endl;
-    _errorLoc = s_mask_loc;
     return false;
   }
 
-  if ((int)s_mask.size() > _totalNrOfQubits)
+  auto makeBranch = [&](int cond, uint64_t from, uint64_t to)
   {
-    _errorStream << s_mask_loc << ": to many bits in s_mask: max=" << _totalNrOfQubits << std::endl;
-    _errorLoc = s_mask_loc;
-    return false;
-  }
+    return static_cast<qisa_instruction_type>(((opcode & OPCODE_MASK) << OPCODE_OFFSET)
+                                              | (((to - from) & ADDR_MASK) << ADDR_OFFSET)
+                                              | (cond & COND_MASK));
+  };
 
-  // Check for duplicates
-  std::set<uint8_t> prev_values;
-  for (auto it = s_mask.begin(); it != s_mask.end(); ++it)
+  // The branches of the program, with their target in the current layout.
+  // A branch with a target outside of the program keeps its offset.
+  struct Branch
+  {
+    uint64_t address;
+    int64_t target;
+    int cond;
+    bool isLong;
+  };
+
+  std::vector<Branch> branches;
+  std::vector<bool> isExpanded(nrOfWords, false);
+
+  std::sort(_longBranches.begin(), _longBranches.end(),
+            [](const LongBranch& a, const LongBranch& b) { return a.address < b.address; });
+  auto longBranch = _longBranches.begin();
+
+  for (size_t i = 0; i < nrOfWords; i++)
   {
-    if (prev_values.count(*it) == 0)
+    const qisa_instruction_type inst = _instructions[i];
+
+    if ((inst & quantumBit) ||
+        (_classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind != CLASSIC_DECODE_BR))
+    {
+      continue;
+    }
+
+    Branch branch;
+    branch.address = i;
+    branch.cond = inst & COND_MASK;
+    branch.isLong = (longBranch != _longBranches.end()) && (longBranch->address == i);
+
+    if (branch.isLong)
     {
-      prev_values.insert(*it);
+      branch.target = longBranch->target;
+      ++longBranch;
     }
     else
     {
-      _errorStream << s_mask_loc << ": duplicate entry in s_mask: " << (int)*it << std::endl;
-      _errorLoc = s_mask_loc;
-      return false;
+      // Sign extend the address, which is an offset relative to the branch instruction.
+      struct {signed int x:21;} s;
+      branch.target = static_cast<int64_t>(i) + (s.x = (inst >> ADDR_OFFSET) & ADDR_MASK);
     }
+
+    branches.push_back(branch);
   }
 
-  return true;
-}
+  // A conditional long branch becomes a branch with the inverted condition over an unconditional
+  // branch. The conditions come in pairs that differ in their lowest bit.
+  // An unconditional long branch is replaced by one that starts the chain towards its target.
+  // A branch that is never taken only needs a valid offset.
+  auto isExpandedBranch = [](const Branch& branch)
+  {
+    return branch.isLong && (branch.cond != COND_ALWAYS) && (branch.cond != COND_NEVER);
+  };
 
+  // A quantum instruction word without wait time (bs 0) continues the bundle before it,
+  // so no island may be placed before it.
+  auto isBundleContinuation = [&](uint64_t i)
+  {
+    return (i < nrOfWords) && (_instructions[i] & quantumBit) && ((_instructions[i] & BS_MASK) == 0);
+  };
 
-bool
-QISA_Driver::validate_t_mask(const std::vector<TargetControlPair>& t_mask,
-                             const location& t_mask_loc)
-{
-  // A valid t_mask:
-  //   - contains at least one element,
-  //   - should not exceed the number of valid pairs,
-  //   - has no duplicates
-  //   - a qubit address can appear no more than once.
+  // The chains of unconditional branches run through islands, which are placed about every
+  // 'spacing' instructions of the original program: island k is placed before the start of
+  // the bundle that holds instruction k * spacing (its position). Islands can share a position,
+  // in which case they follow each other. A long branch passes all islands between itself
+  // and its target, and each island holds one unconditional branch per target that passes it.
+  // If a hop does not reach, the islands are placed closer together.
+  uint64_t spacing = 1ULL << 19;
 
-  // It is assumed here that the vector elements given in t_mask have already been validated.
-  if (t_mask.empty())
-  {
-    _errorStream << t_mask_loc << ": Need at least one target control pair in t_mask" << std::endl;
-    _errorLoc = t_mask_loc;
-    return false;
-  }
+  // Islands are numbered from 1; the entries at index 0 are not used.
+  std::vector<std::vector<uint64_t>> islandTargets;
+  std::vector<uint64_t> islandPositions;
+  std::vector<uint64_t> islandAddresses;
+  std::vector<uint64_t> newAddresses(nrOfWords + 1);
 
-  if (t_mask.size() > _valid_target_control_pairs.size())
+  // Number of islands placed before (or at) the given instruction.
+  auto nrOfIslandsBefore = [&](uint64_t i)
   {
-    _errorStream << t_mask_loc << ": too many pairs in t_mask: max="
-                 << _valid_target_control_pairs.size() << std::endl;
-    _errorLoc = t_mask_loc;
-    return false;
-  }
+    return static_cast<uint64_t>(std::upper_bound(islandPositions.begin() + 1, islandPositions.end(), i)
+                                 - (islandPositions.begin() + 1));
+  };
 
-  // Check for duplicates
-  std::set<TargetControlPair> prev_values;
-  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
+  auto forEachIsland = [&](const Branch& branch, const std::function<void(size_t)>& visit)
   {
-    if (prev_values.count(*it) == 0)
+    const uint64_t first = std::min<uint64_t>(branch.address, branch.target);
+    const uint64_t last = std::max<uint64_t>(branch.address, branch.target);
+
+    // Islands in (first, last]: an island before the branch or the target is between them.
+    for (uint64_t k = nrOfIslandsBefore(first) + 1; (k < islandPositions.size()) && (islandPositions[k] <= last); k++)
     {
-      prev_values.insert(*it);
+      visit(k);
     }
-    else
+  };
+
+  // Address of the next hop of the chain towards target, from island k.
+  auto nextHop = [&](uint64_t k, uint64_t target, bool isForward)
+  {
+    const uint64_t next = isForward ? (k + 1) : (k - 1);
+    const bool isBetween = isForward ? ((next < islandPositions.size()) && (islandPositions[next] <= target))
+                                     : ((next >= 1) && (islandPositions[next] > target));
+
+    if (!isBetween)
     {
-      _errorStream << t_mask_loc << ": duplicate entry in t_mask: " << get_tc_pair_str(*it) << std::endl;
-      _errorLoc = t_mask_loc;
-      return false;
+      return newAddresses[target];
     }
-  }
 
-  // Ensure that each qubit only appears once in the list.
-  std::set<uint8_t> prev_qubit_uses;
-  for (auto it = t_mask.begin(); it != t_mask.end(); ++it)
+    const std::vector<uint64_t>& targets = islandTargets[next];
+    return islandAddresses[next] + 1 +
+           (std::lower_bound(targets.begin(), targets.end(), target) - targets.begin());
+  };
+
+  // Address of the first hop of a long branch.
+  auto firstHop = [&](const Branch& branch)
+  {
+    const bool isForward = (static_cast<uint64_t>(branch.target) > branch.address);
+    const uint64_t k = nrOfIslandsBefore(branch.address) + (isForward ? 0 : 1);
+    return nextHop(k, branch.target, isForward);
+  };
+
+  bool isDone = false;
+
+  while (!isDone)
   {
-    size_t first_count = prev_qubit_uses.count(it->first);
-    size_t second_count = prev_qubit_uses.count(it->second);
-    if ((first_count  == 0) &&
-        (second_count == 0))
+    // Determine the layout: the islands and the new address of each instruction.
+    const size_t nrOfIslands = nrOfWords / spacing;
+
+    islandTargets.assign(nrOfIslands + 1, std::vector<uint64_t>());
+    islandPositions.assign(nrOfIslands + 1, 0);
+    islandAddresses.assign(nrOfIslands + 1, 0);
+
+    for (uint64_t k = 1; k <= nrOfIslands; k++)
     {
-      prev_qubit_uses.insert(it->first);
-      prev_qubit_uses.insert(it->second);
+      uint64_t position = k * spacing;
+      while ((position > 0) && isBundleContinuation(position))
+      {
+        position--;
+      }
+
+      islandPositions[k] = position;
     }
-    else
+
+    for (const Branch& branch : branches)
     {
-      std::ostringstream ss;
-      if ((first_count != 0) && (second_count != 0))
+      if (branch.isLong && (branch.cond != COND_NEVER))
       {
-        ss << ": qubits '" << (int)it->first << "' and '" << (int)it->second << "' are ";
+        forEachIsland(branch, [&](size_t k) { islandTargets[k].push_back(branch.target); });
       }
-      else if ((first_count != 0))
+    }
+
+    for (std::vector<uint64_t>& targets : islandTargets)
+    {
+      std::sort(targets.begin(), targets.end());
+      targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    }
+
+    uint64_t nrOfInsertedWords = 0;
+    uint64_t island = 1;
+    auto branch = branches.begin();
+
+    for (size_t i = 0; i <= nrOfWords; i++)
+    {
+      for (; (island <= nrOfIslands) && (islandPositions[island] == i); island++)
       {
-        ss << ": qubit '" << (int)it->first << "' is ";
+        if (!islandTargets[island].empty())
+        {
+          islandAddresses[island] = i + nrOfInsertedWords;
+          nrOfInsertedWords += 1 + islandTargets[island].size();
+        }
       }
-      else
+
+      newAddresses[i] = i + nrOfInsertedWords;
+
+      if ((branch != branches.end()) && (branch->address == i))
       {
-        ss << ": qubit '" << (int)it->second << "' is ";
+        isExpanded[i] = isExpandedBranch(*branch);
+        nrOfInsertedWords += isExpanded[i] ? 1 : 0;
+        ++branch;
       }
+    }
 
-      _errorStream << t_mask_loc << ss.str()
-                   << "used in more than one target-control pair in t_mask. Offending entry: "
-                   << get_tc_pair_str(*it) << " (t_mask bit "
-                   << (int)_valid_target_control_pairs[*it] << ") " << std::endl;
-      _errorLoc = t_mask_loc;
-      return false;
+    // A branch that no longer reaches its target becomes a long branch, which changes the layout.
+    isDone = true;
+
+    for (Branch& branch : branches)
+    {
+      if (!branch.isLong && (branch.cond != COND_NEVER) &&
+          (branch.target >= 0) && (static_cast<uint64_t>(branch.target) <= nrOfWords) &&
+          !isInReach(newAddresses[branch.address], newAddresses[branch.target]))
+      {
+        branch.isLong = true;
+        isDone = false;
+      }
+    }
+
+    if (!isDone)
+    {
+      continue;
+    }
+
+    // Check that each hop of the chains reaches.
+    bool isReached = true;
+
+    for (const Branch& branch : branches)
+    {
+      if (branch.isLong && (branch.cond != COND_NEVER))
+      {
+        const uint64_t from = newAddresses[branch.address] + (isExpanded[branch.address] ? 1 : 0);
+        isReached = isReached && isInReach(from, firstHop(branch)) &&
+                    isInReach(newAddresses[branch.address], newAddresses[branch.address + 1]);
+      }
+    }
+
+    for (uint64_t k = 1; (k <= nrOfIslands) && isReached; k++)
+    {
+      const std::vector<uint64_t>& targets = islandTargets[k];
+      isReached = targets.empty() || isInReach(islandAddresses[k], newAddresses[islandPositions[k]]);
+
+      for (size_t t = 0; (t < targets.size()) && isReached; t++)
+      {
+        isReached = isInReach(islandAddresses[k] + 1 + t, nextHop(k, targets[t], targets[t] >= islandPositions[k]));
+      }
+    }
+
+    if (!isReached)
+    {
+      if (spacing == 1)
+      {
+        _errorStream << "Cannot rewrite the branches whose target is out of reach." << std::endl;
+        _errorLoc = location();
+        return false;
+      }
+
+      spacing /= 2;
+      isDone = false;
     }
   }
 
-  return true;
-}
+  // Generate the instructions in the new layout.
+  std::vector<qisa_instruction_type> instructions;
+  instructions.reserve(newAddresses[nrOfWords]);
 
+  size_t nrOfRelaxedBranches = 0;
+  uint64_t island = 1;
+  auto branch = branches.begin();
 
-bool QISA_Driver::validate_target_control_pair(const TargetControlPair& target_control_pair,
-                                               const location& target_control_pair_loc)
-{
-  auto findIt = _valid_target_control_pairs.find(target_control_pair);
+  for (size_t i = 0; i <= nrOfWords; i++)
+  {
+    for (; (island < islandPositions.size()) && (islandPositions[island] == i); island++)
+    {
+      const std::vector<uint64_t>& targets = islandTargets[island];
+      if (targets.empty())
+      {
+        continue;
+      }
+
+      // Let the program pass over the island (and the islands that follow it).
+      instructions.push_back(makeBranch(COND_ALWAYS, islandAddresses[island], newAddresses[i]));
+
+      for (const uint64_t target : targets)
+      {
+        instructions.push_back(makeBranch(COND_ALWAYS, instructions.size(), nextHop(island, target, target >= i)));
+      }
+    }
+
+    if (i == nrOfWords)
+    {
+      break;
+    }
+
+    if ((branch == branches.end()) || (branch->address != i))
+    {
+      instructions.push_back(_instructions[i]);
+      continue;
+    }
+
+    const uint64_t address = newAddresses[i];
+
+    if (branch->isLong && (branch->cond != COND_NEVER))
+    {
+      if (isExpanded[i])
+      {
+        const int invertedCond = branch->cond ^ 1;
+        instructions.push_back(makeBranch(invertedCond, address, newAddresses[i + 1]));
+      }
+
+      instructions.push_back(makeBranch(COND_ALWAYS, instructions.size(), firstHop(*branch)));
+      nrOfRelaxedBranches++;
+    }
+    else if ((branch->target >= 0) && (static_cast<uint64_t>(branch->target) <= nrOfWords))
+    {
+      // A branch that is never taken may get out of reach; then any offset will do.
+      const uint64_t target = newAddresses[branch->target];
+      instructions.push_back(makeBranch(branch->cond, address, isInReach(address, target) ? target : address));
+    }
+    else
+    {
+      instructions.push_back(_instructions[i]);
+    }
+
+    ++branch;
+  }
 
-  if (findIt == _valid_target_control_pairs.end())
+  if (_verbose)
   {
-    _errorStream << target_control_pair_loc << ": ("
-                 << (int)target_control_pair.first << ","
-                 << (int)target_control_pair.second
-                 << ") is an invalid target-control pair" << std::endl;
-    _errorLoc = target_control_pair_loc;
-    return false;
+    std::cout << "Relaxed " << nrOfRelaxedBranches << " branch(es) whose target is out of reach, using "
+              << (instructions.size() - nrOfWords) << " extra instruction word(s)." << std::endl;
   }
 
+  _instructions.swap(instructions);
+  _nrOfRelaxedBranches = nrOfRelaxedBranches;
   return true;
 }
 
-bool
-QISA_Driver::validate_bundle_separator(uint8_t bs_val,
-                                       const location& bs_loc)
+size_t
+QISA_Driver::deduplicateMasks()
 {
-  if (!checkValueRange(bs_val, 0, 7, "BS", bs_loc))
+  const size_t nrOfWords = _instructions.size();
+  const qisa_instruction_type quantumBit = 1U << DBL_INST_FORMAT_BIT_OFFSET;
+
+  auto isBranch = [&](qisa_instruction_type inst)
   {
-    return false;
+    return !(inst & quantumBit) &&
+           (_classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind == CLASSIC_DECODE_BR);
+  };
+
+  // Sign extend the address of a branch instruction, which is an offset relative to the instruction itself.
+  auto branchOffset = [](qisa_instruction_type inst)
+  {
+    struct {signed int x:21;} s;
+    return static_cast<int64_t>(s.x = (inst >> ADDR_OFFSET) & ADDR_MASK);
+  };
+
+  // At the branch targets, the masks held by the registers are not known.
+  std::vector<bool> isBranchTarget(nrOfWords + 1, false);
+
+  for (size_t i = 0; i < nrOfWords; i++)
+  {
+    if (isBranch(_instructions[i]))
+    {
+      const int64_t target = static_cast<int64_t>(i) + branchOffset(_instructions[i]);
+
+      if ((target < 0) || (target > static_cast<int64_t>(nrOfWords)))
+      {
+        // The program does not stay within itself; leave it as it is.
+        return 0;
+      }
+
+      isBranchTarget[target] = true;
+    }
   }
 
-  return true;
-}
+  // Mask held per S register, and per T register and position. -1 if not known.
+  const int nrOfTMaskParts = POS_MASK + 1;
+  std::vector<int64_t> sMasks(_nrOfRegisters[S_REGISTER], -1);
+  std::vector<int64_t> tMasks(_nrOfRegisters[T_REGISTER] * nrOfTMaskParts, -1);
 
-QInstructionPtr
-QISA_Driver::get_q_instr_arg_none(const std::string& inst_name,
-                                  const location& inst_loc)
-{
-  int opcode;
+  std::vector<bool> isRemoved(nrOfWords, false);
+  size_t nrOfRemovedWords = 0;
+
+  for (size_t i = 0; i < nrOfWords; i++)
+  {
+    if (isBranchTarget[i])
+    {
+      std::fill(sMasks.begin(), sMasks.end(), -1);
+      std::fill(tMasks.begin(), tMasks.end(), -1);
+    }
+
+    const qisa_instruction_type inst = _instructions[i];
+
+    if (inst & quantumBit)
+    {
+      continue;
+    }
+
+    const ClassicDecodeKind kind = _classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind;
+
+    if (kind == CLASSIC_DECODE_SMIS)
+    {
+      const int sd = (inst >> SD_OFFSET) & SD_MASK;
+      const int64_t mask = inst & S_MASK_MASK;
+
+      if (sMasks[sd] == mask)
+      {
+        isRemoved[i] = true;
+        nrOfRemovedWords++;
+        continue;
+      }
+
+      if (_maskRegisterRenaming)
+      {
+        auto holder = std::find(sMasks.begin(), sMasks.end(), mask);
+
+        if ((holder != sMasks.end()) &&
+            renameMaskRegister(i + 1, S_REGISTER, sd, static_cast<int>(holder - sMasks.begin()), isBranchTarget))
+        {
+          // Register sd keeps the mask it held before.
+          isRemoved[i] = true;
+          nrOfRemovedWords++;
+          continue;
+        }
+      }
+
+      sMasks[sd] = mask;
+    }
+    else if (kind == CLASSIC_DECODE_SMIT)
+    {
+      const int td = (inst >> TD_OFFSET) & TD_MASK;
+      const int pos = (inst >> POS_OFFSET) & POS_MASK;
+      const int64_t mask = inst & T_MASK_MASK;
+
+      if (tMasks[td * nrOfTMaskParts + pos] == mask)
+      {
+        isRemoved[i] = true;
+        nrOfRemovedWords++;
+        continue;
+      }
+
+      if (_maskRegisterRenaming && (pos == 0) && isCompleteSMIT(i, td))
+      {
+        // A complete SMIT can be replaced by another register that holds its mask at all positions.
+        bool isRenamed = false;
+
+        for (int tx = 0; (tx < _nrOfRegisters[T_REGISTER]) && !isRenamed; tx++)
+        {
+          bool holdsMask = (tx != td);
+
+          for (int p = 0; (p < pos_number_t) && holdsMask; p++)
+          {
+            holdsMask = (tMasks[tx * nrOfTMaskParts + p] == (_instructions[i + p] & T_MASK_MASK)) &&
+                        ((p == 0) || !isBranchTarget[i + p]);
+          }
+
+          isRenamed = holdsMask &&
+                      renameMaskRegister(i + pos_number_t, T_REGISTER, td, tx, isBranchTarget);
+        }
+
+        if (isRenamed)
+        {
+          // Register td keeps the mask it held before.
+          for (int p = 0; p < pos_number_t; p++)
+          {
+            isRemoved[i + p] = true;
+          }
+
+          nrOfRemovedWords += pos_number_t;
+          i += pos_number_t - 1;
+          continue;
+        }
+      }
 
-  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_NONE))
+      tMasks[td * nrOfTMaskParts + pos] = mask;
+    }
+  }
+
+  if (_verbose)
   {
-    return NULL;
+    std::cout << "Removed " << nrOfRemovedWords << " redundant SMIS/SMIT instruction word(s)." << std::endl;
   }
 
-  return std::make_shared<QInstruction>(opcode);;
-}
+  if (nrOfRemovedWords == 0)
+  {
+    return 0;
+  }
 
-QInstructionPtr
-QISA_Driver::get_q_instr_arg_st(const std::string& inst_name,
-                                const location& inst_loc,
-                                uint8_t st,
-                                const location& st_loc,
-                                bool is_conditional)
-{
-  int opcode;
+  // Address of each instruction after the removal, and of the end of the program.
+  std::vector<int64_t> newAddresses(nrOfWords + 1);
+  int64_t nrOfKeptWords = 0;
 
-  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_ST))
+  for (size_t i = 0; i < nrOfWords; i++)
   {
-    return NULL;
+    newAddresses[i] = nrOfKeptWords;
+    if (!isRemoved[i])
+    {
+      nrOfKeptWords++;
+    }
   }
+  newAddresses[nrOfWords] = nrOfKeptWords;
 
-  if (!checkRegisterNumber(st, st_loc, S_REGISTER))
+  // Move the remaining instructions to their new address, and adjust the branch offsets.
+  // A branch to a removed instruction now goes to the instruction that followed it.
+  // The offsets only become smaller, so they stay in range.
+  for (size_t i = 0; i < nrOfWords; i++)
   {
-    return NULL;
+    if (isRemoved[i])
+    {
+      continue;
+    }
+
+    qisa_instruction_type inst = _instructions[i];
+
+    if (isBranch(inst))
+    {
+      const int64_t target = static_cast<int64_t>(i) + branchOffset(inst);
+      const int64_t offset = newAddresses[target] - newAddresses[i];
+
+      inst = (inst & ~static_cast<qisa_instruction_type>(ADDR_MASK << ADDR_OFFSET))
+             | ((offset & ADDR_MASK) << ADDR_OFFSET);
+    }
+
+    _instructions[newAddresses[i]] = inst;
   }
 
-  return std::make_shared<QInstruction>(opcode, st, is_conditional);
+  _instructions.resize(nrOfKeptWords);
+
+  return nrOfRemovedWords;
 }
 
-QInstructionPtr
-QISA_Driver::get_q_instr_arg_tt(const std::string& inst_name,
-                                const location& inst_loc,
-                                uint8_t tt,
-                                const location& tt_loc)
+bool
+QISA_Driver::renameMaskRegister(size_t first,
+                                RegisterKind registerKind,
+                                int from,
+                                int to,
+                                const std::vector<bool>& isBranchTarget)
 {
-  int opcode;
+  const qisa_instruction_type quantumBit = 1U << DBL_INST_FORMAT_BIT_OFFSET;
+  const int vliwOffsets[] = { VLIW_INST_0_OFFSET, VLIW_INST_1_OFFSET };
 
-  if (!get_opcode(inst_name, inst_loc, opcode, IK_DF_ARG_TT))
-  {
-    return NULL;
-  }
+  const bool isSRegister = (registerKind == S_REGISTER);
+  const ClassicDecodeKind writeKind = isSRegister ? CLASSIC_DECODE_SMIS : CLASSIC_DECODE_SMIT;
+  const QuantumDecodeKind useKind = isSRegister ? QUANTUM_DECODE_ARG_ST : QUANTUM_DECODE_ARG_TT;
+  const qisa_instruction_type registerMask = isSRegister ? Q_INST_SD_MASK : Q_INST_TD_MASK;
 
-  if (!checkRegisterNumber(tt, tt_loc, T_REGISTER))
+  // The uses of register 'from', as (instruction index, offset of the quantum instruction in the VLIW).
+  std::vector<std::pair<size_t, int> > uses;
+  bool isToWritten = false;
+
+  for (size_t i = first; i < _instructions.size(); i++)
   {
-    return NULL;
-  }
+    if (isBranchTarget[i])
+    {
+      // Register 'from' may be used here after coming from elsewhere.
+      return false;
+    }
 
-  return std::make_shared<QInstruction>(opcode, tt);
-}
+    const qisa_instruction_type inst = _instructions[i];
 
-QInstructionPtr
-QISA_Driver::get_q_instr_arg_one(const std::string& inst_name,
-                                 const location& inst_loc,
-                                 const std::string& reg_name,
-                                 const location& reg_name_loc)
-{
-  std::string searchString(inst_name);
+    if (inst & quantumBit)
+    {
+      for (int vliwOffset : vliwOffsets)
+      {
+        const qisa_instruction_type q_inst = (inst >> vliwOffset) & VLIW_Q_INST_MASK;
+        const int opc = (q_inst >> Q_INST_OPCODE_OFFSET) & Q_INST_OPCODE_MASK;
 
-  // Make the instruction name uppercase.
-  // https://stackoverflow.com/a/17793588
-  for (auto & c: searchString) c = toupper((unsigned char)c);
+        if ((_quantumDecodeTable[opc].kind == useKind) &&
+            (static_cast<int>(q_inst & registerMask) == from))
+        {
+          if (isToWritten)
+          {
+            return false;
+          }
 
+          uses.emplace_back(i, vliwOffset);
+        }
+      }
 
-  auto stIt = _q_inst_arg_st_opcodes.find(searchString);
+      continue;
+    }
 
-  if (stIt != _q_inst_arg_st_opcodes.end())
-  {
-    // This is a quantum instruction that expects an s-register.
-    // The given reg_name should be an existing s-register alias.
+    const ClassicDecodeEntry& decodeEntry = _classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK];
 
-    uint8_t reg_nr;
-    bool success = get_register_nr(reg_name, reg_name_loc, QISA::QISA_Driver::S_REGISTER, reg_nr);
-    if (success)
+    if (decodeEntry.kind == CLASSIC_DECODE_BR)
     {
-      // By giving the false flag, we make sure that a s-register
-      // type quantum instruction is created.
-      return std::make_shared<QInstruction>(stIt->second, reg_nr, false);
+      // Register 'from' may be used at the branch target.
+      return false;
     }
-    else
+
+    if ((decodeEntry.kind == CLASSIC_DECODE_NO_ARGS) && (decodeEntry.name == "STOP"))
     {
-      // An error message has already been given by get_register_nr().
-      // However, to keep consistent with the rest of the error messages,
-      // add another one that specifically states that an s-register is expected.
-      addExpectationErrorMessage("an S_REGISTER");
-      return NULL;
+      break;
     }
-  }
-  else
-  {
-    auto ttIt = _q_inst_arg_tt_opcodes.find(searchString);
-    if (ttIt != _q_inst_arg_tt_opcodes.end())
+
+    if (decodeEntry.kind == writeKind)
     {
-      // This is a quantum instruction that expects a t-register.
-      // The given reg_name should be an existing t-register alias.
+      const int reg = isSRegister ? ((inst >> SD_OFFSET) & SD_MASK)
+                                  : ((inst >> TD_OFFSET) & TD_MASK);
 
-      uint8_t reg_nr;
-      bool success = get_register_nr(reg_name, reg_name_loc, QISA::QISA_Driver::T_REGISTER, reg_nr);
-      if (success)
+      if (reg == to)
       {
-        return std::make_shared<QInstruction>(ttIt->second, reg_nr);
+        isToWritten = true;
       }
-      else
+      else if (reg == from)
       {
-        // An error message has already been given by get_register_nr().
-        // However, to keep consistent with the rest of the error messages,
-        // add another one that specifically states that an s-register is expected.
-        addExpectationErrorMessage("a T_REGISTER");
-        return NULL;
+        // Only a complete SMIT replaces the whole mask of a T register.
+        if (!isSRegister && !isCompleteSMIT(i, from))
+        {
+          return false;
+        }
+
+        break;
       }
     }
-    else
-    {
-      _errorStream << inst_loc << ": opcode for quantum instruction '" << inst_name << "' not found" << std::endl;
-      _errorLoc = inst_loc;
-      return NULL;
-    }
   }
-}
-
 
-
-uint64_t
-QISA_Driver::encode_q_instr(const std::shared_ptr<QInstruction>& q_inst)
-{
-  uint64_t result;
-  result = (q_inst->opcode & Q_INST_OPCODE_MASK) << Q_INST_OPCODE_OFFSET;
-
-  switch (q_inst->type) {
-    case QInstruction::ARG_NONE:
-      break;
-    case QInstruction::ARG_ST:
-      result |= (q_inst->reg_nr & Q_INST_SD_MASK)
-                | (q_inst->is_conditional & 1) << Q_INST_ST_COND_OFFSET;
-      break;
-    case QInstruction::ARG_TT:
-      result |= (q_inst->reg_nr & Q_INST_TD_MASK);
-      break;
-    default:
-      // Set to 0 in case another type has been given that we
-      // don't now of yet...
-      result = 0;
+  for (const auto& use : uses)
+  {
+    qisa_instruction_type& inst = _instructions[use.first];
+    inst = (inst & ~(registerMask << use.second)) | (static_cast<qisa_instruction_type>(to) << use.second);
   }
 
-  return result;
+  return true;
 }
 
-
 bool
-QISA_Driver::decode_q_instr(uint64_t q_inst, std::string& q_inst_str)
+QISA_Driver::isCompleteSMIT(size_t index, int td) const
 {
-  std::ostringstream ss;
-
-  int opc = (q_inst >> Q_INST_OPCODE_OFFSET) & Q_INST_OPCODE_MASK;
-
-  location errLoc = location();
-
-  if (_quantumOpcode2instName.find(opc) == _quantumOpcode2instName.end())
+  if (index + pos_number_t > _instructions.size())
   {
-    _errorStream << "Unknown quantum opcode: " << getHex(opc, 2);
-    _errorLoc = errLoc;
-    ss << "<INVALID QUANTUM OPCODE: " << getHex(opc, 2) << ">";
-    q_inst_str = ss.str();
     return false;
   }
 
-  std::string inst_name = _quantumOpcode2instName[opc];
-
-  if (_q_inst_arg_st_opcodes.find(inst_name) != _q_inst_arg_st_opcodes.end())
+  for (int pos = 0; pos < pos_number_t; pos++)
   {
-    int rs = (q_inst & Q_INST_SD_MASK);
-    if (!checkRegisterNumber(rs, errLoc, S_REGISTER))
-      return false;
-
-    bool is_cond = (q_inst >> Q_INST_ST_COND_OFFSET) & 1;
+    const qisa_instruction_type inst = _instructions[index + pos];
 
-    if (is_cond)
+    if ((inst & (1U << DBL_INST_FORMAT_BIT_OFFSET)) ||
+        (_classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind != CLASSIC_DECODE_SMIT) ||
+        (static_cast<int>((inst >> TD_OFFSET) & TD_MASK) != td) ||
+        (static_cast<int>((inst >> POS_OFFSET) & POS_MASK) != pos))
     {
-      ss << "C,";
+      return false;
     }
-
-    ss << inst_name << " S" << rs;
   }
-  else if (_q_inst_arg_tt_opcodes.find(inst_name) != _q_inst_arg_tt_opcodes.end())
-  {
-    int rt = (q_inst & Q_INST_TD_MASK);
-    if (!checkRegisterNumber(rt, errLoc, T_REGISTER))
-      return false;
 
-    ss << inst_name << " T" << rt;
-  }
-  else
+  return true;
+}
+
+bool
+QISA_Driver::analyzeTimeline(QISA_Timeline& timeline)
+{
+  timeline.clear();
+
+  if (_lastDriverAction != DRIVER_ACTION_PARSE)
   {
-    // If it is neither an st nor a tt instruction, it must be one without an argument.
-    ss << inst_name;
+    _errorStream << "Can only analyze the timeline after assembly." << std::endl;
+    _errorLoc = location();
+    return false;
   }
 
-  q_inst_str = ss.str();
+  const size_t nrOfWords = _instructions.size();
+  const qisa_instruction_type quantumBit = 1U << DBL_INST_FORMAT_BIT_OFFSET;
 
-  return true;
-}
+  // A basic block starts at the start of the program, at each branch target and after each branch.
+  // The end of the program is marked as well, to end the last block.
+  std::vector<bool> isBlockStart(nrOfWords + 1, false);
+  isBlockStart[0] = true;
+  isBlockStart[nrOfWords] = true;
 
+  // Branch destinations, named as in the disassembly.
+  std::vector<uint64_t> destinations;
 
-bool
-QISA_Driver::generate_q_bundle(uint8_t bs_val,
-                               const location& bs_loc,
-                               const BundledQInstructions& bundle,
-                               const location& bundle_loc)
-{
-  if (_verbose)
+  // Loops, as (branch target, address of the branch).
+  std::vector<std::pair<uint64_t, uint64_t>> loopRanges;
+
+  for (size_t i = 0; i < nrOfWords; i++)
   {
-    std::cout << std::setw(8) << std::setfill('0') << _instructions.size() << ": " << std::setw(0)
-              << "Q_BUNDLE: bs=" << (int)bs_val
-              << ", bundle: (";
+    const qisa_instruction_type inst = _instructions[i];
 
-    auto it = bundle.begin();
-    if (it != bundle.end())
+    if ((inst & quantumBit) ||
+        (_classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind != CLASSIC_DECODE_BR))
     {
-      std::cout << _quantumOpcode2instName[(*it)->opcode];
+      continue;
     }
-    ++it;
-    for (; it != bundle.end(); ++it)
+
+    // Sign extend the address, which is an offset relative to the branch instruction.
+    struct {signed int x:21;} s;
+    const uint64_t destination = i + static_cast<int64_t>(s.x = (inst >> ADDR_OFFSET) & ADDR_MASK);
+
+    destinations.push_back(destination);
+    isBlockStart[i + 1] = true;
+
+    if (destination <= i)
     {
-      std::cout << "," << _quantumOpcode2instName[(*it)->opcode];
+      isBlockStart[destination] = true;
+      loopRanges.emplace_back(destination, i);
+    }
+    else if (destination < nrOfWords)
+    {
+      isBlockStart[destination] = true;
     }
-    std::cout << ")" << std::endl;
   }
 
-  bool issued_bs = false;
-
-  for (auto it = bundle.begin(); it != bundle.end(); ++it)
-  {
-    // Quantum instructions are put pair-wise in a
-    // 'very large instruction word' (VLIW).
+  std::sort(destinations.begin(), destinations.end());
+  destinations.erase(std::unique(destinations.begin(), destinations.end()), destinations.end());
 
-    // The double instruction format always start with the highest bit set.
-    qisa_instruction_type instruction = (1L << DBL_INST_FORMAT_BIT_OFFSET);
+  const int nrOfDigitsPerLabel = getNrOfDisassemblyLabelDigits(destinations.size());
 
-    // Set the bundle separator. This comes at the last 3 bits.
-    // Only do this for the first VLIW of the bundle.
-    if (!issued_bs)
+  auto getLabel = [&](uint64_t address)
+  {
+    auto it = std::lower_bound(destinations.begin(), destinations.end(), address);
+    if ((it == destinations.end()) || (*it != address))
     {
-      instruction |= (bs_val & BS_MASK);
-      issued_bs = true;
+      return std::string();
     }
 
-    // Handle the first pair of the VLIW.
+    std::ostringstream ssLabel;
+    ssLabel << DISASSEMBLY_LABEL_PREFIX << std::setw(nrOfDigitsPerLabel) << std::setfill('0')
+            << (it - destinations.begin());
+    return ssLabel.str();
+  };
 
-    instruction |= (encode_q_instr(*it) << VLIW_INST_0_OFFSET);
+  timeline.program.startAddress = 0;
+  timeline.program.endAddress = nrOfWords;
+  analyzeTimelineSection(timeline.program, &timeline.operations);
 
-    // Handle the second pair of the VLIW (if there are any quantum instructions left to encode).
-    ++it;
-    if (it != bundle.end())
+  // The blocks follow each other on the timeline.
+  uint64_t cycle = 0;
+
+  for (size_t start = 0; start < nrOfWords; )
+  {
+    size_t end = start + 1;
+    while (!isBlockStart[end])
     {
-      instruction |= (encode_q_instr(*it) << VLIW_INST_1_OFFSET);
+      end++;
     }
-    // This VLIW is done. Save it.
-    _instructions.emplace_back(instruction);
 
-    // Apparently, the compiler doesn't like when we mess around with the loop iterator ourselves...
-    // It will not detect the end-of-vector properly.
-    if (it == bundle.end())
-      break;
+    QISA_Timeline::Section block = QISA_Timeline::Section();
+    block.kind = QISA_Timeline::SECTION_BLOCK;
+    block.label = getLabel(start);
+    block.startAddress = start;
+    block.endAddress = end;
+    block.startCycle = cycle;
+    analyzeTimelineSection(block, nullptr);
+
+    cycle += block.cycles;
+    timeline.blocks.push_back(block);
+    start = end;
   }
 
-  return true;
-}
+  for (const auto& loopRange : loopRanges)
+  {
+    // The loop starts where the block at its branch target starts.
+    auto firstBlock = std::lower_bound(timeline.blocks.begin(), timeline.blocks.end(), loopRange.first,
+                                       [](const QISA_Timeline::Section& block, uint64_t address)
+                                       {
+                                         return block.startAddress < address;
+                                       });
 
+    QISA_Timeline::Section loop = QISA_Timeline::Section();
+    loop.kind = QISA_Timeline::SECTION_LOOP;
+    loop.label = getLabel(loopRange.first);
+    loop.startAddress = loopRange.first;
+    loop.endAddress = loopRange.second + 1;
+    loop.startCycle = firstBlock->startCycle;
+    analyzeTimelineSection(loop, nullptr);
 
-std::string
-QISA_Driver::get_s_mask_str(const std::vector<uint8_t>& s_mask)
-{
-  std::ostringstream ss;
-  ss << "{";
-  if (!s_mask.empty())
-  {
-    auto it = s_mask.begin();
-    ss << (int)*it;
-    it++;
-    for (;it != s_mask.end(); ++it)
-    {
-      ss << ", " << (int)*it;
-    }
+    timeline.loops.push_back(loop);
   }
-  ss << "}";
 
-  return ss.str();
+  return true;
 }
 
 std::string
-QISA_Driver::get_tc_pair_str(const TargetControlPair& tc_pair)
+QISA_Driver::getTimelineOutput(const std::string& format)
 {
-  std::ostringstream ss;
-  ss << "(" << (int)tc_pair.first << "," << (int)tc_pair.second << ")";
-  return ss.str();
-}
-
+  if ((format != "csv") && (format != "json") && (format != "chrome"))
+  {
+    _errorStream << "Unknown timeline format: '" << format << "'. Valid formats: csv, json, chrome." << std::endl;
+    _errorLoc = location();
+    return "";
+  }
 
-std::string
-QISA_Driver::get_t_mask_str(const std::vector<QISA_Driver::TargetControlPair>& t_mask)
-{
-  std::ostringstream ss;
-  ss << "{";
-  if (!t_mask.empty())
+  QISA_Timeline timeline;
+  if (!analyzeTimeline(timeline))
   {
-    auto it = t_mask.begin();
+    return "";
+  }
 
-    ss << get_tc_pair_str(*it);
-    it++;
-    for (;it != t_mask.end(); ++it)
-    {
-      ss << ", " << get_tc_pair_str(*it);
-    }
+  std::ostringstream ss;
+
+  if (format == "csv")
+  {
+    timeline.writeCsv(ss);
+  }
+  else if (format == "json")
+  {
+    timeline.writeJson(ss);
+  }
+  else
+  {
+    timeline.writeChromeTrace(ss);
   }
-  ss << "}";
 
   return ss.str();
 }
 
-
-bool
-QISA_Driver::processDeferredInstructions()
+void
+QISA_Driver::analyzeTimelineSection(QISA_Timeline::Section& section,
+                                    std::vector<QISA_Timeline::Operation>* operations)
 {
-  // Assume that there are no errors...
-  int result = true;
+  const qisa_instruction_type quantumBit = 1U << DBL_INST_FORMAT_BIT_OFFSET;
+  const int slotOffsets[] = { VLIW_INST_0_OFFSET, VLIW_INST_1_OFFSET };
 
-  if (!_deferredInstructions.empty())
-  {
-    if (_verbose)
-      std::cout << "Processing deferred instructions..." << std::endl;
-  }
+  // Cycle relative to the start of the section.
+  uint64_t cycle = 0;
 
-  for (auto& itKV : _deferredInstructions)
-  {
-    if (itKV.second.label_name == "<<MULTI_LABEL_ERROR>>")
-    {
-      // An error has already been detected: an undeclared label has been used multiple times for the same instruction.
-      // This is as of yet not supported.
-      _errorStream << itKV.second.label_name_loc
-                   << ": Using multiple labels for one instruction is not supported." << std::endl;
-      _errorLoc = itKV.second.label_name_loc;
+  // Whether a quantum instruction word without wait time (bs 0) adds to the current bundle.
+  // A bundle ends at a QWAIT or QWAITR instruction.
+  bool isInBundle = false;
+  uint64_t bundleWidth = 0;
 
-      // Set return value to false to indicate an error condition.
-      result = false;
+  // Last cycle at which an operation has started; 0 if none has started yet.
+  uint64_t lastBusyCycle = 0;
+  uint64_t nrOfBusyCycles = 0;
 
-      // Continue with the next deferred instruction.
-      continue;
-    }
+  for (uint64_t address = section.startAddress; address < section.endAddress; address++)
+  {
+    const qisa_instruction_type inst = _instructions[address];
 
-    auto findIt = _labels.find(itKV.second.label_name);
-    if (findIt == _labels.end())
+    if (!(inst & quantumBit))
     {
-      // Label has not been defined in this program.
-      // Issue an error.
-
-      _errorStream << itKV.second.label_name_loc
-                   << ": Label '" << itKV.second.label_name << "' not found." << std::endl;
-      _errorLoc = itKV.second.label_name_loc;
+      const ClassicDecodeKind kind = _classicDecodeTable[(inst >> OPCODE_OFFSET) & OPCODE_MASK].kind;
 
-      // Set return value to false to indicate an error condition.
-      result = false;
+      if (kind == CLASSIC_DECODE_QWAIT)
+      {
+        cycle += inst & U_IMM20_MASK;
+        isInBundle = false;
+      }
+      else if (kind == CLASSIC_DECODE_QWAITR)
+      {
+        section.nrOfDynamicWaits++;
+        isInBundle = false;
+      }
 
-// We used to return multiple errors, but this breaks things with error reporting.
-#if 0
-      // Continue with the next deferred instruction.
       continue;
-#endif
-      // Now, we return at the first missing label.
-      return result;
     }
 
-    const uint64_t label_address = findIt->second;
+    const int bs = inst & BS_MASK;
 
-    switch (itKV.second.instruction)
+    if ((bs != 0) || !isInBundle)
     {
-      case QISA_Parser::token::TOK_BR:
-      {
-        int64_t offset = label_address - itKV.second.programCounter;
+      cycle += bs;
+      section.nrOfBundles++;
+      isInBundle = true;
+      bundleWidth = 0;
+    }
 
-        // Ensure that the new offset is valid.
+    for (const int slotOffset : slotOffsets)
+    {
+      const qisa_instruction_type q_inst = (inst >> slotOffset) & VLIW_Q_INST_MASK;
 
-        // An offset is encoded using 21 bits (signed).
-        // Check if the given value is within this range.
+      // QNOP is encoded as 0.
+      if (q_inst == 0)
+      {
+        continue;
+      }
 
-        const int64_t minOffset = -(1LL<<20) + 1;
-        const int64_t maxOffset =  (1LL<<20) - 1;
+      if (operations != nullptr)
+      {
+        QISA_Timeline::Operation operation;
+        operation.cycle = section.startCycle + cycle;
+        operation.address = address;
+        operation.slot = static_cast<unsigned>(bundleWidth);
+        decode_q_instr(q_inst, operation.name);
+        operations->push_back(operation);
+      }
 
+      section.nrOfOperations++;
+      bundleWidth++;
+      section.maxBundleWidth = std::max(section.maxBundleWidth, bundleWidth);
 
-        if (!checkValueRange(offset, minOffset, maxOffset, "addr", itKV.second.label_name_loc))
-        {
-          return false;
-        }
+      if (cycle > lastBusyCycle)
+      {
+        section.maxIdleGap = std::max(section.maxIdleGap, cycle - lastBusyCycle - 1);
+        lastBusyCycle = cycle;
+        nrOfBusyCycles++;
+      }
+    }
+  }
 
-        if (itKV.second.is_alias)
-        {
-          // Correct for the implicit CMP instruction that precedes the actual branch instruction.
-          // Normally, the branch offset will always be positive, but just to be sure we handle
-          // the negative case also.
-          if (offset < 0)
-          {
-            offset--;
-          }
-          else
-          {
-            // The positive case is already been handled implicitely by the fact that
-            // the program counter already advanced by one due to the CMP instruction.
-          }
-        }
+  section.cycles = cycle;
+  section.idleCycles = cycle - nrOfBusyCycles;
+  section.maxIdleGap = std::max(section.maxIdleGap, cycle - lastBusyCycle);
+}
 
 
-        // We only have to set the offset, so we 'or' the affected instruction with this offset.
-        _instructions[itKV.second.programCounter] |= ((offset & ADDR_MASK) << ADDR_OFFSET);
+const std::vector<QISA_Driver::qisa_instruction_type>&
+QISA_Driver::getInstructions() const
+{
+  return _instructions;
+}
 
-        if (_verbose)
-        {
-          std::cout << "Resolved label offset for instruction " << itKV.second.programCounter
-                    << " to " << offset << std::endl;
-        }
+std::shared_ptr<const std::vector<QISA_Driver::qisa_instruction_type>>
+QISA_Driver::shareInstructions()
+{
+  if (!_sharedInstructions)
+  {
+    _sharedInstructions = std::make_shared<std::vector<qisa_instruction_type>>();
+  }
 
-        break;
-      }
-      default:
-      {
-        _errorStream << itKV.second.label_name_loc
-                     << ": Use of forward defined label '" << itKV.second.label_name
-                     << "' for this instruction is not yet supported!" << std::endl;
-        _errorLoc = itKV.second.label_name_loc;
-        // Set return value to false to indicate an error condition.
-        result = false;
+  return _sharedInstructions;
+}
 
-        break;
-      }
+void
+QISA_Driver::releaseSharedInstructions()
+{
+  if (_sharedInstructions)
+  {
+    // Swapping keeps the memory of the instructions where it is.
+    if (_sharedInstructions.use_count() > 1)
+    {
+      _sharedInstructions->swap(_instructions);
     }
-  }
 
-  return result;
+    _sharedInstructions.reset();
+  }
 }
 
-
 std::vector<std::string>
 QISA_Driver::getInstructionsAsHexStrings(bool withBinaryOutput)
 {
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::outputFormatTime);
+
   std::vector<std::string> result;
 
   if (withBinaryOutput)
@@ -3144,6 +5382,18 @@ QISA_Driver::getInstructionsAsHexStrings(bool withBinaryOutput)
   return result;
 }
 
+void
+QISA_Driver::setDisassemblyThreads(unsigned nrOfThreads)
+{
+  _nrOfDisassemblyThreads = nrOfThreads;
+}
+
+void
+QISA_Driver::setAssemblyCacheDirectory(const std::string& directory)
+{
+  _assemblyCacheDirectory = directory;
+}
+
 bool
 QISA_Driver::setDisassemblyFormat(int format_id)
 {
@@ -3165,79 +5415,88 @@ std::string QISA_Driver::getDisassemblyOutput()
     return "Can only get disassembly output after successful disassembly!";
   }
 
-  // Determine the longest assembly output line.
-  // This will be used to properly indent the instruction
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::outputFormatTime);
+
+  // The length of the longest assembly output line has been determined
+  // while decoding. It is used to properly indent the instruction
   // hex code comment in output format 2.
+  const size_t maxDisassemblyLineLength = getDisassemblyLineLength();
 
-  size_t maxDisassemblyLineLength = 0;
-  if (_disassemblyFormatId == 2)
+  if (_disassemblyLabels.empty())
   {
-    for (auto it : _disassembledInstructions)
-    {
-      if (maxDisassemblyLineLength < it.second.instruction.size())
-      {
-        maxDisassemblyLineLength = it.second.instruction.size();
-      }
-    }
-    // Add 4 to leave some space between the end of the instruction text
-    // and the start of the hex code.
-    maxDisassemblyLineLength += 4;
-    // Add the label string length to it.
-    // This will be zero when no branch instructions were used.
-    maxDisassemblyLineLength += _disassemblyLabelStringLength;
+    // This is the simple (but unlikely) case where there are no branch
+    // instructions in the code.
+
+    if (_verbose)
+      std::cout << "No branch instructions found." << std::endl;
   }
 
+  // The output is formatted per range of instructions, possibly in parallel.
+  // Afterwards, the formatted ranges are concatenated.
+  std::vector<std::pair<size_t, std::string> > formattedRanges;
+  std::mutex formattedRangesMutex;
+
+  forEachDisassemblyRange([&](size_t first, size_t last)
+  {
+    std::ostringstream ssRange;
+    writeDisassembly(ssRange, first, last, maxDisassemblyLineLength);
+
+    std::lock_guard<std::mutex> lock(formattedRangesMutex);
+    formattedRanges.emplace_back(first, ssRange.str());
+  });
+
+  std::sort(formattedRanges.begin(), formattedRanges.end());
+
+  size_t outputSize = 0;
+  for (const auto& formattedRange : formattedRanges)
+  {
+    outputSize += formattedRange.second.size();
+  }
 
   // This will hold the disassembly output to return.
-  std::stringstream disassemblyOutput;
+  std::string disassemblyOutput;
+  disassemblyOutput.reserve(outputSize);
 
-  if (_disassemblyLabels.empty())
+  for (const auto& formattedRange : formattedRanges)
   {
-    // This is the simple (but unlikely) case where there are no branch
-    // instructions in the code.
+    disassemblyOutput += formattedRange.second;
+  }
 
-    if (_verbose)
-      std::cout << "No branch instructions found." << std::endl;
+  return disassemblyOutput;
+}
 
-    if (_disassemblyFormatId == 1)
-    {
-      for (auto it : _disassembledInstructions)
-      {
-        disassemblyOutput << it.second.hexCode << "  # " << it.second.instruction << std::endl;
-      }
-    }
-    else // For now there are only two output formats, so this must be format 2.
-    {
-      for (auto it : _disassembledInstructions)
-      {
-        disassemblyOutput << std::setw(maxDisassemblyLineLength) << std::left
-                  << it.second.instruction << "# "
-                  << it.second.hexCode << std::endl;
-      }
-    }
+void
+QISA_Driver::writeDisassembly(std::ostream& os, size_t first, size_t last, size_t maxDisassemblyLineLength)
+{
+  for (size_t i = first; i < last; i++)
+  {
+    writeDisassembledInstruction(os, _disassembledInstructions[i], maxDisassemblyLineLength);
   }
-  else
+}
+
+void
+QISA_Driver::writeDisassembledInstruction(std::ostream& os,
+                                          const DisassembledInstruction& disassembledInstruction,
+                                          size_t maxDisassemblyLineLength)
+{
+  // Note that the label is empty if there are no branch instructions in the code.
+  // The lines are terminated by '\n' instead of std::endl, to avoid flushing the stream.
+  if (_disassemblyFormatId == 1)
   {
-    if (_disassemblyFormatId == 1)
-    {
-      for (auto it : _disassembledInstructions)
-      {
-        disassemblyOutput << it.second.hexCode << "  # " << it.second.label
-                  << it.second.instruction << std::endl;
-      }
-    }
-    else // For now there are only two output formats, so this must be format 2.
+    os << disassembledInstruction.hexCode << "  # " << disassembledInstruction.label
+       << disassembledInstruction.instruction << '\n';
+  }
+  else // For now there are only two output formats, so this must be format 2.
+  {
+    const size_t lineLength = disassembledInstruction.label.size() + disassembledInstruction.instruction.size();
+
+    os << disassembledInstruction.label << disassembledInstruction.instruction;
+    if (lineLength < maxDisassemblyLineLength)
     {
-      for (auto it : _disassembledInstructions)
-      {
-        std::string fullInstruction(it.second.label + it.second.instruction);
-        disassemblyOutput << std::setw(maxDisassemblyLineLength) << std::left
-                  << fullInstruction << "# " << it.second.hexCode << std::endl;
-      }
+      os << std::string(maxDisassemblyLineLength - lineLength, ' ');
     }
+    os << "# " << disassembledInstruction.hexCode << '\n';
   }
-
-  return disassemblyOutput.str();
 }
 
 bool
@@ -3300,9 +5559,19 @@ QISA_Driver::saveAssembly(const std::string& outputFileName)
 bool
 QISA_Driver::saveDisassembly(std::ofstream& outputStream)
 {
-  std::string disassemblyOutput = getDisassemblyOutput();
+  QISA_StatsTimer timer(activeStats(), &QISA_Stats::outputFormatTime);
+
+  if (_nrOfDisassemblyThreads != 1)
+  {
+    // Let the output be formatted in parallel.
+    outputStream << getDisassemblyOutput();
+  }
+  else
+  {
+    // Write the output directly, without building it in memory first.
+    writeDisassembly(outputStream, 0, _disassembledInstructions.size(), getDisassemblyLineLength());
+  }
 
-  outputStream << disassemblyOutput;
   if (outputStream.fail())
   {
     error("Error occurred while writing disassembly output to output stream");
@@ -3537,24 +5806,8 @@ QISA_Driver::loadQuantumInstructions(const q_map_t& arg_none_map,
 
 
   // Check if  opcode '0' is present in 'arg_none_map'.
-
-  // This instruction is used as filler when only one double format
-  // instruction has been specified on an assembly instruction.
-  bool foundOpcodeZero = false;
-  for (auto it : q_inst_arg_none_opcodes)
+  if (!checkQuantumOpcodeZero(q_inst_arg_none_opcodes))
   {
-    if (it.second == 0)
-    {
-      foundOpcodeZero = true;
-      break;
-    }
-  }
-
-  if (!foundOpcodeZero)
-  {
-    _errorStream << "The Quantum instruction for opcode 0 is missing." << std::endl;
-    _errorStream << "It is mandatory for correct operation of QISA-AS."  << std::endl;
-    _errorStream << "Specify this in parameter 'arg_none_map'."  << std::endl;
     return false;
   }
 
@@ -3588,6 +5841,37 @@ QISA_Driver::loadQuantumInstructions(const q_map_t& arg_none_map,
 
   // Everything seems fine.
   // Now update the appropriate member maps.
+  installQuantumInstructions(q_inst_arg_none_opcodes,
+                             q_inst_arg_st_opcodes,
+                             q_inst_arg_tt_opcodes);
+
+  return true;
+}
+
+bool
+QISA_Driver::checkQuantumOpcodeZero(const q_map_t& q_inst_arg_none_opcodes)
+{
+  // This instruction is used as filler when only one double format
+  // instruction has been specified on an assembly instruction.
+  for (auto it : q_inst_arg_none_opcodes)
+  {
+    if (it.second == 0)
+    {
+      return true;
+    }
+  }
+
+  _errorStream << "The Quantum instruction for opcode 0 is missing." << std::endl;
+  _errorStream << "It is mandatory for correct operation of QISA-AS."  << std::endl;
+  _errorStream << "Specify this in parameter 'arg_none_map'."  << std::endl;
+  return false;
+}
+
+void
+QISA_Driver::installQuantumInstructions(q_map_t& q_inst_arg_none_opcodes,
+                                       q_map_t& q_inst_arg_st_opcodes,
+                                       q_map_t& q_inst_arg_tt_opcodes)
+{
   _q_inst_arg_none_opcodes.swap(q_inst_arg_none_opcodes);
   _q_inst_arg_st_opcodes.swap(q_inst_arg_st_opcodes);
   _q_inst_arg_tt_opcodes.swap(q_inst_arg_tt_opcodes);
@@ -3613,7 +5897,80 @@ QISA_Driver::loadQuantumInstructions(const q_map_t& arg_none_map,
     _quantumOpcode2instName[it.second] = it.first;
   }
 
+  buildQuantumDecodeTable();
+}
+
+bool
+QISA_Driver::loadQuantumInstructionsImage(const std::string& imageFilename)
+{
+  QISA_InstructionSetImage image;
+
+  if (!image.open(imageFilename))
+  {
+    _errorStream << "Error loading instruction set image '" << imageFilename <<  "':" << std::endl;
+    _errorStream << "\t" << image.getErrorMessage() << std::endl;
+    _errorLoc = location();
+
+    return false;
+  }
+
+  // The image contains validated instructions, sorted on kind and name.
+  // So the maps can be filled without checking the individual instructions.
+  q_map_t maps[QISA_InstructionSetImage::NR_OF_KINDS];
+
+  for (size_t i = 0; i < image.size(); i++)
+  {
+    q_map_t& map = maps[image.getKind(i)];
+    map.emplace_hint(map.end(), image.getName(i), image.getOpcode(i));
+  }
+
+  // The same check as on a QMAP file, such that an image of an instruction set
+  // without a filler for unused VLIW slots is rejected as well.
+  if (!checkQuantumOpcodeZero(maps[QISA_InstructionSetImage::KIND_ARG_NONE]))
+  {
+    _errorStream << "Instruction set image '" << imageFilename << "' cannot be used." << std::endl;
+    _errorLoc = location();
+    return false;
+  }
+
+  installQuantumInstructions(maps[QISA_InstructionSetImage::KIND_ARG_NONE],
+                             maps[QISA_InstructionSetImage::KIND_ARG_ST],
+                             maps[QISA_InstructionSetImage::KIND_ARG_TT]);
+
+  return true;
+}
+
+bool
+QISA_Driver::saveQuantumInstructionsImage(const std::string& imageFilename)
+{
+  q_map_t maps[QISA_InstructionSetImage::NR_OF_KINDS];
+
+  maps[QISA_InstructionSetImage::KIND_ARG_NONE] = _q_inst_arg_none_opcodes;
+  maps[QISA_InstructionSetImage::KIND_ARG_ST] = _q_inst_arg_st_opcodes;
+  maps[QISA_InstructionSetImage::KIND_ARG_TT] = _q_inst_arg_tt_opcodes;
+
+  std::string errorMessage;
+
+  if (!QISA_InstructionSetImage::write(imageFilename, maps, errorMessage))
+  {
+    error(errorMessage);
+    return false;
+  }
+
   return true;
 }
 
 } // namespace QISA
+
+QISA::QISA_Parser::symbol_type
+yylex(QISA::QISA_Driver& driver, yyscan_t scanner)
+{
+#ifdef QISA_AS_FAST_SCANNER
+  QISA::QISA_Parser::symbol_type token = static_cast<QISA::QISA_Scanner*>(scanner)->next();
+#else
+  QISA::QISA_Parser::symbol_type token = qisa_flex_lex(driver, scanner);
+#endif
+
+  driver.tokenScanned(token.type_get());
+  return token;
+}
@@ -7,9 +7,12 @@
 #include <istream>
 #include <sstream>
 #include <map>
-#include <set>
+#include <vector>
 #include <algorithm>
 #include <bitset>
+#include <functional>
+#include <mutex>
+#include <memory>
 
 // Tell Flex the lexer's prototype ...
 #ifndef YY_TYPEDEF_YY_SCANNER_T
@@ -18,13 +21,25 @@ typedef void* yyscan_t;
 #endif
 
 #include "qisa_parser.tab.hh"
+#include "qisa_symbol_table.h"
+#include "qisa_arena.h"
+#include "qisa_stats.h"
+#include "qisa_mapped_file.h"
+#include "qisa_line_index.h"
+#include "qisa_topology.h"
+#include "qisa_timeline.h"
 
 
 # define YY_DECL \
-    QISA::QISA_Parser::symbol_type yylex (QISA::QISA_Driver& driver, yyscan_t yyscanner)
-// ... and declare it for the parser's sake.
+    QISA::QISA_Parser::symbol_type qisa_flex_lex (QISA::QISA_Driver& driver, yyscan_t yyscanner)
+// ... and declare it.
 YY_DECL;
 
+// The parser gets its tokens from yylex(), which passes them on from the scanner
+// that has been selected at build time: the flex scanner (qisa_lexer.l) or, if
+// QISA_AS_FAST_SCANNER is defined, the hand-written scanner (qisa_scanner.cpp).
+QISA::QISA_Parser::symbol_type yylex (QISA::QISA_Driver& driver, yyscan_t yyscanner);
+
 #ifdef _WIN32
 #define DllExport __declspec(dllexport)
 #else
@@ -82,11 +97,39 @@ public:
   // Currently, instructions are encoded in 32 bits.
   typedef uint32_t qisa_instruction_type;
 
+  // The outcome of assembling one program by assembleMany().
+  struct AssemblyResult
+  {
+    // True if the program has been assembled successfully.
+    bool success;
+
+    // The generated instructions, if successful.
+    std::vector<qisa_instruction_type> instructions;
+
+    // The error message, if not successful.
+    std::string errorMessage;
+  };
+
+  // An error found while assembling (see getDiagnostics()).
+  struct Diagnostic
+  {
+    // Location of the error in the source code: the line and column at which
+    // it begins, and the line and column just past its end.
+    // Lines and columns start at 1. A line of 0 means that the error is not
+    // related to a specific location in the source code.
+    unsigned int line;
+    unsigned int column;
+    unsigned int endLine;
+    unsigned int endColumn;
+
+    // The error message, which may consist of several lines.
+    std::string message;
+  };
+
   DllExport QISA_Driver();
 
   DllExport virtual
-  ~QISA_Driver()
-  {}
+  ~QISA_Driver();
 
   /**
    * Free the resources allocated by the driver and reset it, such that
@@ -98,19 +141,59 @@ public:
   DllExport void
   reset();
 
-  //read the quantum information layout file
+  /**
+   * Read the quantum layout information (topology) from the given file:
+   * the number of qubits and the directed edges between them (see QISA_Topology).
+   *
+   * @param[in] input_filename File that contains the quantum layout information.
+   *
+   * @return True on success, false if the file cannot be read, is not valid,
+   *         or describes a topology that does not fit in the encoding of the
+   *         SMIS and SMIT instructions. In that case, the current topology is kept,
+   *         and getLastErrorMessage() describes the problem.
+   */
+  DllExport bool
+  read(const std::string& input_filename);
+
+  /**
+   * Take over the configuration of another driver: the quantum instruction
+   * set and the quantum layout information (topology).
+   * This makes it possible to load a QMAP file and a layout file once, and
+   * share the result among several drivers, e.g. one per thread.
+   *
+   * @param[in] prototype Driver to copy the configuration from.
+   *                      It is only read, so it can be shared by several
+   *                      threads that configure their own driver from it.
+   */
   DllExport void
-  read(std::string input_filename);
+  configureFrom(const QISA_Driver& prototype);
 
   // Handling the scanner.
 
-   // Note: implementation in qisa_lexer.l
+  // Start scanning the current source, using the scanner that has been selected at build time.
+  bool
+  scanBegin (yyscan_t* scanner);
+
+  void
+  scanEnd (yyscan_t scanner);
+
+  // Start scanning using the flex scanner, of which the tokens are given by qisa_flex_lex().
+  // Note: implementation in qisa_lexer.l
   bool
-  scanBegin (yyscan_t* flex_scanner);
+  flexScanBegin (yyscan_t* flex_scanner);
 
   // Note: implementation in qisa_lexer.l
   void
-  scanEnd (yyscan_t flex_scanner);
+  flexScanEnd (yyscan_t flex_scanner);
+
+  // Start scanning using the hand-written scanner; the scanner handle is a QISA_Scanner.
+  // Note: implementation in qisa_scanner.cpp
+  bool
+  fastScanBegin (yyscan_t* scanner);
+
+  // Note: implementation in qisa_scanner.cpp
+  void
+  fastScanEnd (yyscan_t scanner);
 
 
 
@@ -127,6 +210,43 @@ public:
   DllExport bool
   assemble(const std::string& filename);
 
+  /**
+   * Assemble QISA assembly source code that resides in memory.
+   * This avoids the round-trip through the filesystem that is needed by assemble().
+   *
+   * @param[in] buffer Start of the QISA assembly source code.
+   *                   The buffer does not have to be zero-terminated.
+   * @param[in] size   Number of bytes in buffer.
+   *
+   * @return True on success, false on failure.
+   */
+  DllExport bool
+  assembleBuffer(const char* buffer, size_t size);
+
+  /**
+   * Assemble QISA assembly source code that is given as a string.
+   *
+   * @param[in] source QISA assembly source code.
+   *
+   * @return True on success, false on failure.
+   */
+  DllExport bool
+  assembleString(const std::string& source);
+
+  /**
+   * Assemble a number of programs in parallel.
+   * Each thread uses its own driver, configured from this one (see configureFrom()),
+   * so the quantum instruction set and the quantum layout information of this driver are used.
+   * This driver itself is not changed.
+   *
+   * @param[in] sources     QISA assembly source code, one program per element.
+   * @param[in] nrOfThreads Number of threads to use. If 0, one thread per hardware thread is used.
+   *
+   * @return The outcome per program, in the same order as the given sources.
+   */
+  DllExport std::vector<AssemblyResult>
+  assembleMany(const std::vector<std::string>& sources, unsigned nrOfThreads = 0) const;
+
   /**
    * Disassemble the given file.
    *
@@ -136,12 +256,225 @@ public:
   DllExport bool
   disassemble(const std::string& filename);
 
+  /**
+   * Disassemble QISA instructions in binary form that reside in memory.
+   *
+   * @param[in] buffer Start of the instructions, in the same form as saved by save().
+   * @param[in] size   Number of bytes in buffer.
+   *
+   * @return True on success, false on failure.
+   */
+  DllExport bool
+  disassembleBuffer(const char* buffer, size_t size);
+
+  /**
+   * Disassemble the given file and write the disassembly directly to the given stream,
+   * in the selected disassembly output format.
+   *
+   * Unlike disassemble(), the disassembled instructions are not kept in memory:
+   * the input is decoded twice, first to find the branch destinations and the width
+   * of the instruction texts, then to write the output. The output is identical to
+   * that of disassemble() followed by getDisassemblyOutput().
+   *
+   * @param[in] filename File that contains QISA instructions in binary form.
+   * @param[in] os       Stream to write the disassembly to.
+   *
+   * @return True on success, false on failure.
+   *
+   * @note
+   *   Afterwards, getDisassemblyOutput() and save() have nothing to return.
+   */
+  DllExport bool
+  disassembleTo(const std::string& filename, std::ostream& os);
+
+  /**
+   * Enable or disable the collection of statistics (see getStats()).
+   * Collecting statistics is disabled by default; when disabled, it costs nothing.
+   *
+   * @param[in] enabled True to enable the collection of statistics, false to disable it.
+   */
+  DllExport void
+  enableStats(bool enabled);
+
+  /**
+   * @return The statistics that have been collected since they were enabled or
+   *         last cleared: the time spent per phase and a number of counters.
+   *         These accumulate over all assemblies and disassemblies.
+   */
+  DllExport const QISA_Stats&
+  getStats() const;
+
+  /**
+   * Clear the statistics collected so far.
+   */
+  DllExport void
+  resetStats();
+
+  /**
+   * Enable or disable error recovery while assembling.
+   *
+   * Without error recovery, which is the default, assembly stops at the first error.
+   * With error recovery, the rest of a line that contains an error is skipped and
+   * assembly continues on the next line, such that all errors are found in one pass.
+   * The assembly still fails if any error has been found.
+   *
+   * @param[in] enabled True to enable error recovery, false to disable it.
+   */
+  DllExport void
+  setErrorRecovery(bool enabled);
+
+  /**
+   * @return True if error recovery is enabled (see setErrorRecovery()).
+   */
+  DllExport bool
+  getErrorRecovery() const;
+
+  /**
+   * @return The errors found by the last assembly, in the order in which they
+   *         have been found. Without error recovery, there is at most one.
+   */
+  DllExport const std::vector<Diagnostic>&
+  getDiagnostics() const;
+
+  /**
+   * Enable or disable the removal of redundant SMIS and SMIT instructions after assembly.
+   *
+   * Within straight-line code, the assembler tracks the mask that each S and T register
+   * holds. An SMIS or SMIT instruction word that writes the mask that the register
+   * already holds is removed, and the branch offsets are adjusted accordingly.
+   * At branch targets, the contents of the registers are considered unknown.
+   * This is disabled by default.
+   *
+   * @param[in] enabled True to remove redundant mask writes, false to keep them.
+   */
+  DllExport void
+  setMaskDeduplication(bool enabled);
+
+  /**
+   * @return True if redundant mask writes are removed (see setMaskDeduplication()).
+   */
+  DllExport bool
+  getMaskDeduplication() const;
+
+  /**
+   * Enable or disable renaming of mask registers, in addition to mask deduplication.
+   *
+   * If an SMIS or SMIT instruction writes a mask that another register of the same kind
+   * already holds, the instruction is removed and the quantum instructions that use
+   * its register are changed to use the other register instead. This is only done if
+   * the register is written again (or the program stops) before the next branch, and
+   * the other register keeps its mask while it is used in place of the register.
+   * It has no effect unless mask deduplication is enabled. This is disabled by default.
+   *
+   * @param[in] enabled True to rename mask registers, false to leave them.
+   */
+  DllExport void
+  setMaskRegisterRenaming(bool enabled);
+
+  /**
+   * @return True if mask registers are renamed (see setMaskRegisterRenaming()).
+   */
+  DllExport bool
+  getMaskRegisterRenaming() const;
+
+  /**
+   * @return The number of SMIS and SMIT instruction words that have been removed
+   *         from the result of the last assembly by mask deduplication.
+   */
+  DllExport size_t
+  getNrOfRemovedMaskWords() const;
+
+  /**
+   * Enable or disable packing of quantum instructions into as few VLIWs as possible.
+   *
+   * Without packing, which is the default, the quantum instructions of each bundle
+   * are put pair-wise in VLIWs, in source order. With packing, QNOPs are left out
+   * of bundles, and a bundle without wait time (bs 0) fills the free slots of the
+   * VLIW before it, since their instructions are executed at the same time.
+   * This is not done for a bundle that is referred to by a label.
+   *
+   * @param[in] enabled True to pack the quantum instructions, false to put them pair-wise.
+   */
+  DllExport void
+  setVliwPacking(bool enabled);
+
+  /**
+   * @return True if the quantum instructions are packed (see setVliwPacking()).
+   */
+  DllExport bool
+  getVliwPacking() const;
+
+  /**
+   * Enable or disable relaxation of branches whose target is out of reach.
+   *
+   * The offset of a branch instruction is limited to +/-(2^20-1) instructions.
+   * With relaxation, which is the default, a branch to a label beyond that range
+   * is rewritten into a branch with the inverted condition over an unconditional
+   * branch, which reaches the label through a chain of unconditional branches.
+   * These are placed in islands, each of which starts with a branch over the island.
+   * An island is never placed between the VLIWs of a quantum bundle.
+   * Without relaxation, such a branch is an error.
+   *
+   * @param[in] enabled True to rewrite branches that are out of reach, false to report them as errors.
+   */
+  DllExport void
+  setBranchRelaxation(bool enabled);
+
+  /**
+   * @return True if branches that are out of reach are rewritten (see setBranchRelaxation()).
+   */
+  DllExport bool
+  getBranchRelaxation() const;
+
+  /**
+   * @return The number of branch instructions that have been rewritten by the last assembly,
+   *         because their target was out of reach.
+   */
+  DllExport size_t
+  getNrOfRelaxedBranches() const;
+
+  /**
+   * Determine the static quantum timeline of the result of the last assembly:
+   * the cycles taken by the program, by each basic block and by one pass through
+   * each loop body, the bundle widths and the idle gaps (see QISA_Timeline).
+   *
+   * @param[out] timeline Receives the timeline.
+   *
+   * @return True on success, false if there is no assembly result to analyze.
+   */
+  DllExport bool
+  analyzeTimeline(QISA_Timeline& timeline);
+
+  /**
+   * Determine the static quantum timeline of the result of the last assembly
+   * (see analyzeTimeline()), in the given format.
+   *
+   * @param[in] format 'csv' or 'json' for the timing of the program, its basic blocks and its loops,
+   *                   or 'chrome' for the basic blocks and operations in the Chrome trace event format.
+   *
+   * @return The timeline, or an empty string on failure.
+   */
+  DllExport std::string
+  getTimelineOutput(const std::string& format);
+
   /**
    * @return The last generated error message.
+   *         With error recovery enabled, this contains all errors found by the
+   *         last assembly, each with the source lines involved.
    */
   DllExport std::string
   getLastErrorMessage();
 
+  /**
+   * @return The mutex that serializes the use of this driver by several threads.
+   *         The driver does not lock it itself: a driver must not be used by several
+   *         threads at the same time, and the user of the driver is responsible for that.
+   *         The Python interface, which releases the GIL while the driver is busy,
+   *         locks this mutex for the duration of each call.
+   */
+  DllExport std::mutex&
+  getUseMutex();
+
   /** @return The version of this assembler. */
   DllExport static std::string
   getVersion();
@@ -173,6 +506,29 @@ public:
   DllExport std::vector<std::string>
   getInstructionsAsHexStrings(bool withBinaryOutput);
 
+  /**
+   * Retrieve the generated code, as assembled by the last successful assembly.
+   *
+   * @return The encoded instructions.
+   */
+  DllExport const std::vector<qisa_instruction_type>&
+  getInstructions() const;
+
+  /**
+   * Share the generated code, as assembled by the last successful assembly,
+   * without copying it.
+   * The instructions remain where getInstructions() finds them. As long as the
+   * returned owner (or a copy of it) exists, the next reset() of the driver
+   * (e.g. by the next assembly or disassembly) or the destruction of the driver
+   * moves the instructions into the owner instead of discarding them.
+   * Either way, their memory remains valid and unchanged until the last
+   * copy of the owner is gone.
+   *
+   * @return The owner of the instructions.
+   */
+  DllExport std::shared_ptr<const std::vector<qisa_instruction_type>>
+  shareInstructions();
+
   /**
    * Set the disassembly format to one of the known format types.
    *
@@ -195,6 +551,50 @@ public:
   DllExport bool
   setDisassemblyFormat(int format_id);
 
+  /**
+   * Set the number of threads to use while disassembling.
+   *
+   * When more than one thread is used, the input is split into chunks
+   * that are decoded in parallel. The branch destinations found in the
+   * chunks are merged, after which the labels are assigned and the output
+   * is formatted in parallel as well.
+   * The output is identical to that of a serial disassembly.
+   *
+   * @param nrOfThreads Number of threads to use.
+   *                    1 (the default) disassembles serially,
+   *                    0 uses one thread per hardware thread.
+   *
+   * @note
+   *   In verbose mode, disassembly is always done serially, to keep the
+   *   informational messages in order.
+   */
+  DllExport void
+  setDisassemblyThreads(unsigned nrOfThreads);
+
+  /**
+   * Enable or disable the assembly cache.
+   *
+   * When enabled, the result of each successful assembly is stored in the given
+   * directory, keyed on a hash of the source code, the configured instruction set,
+   * the quantum layout information and the assembler version.
+   * A subsequent assembly of the same source code with the same configuration
+   * takes the result from the cache, without scanning and parsing the source code.
+   * Since the source code and the configuration are stored along with the result,
+   * and are compared on a cache hit, a hash collision only leads to a cache miss.
+   *
+   * @param directory Existing directory in which to store the assembly results.
+   *                  If empty (the default), the assembly cache is disabled.
+   *
+   * @note
+   *   On a cache hit, only the generated instructions are available:
+   *   getInstructionsAsHexStrings(), getInstructions() and save() work as usual.
+   *   getNrOfRemovedMaskWords() and getNrOfRelaxedBranches() return the counts
+   *   of the assembly that has been cached.
+   *   In verbose mode, the number of cache hits and misses is shown.
+   */
+  DllExport void
+  setAssemblyCacheDirectory(const std::string& directory);
+
   /**
    * Retrieve the disassembled instructions as a multi-line string.
    * @return The disassembly output: one (or more, in case of quantum) disassembled instruction per line.
@@ -262,6 +662,34 @@ public:
                          const q_map_t& arg_st_map,
                          const q_map_t& arg_tt_map);
 
+  /**
+   * Load quantum instruction specifications from the given instruction set image,
+   * as written by saveQuantumInstructionsImage().
+   * The image is memory mapped and contains validated instructions in the order of
+   * the instruction maps, so this is much faster than loading a QMAP file.
+   *
+   * @param imageFilename Image file to load.
+   *
+   * @return True on success, false if the file is not a valid image.
+   *
+   * @note
+   *   On error, you can use getLastErrorMessage() to get a
+   *   description of that error.
+   */
+  DllExport bool
+  loadQuantumInstructionsImage(const std::string& imageFilename);
+
+  /**
+   * Save the currently loaded quantum instructions as an instruction set image,
+   * which can be loaded by loadQuantumInstructionsImage().
+   *
+   * @param imageFilename Image file to write.
+   *
+   * @return True on success, false on failure.
+   */
+  DllExport bool
+  saveQuantumInstructionsImage(const std::string& imageFilename);
+
 
   // Error reporting.
   void
@@ -426,7 +854,7 @@ public:
    * @param inst_name Name of the instruction.
    * @param inst_loc Location of the instruction in the source file.
    *
-   * @return Shared pointer to a QInstruction, or empty pointer if an error occurred.
+   * @return Pointer to a QInstruction (allocated in _qInstructionArena), or NULL if an error occurred.
    */
   QInstructionPtr
   get_q_instr_arg_none(const std::string& inst_name,
@@ -441,7 +869,7 @@ public:
    * @param st_loc Location of the register specification in the source file.
    * @param is_conditional Denotes if this instruction is conditional or not.
    *
-   * @return Shared pointer to a QInstruction, or empty pointer if an error occurred.
+   * @return Pointer to a QInstruction (allocated in _qInstructionArena), or NULL if an error occurred.
    */
   QInstructionPtr
   get_q_instr_arg_st(const std::string& inst_name,
@@ -458,7 +886,7 @@ public:
    * @param tt Indicates the register involved.
    * @param tt_loc Location of the register specification in the source file.
    *
-   * @return Shared pointer to a QInstruction, or empty pointer if an error occurred.
+   * @return Pointer to a QInstruction (allocated in _qInstructionArena), or NULL if an error occurred.
    */
   QInstructionPtr
   get_q_instr_arg_tt(const std::string& inst_name,
@@ -508,13 +936,23 @@ public:
                          const BundledQInstructions& bundle,
                          const QISA::location& bundle_loc);
 
+  /**
+   * Generate the VLIWs of a bundle of quantum instructions, using as few VLIWs as possible
+   * (see setVliwPacking()).
+   *
+   * @param bs_val Bundle separator.
+   * @param bundle List of quantum instructions that form a bundle.
+   */
+  void generate_packed_q_bundle(uint8_t bs_val,
+                                const BundledQInstructions& bundle);
+
   /**
    * Encode a given quantum instruction, given its opcode and parameters.
    * @param q_inst Contains the opcode and possible parameters.
    * @return Encoded instruction.
    */
   uint64_t
-  encode_q_instr(const std::shared_ptr<QInstruction>& q_inst);
+  encode_q_instr(const QInstruction& q_inst);
 
 
   /**
@@ -771,12 +1209,28 @@ public:
    */
   void haveEOF() { _hadEOF = true; }
 
+  /**
+   * Record that the scanner has produced a token of the given kind.
+   * It is used by yylex().
+   */
+  void tokenScanned(int kind)
+  {
+    _lastTokenKind = kind;
+    if (_statsEnabled) _stats.nrOfTokens++;
+  }
+
 
   // The name of the file being parsed.
   // Used later to pass the file name to the location tracker.
   // NOTE: This is a public member due to the way that the bison parser wants to use it.
   std::string _filename;
 
+  // The location of the token that is currently being scanned.
+  // This is kept in the driver instead of in the lexer, such that several
+  // drivers can be used concurrently from different threads.
+  // NOTE: This is a public member due to the way that the flex scanner wants to use it.
+  QISA::location _scanLocation;
+
   private: // -- Forward declarations.
   struct DisassembledInstruction;
 
@@ -785,13 +1239,137 @@ public:
 
   private: // -- functions
 
+  /**
+   * @return The statistics to update, or a null pointer if statistics are not collected.
+   *         Used to create a QISA_StatsTimer.
+   */
+  QISA_Stats* activeStats() { return _statsEnabled ? &_stats : nullptr; }
+
+  /**
+   * Record a lookup in one of the symbol, register, label or mnemonic tables,
+   * if statistics are collected.
+   */
+  void countMapLookup() { if (_statsEnabled) _stats.nrOfMapLookups++; }
+
+  /**
+   * Run the scanner and parser over the current input, which is either the file named
+   * _filename or the contents of _sourceBuffer, and resolve the deferred labels.
+   * Used by assemble(), assembleBuffer() and assembleString().
+   *
+   * @return True on success, false on failure.
+   */
+  bool
+  parseInput();
+
+  /**
+   * Hand over the instructions to the owner returned by shareInstructions(), if it
+   * still exists, such that _instructions can be changed.
+   */
+  void
+  releaseSharedInstructions();
+
+  /**
+   * Get the source code that is assembled: either _sourceBuffer, or the contents
+   * of the file named _filename, once it has been mapped by getAssemblyCacheKey().
+   *
+   * @param[out] data Start of the source code.
+   * @param[out] size Size of the source code, in bytes.
+   */
+  void
+  getSourceCode(const char*& data, size_t& size) const;
 
   /**
-   * Lookup the last error location in the source file and return its contents.
-   * @return The source line affected by the las error.
+   * Determine the key under which the result of assembling the current input
+   * is stored in the assembly cache.
+   * If the input is a file, it is mapped into _sourceFile, and the scanner
+   * takes the source code from there. So the source code that is scanned is
+   * the same as the one the key has been derived from.
+   *
+   * @param[out] configuration Everything other than the source code that determines
+   *                           the generated instructions: the assembler version, the
+   *                           instruction set, the optimizations and the topology.
+   * @param[out] key           Hash of the configuration and the source code.
+   *
+   * @return True on success, false if the source code cannot be read.
+   */
+  bool
+  getAssemblyCacheKey(std::string& configuration, uint64_t& key);
+
+  /**
+   * @return The name of the file in the assembly cache that belongs to the given key.
+   */
+  std::string
+  getAssemblyCacheFilename(uint64_t key);
+
+  /**
+   * Take the generated instructions, and the number of removed mask words and
+   * relaxed branches, from the assembly cache.
+   * A cache file is only used if the configuration and the source code stored in it
+   * are equal to the current ones, so two inputs with the same key cannot be mixed up.
+   *
+   * @param[in] configuration The configuration, as returned by getAssemblyCacheKey().
+   * @param[in] key           The cache key.
+   *
+   * @return True on a cache hit, false on a cache miss.
+   */
+  bool
+  loadCachedAssembly(const std::string& configuration, uint64_t key);
+
+  /**
+   * Store the generated instructions, and the number of removed mask words and
+   * relaxed branches, in the assembly cache.
+   * Failure to do so is not an error, it only costs a cache miss later on.
+   *
+   * @param[in] configuration The configuration, as returned by getAssemblyCacheKey().
+   * @param[in] key           The cache key.
+   */
+  void
+  storeCachedAssembly(const std::string& configuration, uint64_t key);
+
+  /**
+   * Lookup the given error location in the source file and return its contents.
+   *
+   * @param[in] loc    Location of the error.
+   * @param[in] errors The error message(s) issued at that location.
+   *
+   * @return The source lines affected by the error, with some context lines.
    */
   std::string
-  getErrorSourceLine();
+  getErrorSourceLine(const location& loc, const std::string& errors);
+
+  /**
+   * Make sure that _sourceLines indexes the source code of the last assembly.
+   * The index is built on first use, so assemblies without errors do not pay for it.
+   *
+   * @return True on success, false if the source file cannot be read.
+   */
+  bool
+  indexSourceLines();
+
+  /**
+   * Take the error messages that have been issued since the last recorded
+   * diagnostic, if any, and record them as a diagnostic at the last error location.
+   */
+  void
+  recordDiagnostic();
+
+  /**
+   * @return True if the error messages issued since the last recorded diagnostic
+   *         contain the given text.
+   */
+  bool
+  unrecordedErrorsContain(const std::string& text) const;
+
+  /**
+   * Used for error recovery, after the parser has stopped at an error:
+   * skip the tokens up to and including the end of the line that contains the error.
+   *
+   * @param[in] scanner The scanner that provides the tokens to the parser.
+   *
+   * @return True if there is more input to parse, false at the end of the input.
+   */
+  bool
+  skipToNextLine(yyscan_t scanner);
 
 
   /**
@@ -848,6 +1426,13 @@ public:
                        uint8_t pos,
                        int64_t t_mask_bits);
 
+  // Used by generate_SMIT with a t_mask.
+  // Generates one instruction per part of the t_mask (see pos_number_t).
+  void
+  unsafe_generate_SMIT_parts(int opcode,
+                             uint8_t td,
+                             int64_t t_mask_bits);
+
 
   /**
    * Check if the given register number is acceptable to be used to adress a 'Q' register.
@@ -962,6 +1547,68 @@ public:
   bool
   processDeferredInstructions();
 
+  /**
+   * Rewrite the branches in _longBranches, and any branch that gets out of reach because of
+   * that, such that each of them reaches its target (see setBranchRelaxation()).
+   * The other branch offsets are adjusted to the inserted instructions.
+   *
+   * @return True on success, false if the branches cannot be made to reach their targets.
+   */
+  bool
+  relaxBranches();
+
+  /**
+   * Remove the SMIS and SMIT instruction words that write a mask that is already held,
+   * and rename mask registers if enabled (see setMaskDeduplication()).
+   * The branch offsets are adjusted to the remaining instructions.
+   *
+   * @return The number of removed instruction words.
+   */
+  size_t
+  deduplicateMasks();
+
+  /**
+   * Try to replace register 'from' by register 'to' in the quantum instructions, starting at
+   * instruction first, until register 'from' is written again. This fails if the end of that
+   * range cannot be determined within straight-line code, or if register 'to' is written while
+   * register 'from' is still used.
+   *
+   * @param[in] first          Index in _instructions of the first instruction to consider.
+   * @param[in] registerKind   S_REGISTER or T_REGISTER.
+   * @param[in] from           Register to replace.
+   * @param[in] to             Register to use instead.
+   * @param[in] isBranchTarget Per instruction index, whether it is the target of a branch.
+   *
+   * @return True if the register has been replaced, false if nothing has been changed.
+   */
+  bool
+  renameMaskRegister(size_t first,
+                     RegisterKind registerKind,
+                     int from,
+                     int to,
+                     const std::vector<bool>& isBranchTarget);
+
+  /**
+   * @param[in] index Index in _instructions.
+   * @param[in] td    T register.
+   *
+   * @return True if the instruction words starting at index form a complete SMIT of register td:
+   *         one instruction word per position, in order.
+   */
+  bool
+  isCompleteSMIT(size_t index, int td) const;
+
+  /**
+   * Determine the timing of the instructions from section.startAddress up to section.endAddress.
+   *
+   * @param[in,out] section    Section to fill in; its addresses must have been set.
+   * @param[out]    operations If not null, receives the quantum operations of the section,
+   *                           placed on the timeline from section.startCycle onwards.
+   */
+  void
+  analyzeTimelineSection(QISA_Timeline::Section& section,
+                         std::vector<QISA_Timeline::Operation>* operations);
+
 
   /**
    * Reverse the bits in the given src.
@@ -981,29 +1628,6 @@ public:
   template<typename SrcType, int nrOfBits>
   SrcType reverseBits(const SrcType src);
 
-  /*****************************************************************/
-  /* Comparator for case-insensitive comparison in STL associative */
-  /* containers.                                                   */
-  /* source: https://stackoverflow.com/a/1801913                   */
-  /*****************************************************************/
-  struct ci_less : std::binary_function<std::string, std::string, bool>
-  {
-    // case-independent (ci) compare_less binary function
-    struct nocase_compare : public std::binary_function<unsigned char,unsigned char,bool>
-    {
-      bool operator() (const unsigned char& c1, const unsigned char& c2) const {
-          return tolower (c1) < tolower (c2);
-      }
-    };
-    bool operator() (const std::string & s1, const std::string & s2) const {
-      return std::lexicographical_compare
-        (s1.begin (), s1.end (),   // source range
-        s2.begin (), s2.end (),   // dest range
-        nocase_compare ());  // comparison
-    }
-  };
-
-
   std::string
   getHex(uint64_t val, int nDigits);
 
@@ -1018,6 +1642,119 @@ public:
   getSpacedBinary(T_val value);
 
 
+  /**
+   * Disassemble a sequence of instruction words that reside in memory.
+   * The results are stored in _disassembledInstructions, which is indexed by address
+   * (relative to firstAddress).
+   *
+   * @param[in] words     Start of the instruction words (native byte order).
+   *                      These do not have to be aligned.
+   * @param[in] nrOfWords Number of instruction words to disassemble.
+   * @param[in] firstAddress Address of the first instruction word.
+   *                         This is used when only a part of the input is disassembled.
+   *                         The results are stored relative to this address.
+   *
+   * @return True on success, false if one or more words could not be decoded.
+   */
+  bool
+  disassembleWords(const char* words, size_t nrOfWords, uint64_t firstAddress = 0);
+
+  /**
+   * Disassemble a sequence of instruction words that reside in memory,
+   * using _nrOfDisassemblyThreads threads.
+   * This has the same effect as disassembleWords().
+   *
+   * @param[in] words     Start of the instruction words (native byte order).
+   * @param[in] nrOfWords Number of instruction words to disassemble.
+   *
+   * @return True on success, false if one or more words could not be decoded.
+   */
+  bool
+  disassembleWordsParallel(const char* words, size_t nrOfWords);
+
+  /**
+   * Disassemble the given input, which has already been read or mapped into memory,
+   * and add the labels. Used by disassemble() and disassembleBuffer().
+   *
+   * @param[in] input Start of the instructions in binary form.
+   * @param[in] size  Number of bytes in input.
+   *
+   * @return True on success, false on failure.
+   */
+  bool
+  disassembleInput(const char* input, size_t size);
+
+  /**
+   * Write the disassembled instructions in range [first, last) to the given stream,
+   * in the selected disassembly output format.
+   *
+   * @param[in] os                       Stream to write to.
+   * @param[in] first                    Address of the first instruction to write.
+   * @param[in] last                     Address after the last instruction to write.
+   * @param[in] maxDisassemblyLineLength Width of the instruction text (only used for output format 2).
+   */
+  void
+  writeDisassembly(std::ostream& os, size_t first, size_t last, size_t maxDisassemblyLineLength);
+
+  /**
+   * Write one disassembled instruction to the given stream, in the selected
+   * disassembly output format.
+   *
+   * @param[in] os                       Stream to write to.
+   * @param[in] disassembledInstruction  Instruction to write.
+   * @param[in] maxDisassemblyLineLength Width of the instruction text (only used for output format 2).
+   */
+  void
+  writeDisassembledInstruction(std::ostream& os,
+                               const DisassembledInstruction& disassembledInstruction,
+                               size_t maxDisassemblyLineLength);
+
+  /**
+   * Decode a single instruction word.
+   * On failure, an error message is added to _errorStream.
+   *
+   * @param[in]  inst                    Instruction word to decode.
+   * @param[in]  address                 Address of the instruction word.
+   * @param[out] disassembledInstruction Receives the decoded instruction.
+   *
+   * @return True on success, false on failure.
+   */
+  bool
+  decodeWord(qisa_instruction_type inst, uint64_t address, DisassembledInstruction& disassembledInstruction);
+
+  /**
+   * Register the branch destination of a decoded instruction (if any) in
+   * _disassemblyLabels, and keep track of the width of the instruction texts.
+   *
+   * @param[in] disassembledInstruction Successfully decoded instruction.
+   */
+  void
+  recordDisassembledInstruction(const DisassembledInstruction& disassembledInstruction);
+
+  /**
+   * @return The width of the instruction text in output format 2, or 0 for the other formats.
+   *         The labels must have been named already.
+   */
+  size_t
+  getDisassemblyLineLength();
+
+  /**
+   * @return The text that is appended to a branch instruction to refer to its destination label.
+   */
+  static std::string
+  getBranchLabelComment(const std::string& labelName, int64_t offset);
+
+  /**
+   * Call the given function for consecutive ranges [first, last) of the disassembled
+   * instructions, that together cover all of them.
+   * When more than one disassembly thread has been requested and there are enough
+   * instructions, the ranges are processed in parallel.
+   *
+   * @param[in] process Function to call for each range, with arguments first and last.
+   */
+  void
+  forEachDisassemblyRange(const std::function<void(size_t, size_t)>& process);
+
   bool
   disassembleInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst);
 
@@ -1027,6 +1764,32 @@ public:
   bool
   disassembleQuantumInstruction(qisa_instruction_type inst, DisassembledInstruction& disassembledInst);
 
+  /**
+   * Fill _classicDecodeTable, using the opcodes of the classic instructions.
+   */
+  void
+  buildClassicDecodeTable();
+
+  /**
+   * Look up a classic instruction, using the perfect hash index on the
+   * instruction names that is generated along with setOpcodes().
+   * The comparison is case insensitive.
+   *
+   * @param[in]  instruction_name Name of the instruction.
+   * @param[out] opcode           Opcode of the instruction, if found.
+   *
+   * @return True if the instruction has been found, false otherwise.
+   */
+  static bool
+  findClassicOpcode(const std::string& instruction_name, int& opcode);
+
+  /**
+   * Fill _quantumDecodeTable and _quantumMnemonics, using the currently loaded quantum instructions.
+   * This must be called whenever the quantum instruction set changes.
+   */
+  void
+  buildQuantumDecodeTable();
+
   /**
    * Post-process the disassembly steps to add labels.
    * By doing this after all branch destinations are known, we can issue labels
@@ -1036,6 +1799,36 @@ public:
   void
   postProcessDisassembly();
 
+  /**
+   * Assign a name to each branch destination in _disassemblyLabels, in order of address.
+   * This also sets _disassemblyLabelStringLength.
+   *
+   * @param[out] dest2LabelMap Receives the label name of each branch destination.
+   */
+  void
+  nameDisassemblyLabels(std::map<uint64_t, std::string>& dest2LabelMap);
+
+  /**
+   * @param[in] nrOfLabels Number of branch destinations in the disassembly.
+   *
+   * @return The number of digits in the name of each label, such that all labels have the same length.
+   */
+  static int
+  getNrOfDisassemblyLabelDigits(size_t nrOfLabels);
+
+  /**
+   * Add the label (or the indentation in its place) to a disassembled instruction,
+   * and add the destination label to it in case of a branch instruction.
+   *
+   * @param[in,out] disassembledInstruction Instruction to update.
+   * @param[in]     dest2LabelMap           Label name of each branch destination.
+   * @param[in]     emptyLabel              Indentation used when the instruction has no label.
+   */
+  void
+  applyDisassemblyLabel(DisassembledInstruction& disassembledInstruction,
+                        const std::map<uint64_t, std::string>& dest2LabelMap,
+                        const std::string& emptyLabel);
+
   /**
    * Save binary assembled instructions to the given output stream.
    *
@@ -1077,6 +1870,16 @@ public:
   bool
   saveDisassembly(const std::string& outputFileName);
 
+  /**
+   * Make the given validated quantum instruction maps the current ones,
+   * and derive the reverse lookup map and the decode table from them.
+   * The given maps are emptied.
+   */
+  void
+  installQuantumInstructions(q_map_t& q_inst_arg_none_opcodes,
+                             q_map_t& q_inst_arg_st_opcodes,
+                             q_map_t& q_inst_arg_tt_opcodes);
+
   /**
    * Check a given map containing quantum instruction names and their opcode for correctness.
    *
@@ -1096,6 +1899,17 @@ public:
                              std::map<int, std::string>& checkOpcodeMap,
                              q_map_t& outputMap);
 
+  /**
+   * Check that the given validated map of quantum instructions without arguments
+   * contains an instruction with opcode 0, which is used to fill unused VLIW slots.
+   *
+   * @param q_inst_arg_none_opcodes Validated map of instructions without arguments.
+   *
+   * @return True on success, false on failure.
+   */
+  bool
+  checkQuantumOpcodeZero(const q_map_t& q_inst_arg_none_opcodes);
+
 private: // -- constants
 
   //---------------------------------------------------------
@@ -1175,6 +1989,35 @@ private: // -- constants
     Q_INST_TD_MASK             = 0x00003f, // 6 bits
   };
 
+  // Specifies how a classic instruction must be decoded while disassembling.
+  enum ClassicDecodeKind : uint8_t
+  {
+    CLASSIC_DECODE_UNKNOWN,  // No instruction has been defined for this opcode.
+    CLASSIC_DECODE_NO_ARGS,  // NOP, STOP
+    CLASSIC_DECODE_RD_RS_RT, // ADD, ADDC, SUB, SUBC, AND, OR, XOR
+    CLASSIC_DECODE_NOT,
+    CLASSIC_DECODE_CMP,
+    CLASSIC_DECODE_BR,
+    CLASSIC_DECODE_LDI,
+    CLASSIC_DECODE_LDUI,
+    CLASSIC_DECODE_FBR,
+    CLASSIC_DECODE_FMR,
+    CLASSIC_DECODE_SMIS,
+    CLASSIC_DECODE_SMIT,
+    CLASSIC_DECODE_QWAIT,
+    CLASSIC_DECODE_QWAITR,
+    CLASSIC_DECODE_OTHER     // Known instruction that cannot be disassembled (yet).
+  };
+
+  // Specifies how a quantum instruction must be decoded while disassembling.
+  enum QuantumDecodeKind : uint8_t
+  {
+    QUANTUM_DECODE_UNKNOWN,  // No instruction has been defined for this opcode.
+    QUANTUM_DECODE_ARG_NONE, // Instruction without argument.
+    QUANTUM_DECODE_ARG_ST,   // Instruction with s-register argument.
+    QUANTUM_DECODE_ARG_TT    // Instruction with t-register argument.
+  };
+
   enum QISA_InstructionKind : uint8_t
   {
     IK_SINGLE_FORMAT, // Classic instructions.
@@ -1200,17 +2043,95 @@ private: // -- variables
   // This is set from within the lexer when it sees an EOF character.
   bool _hadEOF;
 
+  // True if the source code is taken from _sourceBuffer instead of from the file named _filename.
+  bool _sourceIsBuffer;
+
+  // Copy of the source code given to assembleBuffer() or assembleString().
+  // It is kept to be able to show the source lines involved in an error.
+  // The flex scanner scans it in place; while it does so, two NUL characters are appended.
+  std::string _sourceBuffer;
+
+  // Contents of the file named _filename, once it is needed to derive the
+  // assembly cache key or to show the source lines involved in an error.
+  QISA_MappedFile _sourceFile;
+
+  // True if the scanner takes the source code from _sourceFile instead of reading
+  // the file named _filename itself. This is the case if the assembly cache key
+  // has been derived from _sourceFile.
+  bool _scanSourceFile;
+
+  // Index of the lines of the source code, either in _sourceBuffer or in _sourceFile.
+  QISA_LineIndex _sourceLines;
+
+  // Directory in which assembly results are cached.
+  // If empty, the assembly cache is disabled.
+  std::string _assemblyCacheDirectory;
+
+  // Number of assemblies that have been taken from the assembly cache.
+  uint64_t _assemblyCacheHits;
+
+  // Number of assemblies that have not been found in the assembly cache.
+  uint64_t _assemblyCacheMisses;
+
+  // Serializes the use of this driver by several threads (see getUseMutex()).
+  std::mutex _useMutex;
+
+  // Whether statistics are collected.
+  bool _statsEnabled;
+
+  // The statistics collected so far.
+  QISA_Stats _stats;
+
+  // Whether error recovery is enabled (see setErrorRecovery()).
+  bool _errorRecovery;
+
+  // The errors found by the last assembly (see getDiagnostics()).
+  std::vector<Diagnostic> _diagnostics;
+
+  // Position in _errorStream of the first error message that has not been
+  // recorded as a diagnostic yet.
+  size_t _unrecordedErrorsStart;
+
+  // Kind of the last token produced by the scanner.
+  // Used for error recovery, to know where the line with the error ends.
+  int _lastTokenKind;
+
+  // Whether redundant mask writes are removed (see setMaskDeduplication()).
+  bool _maskDeduplication;
+
+  // Whether mask registers are renamed (see setMaskRegisterRenaming()).
+  bool _maskRegisterRenaming;
+
+  // Number of instruction words removed from the last assembly by mask deduplication.
+  size_t _nrOfRemovedMaskWords;
+
+  // Whether quantum instructions are packed into as few VLIWs as possible (see setVliwPacking()).
+  bool _vliwPacking;
+
+  // Whether branches whose target is out of reach are rewritten (see setBranchRelaxation()).
+  bool _branchRelaxation;
+
+  // Number of branches rewritten by the last assembly.
+  size_t _nrOfRelaxedBranches;
+
+  // A branch whose target is out of reach of its 21-bit offset. Its offset is left 0
+  // while assembling; relaxBranches() rewrites it afterwards.
+  struct LongBranch
+  {
+    uint64_t address;
+    uint64_t target;
+  };
+
+  std::vector<LongBranch> _longBranches;
+
   // Total number of registers available in processor, per kind of register.
   int _nrOfRegisters[4];
 
   // 'Name' of a register, per kind of register
   char _registerName[4];
 
-  // Total number of addressable qubits in the processor.
-  int _totalNrOfQubits;
-
-  // Total number of direct edge address in the processor
-  int _NrOfEdgeAdress;
+  // Quantum layout information: the qubits and the edges between them.
+  QISA_Topology _topology;
 
   // Number of pos in SMIS and SMIT respectively
   int pos_number_s;
@@ -1220,26 +2141,36 @@ private: // -- variables
   // This is the number of quantum cycles (20 ns) between quantum instruction bundles.
   int _max_bs_val;
 
-  // Contains a mapping of all valid control pairs to their
-  // respective bit index in the t_mask.
-  std::map<TargetControlPair, uint8_t> _valid_target_control_pairs;
-
-  // Other way around, to go from bit number to tc_pair.
-  std::map<uint8_t, TargetControlPair> _bit2tc_pair;
-
   // List of assembled instructions.
   std::vector<qisa_instruction_type> _instructions;
 
+  // Owner of _instructions as handed out by shareInstructions(), if any.
+  // It stays empty until _instructions is released (see releaseSharedInstructions()).
+  std::shared_ptr<std::vector<qisa_instruction_type>> _sharedInstructions;
+
   // Id of the output format in which the disassembly must be given.
   int _disassemblyFormatId;
 
+  // Number of threads to use while disassembling.
+  // If 0, one thread per hardware thread is used.
+  unsigned _nrOfDisassemblyThreads;
+
   // Set when disassembling.
   // Is zero when there are no branch instructions.
   // Contains the maximum length of a label when there were branch instructions.
   size_t _disassemblyLabelStringLength;
 
-  // Maps an instruction address to the information about the corresponding disassebled instruction.
-  std::map<uint64_t, DisassembledInstruction> _disassembledInstructions;
+  // Set when disassembling.
+  // Length of the longest instruction text that is not a branch instruction.
+  size_t _disassemblyMaxInstructionLength;
+
+  // Set when disassembling.
+  // Length of the longest branch instruction text, including the label comment
+  // but without the label name (all label names have the same length).
+  size_t _disassemblyMaxBranchLength;
+
+  // Information about the disassembled instructions, indexed by instruction address.
+  std::vector<DisassembledInstruction> _disassembledInstructions;
 
   // Used to check whether a bundle specification of 0 is legal or not.
   // This is used while disassembling.
@@ -1252,7 +2183,7 @@ private: // -- variables
 
   // Prefix used to denote a label in the disassembly.
   // (This will be followed by a number.)
-  static const char* DISASSEMBLY_LABEL_PREFIX;
+  static const char* const DISASSEMBLY_LABEL_PREFIX;
 
   // Opcodes for the instructions.
   // They are defined elsewhere.
@@ -1276,18 +2207,64 @@ private: // -- variables
   // for disassembling the quantum instructions.
   std::map<int, std::string> _quantumOpcode2instName;
 
+  // Entry of the tables that are used to decode instructions while disassembling.
+  struct ClassicDecodeEntry
+  {
+    ClassicDecodeKind kind;
+    std::string name;
+  };
+
+  struct QuantumDecodeEntry
+  {
+    QuantumDecodeKind kind;
+    std::string name;
+  };
+
+  // Opcode indexed tables, derived from _classicOpcode2instName and
+  // _quantumOpcode2instName respectively.
+  // These avoid map lookups and string comparisons while disassembling.
+  ClassicDecodeEntry _classicDecodeTable[OPCODE_MASK + 1];
+  QuantumDecodeEntry _quantumDecodeTable[Q_INST_OPCODE_MASK + 1];
+
+  // Opcodes of a quantum instruction, indexed by QISA_InstructionKind.
+  // An opcode is -1 if the instruction is not defined for that kind.
+  struct QuantumMnemonic
+  {
+    QuantumMnemonic()
+    {
+      opcodes[IK_SINGLE_FORMAT] = -1;
+      opcodes[IK_DF_ARG_NONE] = -1;
+      opcodes[IK_DF_ARG_ST] = -1;
+      opcodes[IK_DF_ARG_TT] = -1;
+    }
+
+    int opcodes[4];
+  };
+
+  // Name indexed table of all quantum instructions, derived from the quantum opcode maps.
+  // This is used while parsing, to find an instruction with a single lookup.
+  QISA_SymbolTable<QuantumMnemonic> _quantumMnemonics;
+
   // Label to 'address' map.
   // This 'address' is in instruction units, not in byte units.
-  std::map<std::string, uint64_t, ci_less> _labels;
+  QISA_SymbolTable<uint64_t> _labels;
+
+  // Address of the last label that has been defined, to know if a label refers to
+  // the next instruction. This is -1 if no label has been defined yet.
+  uint64_t _lastLabelAddress;
 
   // Aliases for registers, one map per kind of register.
-  std::map<std::string, uint8_t, ci_less> _registerAliases[4];
+  QISA_SymbolTable<uint8_t> _registerAliases[4];
 
   // Integer valued symbols.
-  std::map<std::string, int64_t, ci_less> _intSymbols;
+  QISA_SymbolTable<int64_t> _intSymbols;
 
   // Symbols that represent strings.
-  std::map<std::string, std::string, ci_less> _strSymbols;
+  QISA_SymbolTable<std::string> _strSymbols;
+
+  // Holds the quantum instructions that are created while parsing, until they
+  // have been encoded into a bundle. Cleared at the start of each assembly run.
+  QISA_Arena<QInstruction> _qInstructionArena;
 
   // Names of the known branch conditions.
   // Used for pretty printing.
@@ -1338,6 +2315,12 @@ private: // -- variables
     // Full decoded instruction text.
     std::string instruction;
 
+    // Set if this is a branch instruction.
+    bool isBranch;
+
+    // Destination address, in case this is a branch instruction.
+    uint64_t branchDestination;
+
   };
 
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+#include <string>
+
+namespace QISA
+{
+
+/**
+ * Incremental 64-bit FNV-1a hash.
+ *
+ * This is not a cryptographic hash; it is used to derive a key from the
+ * inputs that determine the result of an assembly.
+ */
+class QISA_Hash
+{
+public:
+
+  QISA_Hash()
+    : _value(14695981039346656037ULL)
+  {
+  }
+
+  /**
+   * Add the given bytes to the hash.
+   */
+  void
+  add(const void* data, size_t size)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (size_t i = 0; i < size; i++)
+    {
+      _value ^= bytes[i];
+      _value *= 1099511628211ULL;
+    }
+  }
+
+  /**
+   * Add an integer value to the hash, independent of the byte order of the host.
+   */
+  void
+  add(uint64_t value)
+  {
+    unsigned char bytes[8];
+
+    for (int i = 0; i < 8; i++)
+    {
+      bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    add(bytes, sizeof(bytes));
+  }
+
+  /**
+   * Add a string to the hash.
+   * Its length is added as well, such that e.g. "ab" + "c" and "a" + "bc" differ.
+   */
+  void
+  add(const std::string& str)
+  {
+    add(static_cast<uint64_t>(str.size()));
+    add(str.data(), str.size());
+  }
+
+  /**
+   * Case insensitive 32-bit hash of a name, used by the hash tables on
+   * instruction names and symbols.
+   *
+   * This is FNV-1a on the upper case characters, with a seed to be able to derive
+   * independent hash functions (as needed for a perfect hash).
+   * Note that scripts/gen_qisa_instructions.py implements the same function.
+   *
+   * @param[in] name   Start of the name.
+   * @param[in] length Number of characters in the name.
+   * @param[in] seed   Selects the hash function.
+   *
+   * @return The hash value.
+   */
+  static uint32_t
+  hashName(const char* name, size_t length, uint32_t seed)
+  {
+    uint32_t hash = 2166136261u ^ seed;
+    hash *= 16777619u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+      hash ^= static_cast<uint8_t>(toupper(static_cast<unsigned char>(name[i])));
+      hash *= 16777619u;
+    }
+
+    // Mix the high bits into the low bits, since only the latter are used to index the tables.
+    hash ^= hash >> 15;
+    return hash;
+  }
+
+  /**
+   * @return True if the given names are equal, ignoring case.
+   */
+  static bool
+  equalNames(const char* name1, size_t length1, const char* name2, size_t length2)
+  {
+    if (length1 != length2)
+    {
+      return false;
+    }
+
+    for (size_t i = 0; i < length1; i++)
+    {
+      if (toupper(static_cast<unsigned char>(name1[i])) != toupper(static_cast<unsigned char>(name2[i])))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @return The hash of everything that has been added so far.
+   */
+  uint64_t
+  value() const
+  {
+    return _value;
+  }
+
+private:
+
+  uint64_t _value;
+};
+
+} // namespace QISA
@@ -0,0 +1,200 @@
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+#include "qisa_instruction_set_image.h"
+
+namespace QISA
+{
+
+const uint32_t QISA_InstructionSetImage::FORMAT_VERSION;
+
+// Identifies an instruction set image.
+static const char IMAGE_MAGIC[8] = { 'Q', 'I', 'S', 'A', 'S', 'P', 'E', 'C' };
+
+// Used to detect an image that has been written by a host with another byte order.
+static const uint32_t IMAGE_BYTE_ORDER_MARK = 0x01020304;
+
+QISA_InstructionSetImage::QISA_InstructionSetImage()
+  : _header(nullptr)
+  , _entries(nullptr)
+  , _names(nullptr)
+{
+}
+
+uint32_t
+QISA_InstructionSetImage::checksum(const char* data, size_t size)
+{
+  uint32_t hash = 2166136261u;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+bool
+QISA_InstructionSetImage::write(const std::string& filename,
+                                const q_map_t maps[NR_OF_KINDS],
+                                std::string& errorMessage)
+{
+  // Collect the entries and the names.
+  std::vector<ImageEntry> entries;
+  std::string names;
+
+  for (int kind = 0; kind < NR_OF_KINDS; kind++)
+  {
+    for (const auto& it : maps[kind])
+    {
+      if (it.first.empty() || (it.first.size() > 255))
+      {
+        errorMessage = "Instruction name '" + it.first + "' has an unsupported length.";
+        return false;
+      }
+
+      if ((it.second < 0) || (it.second > 255))
+      {
+        errorMessage = "Opcode of instruction '" + it.first + "' is out of range.";
+        return false;
+      }
+
+      ImageEntry entry;
+      entry.nameOffset = static_cast<uint32_t>(names.size());
+      entry.nameLength = static_cast<uint8_t>(it.first.size());
+      entry.kind = static_cast<uint8_t>(kind);
+      entry.opcode = static_cast<uint8_t>(it.second);
+      entry.reserved = 0;
+
+      entries.push_back(entry);
+      names += it.first;
+    }
+  }
+
+  // Assemble the part of the image that follows the header, to be able to compute its checksum.
+  std::string body;
+  body.append(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ImageEntry));
+  body.append(names);
+
+  ImageHeader header;
+  memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+  header.byteOrderMark = IMAGE_BYTE_ORDER_MARK;
+  header.version = FORMAT_VERSION;
+  header.nrOfEntries = static_cast<uint32_t>(entries.size());
+  header.namesSize = static_cast<uint32_t>(names.size());
+  header.checksum = checksum(body.data(), body.size());
+
+  std::ofstream imageFile(filename, std::ios::out | std::ios::binary);
+  if (!imageFile.is_open())
+  {
+    errorMessage = "Cannot open file '" + filename + "' for writing.";
+    return false;
+  }
+
+  imageFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  imageFile.write(body.data(), body.size());
+  imageFile.close();
+
+  if (imageFile.fail())
+  {
+    errorMessage = "Write error on file '" + filename + "'.";
+    return false;
+  }
+
+  return true;
+}
+
+bool
+QISA_InstructionSetImage::isImage(const std::string& filename)
+{
+  std::ifstream imageFile(filename, std::ios::in | std::ios::binary);
+
+  char magic[sizeof(IMAGE_MAGIC)];
+  return imageFile.read(magic, sizeof(magic)) &&
+         !memcmp(magic, IMAGE_MAGIC, sizeof(magic));
+}
+
+bool
+QISA_InstructionSetImage::open(const std::string& filename)
+{
+  _header = nullptr;
+  _errorMessage.clear();
+
+  if (!_file.open(filename))
+  {
+    _errorMessage = _file.getErrorMessage();
+    return false;
+  }
+
+  const char* data = _file.data();
+  const size_t size = _file.size();
+
+  if ((size < sizeof(ImageHeader)) || memcmp(data, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)))
+  {
+    _errorMessage = "File '" + filename + "' is not an instruction set image.";
+    return false;
+  }
+
+  // The tables are used in place, so they must be properly aligned.
+  if (reinterpret_cast<uintptr_t>(data) % alignof(ImageHeader) != 0)
+  {
+    _errorMessage = "Instruction set image '" + filename + "' is not properly aligned in memory.";
+    return false;
+  }
+
+  const ImageHeader* header = reinterpret_cast<const ImageHeader*>(data);
+
+  if (header->byteOrderMark != IMAGE_BYTE_ORDER_MARK)
+  {
+    _errorMessage = "Instruction set image '" + filename + "' has been written by a host with another byte order.";
+    return false;
+  }
+
+  if (header->version != FORMAT_VERSION)
+  {
+    _errorMessage = "Instruction set image '" + filename + "' has an unsupported version.";
+    return false;
+  }
+
+  const uint64_t expectedSize = sizeof(ImageHeader) +
+                                uint64_t(header->nrOfEntries) * sizeof(ImageEntry) +
+                                header->namesSize;
+
+  if ((size != expectedSize) ||
+      (checksum(data + sizeof(ImageHeader), size - sizeof(ImageHeader)) != header->checksum))
+  {
+    _errorMessage = "Instruction set image '" + filename + "' is damaged.";
+    return false;
+  }
+
+  const ImageEntry* entries = reinterpret_cast<const ImageEntry*>(data + sizeof(ImageHeader));
+  const char* names = reinterpret_cast<const char*>(entries + header->nrOfEntries);
+
+  // The checksum protects against damage, but make sure that a bad image
+  // cannot lead to accesses outside of the image.
+  for (uint32_t i = 0; i < header->nrOfEntries; i++)
+  {
+    if ((entries[i].kind >= NR_OF_KINDS) ||
+        (uint64_t(entries[i].nameOffset) + entries[i].nameLength > header->namesSize))
+    {
+      _errorMessage = "Instruction set image '" + filename + "' is damaged.";
+      return false;
+    }
+  }
+
+  _header = header;
+  _entries = entries;
+  _names = names;
+
+  return true;
+}
+
+std::string
+QISA_InstructionSetImage::getName(size_t index) const
+{
+  return std::string(_names + _entries[index].nameOffset, _entries[index].nameLength);
+}
+
+} // namespace QISA
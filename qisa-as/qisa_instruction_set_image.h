@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <map>
+
+#include "qisa_mapped_file.h"
+
+namespace QISA
+{
+
+/**
+ * Compiled, binary form of a quantum instruction set (see QISA_QMapParser for
+ * the textual form).
+ *
+ * An image holds the validated opcode tables, with (upper case) instruction
+ * names. It is memory mapped, and its entries are already in the order of the
+ * driver's instruction maps, so these can be filled in a single pass without
+ * parsing any text.
+ *
+ * Layout (all integers in the byte order of the host that wrote the image):
+ *
+ *   ImageHeader
+ *   ImageEntry     entries[nrOfEntries]       (sorted on kind, then on name)
+ *   char           names[namesSize]           (names, not zero-terminated)
+ */
+class QISA_InstructionSetImage
+{
+public:
+
+  //! Defines the type used to store mappings between an instruction name and its opcode.
+  typedef std::map<std::string, int> q_map_t;
+
+  //! Kind of quantum instruction, i.e. the map in which it is specified.
+  enum InstructionKind : uint8_t
+  {
+    KIND_ARG_NONE = 0,
+    KIND_ARG_ST   = 1,
+    KIND_ARG_TT   = 2,
+    NR_OF_KINDS   = 3
+  };
+
+  //! Version of the image layout. Images with another version are rejected.
+  static const uint32_t FORMAT_VERSION = 2;
+
+  DllExport
+  QISA_InstructionSetImage();
+
+  /**
+   * Write an image of the given instruction set to the given file.
+   * The maps must already have been validated, and contain upper case names.
+   *
+   * @param[in]  filename     File to write.
+   * @param[in]  maps         Instruction maps, indexed by InstructionKind.
+   * @param[out] errorMessage Describes the problem on failure.
+   *
+   * @return True on success, false on failure.
+   */
+  DllExport static bool
+  write(const std::string& filename, const q_map_t maps[NR_OF_KINDS], std::string& errorMessage);
+
+  /**
+   * @return True if the given file starts like an instruction set image.
+   */
+  DllExport static bool
+  isImage(const std::string& filename);
+
+  /**
+   * Map the given image file into memory and check its consistency.
+   *
+   * @param[in] filename File to open.
+   *
+   * @return True on success, false on failure.
+   *         In the latter case, getErrorMessage() describes the problem.
+   */
+  DllExport bool
+  open(const std::string& filename);
+
+  /**
+   * @return Description of the last error that occurred in open().
+   */
+  const std::string&
+  getErrorMessage() const
+  {
+    return _errorMessage;
+  }
+
+  /**
+   * @return The number of instructions in the image.
+   */
+  size_t
+  size() const
+  {
+    return _header ? _header->nrOfEntries : 0;
+  }
+
+  /**
+   * @return The name of the instruction at the given index.
+   */
+  DllExport std::string
+  getName(size_t index) const;
+
+  /**
+   * @return The kind of the instruction at the given index.
+   */
+  InstructionKind
+  getKind(size_t index) const
+  {
+    return static_cast<InstructionKind>(_entries[index].kind);
+  }
+
+  /**
+   * @return The opcode of the instruction at the given index.
+   */
+  int
+  getOpcode(size_t index) const
+  {
+    return _entries[index].opcode;
+  }
+
+private:
+
+  struct ImageHeader
+  {
+    char magic[8];
+    uint32_t byteOrderMark;
+    uint32_t version;
+    uint32_t nrOfEntries;
+    uint32_t namesSize;
+    uint32_t checksum;
+  };
+
+  struct ImageEntry
+  {
+    uint32_t nameOffset;
+    uint8_t nameLength;
+    uint8_t kind;
+    uint8_t opcode;
+    uint8_t reserved;
+  };
+
+  // Checksum over the part of the image that follows the header.
+  static uint32_t
+  checksum(const char* data, size_t size);
+
+  QISA_MappedFile _file;
+
+  // Pointers into _file.
+  const ImageHeader* _header;
+  const ImageEntry* _entries;
+  const char* _names;
+
+  std::string _errorMessage;
+};
+
+} // namespace QISA
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace QISA
+{
+
+/**
+ * Index of the lines in a source text, to look up a line by its number in
+ * constant time. It is used to show the source lines involved in an error,
+ * without scanning the source text again for each error.
+ *
+ * The text itself is not copied: it must remain valid while the index is used.
+ */
+class QISA_LineIndex
+{
+public:
+
+  QISA_LineIndex()
+    : _text(nullptr)
+    , _size(0)
+    , _isBuilt(false)
+  {}
+
+  /**
+   * Build the index of the given text, replacing the previous index.
+   * Lines are terminated by a new-line character. As with std::getline(),
+   * a new-line at the end of the text does not start another line.
+   *
+   * @param[in] text Start of the text.
+   * @param[in] size Number of bytes in text.
+   */
+  void
+  build(const char* text, size_t size)
+  {
+    _text = text;
+    _size = size;
+    _lineStarts.clear();
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+      _lineStarts.push_back(pos);
+
+      const void* newline = std::memchr(text + pos, '\n', size - pos);
+      if (newline == nullptr)
+      {
+        break;
+      }
+
+      pos = static_cast<const char*>(newline) - text + 1;
+    }
+
+    _isBuilt = true;
+  }
+
+  /**
+   * Forget the indexed text.
+   */
+  void
+  clear()
+  {
+    _text = nullptr;
+    _size = 0;
+    _lineStarts.clear();
+    _isBuilt = false;
+  }
+
+  /**
+   * @return True if build() has been called since the last clear().
+   */
+  bool
+  isBuilt() const
+  {
+    return _isBuilt;
+  }
+
+  /**
+   * @return The number of lines in the indexed text.
+   */
+  size_t
+  nrOfLines() const
+  {
+    return _lineStarts.size();
+  }
+
+  /**
+   * @param[in] lineNr Number of the line, starting at 1.
+   *                   It must not be larger than nrOfLines().
+   *
+   * @return The contents of the given line, without its terminating new-line.
+   */
+  std::string
+  getLine(size_t lineNr) const
+  {
+    const size_t start = _lineStarts[lineNr - 1];
+    size_t end = (lineNr < _lineStarts.size()) ? (_lineStarts[lineNr] - 1) : _size;
+
+    if ((end > start) && (_text[end - 1] == '\n'))
+    {
+      // Last line, terminated by a new-line.
+      end--;
+    }
+
+    return std::string(_text + start, end - start);
+  }
+
+private:
+
+  // The indexed text.
+  const char* _text;
+  size_t _size;
+
+  // Offset in the text of the start of each line.
+  std::vector<size_t> _lineStarts;
+
+  bool _isBuilt;
+};
+
+} // namespace QISA
@@ -0,0 +1,154 @@
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "qisa_mapped_file.h"
+
+namespace QISA
+{
+
+QISA_MappedFile::QISA_MappedFile()
+  : _data(nullptr)
+  , _size(0)
+  , _isMapped(false)
+#ifdef _WIN32
+  , _fileHandle(INVALID_HANDLE_VALUE)
+  , _mappingHandle(NULL)
+#endif
+{
+}
+
+QISA_MappedFile::~QISA_MappedFile()
+{
+  close();
+}
+
+bool
+QISA_MappedFile::open(const std::string& filename)
+{
+  close();
+  _errorMessage.clear();
+
+#ifdef _WIN32
+  HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                  NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    _errorMessage = "Cannot open file '" + filename + "'.";
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(fileHandle, &fileSize) && (fileSize.QuadPart > 0))
+  {
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle != NULL)
+    {
+      void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+      if (view != NULL)
+      {
+        _fileHandle = fileHandle;
+        _mappingHandle = mappingHandle;
+        _data = static_cast<const char*>(view);
+        _size = static_cast<size_t>(fileSize.QuadPart);
+        _isMapped = true;
+        return true;
+      }
+      CloseHandle(mappingHandle);
+    }
+  }
+  CloseHandle(fileHandle);
+#else
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    _errorMessage = "Cannot open file '" + filename + "': " + strerror(errno);
+    return false;
+  }
+
+  struct stat fileStat;
+  if ((fstat(fd, &fileStat) == 0) &&
+      S_ISREG(fileStat.st_mode) &&
+      (fileStat.st_size > 0))
+  {
+    void* mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+      // The file is read front to back.
+      madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+
+      ::close(fd);
+      _data = static_cast<const char*>(mapping);
+      _size = static_cast<size_t>(fileStat.st_size);
+      _isMapped = true;
+      return true;
+    }
+  }
+  ::close(fd);
+#endif
+
+  // Mapping is not possible, read the file in the conventional way.
+  return readIntoBuffer(filename);
+}
+
+void
+QISA_MappedFile::close()
+{
+  if (_isMapped)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+    _mappingHandle = NULL;
+    _fileHandle = INVALID_HANDLE_VALUE;
+#else
+    munmap(const_cast<char*>(_data), _size);
+#endif
+    _isMapped = false;
+  }
+
+  std::vector<char>().swap(_buffer);
+  _data = nullptr;
+  _size = 0;
+}
+
+bool
+QISA_MappedFile::readIntoBuffer(const std::string& filename)
+{
+  std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+
+  if (!inputFile.is_open())
+  {
+    _errorMessage = "Cannot open file '" + filename + "'.";
+    return false;
+  }
+
+  char chunk[65536];
+  while (inputFile.read(chunk, sizeof(chunk)) || (inputFile.gcount() > 0))
+  {
+    _buffer.insert(_buffer.end(), chunk, chunk + inputFile.gcount());
+  }
+
+  if (inputFile.bad())
+  {
+    _errorMessage = "Error while reading file '" + filename + "'.";
+    std::vector<char>().swap(_buffer);
+    return false;
+  }
+
+  _data = _buffer.data();
+  _size = _buffer.size();
+  return true;
+}
+
+} // namespace QISA
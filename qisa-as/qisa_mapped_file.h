@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifndef DllExport
+#ifdef _WIN32
+#define DllExport __declspec(dllexport)
+#else
+#define DllExport
+#endif
+#endif
+
+namespace QISA
+{
+
+/**
+ * Read-only view on the contents of a file.
+ *
+ * Where possible, the file is memory mapped, such that its contents can be
+ * accessed without copying them.
+ * If the file cannot be mapped (e.g. because it is empty or because it is not
+ * a regular file), its contents are read into a buffer instead.
+ */
+class QISA_MappedFile
+{
+public:
+
+  DllExport
+  QISA_MappedFile();
+
+  DllExport
+  ~QISA_MappedFile();
+
+  /**
+   * Open the given file and make its contents available.
+   * A previously opened file is closed first.
+   *
+   * @param[in] filename Name of the file to open.
+   *
+   * @return True on success, false if the file could not be opened or read.
+   *         In the latter case, getErrorMessage() describes the problem.
+   */
+  DllExport bool
+  open(const std::string& filename);
+
+  /**
+   * Release the contents of the file.
+   */
+  DllExport void
+  close();
+
+  /**
+   * @return Pointer to the contents of the file.
+   *         The contents remain valid until close() is called.
+   */
+  const char*
+  data() const
+  {
+    return _data;
+  }
+
+  /**
+   * @return The size of the file, in bytes.
+   */
+  size_t
+  size() const
+  {
+    return _size;
+  }
+
+  /**
+   * @return Description of the last error that occurred in open().
+   */
+  const std::string&
+  getErrorMessage() const
+  {
+    return _errorMessage;
+  }
+
+private:
+
+  // Read the whole file into _buffer.
+  bool
+  readIntoBuffer(const std::string& filename);
+
+  // Not copyable: this object owns the mapping.
+  QISA_MappedFile(const QISA_MappedFile&);
+  QISA_MappedFile& operator=(const QISA_MappedFile&);
+
+  // Start of the file contents: either the mapping or _buffer.
+  const char* _data;
+
+  // Size of the file contents, in bytes.
+  size_t _size;
+
+  // True if _data points to a memory mapping.
+  bool _isMapped;
+
+  // Holds the file contents if the file could not be mapped.
+  std::vector<char> _buffer;
+
+#ifdef _WIN32
+  // Handles needed to undo the mapping.
+  void* _fileHandle;
+  void* _mappingHandle;
+#endif
+
+  std::string _errorMessage;
+};
+
+} // namespace QISA
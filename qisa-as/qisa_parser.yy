@@ -13,6 +13,8 @@
   #include <memory>
   #include <vector>
 
+  #include "qisa_small_vector.h"
+
   namespace QISA
   {
     struct QInstruction
@@ -53,8 +55,12 @@
         bool is_conditional;
     };
 
-    typedef std::shared_ptr<QInstruction> QInstructionPtr;
-    typedef std::vector<QInstructionPtr> BundledQInstructions;
+    // Quantum instructions are allocated in an arena that is owned by the driver,
+    // and remain valid until the next assembly run.
+    typedef QInstruction* QInstructionPtr;
+
+    // Most bundles contain only a few instructions, so keep up to 4 of them inline.
+    typedef QISA_SmallVector<QInstructionPtr, 4> BundledQInstructions;
 
     class QISA_Driver;
   }
@@ -651,13 +657,12 @@ one_or_more_q_instrs
     {
       $$ = QISA::BundledQInstructions();
       $$.push_back($1);
-      QInstructionPtr inst = $1;
     }
   | one_or_more_q_instrs VBAR q_instr
     {
       QISA::BundledQInstructions &instrs = $1;
       instrs.push_back($3);
-      $$ = instrs;
+      $$ = std::move(instrs);
     }
     ;
 
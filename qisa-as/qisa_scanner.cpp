@@ -0,0 +1,759 @@
+#include <iostream>
+#include <cstring>
+#include <limits>
+
+#include "qisa_scanner.h"
+#include "qisa_driver.h"
+#include "qisa_hash.h"
+
+namespace QISA
+{
+
+namespace
+{
+
+// Class of a character, which determines the kind of token that starts with it.
+enum CharClass : uint8_t
+{
+  CC_JUNK,         // Not the start of any token.
+  CC_SPACE,        // ' ', '\t'
+  CC_NEWLINE,      // '\n'
+  CC_CR,           // '\r'
+  CC_HASH,         // '#'
+  CC_DIGIT,        // '0' - '9'
+  CC_MINUS,        // '-'
+  CC_ALPHA,        // 'a' - 'z', 'A' - 'Z'
+  CC_QUOTE,        // '"'
+  CC_DOT,          // '.'
+  CC_COMMA,        // ','
+  CC_COLON,        // ':'
+  CC_VBAR,         // '|'
+  CC_BRACE_OPEN,   // '{'
+  CC_BRACE_CLOSE,  // '}'
+  CC_PAREN_OPEN,   // '('
+  CC_PAREN_CLOSE   // ')'
+};
+
+// Character tables, indexed by (unsigned) character.
+struct CharTables
+{
+  CharTables()
+  {
+    for (int c = 0; c < 256; c++)
+    {
+      charClass[c] = CC_JUNK;
+      isWordChar[c] = false;
+      digitValue[c] = 0xff;
+    }
+
+    for (int c = '0'; c <= '9'; c++)
+    {
+      charClass[c] = CC_DIGIT;
+      isWordChar[c] = true;
+      digitValue[c] = c - '0';
+    }
+
+    for (int c = 'a'; c <= 'z'; c++)
+    {
+      charClass[c] = CC_ALPHA;
+      charClass[c - 'a' + 'A'] = CC_ALPHA;
+      isWordChar[c] = true;
+      isWordChar[c - 'a' + 'A'] = true;
+    }
+
+    for (int c = 'a'; c <= 'f'; c++)
+    {
+      digitValue[c] = c - 'a' + 10;
+      digitValue[c - 'a' + 'A'] = c - 'a' + 10;
+    }
+
+    isWordChar['_'] = true;
+
+    charClass[' '] = CC_SPACE;
+    charClass['\t'] = CC_SPACE;
+    charClass['\n'] = CC_NEWLINE;
+    charClass['\r'] = CC_CR;
+    charClass['#'] = CC_HASH;
+    charClass['-'] = CC_MINUS;
+    charClass['"'] = CC_QUOTE;
+    charClass['.'] = CC_DOT;
+    charClass[','] = CC_COMMA;
+    charClass[':'] = CC_COLON;
+    charClass['|'] = CC_VBAR;
+    charClass['{'] = CC_BRACE_OPEN;
+    charClass['}'] = CC_BRACE_CLOSE;
+    charClass['('] = CC_PAREN_OPEN;
+    charClass[')'] = CC_PAREN_CLOSE;
+  }
+
+  CharClass charClass[256];
+  bool isWordChar[256];
+
+  // Value of a (hexadecimal) digit, or 0xff for other characters.
+  uint8_t digitValue[256];
+};
+
+const CharTables charTables;
+
+inline CharClass
+charClassOf(char c)
+{
+  return charTables.charClass[static_cast<unsigned char>(c)];
+}
+
+inline bool
+isWordChar(char c)
+{
+  return charTables.isWordChar[static_cast<unsigned char>(c)];
+}
+
+inline uint8_t
+digitValueOf(char c)
+{
+  return charTables.digitValue[static_cast<unsigned char>(c)];
+}
+
+inline bool
+isDigit(char c)
+{
+  return charClassOf(c) == CC_DIGIT;
+}
+
+typedef QISA_Parser::symbol_type (*TokenMaker)(const location& loc);
+
+struct Keyword
+{
+  const char* name;
+  TokenMaker makeToken;
+};
+
+#define QISA_KEYWORD(NAME) \
+  { #NAME, [](const location& loc) { return QISA_Parser::make_##NAME(loc); } }
+
+#define QISA_CONDITION(NAME) \
+  { #NAME, [](const location& loc) { return QISA_Parser::make_COND_##NAME(QISA_Driver::COND_##NAME, loc); } }
+
+// The keywords of qisa_lexer.l.
+const Keyword KEYWORDS[] =
+{
+  // Branch conditions.
+  QISA_CONDITION(ALWAYS),
+  QISA_CONDITION(NEVER),
+  QISA_CONDITION(EQ),
+  QISA_CONDITION(NE),
+  QISA_CONDITION(EQZ),
+  QISA_CONDITION(NEZ),
+  QISA_CONDITION(LT),
+  QISA_CONDITION(LTZ),
+  QISA_CONDITION(LE),
+  QISA_CONDITION(GT),
+  QISA_CONDITION(GE),
+  QISA_CONDITION(GEZ),
+  QISA_CONDITION(LTU),
+  QISA_CONDITION(LEU),
+  QISA_CONDITION(GTU),
+  QISA_CONDITION(GEU),
+  QISA_CONDITION(CARRY),
+  QISA_CONDITION(NOTCARRY),
+
+  // Classic low-level instructions.
+  QISA_KEYWORD(NOP),
+  QISA_KEYWORD(STOP),
+  QISA_KEYWORD(ADD),
+  QISA_KEYWORD(SUB),
+  QISA_KEYWORD(ADDC),
+  QISA_KEYWORD(SUBC),
+  QISA_KEYWORD(AND),
+  QISA_KEYWORD(OR),
+  QISA_KEYWORD(XOR),
+  QISA_KEYWORD(NOT),
+  QISA_KEYWORD(CMP),
+  QISA_KEYWORD(BR),
+  QISA_KEYWORD(LDI),
+  QISA_KEYWORD(LDUI),
+  QISA_KEYWORD(FBR),
+  QISA_KEYWORD(FMR),
+  QISA_KEYWORD(SMIS),
+  QISA_KEYWORD(SMIT),
+
+  // Quantum instructions that use the same (single) instruction format.
+  QISA_KEYWORD(QWAIT),
+  QISA_KEYWORD(QWAITR),
+
+  // Aliases, that may result in another or more classic low-level instructions.
+  QISA_KEYWORD(SHL1),
+  QISA_KEYWORD(NAND),
+  QISA_KEYWORD(NOR),
+  QISA_KEYWORD(XNOR),
+  QISA_KEYWORD(BRA),
+  QISA_KEYWORD(GOTO),
+  QISA_KEYWORD(BRN),
+  QISA_KEYWORD(BEQ),
+  QISA_KEYWORD(BNE),
+  QISA_KEYWORD(BLT),
+  QISA_KEYWORD(BLE),
+  QISA_KEYWORD(BGT),
+  QISA_KEYWORD(BGE),
+  QISA_KEYWORD(BLTU),
+  QISA_KEYWORD(BLEU),
+  QISA_KEYWORD(BGTU),
+  QISA_KEYWORD(BGEU),
+  QISA_KEYWORD(COPY),
+  QISA_KEYWORD(MOV),
+  QISA_KEYWORD(MULT2),
+
+  // Bundle separator.
+  QISA_KEYWORD(BS)
+};
+
+#undef QISA_KEYWORD
+#undef QISA_CONDITION
+
+// Length of the longest keyword.
+const size_t MAX_KEYWORD_LENGTH = 8;
+
+// Hash table on the keywords, using the case insensitive name hash.
+struct KeywordTable
+{
+  static const uint32_t TABLE_SIZE = 128;
+
+  KeywordTable()
+  {
+    for (auto& slot : slots)
+    {
+      slot = nullptr;
+    }
+
+    for (const Keyword& keyword : KEYWORDS)
+    {
+      uint32_t index = QISA_Hash::hashName(keyword.name, strlen(keyword.name), 0) & (TABLE_SIZE - 1);
+      while (slots[index])
+      {
+        index = (index + 1) & (TABLE_SIZE - 1);
+      }
+      slots[index] = &keyword;
+    }
+  }
+
+  // Returns the keyword with the given (case insensitive) name, or NULL if there is none.
+  const Keyword*
+  find(const char* name, size_t length) const
+  {
+    uint32_t index = QISA_Hash::hashName(name, length, 0) & (TABLE_SIZE - 1);
+
+    while (slots[index])
+    {
+      const Keyword* keyword = slots[index];
+      if (QISA_Hash::equalNames(name, length, keyword->name, strlen(keyword->name)))
+      {
+        return keyword;
+      }
+      index = (index + 1) & (TABLE_SIZE - 1);
+    }
+
+    return nullptr;
+  }
+
+  const Keyword* slots[TABLE_SIZE];
+};
+
+const KeywordTable keywordTable;
+
+// Returns true if the text at [begin, end) starts with the given lower case word,
+// ignoring case.
+bool
+startsWith(const char* begin, const char* end, const char* word)
+{
+  const size_t length = strlen(word);
+
+  if (static_cast<size_t>(end - begin) < length)
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; i++)
+  {
+    if (tolower(static_cast<unsigned char>(begin[i])) != word[i])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // anonymous namespace
+
+QISA_Scanner::QISA_Scanner(QISA_Driver& driver, bool trace)
+  : _driver(driver)
+  , _trace(trace)
+  , _begin(nullptr)
+  , _cursor(nullptr)
+  , _end(nullptr)
+{
+}
+
+void
+QISA_Scanner::setInput(const char* data, size_t size)
+{
+  _begin = data;
+  _cursor = data;
+  _end = data + size;
+}
+
+bool
+QISA_Scanner::openInput(const std::string& filename)
+{
+  if (!_inputFile.open(filename))
+  {
+    return false;
+  }
+
+  setInput(_inputFile.data(), _inputFile.size());
+  return true;
+}
+
+QISA_Parser::symbol_type
+QISA_Scanner::next()
+{
+  // The location of the current token.
+  // As in the flex scanner, it is kept in the driver.
+  location& loc = _driver._scanLocation;
+
+  loc.step();
+
+  for (;;)
+  {
+    // This is a trick to always generate an extra new line at the end of file.
+    // It prevents the parser to give an error message in case the last line of a file is not properly terminated.
+    if (_cursor == _end)
+    {
+      if (_trace)
+      {
+        std::cerr << "--EOF" << std::endl;
+      }
+
+      if (_driver.hadEOF())
+      {
+        return QISA_Parser::make_END(loc);
+      }
+
+      _driver.haveEOF();
+      return QISA_Parser::make_NEWLINE(loc);
+    }
+
+    const char* start = _cursor;
+
+    switch (charClassOf(*_cursor))
+    {
+      case CC_SPACE:
+        do
+        {
+          _cursor++;
+        } while ((_cursor != _end) && (charClassOf(*_cursor) == CC_SPACE));
+
+        traceToken(start, _cursor);
+        loc.columns(static_cast<int>(_cursor - start));
+        loc.step();
+        break;
+
+      case CC_HASH:
+      {
+        // A comment runs until the end of the line.
+        const char* newline = static_cast<const char*>(memchr(_cursor, '\n', _end - _cursor));
+        _cursor = newline ? newline : _end;
+
+        traceToken(start, _cursor);
+        loc.columns(static_cast<int>(_cursor - start));
+        loc.step();
+        break;
+      }
+
+      case CC_CR:
+        // Carriage returns are ignored, but they do count as a column.
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        break;
+
+      case CC_NEWLINE:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        loc.lines(1);
+        loc.step();
+        return QISA_Parser::make_NEWLINE(loc);
+
+      case CC_DIGIT:
+        return scanInteger(loc);
+
+      case CC_MINUS:
+        if ((_cursor + 1 != _end) && isDigit(_cursor[1]))
+        {
+          return scanInteger(loc);
+        }
+        goto junk;
+
+      case CC_ALPHA:
+        return scanWord(loc);
+
+      case CC_QUOTE:
+      {
+        // A string runs until the next double quote; it may span several lines.
+        const char* closingQuote = static_cast<const char*>(memchr(_cursor + 1, '"', _end - _cursor - 1));
+        if (!closingQuote)
+        {
+          goto junk;
+        }
+
+        _cursor = closingQuote + 1;
+        traceToken(start, _cursor);
+        loc.columns(static_cast<int>(_cursor - start));
+
+        // Like the flex scanner, which passes the text as a C string, stop at a NUL character.
+        const char* nul = static_cast<const char*>(memchr(start, '\0', _cursor - start));
+        return QISA_Parser::make_STRING(std::string(start, nul ? nul : _cursor), loc);
+      }
+
+      case CC_DOT:
+        // Directives.
+        if (startsWith(_cursor, _end, ".def_sym"))
+        {
+          _cursor += 8;
+          traceToken(start, _cursor);
+          loc.columns(8);
+          return QISA_Parser::make_DIR_DEF_SYMBOL(loc);
+        }
+
+        if (startsWith(_cursor, _end, ".register"))
+        {
+          _cursor += 9;
+          traceToken(start, _cursor);
+          loc.columns(9);
+          return QISA_Parser::make_DIR_REGISTER(loc);
+        }
+        goto junk;
+
+      case CC_COMMA:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_COMMA(loc);
+
+      case CC_COLON:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_COLON(loc);
+
+      case CC_VBAR:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_VBAR(loc);
+
+      case CC_BRACE_OPEN:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_BRACE_OPEN(loc);
+
+      case CC_BRACE_CLOSE:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_BRACE_CLOSE(loc);
+
+      case CC_PAREN_OPEN:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_PAREN_OPEN(loc);
+
+      case CC_PAREN_CLOSE:
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_PAREN_CLOSE(loc);
+
+      default:
+      junk:
+      {
+        // A single character that does not start any token.
+        const char c = *_cursor;
+        _cursor++;
+        traceToken(start, _cursor);
+        loc.columns(1);
+        return QISA_Parser::make_JUNK(c ? std::string(1, c) : std::string(), loc);
+      }
+    }
+  }
+}
+
+QISA_Parser::symbol_type
+QISA_Scanner::scanWord(location& loc)
+{
+  const char* start = _cursor;
+  const char* wordEnd = _cursor + 1;
+
+  while ((wordEnd != _end) && isWordChar(*wordEnd))
+  {
+    wordEnd++;
+  }
+
+  const size_t length = wordEnd - start;
+
+  // "C," specifies a conditional quantum instruction.
+  // Since it is longer than the identifier "C", it takes precedence.
+  if ((length == 1) && ((*start == 'c') || (*start == 'C')) &&
+      (wordEnd != _end) && (*wordEnd == ','))
+  {
+    _cursor = wordEnd + 1;
+    traceToken(start, _cursor);
+    loc.columns(2);
+    return QISA_Parser::make_COND_Q_INSTR_ST(loc);
+  }
+
+  _cursor = wordEnd;
+  traceToken(start, _cursor);
+  loc.columns(static_cast<int>(length));
+
+  // A register: one of 'q', 'r', 's' or 't', followed by digits only.
+  if (length >= 2)
+  {
+    const char registerKind = static_cast<char>(tolower(static_cast<unsigned char>(*start)));
+
+    if ((registerKind == 'q') || (registerKind == 'r') || (registerKind == 's') || (registerKind == 't'))
+    {
+      const char* p = start + 1;
+      while ((p != wordEnd) && isDigit(*p))
+      {
+        p++;
+      }
+
+      if (p == wordEnd)
+      {
+        const uint8_t registerNumber = toRegisterNumber(start + 1, wordEnd);
+
+        switch (registerKind)
+        {
+          case 'q':
+            return QISA_Parser::make_Q_REGISTER(registerNumber, loc);
+          case 'r':
+            return QISA_Parser::make_R_REGISTER(registerNumber, loc);
+          case 's':
+            return QISA_Parser::make_S_REGISTER(registerNumber, loc);
+          default:
+            return QISA_Parser::make_T_REGISTER(registerNumber, loc);
+        }
+      }
+    }
+  }
+
+  if (length <= MAX_KEYWORD_LENGTH)
+  {
+    const Keyword* keyword = keywordTable.find(start, length);
+    if (keyword)
+    {
+      return keyword->makeToken(loc);
+    }
+  }
+
+  return QISA_Parser::make_IDENTIFIER(std::string(start, length), loc);
+}
+
+QISA_Parser::symbol_type
+QISA_Scanner::scanInteger(location& loc)
+{
+  const char* start = _cursor;
+  const bool negative = (*start == '-');
+  const char* digits = negative ? start + 1 : start;
+
+  const char* p = digits;
+  while ((p != _end) && isDigit(*p))
+  {
+    p++;
+  }
+
+  // "0x..." and "0b..." are longer than the integer "0", so they take precedence.
+  if (!negative && (p == digits + 1) && (*digits == '0') && (p + 1 < _end))
+  {
+    const char prefix = static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+    const int base = (prefix == 'x') ? 16 : ((prefix == 'b') ? 2 : 0);
+
+    if ((base != 0) && (digitValueOf(p[1]) < base))
+    {
+      const char* prefixedDigits = p + 1;
+      const char* q = prefixedDigits;
+      while ((q != _end) && (digitValueOf(*q) < base))
+      {
+        q++;
+      }
+
+      _cursor = q;
+      traceToken(start, _cursor);
+      loc.columns(static_cast<int>(_cursor - start));
+      return QISA_Parser::make_INTEGER(toInteger(prefixedDigits, q, base, false), loc);
+    }
+  }
+
+  _cursor = p;
+  traceToken(start, _cursor);
+  loc.columns(static_cast<int>(_cursor - start));
+  return QISA_Parser::make_INTEGER(toInteger(digits, p, 10, negative), loc);
+}
+
+int64_t
+QISA_Scanner::toInteger(const char* begin, const char* end, int base, bool negative)
+{
+  // Number of digits that certainly fit in an int64_t, per base.
+  const size_t nrOfSafeDigits = (base == 10) ? 18 : ((base == 16) ? 15 : 62);
+
+  uint64_t value = 0;
+
+  if (static_cast<size_t>(end - begin) <= nrOfSafeDigits)
+  {
+    // The common case: no need to check for overflow.
+    for (const char* p = begin; p != end; p++)
+    {
+      value = value * base + digitValueOf(*p);
+    }
+
+    return negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+  }
+
+  // The magnitude of the most negative value is one larger than that of the most positive value.
+  const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+
+  bool outOfRange = false;
+
+  for (const char* p = begin; p != end; p++)
+  {
+    const uint64_t digit = digitValueOf(*p);
+
+    if (value > (limit - digit) / base)
+    {
+      outOfRange = true;
+      break;
+    }
+
+    value = value * base + digit;
+  }
+
+  if (outOfRange)
+  {
+    _driver.error(_driver._scanLocation, "value is out of range for int64_t");
+
+    // Like strtol(), saturate the value.
+    return negative ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+  }
+
+  if (negative)
+  {
+    return (value == limit) ? std::numeric_limits<int64_t>::min() : -static_cast<int64_t>(value);
+  }
+
+  return static_cast<int64_t>(value);
+}
+
+uint8_t
+QISA_Scanner::toRegisterNumber(const char* begin, const char* end)
+{
+  const uint64_t maxValue = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+  uint64_t value = 0;
+
+  for (const char* p = begin; p != end; p++)
+  {
+    const uint64_t digit = digitValueOf(*p);
+
+    if (value > (maxValue - digit) / 10)
+    {
+      // Like strtol(), saturate the value.
+      value = maxValue;
+      break;
+    }
+
+    value = value * 10 + digit;
+  }
+
+  if (value > 255)
+  {
+    _driver.error(_driver._scanLocation, "value is out of range for uint8_t");
+  }
+
+  // As in the flex scanner, an out of range value is truncated.
+  return static_cast<uint8_t>(value);
+}
+
+void
+QISA_Scanner::traceToken(const char* begin, const char* end) const
+{
+  if (_trace)
+  {
+    std::cerr << "--accepting (\"" << std::string(begin, end) << "\")" << std::endl;
+  }
+}
+
+bool
+QISA_Driver::fastScanBegin(yyscan_t* scanner)
+{
+  // Initialize the scan location.
+  // Otherwise, the current location keeps increasing each time
+  // a new file is processed.
+  _scanLocation = location();
+
+  QISA_Scanner* fastScanner = new QISA_Scanner(*this, _traceScanning);
+  *scanner = fastScanner;
+
+  if (_sourceIsBuffer)
+  {
+    if (_sourceBuffer.empty())
+    {
+      error("Input buffer is empty!");
+    }
+    else
+    {
+      // Scan the in-memory source code directly.
+      fastScanner->setInput(_sourceBuffer.data(), _sourceBuffer.size());
+      return true;
+    }
+  }
+  else if (_scanSourceFile)
+  {
+    if (_sourceFile.size() == 0)
+    {
+      error("File '" + _filename + "' is empty!");
+    }
+    else
+    {
+      // Scan the source file that has been mapped to derive the assembly cache key.
+      fastScanner->setInput(_sourceFile.data(), _sourceFile.size());
+      return true;
+    }
+  }
+  else if (!fastScanner->openInput(_filename))
+  {
+    error(fastScanner->getErrorMessage());
+  }
+  else if (fastScanner->getInputSize() == 0)
+  {
+    error("File '" + _filename + "' is empty!");
+  }
+  else
+  {
+    return true;
+  }
+
+  delete fastScanner;
+  *scanner = nullptr;
+  return false;
+}
+
+void
+QISA_Driver::fastScanEnd(yyscan_t scanner)
+{
+  delete static_cast<QISA_Scanner*>(scanner);
+}
+
+} // namespace QISA
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "qisa_parser.tab.hh"
+#include "qisa_mapped_file.h"
+
+namespace QISA
+{
+
+class QISA_Driver;
+
+/**
+ * Hand-written scanner for QISA assembly, as an alternative for the flex
+ * scanner in qisa_lexer.l.
+ *
+ * It produces exactly the same tokens and locations as the flex scanner, but
+ * it works directly on the whole source text (a memory mapped file or the
+ * driver's source buffer):
+ *   - the next token is selected by a switch on the class of its first character;
+ *   - keywords are found by one lookup of the case folded identifier in a hash table;
+ *   - integers are converted while they are scanned;
+ *   - a std::string is only created for tokens that carry text (identifiers,
+ *     strings and junk).
+ *
+ * It is used by the parser if the assembler has been built with QISA_AS_FAST_SCANNER
+ * (see the CMake option of the same name).
+ */
+class QISA_Scanner
+{
+public:
+
+  /**
+   * @param[in] driver Driver that receives the error messages, and holds the scan location.
+   * @param[in] trace  Write each token that is recognized to std::cerr.
+   */
+  QISA_Scanner(QISA_Driver& driver, bool trace);
+
+  /**
+   * Scan the given text. It must remain valid while scanning.
+   */
+  void
+  setInput(const char* data, size_t size);
+
+  /**
+   * Open the given file, and scan its contents.
+   *
+   * @return True on success, false on failure.
+   *         In the latter case, getErrorMessage() describes the problem.
+   */
+  bool
+  openInput(const std::string& filename);
+
+  /**
+   * @return Description of the problem that occurred in openInput().
+   */
+  const std::string&
+  getErrorMessage() const
+  {
+    return _inputFile.getErrorMessage();
+  }
+
+  /**
+   * @return The size of the input, in bytes.
+   */
+  size_t
+  getInputSize() const
+  {
+    return _end - _begin;
+  }
+
+  /**
+   * @return The next token.
+   *         At the end of the input, a NEWLINE is returned first, and END after that.
+   */
+  QISA_Parser::symbol_type
+  next();
+
+private:
+
+  // Convert the digits in [begin, end) to a value, with the same result as strtol()
+  // gives for them, and report an error if the value is out of range.
+  int64_t
+  toInteger(const char* begin, const char* end, int base, bool negative);
+
+  // Convert the register number in [begin, end), reporting an error if it is out of range.
+  uint8_t
+  toRegisterNumber(const char* begin, const char* end);
+
+  // Scan an identifier, keyword or register that starts at _cursor.
+  QISA_Parser::symbol_type
+  scanWord(location& loc);
+
+  // Scan an integer that starts at _cursor, which is at a digit or at a '-' followed by a digit.
+  QISA_Parser::symbol_type
+  scanInteger(location& loc);
+
+  void
+  traceToken(const char* begin, const char* end) const;
+
+  QISA_Driver& _driver;
+
+  const bool _trace;
+
+  // Holds the contents of the input file, if the input is a file.
+  QISA_MappedFile _inputFile;
+
+  const char* _begin;
+  const char* _cursor;
+  const char* _end;
+};
+
+} // namespace QISA
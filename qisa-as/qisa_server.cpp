@@ -0,0 +1,458 @@
+#include <iostream>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "qisa_server.h"
+
+namespace QISA
+{
+
+const uint32_t QISA_Server::MAX_MESSAGE_SIZE;
+
+#ifndef _WIN32
+
+namespace
+{
+
+// Set by the signal handler to stop the server.
+volatile std::sig_atomic_t stopRequested = 0;
+
+void
+stopHandler(int)
+{
+  stopRequested = 1;
+}
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+// Fill a socket address for the given path.
+// Returns false if the path does not fit.
+bool
+makeSocketAddress(const std::string& socketPath, sockaddr_un& address)
+{
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (socketPath.size() >= sizeof(address.sun_path))
+  {
+    return false;
+  }
+
+  memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  return true;
+}
+
+bool
+readAll(int fd, char* data, size_t size)
+{
+  while (size != 0)
+  {
+    ssize_t n = ::recv(fd, data, size, 0);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool
+writeAll(int fd, const char* data, size_t size)
+{
+  while (size != 0)
+  {
+    ssize_t n = ::send(fd, data, size, SEND_FLAGS);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+#endif // _WIN32
+
+QISA_Server::QISA_Server(const QISA_Driver& prototype)
+  : _prototype(prototype)
+  , _verbose(false)
+{
+}
+
+void
+QISA_Server::setVerbose(bool verbose)
+{
+  _verbose = verbose;
+}
+
+const std::string&
+QISA_Server::getErrorMessage() const
+{
+  return _errorMessage;
+}
+
+#ifdef _WIN32
+
+bool
+QISA_Server::serve(const std::string& socketPath)
+{
+  _errorMessage = "Server mode is not supported on this platform.";
+  return false;
+}
+
+bool
+QISA_Server::sendRequest(const std::string& socketPath,
+                         RequestKind kind,
+                         int disassemblyFormatId,
+                         const std::string& input,
+                         bool& requestSucceeded,
+                         std::string& output,
+                         std::string& errorMessage)
+{
+  requestSucceeded = false;
+  errorMessage = "Client mode is not supported on this platform.";
+  return false;
+}
+
+#else
+
+bool
+QISA_Server::serve(const std::string& socketPath)
+{
+  sockaddr_un address;
+  if (!makeSocketAddress(socketPath, address))
+  {
+    _errorMessage = "Socket path '" + socketPath + "' is too long.";
+    return false;
+  }
+
+  // A socket file may have been left behind by a server that did not stop normally.
+  // Only remove it if no server is listening on it anymore.
+  int probeFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probeFd >= 0)
+  {
+    bool inUse = (::connect(probeFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    ::close(probeFd);
+
+    if (inUse)
+    {
+      _errorMessage = "Another server is already listening on socket '" + socketPath + "'.";
+      return false;
+    }
+  }
+  ::unlink(socketPath.c_str());
+
+  int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+  {
+    _errorMessage = std::string("Cannot create socket: ") + strerror(errno);
+    return false;
+  }
+
+  if ((::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) ||
+      (::listen(listenFd, SOMAXCONN) != 0))
+  {
+    _errorMessage = "Cannot listen on socket '" + socketPath + "': " + strerror(errno);
+    ::close(listenFd);
+    return false;
+  }
+
+  // Writing to a client that has gone away must not terminate the server.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  stopRequested = 0;
+  std::signal(SIGINT, stopHandler);
+  std::signal(SIGTERM, stopHandler);
+
+  if (_verbose)
+  {
+    std::cout << "QISA-AS: Serving requests on socket '" << socketPath << "'." << std::endl;
+  }
+
+  while (!stopRequested)
+  {
+    // Wake up regularly to check whether the server must stop.
+    pollfd pollFd;
+    pollFd.fd = listenFd;
+    pollFd.events = POLLIN;
+    pollFd.revents = 0;
+
+    int nrOfReadyFds = ::poll(&pollFd, 1, 200);
+    if (nrOfReadyFds <= 0)
+    {
+      continue;
+    }
+
+    int clientFd = ::accept(listenFd, NULL, NULL);
+    if (clientFd < 0)
+    {
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _clientFds.insert(clientFd);
+    }
+
+    std::thread(&QISA_Server::handleConnection, this, clientFd).detach();
+  }
+
+  ::close(listenFd);
+  ::unlink(socketPath.c_str());
+
+  // Let the open connections finish their current request, and wait for them.
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (int clientFd : _clientFds)
+  {
+    ::shutdown(clientFd, SHUT_RD);
+  }
+  _connectionClosed.wait(lock, [this] { return _clientFds.empty(); });
+
+  std::signal(SIGINT, SIG_DFL);
+  std::signal(SIGTERM, SIG_DFL);
+
+  if (_verbose)
+  {
+    std::cout << "QISA-AS: Server stopped." << std::endl;
+  }
+
+  return true;
+}
+
+void
+QISA_Server::handleConnection(int clientFd)
+{
+  std::unique_ptr<QISA_Driver> driver = acquireDriver();
+
+  std::string request;
+  std::string reply;
+
+  while (readMessage(clientFd, request))
+  {
+    handleRequest(*driver, request, reply);
+
+    if (!writeMessage(clientFd, reply))
+    {
+      break;
+    }
+  }
+
+  releaseDriver(std::move(driver));
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  ::close(clientFd);
+  _clientFds.erase(clientFd);
+  _connectionClosed.notify_all();
+}
+
+void
+QISA_Server::handleRequest(QISA_Driver& driver, const std::string& request, std::string& reply)
+{
+  reply.clear();
+
+  if (request.size() < 2)
+  {
+    reply += static_cast<char>(REPLY_FAILURE);
+    reply += "Malformed request.";
+    return;
+  }
+
+  const char* input = request.data() + 2;
+  const size_t inputSize = request.size() - 2;
+
+  bool success = false;
+  std::string output;
+
+  switch (static_cast<uint8_t>(request[0]))
+  {
+    case REQUEST_ASSEMBLE:
+      success = driver.assembleBuffer(input, inputSize);
+      if (success)
+      {
+        const std::vector<QISA_Driver::qisa_instruction_type>& instructions = driver.getInstructions();
+        output.assign(reinterpret_cast<const char*>(instructions.data()),
+                      instructions.size() * sizeof(QISA_Driver::qisa_instruction_type));
+      }
+      break;
+
+    case REQUEST_ASSEMBLE_HEX:
+      success = driver.assembleBuffer(input, inputSize);
+      if (success)
+      {
+        for (const auto& hexString : driver.getInstructionsAsHexStrings(true))
+        {
+          output += hexString;
+          output += '\n';
+        }
+      }
+      break;
+
+    case REQUEST_DISASSEMBLE:
+      success = driver.setDisassemblyFormat(static_cast<uint8_t>(request[1])) &&
+                driver.disassembleBuffer(input, inputSize);
+      if (success)
+      {
+        output = driver.getDisassemblyOutput();
+      }
+      break;
+
+    default:
+      reply += static_cast<char>(REPLY_FAILURE);
+      reply += "Unknown request kind.";
+      return;
+  }
+
+  if (success)
+  {
+    reply += static_cast<char>(REPLY_SUCCESS);
+    reply += output;
+  }
+  else
+  {
+    reply += static_cast<char>(REPLY_FAILURE);
+    reply += driver.getLastErrorMessage();
+  }
+}
+
+std::unique_ptr<QISA_Driver>
+QISA_Server::acquireDriver()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_idleDrivers.empty())
+    {
+      std::unique_ptr<QISA_Driver> driver = std::move(_idleDrivers.back());
+      _idleDrivers.pop_back();
+      return driver;
+    }
+  }
+
+  // The prototype is only read here, so this is safe while other connections are busy.
+  std::unique_ptr<QISA_Driver> driver(new QISA_Driver);
+  driver->configureFrom(_prototype);
+  driver->setVerbose(_verbose);
+  return driver;
+}
+
+void
+QISA_Server::releaseDriver(std::unique_ptr<QISA_Driver> driver)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _idleDrivers.push_back(std::move(driver));
+}
+
+bool
+QISA_Server::readMessage(int fd, std::string& payload)
+{
+  uint32_t size;
+  if (!readAll(fd, reinterpret_cast<char*>(&size), sizeof(size)))
+  {
+    return false;
+  }
+
+  size = ntohl(size);
+  if (size > MAX_MESSAGE_SIZE)
+  {
+    return false;
+  }
+
+  payload.resize(size);
+  return (size == 0) || readAll(fd, &payload[0], size);
+}
+
+bool
+QISA_Server::writeMessage(int fd, const std::string& payload)
+{
+  if (payload.size() > MAX_MESSAGE_SIZE)
+  {
+    return false;
+  }
+
+  uint32_t size = htonl(static_cast<uint32_t>(payload.size()));
+  return writeAll(fd, reinterpret_cast<const char*>(&size), sizeof(size)) &&
+         writeAll(fd, payload.data(), payload.size());
+}
+
+bool
+QISA_Server::sendRequest(const std::string& socketPath,
+                         RequestKind kind,
+                         int disassemblyFormatId,
+                         const std::string& input,
+                         bool& requestSucceeded,
+                         std::string& output,
+                         std::string& errorMessage)
+{
+  requestSucceeded = false;
+
+  sockaddr_un address;
+  if (!makeSocketAddress(socketPath, address))
+  {
+    errorMessage = "Socket path '" + socketPath + "' is too long.";
+    return false;
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    errorMessage = std::string("Cannot create socket: ") + strerror(errno);
+    return false;
+  }
+
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    errorMessage = "Cannot connect to server on socket '" + socketPath + "': " + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+
+  std::string request;
+  request.reserve(input.size() + 2);
+  request += static_cast<char>(kind);
+  request += static_cast<char>(disassemblyFormatId);
+  request += input;
+
+  std::string reply;
+  bool success = writeMessage(fd, request) && readMessage(fd, reply) && !reply.empty();
+  ::close(fd);
+
+  if (!success)
+  {
+    errorMessage = "Communication with server on socket '" + socketPath + "' failed.";
+    return false;
+  }
+
+  requestSucceeded = (static_cast<uint8_t>(reply[0]) == REPLY_SUCCESS);
+  output.assign(reply, 1, std::string::npos);
+  return true;
+}
+
+#endif // _WIN32
+
+} // namespace QISA
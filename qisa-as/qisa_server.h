@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <set>
+
+#include "qisa_driver.h"
+
+namespace QISA
+{
+
+/**
+ * Long-lived assembler process that serves assemble and disassemble requests
+ * over a Unix domain socket.
+ *
+ * The quantum instruction set and the topology are loaded once, in the driver
+ * that is given as prototype. Each request is then handled by a driver that
+ * has been configured from this prototype (see QISA_Driver::configureFrom()).
+ * These drivers are reused for subsequent requests, so the cost of setting up
+ * a driver is only paid once per concurrent client.
+ *
+ * Protocol:
+ *
+ *   Each message (in both directions) consists of a 4-byte length, in network
+ *   byte order, followed by that many bytes of payload.
+ *
+ *   A request payload consists of:
+ *     - 1 byte request kind (see RequestKind),
+ *     - 1 byte disassembly format id (only used for REQUEST_DISASSEMBLE),
+ *     - the input: assembly source text, or binary instructions to disassemble.
+ *
+ *   A reply payload consists of:
+ *     - 1 byte status (see ReplyStatus),
+ *     - on success: the assembled instructions in binary form (as saved by
+ *       QISA_Driver::save()), or the requested text;
+ *       on failure: the error message.
+ *
+ *   A client can send any number of requests over one connection.
+ *   The server replies to each request before reading the next one.
+ */
+class QISA_Server
+{
+public:
+
+  enum RequestKind : uint8_t
+  {
+    // Assemble; reply with the instructions in binary form.
+    REQUEST_ASSEMBLE = 'A',
+
+    // Assemble; reply with the instructions as hex strings (one per line),
+    // as given by QISA_Driver::getInstructionsAsHexStrings(true).
+    REQUEST_ASSEMBLE_HEX = 'H',
+
+    // Disassemble; reply with the disassembly output.
+    REQUEST_DISASSEMBLE = 'D'
+  };
+
+  enum ReplyStatus : uint8_t
+  {
+    REPLY_SUCCESS = 0,
+    REPLY_FAILURE = 1
+  };
+
+  // Upper limit on the size of a message, to guard against garbage input.
+  static const uint32_t MAX_MESSAGE_SIZE = 256 * 1024 * 1024;
+
+  /**
+   * @param[in] prototype Driver from which the drivers that handle the requests
+   *                      are configured. It must outlive this server.
+   */
+  DllExport explicit
+  QISA_Server(const QISA_Driver& prototype);
+
+  /**
+   * Show informational messages of the drivers that handle the requests.
+   */
+  DllExport void
+  setVerbose(bool verbose);
+
+  /**
+   * Listen on the given socket and handle requests, until SIGINT or SIGTERM
+   * is received. Each client connection is handled by its own thread.
+   * The socket file is removed when the server stops.
+   *
+   * @param[in] socketPath Path of the Unix domain socket to create.
+   *
+   * @return True if the server stopped normally, false if it could not be started.
+   *         In the latter case, getErrorMessage() describes the problem.
+   */
+  DllExport bool
+  serve(const std::string& socketPath);
+
+  /**
+   * @return Description of the last error that occurred in serve().
+   */
+  DllExport const std::string&
+  getErrorMessage() const;
+
+  /**
+   * Client side: send a single request to a running server and wait for its reply.
+   *
+   * @param[in]  socketPath          Path of the socket the server listens on.
+   * @param[in]  kind                Kind of request.
+   * @param[in]  disassemblyFormatId Disassembly output format, see QISA_Driver::setDisassemblyFormat().
+   * @param[in]  input               Assembly source text, or binary instructions to disassemble.
+   * @param[out] requestSucceeded    Set to true if the server handled the request successfully.
+   * @param[out] output              The output of the request if it succeeded,
+   *                                 otherwise the error message of the server.
+   * @param[out] errorMessage        Describes the problem if the server could not be reached.
+   *
+   * @return True if a reply was received, false on a communication problem.
+   */
+  DllExport static bool
+  sendRequest(const std::string& socketPath,
+              RequestKind kind,
+              int disassemblyFormatId,
+              const std::string& input,
+              bool& requestSucceeded,
+              std::string& output,
+              std::string& errorMessage);
+
+private:
+
+  // Handle all requests of one client, until it closes the connection.
+  void
+  handleConnection(int clientFd);
+
+  // Handle one request, and fill the reply payload.
+  void
+  handleRequest(QISA_Driver& driver, const std::string& request, std::string& reply);
+
+  // Take an idle driver, or create one if there is none.
+  std::unique_ptr<QISA_Driver>
+  acquireDriver();
+
+  // Return a driver to the idle drivers.
+  void
+  releaseDriver(std::unique_ptr<QISA_Driver> driver);
+
+  // Read one message; returns false on end of file or error.
+  static bool
+  readMessage(int fd, std::string& payload);
+
+  // Write one message; returns false on error.
+  static bool
+  writeMessage(int fd, const std::string& payload);
+
+  const QISA_Driver& _prototype;
+
+  bool _verbose;
+
+  std::string _errorMessage;
+
+  // Protects the members below.
+  std::mutex _mutex;
+
+  // Signalled when a connection has been closed.
+  std::condition_variable _connectionClosed;
+
+  // Drivers that are not in use by a connection.
+  std::vector<std::unique_ptr<QISA_Driver> > _idleDrivers;
+
+  // Sockets of the open client connections.
+  std::set<int> _clientFds;
+};
+
+} // namespace QISA
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace QISA
+{
+
+/**
+ * Sequence container that keeps up to N elements inline, and only moves them
+ * to the heap when more are added.
+ *
+ * This is used for the quantum bundles, which nearly always contain only a few
+ * instructions: building and copying those then involves no heap allocation.
+ * Only trivially copyable element types are supported.
+ */
+template <typename T, size_t N>
+class QISA_SmallVector
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "QISA_SmallVector only supports trivially copyable types");
+
+public:
+
+  typedef T value_type;
+  typedef const T* const_iterator;
+  typedef T* iterator;
+
+  QISA_SmallVector()
+    : _size(0)
+    , _inline()
+  {
+  }
+
+  QISA_SmallVector(const QISA_SmallVector&) = default;
+  QISA_SmallVector& operator=(const QISA_SmallVector&) = default;
+
+  // A moved-from vector is left empty.
+  QISA_SmallVector(QISA_SmallVector&& other)
+    : QISA_SmallVector()
+  {
+    *this = std::move(other);
+  }
+
+  QISA_SmallVector&
+  operator=(QISA_SmallVector&& other)
+  {
+    if (this != &other)
+    {
+      _size = other._size;
+      std::copy(other._inline, other._inline + N, _inline);
+      _heap = std::move(other._heap);
+
+      other.clear();
+    }
+
+    return *this;
+  }
+
+  void
+  push_back(const T& value)
+  {
+    if (_size < N)
+    {
+      _inline[_size] = value;
+    }
+    else
+    {
+      if (_size == N)
+      {
+        // Move the inline elements to the heap.
+        _heap.assign(_inline, _inline + N);
+      }
+      _heap.push_back(value);
+    }
+
+    _size++;
+  }
+
+  size_t
+  size() const
+  {
+    return _size;
+  }
+
+  bool
+  empty() const
+  {
+    return _size == 0;
+  }
+
+  void
+  clear()
+  {
+    _size = 0;
+    _heap.clear();
+  }
+
+  const T&
+  operator[](size_t index) const
+  {
+    return data()[index];
+  }
+
+  T&
+  operator[](size_t index)
+  {
+    return data()[index];
+  }
+
+  const T*
+  data() const
+  {
+    return (_size <= N) ? _inline : _heap.data();
+  }
+
+  T*
+  data()
+  {
+    return (_size <= N) ? _inline : _heap.data();
+  }
+
+  const_iterator
+  begin() const
+  {
+    return data();
+  }
+
+  const_iterator
+  end() const
+  {
+    return data() + _size;
+  }
+
+  iterator
+  begin()
+  {
+    return data();
+  }
+
+  iterator
+  end()
+  {
+    return data() + _size;
+  }
+
+private:
+
+  size_t _size;
+
+  // Holds the elements as long as there are at most N of them.
+  T _inline[N];
+
+  // Holds all elements once there are more than N of them.
+  std::vector<T> _heap;
+};
+
+} // namespace QISA
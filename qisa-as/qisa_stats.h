@@ -0,0 +1,222 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace QISA
+{
+
+/**
+ * Statistics of the work done by a driver: the time spent per phase and a
+ * number of counters.
+ *
+ * The statistics are only collected when enabled (see QISA_Driver::enableStats()),
+ * and accumulate over all assemblies and disassemblies until they are cleared.
+ */
+struct QISA_Stats
+{
+  // Time (in seconds) spent per phase.
+  // The times are exclusive: e.g. the time spent on code generation is not
+  // included in the time spent on scanning and parsing.
+
+  // Scanning and parsing the assembly source code.
+  double scanParseTime;
+
+  // Generating the instructions (the generate_ functions).
+  double codeGenerationTime;
+
+  // Resolving the labels that are used before they are defined.
+  double deferredResolutionTime;
+
+  // Removing redundant mask writes (see QISA_Driver::setMaskDeduplication()).
+  double maskDeduplicationTime;
+
+  // Rewriting the branches whose target is out of reach (see QISA_Driver::setBranchRelaxation()).
+  double branchRelaxationTime;
+
+  // Decoding the instructions while disassembling.
+  double disassemblyDecodeTime;
+
+  // Naming the labels in the disassembly.
+  double disassemblyPostProcessTime;
+
+  // Formatting the disassembly or the hex strings of the assembly.
+  double outputFormatTime;
+
+  // Counters.
+
+  // Number of tokens produced by the scanner.
+  uint64_t nrOfTokens;
+
+  // Number of instructions produced by assembly or decoded by disassembly.
+  uint64_t nrOfInstructions;
+
+  // Number of quantum bundles.
+  uint64_t nrOfBundles;
+
+  // Number of very large instruction words (VLIW) generated for the quantum bundles.
+  uint64_t nrOfVliwWords;
+
+  // Number of instructions that use a label before it is defined.
+  uint64_t nrOfDeferredLabels;
+
+  // Number of SMIS and SMIT instruction words removed by mask deduplication.
+  uint64_t nrOfRemovedMaskWords;
+
+  // Number of branches rewritten by branch relaxation.
+  uint64_t nrOfRelaxedBranches;
+
+  // Number of lookups in the symbol, register, label and mnemonic tables.
+  uint64_t nrOfMapLookups;
+
+  // Phase that is currently being timed (see QISA_StatsTimer), and since when.
+  double QISA_Stats::* activePhase;
+  std::chrono::steady_clock::time_point activePhaseStart;
+
+  QISA_Stats()
+  {
+    clear();
+  }
+
+  /**
+   * Set all times and counters to zero.
+   */
+  void
+  clear()
+  {
+    scanParseTime = 0.0;
+    codeGenerationTime = 0.0;
+    deferredResolutionTime = 0.0;
+    maskDeduplicationTime = 0.0;
+    branchRelaxationTime = 0.0;
+    disassemblyDecodeTime = 0.0;
+    disassemblyPostProcessTime = 0.0;
+    outputFormatTime = 0.0;
+
+    nrOfTokens = 0;
+    nrOfInstructions = 0;
+    nrOfBundles = 0;
+    nrOfVliwWords = 0;
+    nrOfDeferredLabels = 0;
+    nrOfRemovedMaskWords = 0;
+    nrOfRelaxedBranches = 0;
+    nrOfMapLookups = 0;
+
+    activePhase = nullptr;
+  }
+
+  /**
+   * Add the times and counters of the given statistics to these.
+   */
+  void
+  add(const QISA_Stats& other)
+  {
+    scanParseTime += other.scanParseTime;
+    codeGenerationTime += other.codeGenerationTime;
+    deferredResolutionTime += other.deferredResolutionTime;
+    maskDeduplicationTime += other.maskDeduplicationTime;
+    branchRelaxationTime += other.branchRelaxationTime;
+    disassemblyDecodeTime += other.disassemblyDecodeTime;
+    disassemblyPostProcessTime += other.disassemblyPostProcessTime;
+    outputFormatTime += other.outputFormatTime;
+
+    nrOfTokens += other.nrOfTokens;
+    nrOfInstructions += other.nrOfInstructions;
+    nrOfBundles += other.nrOfBundles;
+    nrOfVliwWords += other.nrOfVliwWords;
+    nrOfDeferredLabels += other.nrOfDeferredLabels;
+    nrOfRemovedMaskWords += other.nrOfRemovedMaskWords;
+    nrOfRelaxedBranches += other.nrOfRelaxedBranches;
+    nrOfMapLookups += other.nrOfMapLookups;
+  }
+
+  /**
+   * Call the given functions for each phase time and each counter, with
+   * its name. These names are used in the output of the --stats option
+   * and in the dictionary returned by the Python interface.
+   *
+   * @param[in] visitTime    Called as visitTime(const char* name, double seconds).
+   * @param[in] visitCounter Called as visitCounter(const char* name, uint64_t count).
+   */
+  template<typename TimeVisitor, typename CounterVisitor>
+  void
+  visit(TimeVisitor visitTime, CounterVisitor visitCounter) const
+  {
+    visitTime("scan_parse_time", scanParseTime);
+    visitTime("code_generation_time", codeGenerationTime);
+    visitTime("deferred_resolution_time", deferredResolutionTime);
+    visitTime("mask_deduplication_time", maskDeduplicationTime);
+    visitTime("branch_relaxation_time", branchRelaxationTime);
+    visitTime("disassembly_decode_time", disassemblyDecodeTime);
+    visitTime("disassembly_post_process_time", disassemblyPostProcessTime);
+    visitTime("output_format_time", outputFormatTime);
+
+    visitCounter("tokens", nrOfTokens);
+    visitCounter("instructions", nrOfInstructions);
+    visitCounter("bundles", nrOfBundles);
+    visitCounter("vliw_words", nrOfVliwWords);
+    visitCounter("deferred_labels", nrOfDeferredLabels);
+    visitCounter("removed_mask_words", nrOfRemovedMaskWords);
+    visitCounter("relaxed_branches", nrOfRelaxedBranches);
+    visitCounter("map_lookups", nrOfMapLookups);
+  }
+};
+
+/**
+ * Adds the time spent in its scope to a phase time of the given statistics.
+ *
+ * While a timer is running, the time of the phase that was being timed before
+ * is paused, such that the phase times do not overlap. A timer for the phase
+ * that is already being timed does nothing, so nested calls are counted once.
+ * If no statistics are given (because collecting them is disabled), the timer
+ * does nothing at all.
+ */
+class QISA_StatsTimer
+{
+public:
+
+  QISA_StatsTimer(QISA_Stats* stats, double QISA_Stats::* phase)
+    : _stats((stats && (stats->activePhase != phase)) ? stats : nullptr)
+    , _phase(phase)
+    , _previousPhase(nullptr)
+  {
+    if (_stats)
+    {
+      const auto now = std::chrono::steady_clock::now();
+
+      _previousPhase = _stats->activePhase;
+      if (_previousPhase)
+      {
+        _stats->*_previousPhase += std::chrono::duration<double>(now - _stats->activePhaseStart).count();
+      }
+
+      _stats->activePhase = _phase;
+      _stats->activePhaseStart = now;
+    }
+  }
+
+  ~QISA_StatsTimer()
+  {
+    if (_stats)
+    {
+      const auto now = std::chrono::steady_clock::now();
+
+      _stats->*_phase += std::chrono::duration<double>(now - _stats->activePhaseStart).count();
+
+      // Resume the phase that was being timed before.
+      _stats->activePhase = _previousPhase;
+      _stats->activePhaseStart = now;
+    }
+  }
+
+  QISA_StatsTimer(const QISA_StatsTimer&) = delete;
+  QISA_StatsTimer& operator=(const QISA_StatsTimer&) = delete;
+
+private:
+
+  QISA_Stats* _stats;
+  double QISA_Stats::* _phase;
+  double QISA_Stats::* _previousPhase;
+};
+
+} // namespace QISA
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "qisa_hash.h"
+
+namespace QISA
+{
+
+/**
+ * Hash table that maps names to values, in which the names are compared case
+ * insensitively.
+ *
+ * This replaces std::map with a case insensitive comparator for the symbols
+ * that are looked up while parsing (labels, register aliases, ...): a lookup
+ * hashes the name once and then usually compares it to a single entry.
+ * It uses open addressing with linear probing; entries are never removed,
+ * except by clear().
+ *
+ * The interface follows std::map, as far as it is used: find() returns a pointer
+ * to the entry (name and value), or NULL if the name is not present.
+ * An entry keeps the spelling of the name with which it was first added.
+ */
+template <typename T>
+class QISA_SymbolTable
+{
+public:
+
+  typedef std::pair<std::string, T> value_type;
+
+  QISA_SymbolTable()
+    : _size(0)
+  {
+  }
+
+  /**
+   * @return The entry with the given name, or NULL if it is not present.
+   */
+  value_type*
+  find(const std::string& name)
+  {
+    if (_size == 0)
+    {
+      return NULL;
+    }
+
+    Slot& slot = _slots[findSlot(name, QISA_Hash::hashName(name.data(), name.size(), 0))];
+    return slot.used ? &slot.entry : NULL;
+  }
+
+  const value_type*
+  find(const std::string& name) const
+  {
+    return const_cast<QISA_SymbolTable*>(this)->find(name);
+  }
+
+  /**
+   * @return The value of the entry with the given name.
+   *         The entry is added (with a default constructed value) if it is not present.
+   */
+  T&
+  operator[](const std::string& name)
+  {
+    // Keep the load factor at or below 0.5, so that the probe sequences stay short.
+    if (2 * (_size + 1) > _slots.size())
+    {
+      grow();
+    }
+
+    const uint32_t hash = QISA_Hash::hashName(name.data(), name.size(), 0);
+    Slot& slot = _slots[findSlot(name, hash)];
+
+    if (!slot.used)
+    {
+      slot.used = true;
+      slot.hash = hash;
+      slot.entry.first = name;
+      slot.entry.second = T();
+      _size++;
+    }
+
+    return slot.entry.second;
+  }
+
+  /**
+   * @return The number of entries.
+   */
+  size_t
+  size() const
+  {
+    return _size;
+  }
+
+  bool
+  empty() const
+  {
+    return _size == 0;
+  }
+
+  /**
+   * Remove all entries.
+   * The allocated slots are kept, to be reused by the next program.
+   */
+  void
+  clear()
+  {
+    if (_size == 0)
+    {
+      return;
+    }
+
+    for (Slot& slot : _slots)
+    {
+      if (slot.used)
+      {
+        slot.used = false;
+        slot.entry.first.clear();
+        slot.entry.second = T();
+      }
+    }
+
+    _size = 0;
+  }
+
+private:
+
+  struct Slot
+  {
+    Slot()
+      : used(false)
+      , hash(0)
+    {
+    }
+
+    bool used;
+    uint32_t hash;
+    value_type entry;
+  };
+
+  // Index of the slot that holds the given name, or of the empty slot
+  // at which it should be added. There must be at least one empty slot.
+  size_t
+  findSlot(const std::string& name, uint32_t hash) const
+  {
+    const size_t mask = _slots.size() - 1;
+    size_t index = hash & mask;
+
+    while (_slots[index].used)
+    {
+      const Slot& slot = _slots[index];
+      if ((slot.hash == hash) &&
+          QISA_Hash::equalNames(slot.entry.first.data(), slot.entry.first.size(), name.data(), name.size()))
+      {
+        break;
+      }
+      index = (index + 1) & mask;
+    }
+
+    return index;
+  }
+
+  // Double the number of slots (which is always a power of two).
+  void
+  grow()
+  {
+    std::vector<Slot> oldSlots(_slots.empty() ? 16 : 2 * _slots.size());
+    oldSlots.swap(_slots);
+
+    const size_t mask = _slots.size() - 1;
+
+    for (Slot& oldSlot : oldSlots)
+    {
+      if (oldSlot.used)
+      {
+        size_t index = oldSlot.hash & mask;
+        while (_slots[index].used)
+        {
+          index = (index + 1) & mask;
+        }
+        _slots[index].used = true;
+        _slots[index].hash = oldSlot.hash;
+        _slots[index].entry = std::move(oldSlot.entry);
+      }
+    }
+  }
+
+  std::vector<Slot> _slots;
+  size_t _size;
+};
+
+} // namespace QISA
@@ -0,0 +1,189 @@
+#include <cstdio>
+
+#include "qisa_timeline.h"
+
+namespace QISA
+{
+
+namespace
+{
+
+const char* const sectionKindNames[] = { "program", "block", "loop" };
+
+// Write the given text as a JSON string.
+void
+writeJsonString(std::ostream& os, const std::string& text)
+{
+  os << '"';
+
+  for (const char c : text)
+  {
+    switch (c)
+    {
+      case '"':  os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n";  break;
+      case '\t': os << "\\t";  break;
+
+      default:
+      {
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          os << escaped;
+        }
+        else
+        {
+          os << c;
+        }
+        break;
+      }
+    }
+  }
+
+  os << '"';
+}
+
+void
+writeJsonSection(std::ostream& os, const QISA_Timeline::Section& section)
+{
+  os << "{\"label\": ";
+  writeJsonString(os, section.label);
+  os << ", \"start_address\": "    << section.startAddress
+     << ", \"end_address\": "      << section.endAddress
+     << ", \"start_cycle\": "      << section.startCycle
+     << ", \"cycles\": "           << section.cycles
+     << ", \"bundles\": "          << section.nrOfBundles
+     << ", \"operations\": "       << section.nrOfOperations
+     << ", \"max_bundle_width\": " << section.maxBundleWidth
+     << ", \"idle_cycles\": "      << section.idleCycles
+     << ", \"max_idle_gap\": "     << section.maxIdleGap
+     << ", \"dynamic_waits\": "    << section.nrOfDynamicWaits
+     << "}";
+}
+
+void
+writeJsonSections(std::ostream& os, const std::vector<QISA_Timeline::Section>& sections)
+{
+  os << "[";
+
+  const char* separator = "";
+  for (const QISA_Timeline::Section& section : sections)
+  {
+    os << separator << std::endl << "    ";
+    writeJsonSection(os, section);
+    separator = ",";
+  }
+
+  if (!sections.empty())
+  {
+    os << std::endl << "  ";
+  }
+
+  os << "]";
+}
+
+void
+writeCsvSection(std::ostream& os, const QISA_Timeline::Section& section)
+{
+  // Labels consist of letters, digits and underscores, so they need no quoting.
+  os << sectionKindNames[section.kind] << ","
+     << section.label << ","
+     << section.startAddress << ","
+     << section.endAddress << ","
+     << section.startCycle << ","
+     << section.cycles << ","
+     << section.nrOfBundles << ","
+     << section.nrOfOperations << ","
+     << section.maxBundleWidth << ","
+     << section.idleCycles << ","
+     << section.maxIdleGap << ","
+     << section.nrOfDynamicWaits << std::endl;
+}
+
+} // anonymous namespace
+
+void
+QISA_Timeline::clear()
+{
+  program = Section();
+  program.kind = SECTION_PROGRAM;
+  blocks.clear();
+  loops.clear();
+  operations.clear();
+}
+
+void
+QISA_Timeline::writeCsv(std::ostream& os) const
+{
+  os << "kind,label,start_address,end_address,start_cycle,cycles,bundles,operations,"
+        "max_bundle_width,idle_cycles,max_idle_gap,dynamic_waits" << std::endl;
+
+  writeCsvSection(os, program);
+
+  for (const Section& block : blocks)
+  {
+    writeCsvSection(os, block);
+  }
+
+  for (const Section& loop : loops)
+  {
+    writeCsvSection(os, loop);
+  }
+}
+
+void
+QISA_Timeline::writeJson(std::ostream& os) const
+{
+  os << "{" << std::endl;
+  os << "  \"program\": ";
+  writeJsonSection(os, program);
+  os << "," << std::endl;
+  os << "  \"blocks\": ";
+  writeJsonSections(os, blocks);
+  os << "," << std::endl;
+  os << "  \"loops\": ";
+  writeJsonSections(os, loops);
+  os << std::endl << "}" << std::endl;
+}
+
+void
+QISA_Timeline::writeChromeTrace(std::ostream& os) const
+{
+  os << "{\"traceEvents\": [" << std::endl;
+
+  // Name the tracks: one for the basic blocks, followed by one per position within a bundle.
+  os << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, "
+        "\"args\": {\"name\": \"basic blocks\"}}";
+
+  for (uint64_t slot = 0; slot < program.maxBundleWidth; slot++)
+  {
+    os << "," << std::endl
+       << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << (slot + 1) << ", "
+       << "\"args\": {\"name\": \"operation " << slot << "\"}}";
+  }
+
+  for (const Section& block : blocks)
+  {
+    os << "," << std::endl << "  {\"name\": ";
+    writeJsonString(os, block.label.empty() ? "@" + std::to_string(block.startAddress) : block.label);
+    os << ", \"cat\": \"block\", \"ph\": \"X\", \"ts\": " << block.startCycle
+       << ", \"dur\": " << block.cycles << ", \"pid\": 0, \"tid\": 0"
+       << ", \"args\": {\"start_address\": " << block.startAddress
+       << ", \"end_address\": " << block.endAddress << "}}";
+  }
+
+  for (const Operation& operation : operations)
+  {
+    os << "," << std::endl << "  {\"name\": ";
+    writeJsonString(os, operation.name);
+    os << ", \"cat\": \"operation\", \"ph\": \"X\", \"ts\": " << operation.cycle
+       << ", \"dur\": 1, \"pid\": 0, \"tid\": " << (operation.slot + 1)
+       << ", \"args\": {\"address\": " << operation.address << "}}";
+  }
+
+  os << std::endl << "]}" << std::endl;
+}
+
+} // namespace QISA
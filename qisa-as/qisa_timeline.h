@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef DllExport
+#ifdef _WIN32
+#define DllExport __declspec(dllexport)
+#else
+#define DllExport
+#endif
+#endif
+
+namespace QISA
+{
+
+/**
+ * Static quantum timeline of an assembled program, as determined by
+ * QISA_Driver::analyzeTimeline().
+ *
+ * Time is counted in cycles. It advances by the bundle separator of each
+ * quantum instruction word that starts a new bundle, and by the immediate of
+ * each QWAIT instruction. The duration of a QWAITR instruction is only known
+ * at run time, so it is counted as a dynamic wait that takes no time.
+ * Classic instructions take no quantum time either.
+ *
+ * The program is laid out as written: every instruction is passed once,
+ * without following the branches. The timing of each basic block, and of one
+ * pass through each loop body, is reported as a Section.
+ */
+struct QISA_Timeline
+{
+  enum SectionKind
+  {
+    SECTION_PROGRAM,
+    SECTION_BLOCK,
+    SECTION_LOOP
+  };
+
+  // Timing of a range of instructions.
+  struct Section
+  {
+    SectionKind kind;
+
+    // Name of the label at startAddress, as used in the disassembly
+    // (e.g. 'label_0'). It is empty if no branch refers to startAddress.
+    std::string label;
+
+    // Addresses of the first instruction and of the one just past the section.
+    uint64_t startAddress;
+    uint64_t endAddress;
+
+    // Cycle at which the section starts in the program.
+    uint64_t startCycle;
+
+    // Number of cycles that the section takes.
+    uint64_t cycles;
+
+    uint64_t nrOfBundles;
+    uint64_t nrOfOperations;
+
+    // Largest number of quantum operations in one bundle.
+    uint64_t maxBundleWidth;
+
+    // Number of cycles at which no quantum operation starts, and the
+    // longest run of such cycles.
+    uint64_t idleCycles;
+    uint64_t maxIdleGap;
+
+    // Number of QWAITR instructions.
+    uint64_t nrOfDynamicWaits;
+  };
+
+  // A quantum operation, as placed on the timeline of the program.
+  struct Operation
+  {
+    uint64_t cycle;
+    uint64_t address;
+
+    // Position of the operation within its bundle, starting at 0.
+    unsigned slot;
+
+    // Disassembled operation, e.g. 'CW_01 S0'.
+    std::string name;
+  };
+
+  // The whole program.
+  Section program;
+
+  // The basic blocks, in order of address. A basic block starts at the start
+  // of the program, at each branch target and after each branch instruction.
+  std::vector<Section> blocks;
+
+  // The loops, in order of the address of their branch instruction.
+  // Each branch to an earlier (or its own) address forms a loop, whose body
+  // runs from the branch target up to and including the branch instruction.
+  std::vector<Section> loops;
+
+  // The quantum operations of the program, in order of address.
+  // QNOPs are left out.
+  std::vector<Operation> operations;
+
+  /**
+   * Forget the current timeline.
+   */
+  DllExport void
+  clear();
+
+  /**
+   * Write the timing of the program, its basic blocks and its loops as CSV:
+   * a header line, followed by one line per section.
+   *
+   * @param[in] os Stream to write to.
+   */
+  DllExport void
+  writeCsv(std::ostream& os) const;
+
+  /**
+   * Write the timing of the program, its basic blocks and its loops as a JSON object,
+   * with members 'program', 'blocks' and 'loops'.
+   *
+   * @param[in] os Stream to write to.
+   */
+  DllExport void
+  writeJson(std::ostream& os) const;
+
+  /**
+   * Write the basic blocks and the quantum operations in the Chrome trace event format,
+   * to be viewed with chrome://tracing or Perfetto. One cycle is shown as one microsecond.
+   * The basic blocks are shown on the first track, the operations on one track per
+   * position within their bundle.
+   *
+   * @param[in] os Stream to write to.
+   */
+  DllExport void
+  writeChromeTrace(std::ostream& os) const;
+};
+
+} // namespace QISA
@@ -0,0 +1,340 @@
+#include <fstream>
+#include <sstream>
+
+#include "qisa_topology.h"
+
+namespace QISA
+{
+
+namespace
+{
+
+enum Section
+{
+  SECTION_NONE,
+  SECTION_NUM_QUBITS,
+  SECTION_NUM_DIR_EDGE,
+  SECTION_EDGE_LIST,
+  NR_OF_SECTIONS
+};
+
+// Lines that start and end each section.
+const char* const sectionStart[NR_OF_SECTIONS] = { "", ".NumQubits", ".NumDirEdge", ".EdgeList" };
+const char* const sectionEnd[NR_OF_SECTIONS] = { "", ".EndNumQubits", ".EndNumDirEdge", ".EndEdgeList" };
+
+// An entry of the edge list, as given in the file.
+struct EdgeEntry
+{
+  long id;
+  long target;
+  long control;
+  size_t lineNr;
+};
+
+// Remove leading and trailing white space (including carriage returns).
+std::string
+trim(const std::string& text)
+{
+  const char* const whiteSpace = " \t\r\n";
+
+  const size_t first = text.find_first_not_of(whiteSpace);
+  if (first == std::string::npos)
+  {
+    return "";
+  }
+
+  const size_t last = text.find_last_not_of(whiteSpace);
+  return text.substr(first, last - first + 1);
+}
+
+// Parse a non-negative integer that makes up the whole text.
+bool
+parseCount(const std::string& text, long& value)
+{
+  std::istringstream iss(text);
+  return (iss >> value) && (iss >> std::ws).eof() && (value >= 0);
+}
+
+// Parse an edge list entry: '<edge id>: <target qubit>, <control qubit>'.
+bool
+parseEdge(const std::string& text, EdgeEntry& edge)
+{
+  std::istringstream iss(text);
+  char colon = 0;
+  char comma = 0;
+
+  return (iss >> edge.id >> colon >> edge.target >> comma >> edge.control) &&
+         (iss >> std::ws).eof() &&
+         (colon == ':') && (comma == ',') &&
+         (edge.id >= 0) && (edge.target >= 0) && (edge.control >= 0);
+}
+
+} // anonymous namespace
+
+QISA_Topology::QISA_Topology()
+  : _nrOfQubits(0)
+{
+}
+
+bool
+QISA_Topology::read(const std::string& filename)
+{
+  std::ifstream in(filename);
+
+  if (!in)
+  {
+    clear();
+    _errorMessage = "Cannot open topology file '" + filename + "'.";
+    return false;
+  }
+
+  return read(in, filename);
+}
+
+bool
+QISA_Topology::read(std::istream& in, const std::string& sourceName)
+{
+  clear();
+
+  // Forget the partially read topology and describe the problem.
+  // A line number of 0 means that the problem is not on a specific line.
+  auto fail = [&](size_t lineNr, const std::string& message)
+  {
+    clear();
+
+    std::ostringstream ss;
+    ss << sourceName << ":";
+    if (lineNr != 0)
+    {
+      ss << lineNr << ":";
+    }
+    ss << " " << message;
+
+    _errorMessage = ss.str();
+    return false;
+  };
+
+  long nrOfQubits = -1;
+  long nrOfEdges = -1;
+  std::vector<EdgeEntry> edgeEntries;
+
+  bool seenSection[NR_OF_SECTIONS] = { false, false, false, false };
+  Section section = SECTION_NONE;
+  size_t edgeListLineNr = 0;
+
+  std::string line;
+  size_t lineNr = 0;
+
+  while (std::getline(in, line))
+  {
+    lineNr++;
+
+    const std::string text = trim(line);
+
+    if (text.empty())
+    {
+      continue;
+    }
+
+    if (text[0] == '.')
+    {
+      bool isKnownDirective = false;
+
+      for (int s = SECTION_NONE + 1; s < NR_OF_SECTIONS; s++)
+      {
+        if (text == sectionStart[s])
+        {
+          if (section != SECTION_NONE)
+          {
+            return fail(lineNr, "'" + text + "' found inside section '" + sectionStart[section] + "'");
+          }
+
+          if (seenSection[s])
+          {
+            return fail(lineNr, "section '" + text + "' is given more than once");
+          }
+
+          section = static_cast<Section>(s);
+          seenSection[s] = true;
+
+          if (section == SECTION_EDGE_LIST)
+          {
+            edgeListLineNr = lineNr;
+          }
+
+          isKnownDirective = true;
+          break;
+        }
+
+        if (text == sectionEnd[s])
+        {
+          if (section != s)
+          {
+            return fail(lineNr, "'" + text + "' found without preceding '" + sectionStart[s] + "'");
+          }
+
+          if ((section == SECTION_NUM_QUBITS) && (nrOfQubits < 0))
+          {
+            return fail(lineNr, "the number of qubits is missing");
+          }
+
+          if ((section == SECTION_NUM_DIR_EDGE) && (nrOfEdges < 0))
+          {
+            return fail(lineNr, "the number of edges is missing");
+          }
+
+          section = SECTION_NONE;
+          isKnownDirective = true;
+          break;
+        }
+      }
+
+      if (!isKnownDirective)
+      {
+        return fail(lineNr, "unknown directive '" + text + "'");
+      }
+
+      continue;
+    }
+
+    switch (section)
+    {
+      case SECTION_NUM_QUBITS:
+      {
+        if (nrOfQubits >= 0)
+        {
+          return fail(lineNr, "the number of qubits is given more than once");
+        }
+
+        if (!parseCount(text, nrOfQubits) ||
+            (nrOfQubits < 1) || (nrOfQubits > MAX_NR_OF_QUBITS))
+        {
+          std::ostringstream ss;
+          ss << "invalid number of qubits '" << text << "': expected a number in the range [1-"
+             << MAX_NR_OF_QUBITS << "]";
+          return fail(lineNr, ss.str());
+        }
+        break;
+      }
+
+      case SECTION_NUM_DIR_EDGE:
+      {
+        if (nrOfEdges >= 0)
+        {
+          return fail(lineNr, "the number of edges is given more than once");
+        }
+
+        if (!parseCount(text, nrOfEdges))
+        {
+          return fail(lineNr, "invalid number of edges '" + text + "'");
+        }
+        break;
+      }
+
+      case SECTION_EDGE_LIST:
+      {
+        EdgeEntry edge;
+        if (!parseEdge(text, edge))
+        {
+          return fail(lineNr, "invalid edge '" + text + "': expected '<edge id>: <target qubit>, <control qubit>'");
+        }
+
+        edge.lineNr = lineNr;
+        edgeEntries.push_back(edge);
+        break;
+      }
+
+      default:
+      {
+        return fail(lineNr, "unexpected text outside of a section: '" + text + "'");
+      }
+    }
+  }
+
+  if (section != SECTION_NONE)
+  {
+    return fail(lineNr, std::string("'") + sectionEnd[section] + "' is missing");
+  }
+
+  for (int s = SECTION_NONE + 1; s < NR_OF_SECTIONS; s++)
+  {
+    if (!seenSection[s])
+    {
+      return fail(0, std::string("section '") + sectionStart[s] + "' is missing");
+    }
+  }
+
+  if (edgeEntries.size() != static_cast<size_t>(nrOfEdges))
+  {
+    std::ostringstream ss;
+    ss << "the edge list contains " << edgeEntries.size() << " edges, but "
+       << sectionStart[SECTION_NUM_DIR_EDGE] << " specifies " << nrOfEdges;
+    return fail(edgeListLineNr, ss.str());
+  }
+
+  // Build the edge tables.
+  // As there are as many entries as edges, the edge ids are dense if they are in range and unique.
+  _nrOfQubits = static_cast<int>(nrOfQubits);
+  _edges.resize(nrOfEdges);
+  _edgeQubits.resize(nrOfEdges);
+  _edgeIds.assign(nrOfQubits * nrOfQubits, -1);
+
+  std::vector<bool> seenEdgeId(nrOfEdges, false);
+
+  for (const EdgeEntry& edge : edgeEntries)
+  {
+    std::ostringstream ss;
+
+    if (edge.id >= nrOfEdges)
+    {
+      ss << "edge id " << edge.id << " is out of range [0-" << (nrOfEdges - 1) << "]";
+      return fail(edge.lineNr, ss.str());
+    }
+
+    if (seenEdgeId[edge.id])
+    {
+      ss << "edge id " << edge.id << " is used more than once";
+      return fail(edge.lineNr, ss.str());
+    }
+
+    if ((edge.target >= nrOfQubits) || (edge.control >= nrOfQubits))
+    {
+      ss << "invalid qubit number in edge " << edge.id << ". Valid range: [0-" << (nrOfQubits - 1) << "]";
+      return fail(edge.lineNr, ss.str());
+    }
+
+    if (edge.target == edge.control)
+    {
+      ss << "edge " << edge.id << " connects qubit " << edge.target << " to itself";
+      return fail(edge.lineNr, ss.str());
+    }
+
+    int& edgeId = _edgeIds[edge.target * nrOfQubits + edge.control];
+    if (edgeId >= 0)
+    {
+      ss << "edge " << edge.id << " (" << edge.target << "," << edge.control
+         << ") is the same as edge " << edgeId;
+      return fail(edge.lineNr, ss.str());
+    }
+
+    edgeId = static_cast<int>(edge.id);
+    seenEdgeId[edge.id] = true;
+    _edges[edge.id] = TargetControlPair(static_cast<uint8_t>(edge.target), static_cast<uint8_t>(edge.control));
+    _edgeQubits[edge.id].set(edge.target);
+    _edgeQubits[edge.id].set(edge.control);
+  }
+
+  return true;
+}
+
+void
+QISA_Topology::clear()
+{
+  _nrOfQubits = 0;
+  _edges.clear();
+  _edgeQubits.clear();
+  _edgeIds.clear();
+  _errorMessage.clear();
+}
+
+} // namespace QISA
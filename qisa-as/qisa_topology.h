@@ -0,0 +1,174 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef DllExport
+#ifdef _WIN32
+#define DllExport __declspec(dllexport)
+#else
+#define DllExport
+#endif
+#endif
+
+namespace QISA
+{
+
+/**
+ * Quantum layout information (topology) of a processor: its number of qubits
+ * and the directed edges between them, along which two-qubit operations can
+ * be applied. Each edge has an id, which is its bit number in a t_mask.
+ *
+ * The topology is read from a file with the following sections:
+ *
+ *   .NumQubits
+ *   <number of qubits>
+ *   .EndNumQubits
+ *   .NumDirEdge
+ *   <number of edges>
+ *   .EndNumDirEdge
+ *   .EdgeList
+ *   <edge id>: <target qubit>, <control qubit>
+ *   ...
+ *   .EndEdgeList
+ *
+ * The edge ids must run from 0 up to (but not including) the number of edges.
+ */
+class QISA_Topology
+{
+public:
+
+  // A directed edge, as (target qubit, control qubit).
+  typedef std::pair<uint8_t, uint8_t> TargetControlPair;
+
+  // Qubit numbers must fit in a TargetControlPair.
+  static const int MAX_NR_OF_QUBITS = 256;
+
+  // Set of qubits, with one bit per qubit number.
+  typedef std::bitset<MAX_NR_OF_QUBITS> QubitMask;
+
+  DllExport
+  QISA_Topology();
+
+  /**
+   * Read the topology from the given file, replacing the current topology.
+   *
+   * @param[in] filename Name of the file to read.
+   *
+   * @return True on success, false if the file cannot be read or is not valid.
+   *         In the latter case, getErrorMessage() describes the problem,
+   *         and the topology is empty.
+   */
+  DllExport bool
+  read(const std::string& filename);
+
+  /**
+   * Read the topology from the given stream, replacing the current topology.
+   *
+   * @param[in] in         Stream to read from.
+   * @param[in] sourceName Name of the source of the stream, used in the error messages.
+   *
+   * @return True on success, false if the topology is not valid.
+   *         In the latter case, getErrorMessage() describes the problem,
+   *         and the topology is empty.
+   */
+  DllExport bool
+  read(std::istream& in, const std::string& sourceName);
+
+  /**
+   * Forget the current topology.
+   */
+  DllExport void
+  clear();
+
+  /**
+   * @return The number of qubits; 0 if no topology has been read.
+   */
+  int
+  nrOfQubits() const
+  {
+    return _nrOfQubits;
+  }
+
+  /**
+   * @return The number of directed edges.
+   */
+  size_t
+  nrOfEdges() const
+  {
+    return _edges.size();
+  }
+
+  /**
+   * @param[in] edgeId Id of the edge. It must be smaller than nrOfEdges().
+   *
+   * @return The target-control pair of the given edge.
+   */
+  const TargetControlPair&
+  getEdge(size_t edgeId) const
+  {
+    return _edges[edgeId];
+  }
+
+  /**
+   * @param[in] edgeId Id of the edge. It must be smaller than nrOfEdges().
+   *
+   * @return The qubits of the given edge: its target and control qubit.
+   *         Two edges can be used at the same time if their qubits do not overlap.
+   */
+  const QubitMask&
+  getEdgeQubits(size_t edgeId) const
+  {
+    return _edgeQubits[edgeId];
+  }
+
+  /**
+   * @param[in] pair Target-control pair to look up.
+   *
+   * @return The id of the edge from the given target to the given control qubit,
+   *         or -1 if there is no such edge.
+   */
+  int
+  findEdge(const TargetControlPair& pair) const
+  {
+    if ((pair.first >= _nrOfQubits) || (pair.second >= _nrOfQubits))
+    {
+      return -1;
+    }
+
+    return _edgeIds[pair.first * _nrOfQubits + pair.second];
+  }
+
+  /**
+   * @return Description of the last error that occurred in read().
+   */
+  const std::string&
+  getErrorMessage() const
+  {
+    return _errorMessage;
+  }
+
+private:
+
+  // Number of qubits.
+  int _nrOfQubits;
+
+  // Target-control pair per edge id.
+  std::vector<TargetControlPair> _edges;
+
+  // Qubits per edge id.
+  std::vector<QubitMask> _edgeQubits;
+
+  // Edge id per target-control pair, at index (target * _nrOfQubits + control).
+  // Pairs that are not an edge have id -1.
+  std::vector<int> _edgeIds;
+
+  std::string _errorMessage;
+};
+
+} // namespace QISA
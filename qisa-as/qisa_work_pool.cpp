@@ -0,0 +1,148 @@
+#include <thread>
+#include <exception>
+
+#include "qisa_work_pool.h"
+
+namespace QISA
+{
+
+QISA_WorkPool::QISA_WorkPool(unsigned nrOfThreads)
+  : _nrOfThreads((nrOfThreads == 0) ? defaultNrOfThreads() : nrOfThreads)
+{
+  for (unsigned i = 0; i < _nrOfThreads; i++)
+  {
+    _queues.emplace_back(new WorkQueue);
+  }
+}
+
+unsigned
+QISA_WorkPool::nrOfThreads() const
+{
+  return _nrOfThreads;
+}
+
+unsigned
+QISA_WorkPool::defaultNrOfThreads()
+{
+  unsigned nrOfThreads = std::thread::hardware_concurrency();
+
+  // hardware_concurrency() returns 0 if the value is not computable.
+  return (nrOfThreads == 0) ? 1 : nrOfThreads;
+}
+
+void
+QISA_WorkPool::run(size_t nrOfItems, const task_t& task)
+{
+  if (nrOfItems == 0)
+  {
+    return;
+  }
+
+  // There is no use in starting more workers than there are work items.
+  unsigned nrOfWorkers = _nrOfThreads;
+  if (nrOfItems < nrOfWorkers)
+  {
+    nrOfWorkers = static_cast<unsigned>(nrOfItems);
+  }
+
+  // Distribute the work items over the workers, in contiguous ranges.
+  // Contiguous ranges keep related work items (e.g. files in the same
+  // directory) together as long as no stealing is needed.
+  for (unsigned w = 0; w < _nrOfThreads; w++)
+  {
+    _queues[w]->items.clear();
+  }
+
+  for (unsigned w = 0; w < nrOfWorkers; w++)
+  {
+    size_t first = (nrOfItems * w) / nrOfWorkers;
+    size_t last = (nrOfItems * (w + 1)) / nrOfWorkers;
+
+    // The worker takes its items from the back, so store them in reverse order
+    // to let it process its range front to back.
+    for (size_t item = last; item > first; item--)
+    {
+      _queues[w]->items.push_back(item - 1);
+    }
+  }
+
+  _exception = nullptr;
+
+  std::vector<std::thread> workers;
+  for (unsigned w = 1; w < nrOfWorkers; w++)
+  {
+    workers.emplace_back(&QISA_WorkPool::work, this, w, std::cref(task));
+  }
+
+  // The calling thread acts as worker 0.
+  work(0, task);
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  if (_exception)
+  {
+    std::rethrow_exception(_exception);
+  }
+}
+
+bool
+QISA_WorkPool::nextItem(unsigned workerIndex, size_t& item)
+{
+  // First try the worker's own queue.
+  {
+    WorkQueue& ownQueue = *_queues[workerIndex];
+    std::lock_guard<std::mutex> lock(ownQueue.mutex);
+
+    if (!ownQueue.items.empty())
+    {
+      item = ownQueue.items.back();
+      ownQueue.items.pop_back();
+      return true;
+    }
+  }
+
+  // Then try to steal from the other workers, starting at the next one.
+  for (unsigned i = 1; i < _nrOfThreads; i++)
+  {
+    WorkQueue& victimQueue = *_queues[(workerIndex + i) % _nrOfThreads];
+    std::lock_guard<std::mutex> lock(victimQueue.mutex);
+
+    if (!victimQueue.items.empty())
+    {
+      item = victimQueue.items.front();
+      victimQueue.items.pop_front();
+      return true;
+    }
+  }
+
+  // No work items are left.
+  // Since no new work items are added while running, this worker is done.
+  return false;
+}
+
+void
+QISA_WorkPool::work(unsigned workerIndex, const task_t& task)
+{
+  size_t item;
+
+  while (nextItem(workerIndex, item))
+  {
+    try
+    {
+      task(item, workerIndex);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(_exceptionMutex);
+      if (!_exception)
+      {
+        _exception = std::current_exception();
+      }
+    }
+  }
+}
+
+} // namespace QISA
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef DllExport
+#ifdef _WIN32
+#define DllExport __declspec(dllexport)
+#else
+#define DllExport
+#endif
+#endif
+
+namespace QISA
+{
+
+/**
+ * A small work-stealing thread pool, used to process a number of independent
+ * work items (e.g. input files) in parallel.
+ *
+ * The work items are identified by their index.
+ * Initially, each worker gets an equally sized, contiguous range of work items.
+ * A worker takes its work items from the back of its own queue.
+ * When its queue is empty, it steals work items from the front of the queues
+ * of the other workers, such that the workers stay busy even if the work items
+ * take a varying amount of time to process.
+ */
+class QISA_WorkPool
+{
+public:
+
+  /**
+   * Task to execute for each work item.
+   * The first argument is the index of the work item, the second
+   * argument is the index of the worker (in range [0, nrOfThreads()))
+   * that executes it.
+   * The worker index can be used to select per-worker resources.
+   */
+  typedef std::function<void(size_t, unsigned)> task_t;
+
+  /**
+   * Create a pool that uses the given number of worker threads.
+   *
+   * @param[in] nrOfThreads Number of worker threads to use.
+   *                        If 0, defaultNrOfThreads() is used.
+   */
+  DllExport explicit
+  QISA_WorkPool(unsigned nrOfThreads = 0);
+
+  /**
+   * @return The number of worker threads used by this pool.
+   */
+  DllExport unsigned
+  nrOfThreads() const;
+
+  /**
+   * @return The number of hardware threads, or 1 if that cannot be determined.
+   */
+  DllExport static unsigned
+  defaultNrOfThreads();
+
+  /**
+   * Execute the given task for all work items in range [0, nrOfItems).
+   * This function returns when all work items have been processed.
+   * The calling thread is used as one of the workers.
+   *
+   * @param[in] nrOfItems Number of work items to process.
+   * @param[in] task      Task to execute for each work item.
+   *
+   * @note
+   *   If a task throws an exception, the remaining work items are still processed.
+   *   The first exception that was thrown is rethrown when all workers are done.
+   */
+  DllExport void
+  run(size_t nrOfItems, const task_t& task);
+
+private:
+
+  // Queue of work items belonging to one worker.
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<size_t> items;
+  };
+
+  /**
+   * Get the next work item to process for the given worker.
+   * This takes a work item from the worker's own queue, or steals one from
+   * another worker if its own queue is empty.
+   *
+   * @param[in]  workerIndex Index of the worker asking for work.
+   * @param[out] item        Index of the work item to process.
+   *
+   * @return True if a work item was found, false if all work has been handed out.
+   */
+  bool
+  nextItem(unsigned workerIndex, size_t& item);
+
+  // Executes work items until there are none left.
+  void
+  work(unsigned workerIndex, const task_t& task);
+
+  // Number of worker threads.
+  unsigned _nrOfThreads;
+
+  // One queue per worker.
+  std::vector<std::unique_ptr<WorkQueue> > _queues;
+
+  // Protects _exception.
+  std::mutex _exceptionMutex;
+
+  // First exception thrown by a task, if any.
+  std::exception_ptr _exception;
+};
+
+} // namespace QISA
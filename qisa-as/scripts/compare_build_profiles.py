@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Compares the assemble and disassemble speed of qisa-as, built with different
+build profiles: the CMake build types Debug, Release and RelWithDebInfo,
+link time optimization (QISA_AS_LTO) and profile guided optimization (the
+pgo-generate and pgo-use targets).
+
+Each profile is built in its own subdirectory of the given build root, after
+which a generated assembly program is assembled and the result is
+disassembled, a number of times. The best times are reported, together with
+the speedup relative to the Debug build.
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import time
+
+SOURCE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TOPOLOGY_FILE = os.path.join(SOURCE_DIR, 'test_python_interface',
+                             'qisa_test_assembly', 'surface7_topology.txt')
+
+# Name, CMake options and whether the profile guided optimization targets are used.
+PROFILES = [
+    ('Debug',          ['-DCMAKE_BUILD_TYPE=Debug'],                        False),
+    ('Release',        ['-DCMAKE_BUILD_TYPE=Release'],                      False),
+    ('RelWithDebInfo', ['-DCMAKE_BUILD_TYPE=RelWithDebInfo'],               False),
+    ('Release+LTO',    ['-DCMAKE_BUILD_TYPE=Release', '-DQISA_AS_LTO=ON'],  False),
+    ('Release+PGO',    ['-DCMAKE_BUILD_TYPE=Release'],                      True),
+    ('Release+LTO+PGO', ['-DCMAKE_BUILD_TYPE=Release', '-DQISA_AS_LTO=ON'], True),
+]
+
+# Target-control pairs of the surface-7 topology.
+PAIRS = [(2, 0), (0, 3), (3, 1), (1, 4), (2, 5), (5, 3), (3, 6), (6, 4),
+         (0, 2), (3, 0), (1, 3), (4, 1), (5, 2), (3, 5), (6, 3), (4, 6)]
+
+
+def generate_program(nr_of_blocks, seed):
+    """Returns a program with a mix of classic instructions, mask setup and quantum bundles."""
+    rng = random.Random(seed)
+    lines = []
+
+    for i in range(nr_of_blocks):
+        qubits = sorted(rng.sample(range(7), rng.randint(1, 7)))
+        pair = PAIRS[i % len(PAIRS)]
+
+        lines.append('block_{0}:'.format(i))
+        lines.append('    ldi r{0}, {1}'.format(i % 32, i))
+        lines.append('    add r{0}, r{1}, r{2}'.format(i % 32, (i + 1) % 32, (i + 2) % 32))
+        lines.append('    smis s{0}, {{{1}}}'.format(i % 32, ', '.join(str(q) for q in qubits)))
+        lines.append('    smit t{0}, {{({1}, {2})}}'.format(i % 64, pair[0], pair[1]))
+        lines.append('    bs 1 CW_01 s{0} | CNOT t{1}'.format(i % 32, i % 64))
+        lines.append('    qwait {0}'.format(1 + i % 100))
+        lines.append('    cmp r{0}, r{1}'.format(i % 32, (i + 3) % 32))
+        if i + 1 < nr_of_blocks:
+            lines.append('    br eq, block_{0}'.format(i + 1))
+
+    lines.append('    stop')
+    return '\n'.join(lines) + '\n'
+
+
+def run(command, cwd=None):
+    subprocess.check_call(command, cwd=cwd, stdout=subprocess.DEVNULL)
+
+
+def build_profile(build_root, name, options, use_pgo):
+    """Builds qisa-as for the given profile, and returns the path of the executable."""
+    build_dir = os.path.join(build_root, name)
+    os.makedirs(build_dir, exist_ok=True)
+
+    print('Building {0} in {1}'.format(name, build_dir), file=sys.stderr)
+    run(['cmake'] + options + [SOURCE_DIR], cwd=build_dir)
+
+    if use_pgo:
+        run(['cmake', '--build', '.', '--target', 'pgo-generate'], cwd=build_dir)
+        run(['cmake', '--build', '.', '--target', 'pgo-use'], cwd=build_dir)
+        return os.path.join(build_dir, 'pgo-build', 'qisa-as')
+
+    run(['cmake', '--build', '.', '--target', 'qisa-as'], cwd=build_dir)
+    return os.path.join(build_dir, 'qisa-as')
+
+
+def best_time(command, nr_of_runs):
+    times = []
+    for _ in range(nr_of_runs):
+        start = time.perf_counter()
+        run(command)
+        times.append(time.perf_counter() - start)
+    return min(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--build-root', default='profile-builds',
+                        help='directory in which the profiles are built (default: %(default)s)')
+    parser.add_argument('--blocks', type=int, default=20000,
+                        help='number of instruction blocks in the generated program (default: %(default)s)')
+    parser.add_argument('--runs', type=int, default=5,
+                        help='number of timed runs per profile; the best is reported (default: %(default)s)')
+    parser.add_argument('--profiles', nargs='+', default=[p[0] for p in PROFILES],
+                        choices=[p[0] for p in PROFILES],
+                        help='profiles to compare (default: all)')
+    args = parser.parse_args()
+
+    build_root = os.path.abspath(args.build_root)
+    os.makedirs(build_root, exist_ok=True)
+
+    program_file = os.path.join(build_root, 'benchmark.qisa')
+    with open(program_file, 'w') as f:
+        f.write(generate_program(args.blocks, seed=1))
+
+    results = []
+    for name, options, use_pgo in PROFILES:
+        if name not in args.profiles:
+            continue
+
+        qisa_as = build_profile(build_root, name, options, use_pgo)
+
+        assembled_file = os.path.join(build_root, name + '.out')
+        disassembled_file = os.path.join(build_root, name + '.dis')
+
+        assemble_time = best_time([qisa_as, '--topology', TOPOLOGY_FILE,
+                                   '-o', assembled_file, program_file], args.runs)
+        disassemble_time = best_time([qisa_as, '-d', '-o', disassembled_file, assembled_file], args.runs)
+
+        results.append((name, assemble_time, disassemble_time))
+
+    reference = results[0]
+
+    print('{0:<16} {1:>12} {2:>8} {3:>15} {4:>8}'.format(
+        'Profile', 'Assemble [s]', 'Speedup', 'Disassemble [s]', 'Speedup'))
+    for name, assemble_time, disassemble_time in results:
+        print('{0:<16} {1:>12.3f} {2:>7.2f}x {3:>15.3f} {4:>7.2f}x'.format(
+            name,
+            assemble_time, reference[1] / assemble_time,
+            disassemble_time, reference[2] / disassemble_time))
+    print('Speedups are relative to {0}.'.format(reference[0]))
+
+
+if __name__ == '__main__':
+    main()
@@ -51,6 +51,56 @@ q_all = def_q_arg_none.copy()
 q_all.update(def_q_arg_st)
 q_all.update(def_q_arg_tt)
 
+
+def hash_name(name, seed):
+    """Case insensitive hash of an instruction name.
+
+    This must be the same function as QISA_Hash::hashName() (see qisa_hash.h).
+    """
+    h = ((2166136261 ^ seed) * 16777619) & 0xffffffff
+    for c in name.upper():
+        h = ((h ^ ord(c)) * 16777619) & 0xffffffff
+    return h ^ (h >> 15)
+
+
+def build_perfect_hash(names):
+    """Build a perfect hash index on the given names.
+
+    Each name is first hashed with seed 0 to select a bucket, and then with
+    the displacement of that bucket as seed to select its slot.
+    Returns the list of displacements and the list of slots (a name or None).
+    """
+    table_size = 1
+    while table_size < 2 * len(names):
+        table_size *= 2
+    mask = table_size - 1
+
+    buckets = [[] for _ in range(table_size)]
+    for name in names:
+        buckets[hash_name(name, 0) & mask].append(name)
+
+    displacements = [0] * table_size
+    slots = [None] * table_size
+
+    # Handle the largest buckets first, while most slots are still free.
+    for b in sorted(range(table_size), key=lambda b: -len(buckets[b])):
+        bucket = buckets[b]
+        if not bucket:
+            break
+        displacement = 1
+        while True:
+            bucket_slots = [hash_name(name, displacement) & mask for name in bucket]
+            if (len(set(bucket_slots)) == len(bucket_slots) and
+                all(slots[slot] is None for slot in bucket_slots)):
+                break
+            displacement += 1
+        displacements[b] = displacement
+        for name, slot in zip(bucket, bucket_slots):
+            slots[slot] = name
+
+    return displacements, slots
+
+
 # ---------------------
 # Handle the cpp output
 # ---------------------
@@ -152,6 +202,34 @@ try:
 
         if not encountered_error:
             print('}\n', file=fd)
+
+            # Perfect hash index on the classic instruction names, used by
+            # QISA_Driver::findClassicOpcode().
+            names = [inst.upper() for inst in sorted(def_opcode.keys())]
+            displacements, slots = build_perfect_hash(names)
+            opcodes = dict((inst.upper(), opc) for inst, opc in def_opcode.items())
+
+            print('// Perfect hash index on the names of the classic instructions.', file=fd)
+            print('struct ClassicOpcodeSlot', file=fd)
+            print('{', file=fd)
+            print('  const char* name;', file=fd)
+            print('  int opcode;', file=fd)
+            print('};\n', file=fd)
+            print('static const uint32_t CLASSIC_OPCODE_TABLE_SIZE = {0};\n'.format(len(slots)), file=fd)
+            print('static const uint32_t classicOpcodeDisplacements[CLASSIC_OPCODE_TABLE_SIZE] =', file=fd)
+            print('{', file=fd)
+            for i in range(0, len(displacements), 8):
+                print('  ' + ' '.join('{0},'.format(d) for d in displacements[i:i + 8]), file=fd)
+            print('};\n', file=fd)
+            print('static const ClassicOpcodeSlot classicOpcodeSlots[CLASSIC_OPCODE_TABLE_SIZE] =', file=fd)
+            print('{', file=fd)
+            for name in slots:
+                if name is None:
+                    print('  { NULL, -1 },', file=fd)
+                else:
+                    print('  {{ "{0}", {1:#04x} }},'.format(name, opcodes[name]), file=fd)
+            print('};\n', file=fd)
+
             print('} // namespace QISA', file=fd)
 
 except Exception as e:
@@ -0,0 +1,58 @@
+# Training run for profile guided optimization (see the pgo-generate target in CMakeLists.txt).
+#
+# Assembles all .qisa files of the repository using the instrumented qisa-as,
+# and disassembles the results in both output formats.
+# For Clang, the raw profiles are merged into the file used by the pgo-use stage.
+#
+# Usage: cmake -DQISA_AS=<instrumented qisa-as> -DSOURCE_DIR=<qisa-as source directory>
+#              -DWORK_DIR=<directory for the output files> -DPROFILE_DIR=<profile directory>
+#              -DCOMPILER_ID=<CMAKE_CXX_COMPILER_ID> [-DLLVM_PROFDATA=<llvm-profdata>]
+#              -P pgo_train.cmake
+
+cmake_minimum_required(VERSION 3.1)
+
+# Number of times each file is processed, to give the profiles some weight.
+set(NR_OF_RUNS 10)
+
+set(TOPOLOGY_FILE "${SOURCE_DIR}/test_python_interface/qisa_test_assembly/surface7_topology.txt")
+
+file(GLOB_RECURSE TRAINING_FILES
+     "${SOURCE_DIR}/test_python_interface/*.qisa"
+     "${SOURCE_DIR}/tst_issues/*.qisa")
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+foreach(RUN RANGE 1 ${NR_OF_RUNS})
+  foreach(TRAINING_FILE ${TRAINING_FILES})
+    get_filename_component(NAME "${TRAINING_FILE}" NAME_WE)
+    set(OUTPUT_FILE "${WORK_DIR}/${NAME}.out")
+
+    # Some of the files intentionally contain errors, so the result is not checked.
+    execute_process(COMMAND "${QISA_AS}" --topology "${TOPOLOGY_FILE}" -o "${OUTPUT_FILE}" "${TRAINING_FILE}"
+                    OUTPUT_QUIET ERROR_QUIET)
+
+    if(EXISTS "${OUTPUT_FILE}")
+      execute_process(COMMAND "${QISA_AS}" -d -o "${WORK_DIR}/${NAME}.dis1" "${OUTPUT_FILE}"
+                      OUTPUT_QUIET ERROR_QUIET)
+      execute_process(COMMAND "${QISA_AS}" -d2 -o "${WORK_DIR}/${NAME}.dis2" "${OUTPUT_FILE}"
+                      OUTPUT_QUIET ERROR_QUIET)
+    endif()
+  endforeach()
+endforeach()
+
+list(LENGTH TRAINING_FILES NR_OF_TRAINING_FILES)
+message(STATUS "Trained on ${NR_OF_TRAINING_FILES} files, ${NR_OF_RUNS} times each")
+
+if(COMPILER_ID MATCHES "Clang")
+  if(NOT LLVM_PROFDATA)
+    message(FATAL_ERROR "llvm-profdata is needed to merge the Clang profiles, but it has not been found")
+  endif()
+
+  file(GLOB RAW_PROFILES "${PROFILE_DIR}/*.profraw")
+  execute_process(COMMAND "${LLVM_PROFDATA}" merge -output=${PROFILE_DIR}/qisa-as.profdata ${RAW_PROFILES}
+                  RESULT_VARIABLE MERGE_RESULT)
+  if(NOT MERGE_RESULT EQUAL 0)
+    message(FATAL_ERROR "Merging the profiles failed")
+  endif()
+endif()
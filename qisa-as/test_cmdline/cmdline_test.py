@@ -0,0 +1,74 @@
+"""Helpers shared by the tests of the qisa-as command line.
+
+Each test is a script that takes the path of the qisa-as executable as its
+first argument, and exits with a non-zero status on the first failed check.
+"""
+
+import os
+import subprocess
+import sys
+
+SOURCE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TEST_ASSEMBLY_DIR = os.path.join(SOURCE_DIR, 'test_python_interface', 'qisa_test_assembly')
+TOPOLOGY_FILE = os.path.join(TEST_ASSEMBLY_DIR, 'surface7_topology.txt')
+
+# The files of the test corpus that assemble without errors, and some that do not.
+GOOD_FILES = [os.path.join(TEST_ASSEMBLY_DIR, name)
+              for name in ['test_assembly.qisa', 'test_s_mask.qisa', 'test_t_mask.qisa']]
+BAD_FILES = [os.path.join(TEST_ASSEMBLY_DIR, name)
+             for name in ['test_wrong_s_mask_1.qisa', 'test_wrong_t_mask_1.qisa']]
+
+
+def qisa_as():
+  if len(sys.argv) < 2:
+    print ("Usage: " + sys.argv[0] + " QISA_AS_EXECUTABLE")
+    sys.exit(2)
+
+  return os.path.abspath(sys.argv[1])
+
+
+def fail(message, details=''):
+  print ("FAILED: " + message)
+  if details:
+    print (details)
+  sys.exit(1)
+
+
+def run(*args, **kwargs):
+  """Run the given command, and check its exit status.
+
+  Keyword arguments:
+    expect_success: whether the command must succeed (default) or fail.
+  """
+  expect_success = kwargs.pop('expect_success', True)
+
+  result = subprocess.run(list(args), stdout=subprocess.PIPE, stderr=subprocess.PIPE, **kwargs)
+
+  if (result.returncode == 0) != expect_success:
+    fail("'" + ' '.join(args) + "' exited with status " + str(result.returncode),
+         result.stdout.decode(errors='replace') + result.stderr.decode(errors='replace'))
+
+  return result
+
+
+def read(filename):
+  with open(filename, 'rb') as f:
+    return f.read()
+
+
+def check_equal(actual, expected, what):
+  if actual != expected:
+    fail(what + ' differ(s)')
+
+
+def check_same_file(filename, referenceFilename):
+  check_equal(read(filename), read(referenceFilename),
+              "'" + filename + "' and '" + referenceFilename + "'")
+
+
+def passed():
+  print ("====================")
+  print ("=                  =")
+  print ("= ALL TESTS PASSED =")
+  print ("=                  =")
+  print ("====================")
@@ -0,0 +1,79 @@
+"""Test of the batch mode of qisa-as (--jobs, --manifest).
+
+The test corpus and a file that does not assemble are processed with four
+parallel jobs. The output of each file must be identical to that of a
+single-file run, and the failing file must make the exit status non-zero.
+With -v, the jobs must be as verbose as a single-file run.
+"""
+
+import os
+import re
+import shutil
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+with tempfile.TemporaryDirectory() as workDir:
+  # Batch mode saves the output next to the input files, so work on copies.
+  goodFiles = []
+  for filename in GOOD_FILES:
+    goodFiles.append(shutil.copy(filename, workDir))
+  badFile = shutil.copy(BAD_FILES[0], workDir)
+
+  def batchOutput(filename, extension):
+    return os.path.splitext(filename)[0] + extension
+
+  print ("Assembling each file on its own...")
+  for filename in goodFiles:
+    run(qisaAs, '--topology', TOPOLOGY_FILE, '-o', filename + '.ref', filename)
+
+  print ("Assembling in batch mode, with a failing file in the manifest...")
+  manifestFilename = os.path.join(workDir, 'manifest.txt')
+  with open(manifestFilename, 'w') as manifest:
+    manifest.write('# Files listed in the manifest\n\n' + goodFiles[-1] + '\n' + badFile + '\n')
+
+  result = run(qisaAs, '--topology', TOPOLOGY_FILE, '--jobs', '4', '--manifest', manifestFilename,
+               *goodFiles[:-1], expect_success=False)
+
+  for filename in goodFiles:
+    check_same_file(batchOutput(filename, '.out'), filename + '.ref')
+
+  if os.path.exists(batchOutput(badFile, '.out')):
+    fail("output has been saved for '" + badFile + "'")
+
+  if (badFile + ': FAILED') not in result.stderr.decode():
+    fail("the failure of '" + badFile + "' has not been reported")
+
+  print ("Assembling in batch mode, without failing files...")
+  for filename in goodFiles:
+    os.remove(batchOutput(filename, '.out'))
+
+  run(qisaAs, '--topology', TOPOLOGY_FILE, '--jobs', '4', *goodFiles)
+
+  for filename in goodFiles:
+    check_same_file(batchOutput(filename, '.out'), filename + '.ref')
+
+  print ("Assembling in batch mode, verbosely...")
+  verboseOutput = run(qisaAs, '--topology', TOPOLOGY_FILE, '-v', '-o', goodFiles[0] + '.ref', goodFiles[0]).stdout
+  verboseBatchOutput = run(qisaAs, '--topology', TOPOLOGY_FILE, '-v', '--jobs', '4', goodFiles[0]).stdout
+
+  # The instructions, as shown while they are generated.
+  def generatedInstructions(output):
+    return [line for line in output.splitlines() if re.match(rb'[0-9]{8}: ', line)]
+
+  if not generatedInstructions(verboseOutput) or \
+     (generatedInstructions(verboseBatchOutput) != generatedInstructions(verboseOutput)):
+    fail("the batch job has not shown the instructions while generating them", verboseBatchOutput.decode())
+
+  print ("Disassembling in batch mode...")
+  for filename in goodFiles:
+    run(qisaAs, '--topology', TOPOLOGY_FILE, '-d', '-o', filename + '.dis.ref', filename + '.ref')
+
+  run(qisaAs, '--topology', TOPOLOGY_FILE, '-d', '--jobs', '4', *[f + '.ref' for f in goodFiles])
+
+  for filename in goodFiles:
+    check_same_file(filename + '.dis', filename + '.dis.ref')
+
+passed()
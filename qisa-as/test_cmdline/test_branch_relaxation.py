@@ -0,0 +1,133 @@
+"""Test of the relaxation of branches whose target is out of reach.
+
+A program of more than 2^20 instruction words has a forward unconditional,
+a forward conditional and a backward conditional branch whose targets are
+out of reach. The program consists mostly of quantum bundles of three VLIWs,
+the last two of which have no wait time (bs 0). Each relaxed branch is
+followed through its chain of unconditional branches in the assembled
+program, both when it is taken and when it is not. No island of the chains
+may be placed between the VLIWs of a bundle. The program is assembled with
+and without mask deduplication, which removes words after the relaxation.
+"""
+
+import json
+import os
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+# Number of bundles between the branches and their targets: 3 x 400000 words is out of reach.
+NR_OF_FILLER_BUNDLES = 400000
+FILLER_BUNDLE = 'bs 1 CW_01 s0 | CW_02 s0 | CW_03 s0 | CW_04 s0 | CW_05 s0\n'
+
+# The branches, by number: (branch instruction, condition).
+# A branch is preceded by 'ldi r6, <number>' and followed by 'ldi r7, <number>';
+# its label is at 'ldi r5, <1000 + number>'.
+COND_ALWAYS = 0
+COND_EQ = 2
+COND_NE = 3
+
+BRANCHES = {
+  0: ('br always,', COND_ALWAYS),
+  1: ('bne r0, r1,', COND_NE),
+  2: ('br eq,', COND_EQ)
+}
+
+# Encoding of the classic instructions that are looked for.
+BR_OPCODE = 0x01
+CMP_OPCODE = 0x0d
+LDI_OPCODE = 0x16
+QUANTUM_BIT = 1 << 31
+BS_MASK = 0x7
+
+def branchLines(number):
+  return 'ldi r6, ' + str(number) + '\n' + BRANCHES[number][0] + ' L' + str(number) + '\nldi r7, ' + str(number) + '\n'
+
+def labelLine(number):
+  return 'L' + str(number) + ': ldi r5, ' + str(1000 + number) + '\n'
+
+def ldi(register, value):
+  return (LDI_OPCODE << 25) | (register << 20) | value
+
+def opcode(word):
+  return None if (word & QUANTUM_BIT) else (word >> 25) & 0x3f
+
+def isUnconditionalBranch(word):
+  return (opcode(word) == BR_OPCODE) and ((word & 0xf) == COND_ALWAYS)
+
+def branchOffset(word):
+  offset = (word >> 4) & 0x1fffff
+  return offset - (1 << 21) if offset & (1 << 20) else offset
+
+# Mask deduplication removes the second SMIS, which lies between a branch and the islands it passes.
+program = (labelLine(1)
+           + branchLines(0)
+           + FILLER_BUNDLE * (NR_OF_FILLER_BUNDLES // 2)
+           + 'smis s0, {0}\nsmis s0, {0}\n'
+           + FILLER_BUNDLE * (NR_OF_FILLER_BUNDLES // 2)
+           + labelLine(0)
+           + branchLines(2)
+           + FILLER_BUNDLE * NR_OF_FILLER_BUNDLES
+           + labelLine(2)
+           + branchLines(1)
+           + 'stop\n')
+
+with tempfile.TemporaryDirectory() as workDir:
+  sourceFilename = os.path.join(workDir, 'long_branches.qisa')
+  outputFilename = os.path.join(workDir, 'long_branches.out')
+  with open(sourceFilename, 'w') as f:
+    f.write(program)
+
+  for options in [[], ['--dedup-masks']]:
+    print ("Assembling branches whose target is out of reach " + ' '.join(options) + "...")
+    result = run(qisaAs, '--topology', TOPOLOGY_FILE, '--stats=json', '-o', outputFilename, *options, sourceFilename)
+    stats = json.loads(result.stderr.decode())
+
+    check_equal(stats['relaxed_branches'], len(BRANCHES), "the number of relaxed branches")
+    check_equal(stats['removed_mask_words'], 1 if options else 0, "the number of removed mask words")
+
+    binary = read(outputFilename)
+    words = [int.from_bytes(binary[i:i + 4], 'little') for i in range(0, len(binary), 4)]
+    addresses = dict((word, address) for address, word in reversed(list(enumerate(words))))
+
+    print ("Checking that the VLIWs of each bundle are kept together...")
+    for address, word in enumerate(words):
+      if (word & QUANTUM_BIT) and ((word & BS_MASK) == 0) and not (words[address - 1] & QUANTUM_BIT):
+        fail("the VLIW at address " + str(address) + " is separated from the rest of its bundle",
+             "preceded by 0x%08x" % words[address - 1])
+
+    def follow(address):
+      """Follow the unconditional branches from the given address, and return where they end."""
+      for hop in range(100):
+        if not isUnconditionalBranch(words[address]):
+          return address
+        address += branchOffset(words[address])
+      fail("the chain of unconditional branches from address " + str(address) + " does not end")
+
+    for number, (instruction, cond) in sorted(BRANCHES.items()):
+      print ("Following the chains of '" + instruction + " L" + str(number) + "'...")
+      address = follow(addresses[ldi(6, number)] + 1)
+
+      if opcode(words[address]) == CMP_OPCODE:
+        address = follow(address + 1)
+
+      if cond == COND_ALWAYS:
+        taken = address
+        notTaken = None
+      else:
+        # The branch is inverted: it is taken over the chain when the condition does not hold.
+        word = words[address]
+        if (opcode(word) != BR_OPCODE) or ((word & 0xf) != (cond ^ 1)):
+          fail("'" + instruction + " L" + str(number) + "' has not been inverted", "0x%08x" % word)
+        taken = address + 1
+        notTaken = address + branchOffset(word)
+
+      if words[follow(taken)] != ldi(5, 1000 + number):
+        fail("'" + instruction + " L" + str(number) + "' does not reach its label")
+
+      if (notTaken is not None) and (words[follow(notTaken)] != ldi(7, number)):
+        fail("'" + instruction + " L" + str(number) + "' does not continue after itself when not taken")
+
+passed()
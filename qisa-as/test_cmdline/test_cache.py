@@ -0,0 +1,135 @@
+"""Test of the assembly cache (--cache).
+
+A program with a redundant mask and a branch that needs relaxation is
+assembled twice with mask deduplication, into an empty cache directory.
+The first run must miss and the second run must hit the cache (the scanner
+is not run: no tokens are counted). Both must give the same instructions,
+and report the same number of removed mask words and relaxed branches.
+After that, the test corpus is assembled with a changed topology and with a
+changed quantum instruction set, which must both miss the cache and give the
+same instructions as without the cache. Finally, the cache file of another
+program is given the name and key of a program, as if their keys collide.
+Assembling the program must miss the cache and give its own instructions.
+"""
+
+import json
+import os
+import re
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+def assemble(outputFilename, inputFilename, *options):
+  """Assemble the given file, and return the statistics of the run."""
+  result = run(qisaAs, '--stats=json', '-o', outputFilename, *options, inputFilename)
+  return json.loads(result.stderr.decode())
+
+def checkMiss(stats, what):
+  if stats['tokens'] == 0:
+    fail(what + " has been taken from the cache")
+
+def checkHit(stats, what):
+  if stats['tokens'] != 0:
+    fail(what + " has not been taken from the cache")
+
+with tempfile.TemporaryDirectory() as workDir:
+  cacheDirectory = os.path.join(workDir, 'cache')
+  os.mkdir(cacheDirectory)
+
+  def path(name):
+    return os.path.join(workDir, name)
+
+  print ("Assembling a program with a redundant mask and a long loop, twice...")
+  with open(path('long_loop.qisa'), 'w') as f:
+    f.write('smis s0, {0, 1}\nsmis s0, {0, 1}\nloop: ldi r0, 1\n' + 'nop\n' * (1 << 20) + 'bne r0, r1, loop\nstop\n')
+
+  options = ['--topology', TOPOLOGY_FILE, '--dedup-masks', '--cache', cacheDirectory]
+  missStats = assemble(path('miss.out'), path('long_loop.qisa'), *options)
+  hitStats = assemble(path('hit.out'), path('long_loop.qisa'), *options)
+
+  checkMiss(missStats, "the first assembly")
+  checkHit(hitStats, "the second assembly")
+  check_same_file(path('hit.out'), path('miss.out'))
+
+  for counter in ['removed_mask_words', 'relaxed_branches']:
+    if missStats[counter] != 1:
+      fail("expected 1 for '" + counter + "', got " + str(missStats[counter]))
+    if hitStats[counter] != missStats[counter]:
+      fail("'" + counter + "' is " + str(hitStats[counter]) + " on a cache hit, but "
+           + str(missStats[counter]) + " on a miss")
+
+  print ("Assembling the test corpus with a changed topology and instruction set...")
+  # Swap two edges, which changes the encoding of the t_masks that contain them.
+  with open(TOPOLOGY_FILE) as f:
+    topology = f.read()
+  with open(path('changed_topology.txt'), 'w') as f:
+    f.write(topology.replace('12: 5, 2', '12: 3, 5', 1).replace('13: 3, 5', '13: 5, 2', 1))
+
+  # Give CW_01 another (unused) opcode.
+  with open(os.path.join(SOURCE_DIR, 'qisa_opcodes.qmap')) as f:
+    qmap = f.read()
+  with open(path('changed_opcodes.qmap'), 'w') as f:
+    f.write(re.sub(r"def_q_arg_st\['CW_01'\]\s*=\s*0x01", "def_q_arg_st['CW_01'] = 0x04", qmap))
+
+  changes = [['--topology', path('changed_topology.txt')],
+             ['--topology', TOPOLOGY_FILE, '-q', path('changed_opcodes.qmap')]]
+
+  # Whether a change has any effect on the generated instructions of the test corpus.
+  changesMatter = [False] * len(changes)
+
+  for filename in GOOD_FILES:
+    name = path(os.path.basename(filename))
+
+    checkMiss(assemble(name + '.out', filename, '--topology', TOPOLOGY_FILE, '--cache', cacheDirectory),
+              "the first assembly of '" + filename + "'")
+    checkHit(assemble(name + '.hit.out', filename, '--topology', TOPOLOGY_FILE, '--cache', cacheDirectory),
+             "the second assembly of '" + filename + "'")
+    check_same_file(name + '.hit.out', name + '.out')
+
+    for i, changedOptions in enumerate(changes):
+      what = "the assembly of '" + filename + "' with " + ' '.join(changedOptions)
+
+      checkMiss(assemble(name + '.changed.out', filename, '--cache', cacheDirectory, *changedOptions), what)
+      assemble(name + '.uncached.out', filename, *changedOptions)
+      check_same_file(name + '.changed.out', name + '.uncached.out')
+
+      changesMatter[i] = changesMatter[i] or (read(name + '.changed.out') != read(name + '.out'))
+
+  # Otherwise, the misses above prove nothing.
+  for i, changedOptions in enumerate(changes):
+    if not changesMatter[i]:
+      fail("'" + ' '.join(changedOptions) + "' does not change the generated instructions")
+
+  print ("Assembling a program whose cache file holds another program with the same key...")
+  collisionCacheDirectory = path('collision_cache')
+  os.mkdir(collisionCacheDirectory)
+  collisionOptions = ['--topology', TOPOLOGY_FILE, '--cache', collisionCacheDirectory]
+
+  def assembleIntoEmptyCache(outputFilename, inputFilename):
+    """Assemble the given file into the empty collision cache, and return the name of its cache file."""
+    assemble(outputFilename, inputFilename, *collisionOptions)
+    cacheFilenames = os.listdir(collisionCacheDirectory)
+    check_equal(len(cacheFilenames), 1, "the number of cache files")
+    cacheFilename = os.path.join(collisionCacheDirectory, cacheFilenames[0])
+    cacheFile = read(cacheFilename)
+    os.remove(cacheFilename)
+    return cacheFilename, cacheFile
+
+  programFilename, otherProgramFilename = GOOD_FILES[0], GOOD_FILES[1]
+  cacheFilename, cacheFile = assembleIntoEmptyCache(path('program.out'), programFilename)
+  otherCacheFilename, otherCacheFile = assembleIntoEmptyCache(path('other_program.out'), otherProgramFilename)
+
+  if read(path('program.out')) == read(path('other_program.out')):
+    fail("'" + programFilename + "' and '" + otherProgramFilename + "' give the same instructions")
+
+  # The key follows the magic of 8 bytes.
+  with open(cacheFilename, 'wb') as f:
+    f.write(otherCacheFile[:8] + cacheFile[8:16] + otherCacheFile[16:])
+
+  checkMiss(assemble(path('collision.out'), programFilename, *collisionOptions),
+            "the assembly of '" + programFilename + "' with a colliding cache file")
+  check_same_file(path('collision.out'), path('program.out'))
+
+passed()
@@ -0,0 +1,65 @@
+"""Test of the streaming disassembly writer (-d with -o).
+
+When the disassembly is saved to a file using a single thread, it is
+streamed to that file. The assembled test corpus and a large file made of
+copies of it are disassembled in both output formats; the streamed file
+must be identical to the disassembly shown on stdout, and to the file saved
+from the complete disassembly output (as done with more than one thread).
+"""
+
+import os
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+NR_OF_CORPUS_COPIES = 500
+
+with tempfile.TemporaryDirectory() as workDir:
+  binaryFiles = []
+
+  print ("Assembling the test corpus...")
+  corpus = b''
+  for filename in GOOD_FILES:
+    binaryFilename = os.path.join(workDir, os.path.basename(filename) + '.out')
+    run(qisaAs, '--topology', TOPOLOGY_FILE, '-o', binaryFilename, filename)
+    binaryFiles.append(binaryFilename)
+    corpus += read(binaryFilename)
+
+  corpusCopiesFilename = os.path.join(workDir, 'corpus_copies.out')
+  with open(corpusCopiesFilename, 'wb') as f:
+    f.write(corpus * NR_OF_CORPUS_COPIES)
+  binaryFiles.append(corpusCopiesFilename)
+
+  streamedFilename = os.path.join(workDir, 'streamed.dis')
+  savedFilename = os.path.join(workDir, 'saved.dis')
+
+  for binaryFilename in binaryFiles:
+    for formatOption in ['-d1', '-d2']:
+      print ("Disassembling '" + os.path.basename(binaryFilename) + "' (" + formatOption + ")...")
+
+      run(qisaAs, '--topology', TOPOLOGY_FILE, formatOption, '-o', streamedFilename, binaryFilename)
+      run(qisaAs, '--topology', TOPOLOGY_FILE, formatOption, '--threads', '2', '-o', savedFilename, binaryFilename)
+      shown = run(qisaAs, '--topology', TOPOLOGY_FILE, formatOption, binaryFilename).stdout
+
+      header = b'Disassembly output:\n'
+      if not shown.startswith(header):
+        fail("the disassembly shown on stdout does not start with '" + header.decode().strip() + "'")
+
+      check_equal(read(streamedFilename), shown[len(header):],
+                  "the streamed disassembly and the disassembly shown on stdout")
+      check_same_file(streamedFilename, savedFilename)
+
+  print ("Disassembling invalid instructions...")
+  invalidFilename = os.path.join(workDir, 'invalid.out')
+  with open(invalidFilename, 'wb') as f:
+    f.write(corpus + b'\xff\xff\xff\xff')
+
+  os.remove(streamedFilename)
+  run(qisaAs, '--topology', TOPOLOGY_FILE, '-d', '-o', streamedFilename, invalidFilename, expect_success=False)
+
+  if os.path.exists(streamedFilename):
+    fail("incomplete streamed disassembly has been left behind")
+
+passed()
@@ -0,0 +1,87 @@
+"""Test of multi-threaded disassembly (--threads).
+
+The assembled test corpus, a large file made of copies of it, and files of
+random instruction words are disassembled in both output formats with one
+and with eight threads. The output (or the error messages) must be
+byte-identical.
+"""
+
+import os
+import random
+import re
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+# Multi-threaded disassembly only splits inputs of at least 32768 words.
+NR_OF_CORPUS_COPIES = 500
+NR_OF_RANDOM_WORDS = 500000
+
+def disassemble(formatOption, nrOfThreads, binaryFilename):
+  result = subprocess.run([qisaAs, '--topology', TOPOLOGY_FILE, formatOption, '--threads', nrOfThreads,
+                           binaryFilename], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  return (result.returncode, result.stdout, result.stderr)
+
+def writeWords(filename, words):
+  with open(filename, 'wb') as f:
+    f.write(b''.join(word.to_bytes(4, 'little') for word in words))
+
+with tempfile.TemporaryDirectory() as workDir:
+  binaryFiles = []
+
+  print ("Assembling the test corpus...")
+  corpus = b''
+  for filename in GOOD_FILES:
+    binaryFilename = os.path.join(workDir, os.path.basename(filename) + '.out')
+    run(qisaAs, '--topology', TOPOLOGY_FILE, '-o', binaryFilename, filename)
+    binaryFiles.append(binaryFilename)
+    corpus += read(binaryFilename)
+
+  corpusCopiesFilename = os.path.join(workDir, 'corpus_copies.out')
+  with open(corpusCopiesFilename, 'wb') as f:
+    f.write(corpus * NR_OF_CORPUS_COPIES)
+  binaryFiles.append(corpusCopiesFilename)
+
+  print ("Generating " + str(NR_OF_RANDOM_WORDS) + " random instruction words...")
+  rng = random.Random(20180601)
+  randomWords = [rng.getrandbits(32) for i in range(NR_OF_RANDOM_WORDS)]
+
+  # Most random words are not valid instructions, which makes the disassembly fail.
+  randomFilename = os.path.join(workDir, 'random_words.out')
+  writeWords(randomFilename, randomWords)
+  binaryFiles.append(randomFilename)
+
+  # Leave out the words that are rejected, until the remaining words disassemble.
+  # Leaving out words can make other words invalid (e.g. a VLIW continuation), so repeat this.
+  validRandomFilename = os.path.join(workDir, 'valid_random_words.out')
+  validRandomWords = randomWords
+  for attempt in range(10):
+    writeWords(validRandomFilename, validRandomWords)
+    returnCode, output, errors = disassemble('-d1', '1', validRandomFilename)
+    if returnCode == 0:
+      break
+
+    rejected = set(int(index) for index in re.findall(rb'instructionCount = (\d+)', errors))
+    if not rejected:
+      fail("cannot determine which random words are rejected", errors.decode(errors='replace'))
+    validRandomWords = [word for (index, word) in enumerate(validRandomWords) if index not in rejected]
+  else:
+    fail("the random words still do not disassemble after leaving out the rejected ones")
+
+  print (str(len(validRandomWords)) + " random instruction words are valid.")
+  binaryFiles.append(validRandomFilename)
+
+  for binaryFilename in binaryFiles:
+    for formatOption in ['-d1', '-d2']:
+      print ("Disassembling '" + os.path.basename(binaryFilename) + "' (" + formatOption + ")...")
+
+      reference = disassemble(formatOption, '1', binaryFilename)
+      if (reference[0] == 0) != (binaryFilename != randomFilename):
+        fail("unexpected exit status " + str(reference[0]) + " for '" + binaryFilename + "'")
+
+      check_equal(disassemble(formatOption, '8', binaryFilename), reference,
+                  "the disassembly of '" + binaryFilename + "' with 1 and 8 threads")
+
+passed()
@@ -0,0 +1,106 @@
+"""Test of compiled instruction set images (--compile-qmap).
+
+Some QMAP files are compiled into instruction set images. Assembling with
+the image (-q IMAGE) must give the same instructions and instruction
+specifications as assembling with the QMAP file itself. Images that have
+been corrupted or truncated must be rejected, and so must an image in which
+no quantum instruction has opcode 0 (as for a QMAP file).
+"""
+
+import os
+import sys
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+# QMAP files, with a program that uses their quantum instructions.
+QMAP_TESTS = [
+  (os.path.join(SOURCE_DIR, 'qisa_opcodes.qmap'), GOOD_FILES),
+  (os.path.join(SOURCE_DIR, 'test_python_interface', 'test_load_qmap_file.qmap'),
+   [os.path.join(SOURCE_DIR, 'test_python_interface', 'test_python_dict.qisa')]),
+  (os.path.join(SOURCE_DIR, 'tst_issues', 'tst_issue_95', 'tst_issue_95.qmap'),
+   [os.path.join(SOURCE_DIR, 'tst_issues', 'tst_issue_95', 'tst_issue_95.qisa')])
+]
+
+with tempfile.TemporaryDirectory() as workDir:
+  imageFilename = os.path.join(workDir, 'instructions.qisa-image')
+
+  for qmapFilename, inputFilenames in QMAP_TESTS:
+    print ("Compiling '" + os.path.basename(qmapFilename) + "'...")
+    run(qisaAs, '--compile-qmap', qmapFilename, '-o', imageFilename)
+
+    check_equal(run(qisaAs, '-q', imageFilename, '--dumpspecs').stdout,
+                run(qisaAs, '-q', qmapFilename, '--dumpspecs').stdout,
+                "the instruction specifications of '" + qmapFilename + "' and its image")
+
+    for inputFilename in inputFilenames:
+      name = os.path.join(workDir, os.path.basename(inputFilename))
+
+      run(qisaAs, '--topology', TOPOLOGY_FILE, '-q', qmapFilename, '-o', name + '.qmap.out', inputFilename)
+      run(qisaAs, '--topology', TOPOLOGY_FILE, '-q', imageFilename, '-o', name + '.image.out', inputFilename)
+      check_same_file(name + '.image.out', name + '.qmap.out')
+
+  # Damage the image of the factory default quantum instruction set.
+  run(qisaAs, '--compile-qmap', QMAP_TESTS[0][0], '-o', imageFilename)
+  image = read(imageFilename)
+
+  damagedImages = [
+    ('corrupted', image[:len(image) // 2] + bytes([image[len(image) // 2] ^ 0x01]) + image[len(image) // 2 + 1:]),
+    ('corrupted', image[:-1] + bytes([image[-1] ^ 0x80])),
+    ('truncated', image[:len(image) // 2]),
+    ('truncated', image[:-1])
+  ]
+
+  for kind, damagedImage in damagedImages:
+    print ("Loading a " + kind + " image of " + str(len(damagedImage)) + " bytes...")
+    damagedFilename = os.path.join(workDir, kind + '.qisa-image')
+    with open(damagedFilename, 'wb') as f:
+      f.write(damagedImage)
+
+    damagedOutputFilename = os.path.join(workDir, 'damaged.out')
+    result = run(qisaAs, '--topology', TOPOLOGY_FILE, '-q', damagedFilename, '-o', damagedOutputFilename,
+                 GOOD_FILES[0], expect_success=False)
+
+    if 'is damaged' not in result.stderr.decode():
+      fail("the " + kind + " image has not been reported as damaged", result.stderr.decode())
+
+    if os.path.exists(damagedOutputFilename):
+      fail("output has been saved using a " + kind + " image")
+
+  # Give QNOP an unused opcode, keeping the image consistent otherwise.
+  # Layout: header (magic, byte order mark, version, number of entries, size of the names,
+  # checksum), followed by the entries (name offset, name length, kind, opcode, reserved).
+  HEADER_SIZE = 28
+  ENTRY_SIZE = 8
+  nrOfEntries = int.from_bytes(image[16:20], sys.byteorder)
+  entries = [HEADER_SIZE + i * ENTRY_SIZE for i in range(nrOfEntries)]
+  usedOpcodes = set(image[entry + 6] for entry in entries)
+
+  noOpcodeZeroImage = bytearray(image)
+  for entry in entries:
+    if image[entry + 6] == 0:
+      noOpcodeZeroImage[entry + 6] = min(set(range(1, 256)) - usedOpcodes)
+
+  checksum = 2166136261
+  for byte in noOpcodeZeroImage[HEADER_SIZE:]:
+    checksum = ((checksum ^ byte) * 16777619) & 0xffffffff
+  noOpcodeZeroImage[24:28] = checksum.to_bytes(4, sys.byteorder)
+
+  print ("Loading an image without an instruction with opcode 0...")
+  noOpcodeZeroFilename = os.path.join(workDir, 'no_opcode_zero.qisa-image')
+  with open(noOpcodeZeroFilename, 'wb') as f:
+    f.write(noOpcodeZeroImage)
+
+  noOpcodeZeroOutputFilename = os.path.join(workDir, 'no_opcode_zero.out')
+  result = run(qisaAs, '--topology', TOPOLOGY_FILE, '-q', noOpcodeZeroFilename, '-o', noOpcodeZeroOutputFilename,
+               GOOD_FILES[0], expect_success=False)
+
+  if 'opcode 0 is missing' not in result.stderr.decode():
+    fail("the image without an instruction with opcode 0 has not been rejected", result.stderr.decode())
+
+  if os.path.exists(noOpcodeZeroOutputFilename):
+    fail("output has been saved using an image without an instruction with opcode 0")
+
+passed()
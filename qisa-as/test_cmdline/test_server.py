@@ -0,0 +1,96 @@
+"""Test of the server and client modes of qisa-as (--serve, --connect).
+
+A server is started on a socket in a temporary directory. The test corpus is
+assembled (to a binary file and as hex on stdout) and disassembled (in both
+formats) through it, one request at a time and by concurrent clients.
+The results must be identical to those of local runs. Finally, the server
+is sent SIGTERM, after which it must stop cleanly and remove its socket.
+"""
+
+import os
+import signal
+import tempfile
+import time
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+def runLocal(*args, **kwargs):
+  return run(qisaAs, '--topology', TOPOLOGY_FILE, *args, **kwargs)
+
+def runClient(*args, **kwargs):
+  return run(qisaAs, '--connect', socketPath, *args, **kwargs)
+
+with tempfile.TemporaryDirectory() as workDir:
+  socketPath = os.path.join(workDir, 'qisa-as.sock')
+
+  print ("Starting the server...")
+  server = subprocess.Popen([qisaAs, '--topology', TOPOLOGY_FILE, '--serve', socketPath],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+
+  try:
+    for attempt in range(100):
+      if os.path.exists(socketPath) or (server.poll() is not None):
+        break
+      time.sleep(0.1)
+
+    if not os.path.exists(socketPath):
+      fail("the server does not listen on '" + socketPath + "'", server.communicate()[1].decode())
+
+    for filename in GOOD_FILES:
+      name = os.path.join(workDir, os.path.basename(filename))
+      print ("Assembling '" + os.path.basename(filename) + "' through the server...")
+
+      runLocal('-o', name + '.local.out', filename)
+      runClient('-o', name + '.client.out', filename)
+      check_same_file(name + '.client.out', name + '.local.out')
+
+      check_equal(runClient(filename).stdout, runLocal(filename).stdout, "the hex output of '" + filename + "'")
+
+      for formatOption in ['-d1', '-d2']:
+        print ("Disassembling '" + os.path.basename(filename) + "' (" + formatOption + ") through the server...")
+
+        check_equal(runClient(formatOption, name + '.local.out').stdout,
+                    runLocal(formatOption, name + '.local.out').stdout,
+                    "the disassembly of '" + name + ".local.out'")
+
+        runLocal(formatOption, '-o', name + '.local.dis', name + '.local.out')
+        runClient(formatOption, '-o', name + '.client.dis', name + '.local.out')
+        check_same_file(name + '.client.dis', name + '.local.dis')
+
+    print ("Assembling a file with an error through the server...")
+    if not runClient(BAD_FILES[0], expect_success=False).stderr:
+      fail("the error in '" + BAD_FILES[0] + "' has not been reported")
+
+    print ("Assembling the test corpus through concurrent clients...")
+    clients = []
+    for i in range(8):
+      for filename in GOOD_FILES:
+        outputFilename = os.path.join(workDir, os.path.basename(filename) + '.client' + str(i) + '.out')
+        clients.append((subprocess.Popen([qisaAs, '--connect', socketPath, '-o', outputFilename, filename]),
+                        outputFilename, os.path.join(workDir, os.path.basename(filename)) + '.local.out'))
+
+    for client, outputFilename, referenceFilename in clients:
+      if client.wait() != 0:
+        fail("concurrent client for '" + outputFilename + "' exited with status " + str(client.returncode))
+      check_same_file(outputFilename, referenceFilename)
+
+  finally:
+    if server.poll() is None:
+      print ("Stopping the server...")
+      server.send_signal(signal.SIGTERM)
+
+    try:
+      stdout, stderr = server.communicate(timeout=30)
+    except subprocess.TimeoutExpired:
+      server.kill()
+      fail("the server did not stop after SIGTERM")
+
+  if server.returncode != 0:
+    fail("the server exited with status " + str(server.returncode), stderr.decode())
+
+  if os.path.exists(socketPath):
+    fail("the server has not removed its socket '" + socketPath + "'")
+
+passed()
@@ -0,0 +1,67 @@
+"""Test of the encoding of SMIT with an immediate t_mask.
+
+An SMIT with an immediate value (e.g. 'SMIT t5, 133') is encoded as a single
+instruction, holding the value in its t_mask bits (pos 0). An SMIT with the
+equivalent t_mask in '{...}' form is encoded as one instruction per part of
+the t_mask. The single instruction must be identical to the first of those.
+"""
+
+import os
+import tempfile
+
+from cmdline_test import *
+
+qisaAs = qisa_as()
+
+# Immediate t_masks, all of which only use edges in the first part of the t_mask.
+IMMEDIATES = ['133', '0x85', '0b1001', '1']
+
+# Number of instructions of an SMIT with a '{...}' t_mask (one per value of pos).
+SMIT_PARTS = 3
+
+def assemble(workDir, source):
+  """Assemble the given source code, and return the instruction words."""
+  sourceFilename = os.path.join(workDir, 'smit.qisa')
+  outputFilename = os.path.join(workDir, 'smit.out')
+  with open(sourceFilename, 'w') as f:
+    f.write(source)
+
+  run(qisaAs, '--topology', TOPOLOGY_FILE, '-o', outputFilename, sourceFilename)
+  binary = read(outputFilename)
+  return [int.from_bytes(binary[i:i + 4], 'little') for i in range(0, len(binary), 4)]
+
+def disassemble(workDir, words):
+  """Disassemble the given instruction words, and return the text of each instruction."""
+  binaryFilename = os.path.join(workDir, 'smit.bin')
+  with open(binaryFilename, 'wb') as f:
+    f.write(b''.join(word.to_bytes(4, 'little') for word in words))
+
+  lines = run(qisaAs, '--topology', TOPOLOGY_FILE, '-d1', binaryFilename).stdout.decode().splitlines()
+  return [line.split('# ', 1)[1].strip() for line in lines if '# ' in line]
+
+with tempfile.TemporaryDirectory() as workDir:
+  for immediate in IMMEDIATES:
+    print ("Assembling 'SMIT t5, " + immediate + "'...")
+    immediateWords = assemble(workDir, 'SMIT t5, ' + immediate + '\nSTOP\n')
+
+    if len(immediateWords) != 2:
+      fail("'SMIT t5, " + immediate + "' has been encoded as " + str(len(immediateWords) - 1)
+           + " instructions instead of 1")
+
+    smitText = disassemble(workDir, immediateWords[:1])[0]
+    if not smitText.startswith('SMIT T5, {'):
+      fail("unexpected disassembly of 'SMIT t5, " + immediate + "'", smitText)
+
+    print ("Assembling the equivalent '" + smitText + "'...")
+    t_mask = smitText[smitText.index('{'):]
+    partWords = assemble(workDir, 'SMIT t5, ' + t_mask + '\nSTOP\n')
+
+    if len(partWords) != SMIT_PARTS + 1:
+      fail("'" + smitText + "' has been encoded as " + str(len(partWords) - 1)
+           + " instructions instead of " + str(SMIT_PARTS))
+
+    check_equal(partWords[0], immediateWords[0],
+                "the first instruction of '" + smitText + "' and 'SMIT t5, " + immediate + "'")
+    check_equal(partWords[SMIT_PARTS:], immediateWords[1:], "the instructions after the SMIT")
+
+passed()
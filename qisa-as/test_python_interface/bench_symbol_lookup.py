@@ -0,0 +1,89 @@
+# Measures the throughput of the assembler on programs that make heavy use of
+# symbols: labels, register aliases, .def_sym symbols and mnemonics in mixed
+# case. These all go through the (case insensitive) symbol and mnemonic
+# lookups of the driver.
+#
+# Usage: python3 bench_symbol_lookup.py [NR_OF_BLOCKS] [NR_OF_RUNS]
+
+import os
+import sys
+import time
+import tempfile
+
+from qisa_as import QISA_Driver
+
+nrOfBlocks = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+nrOfRuns = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+
+
+def generateProgram(nrOfBlocks):
+    lines = []
+
+    # Aliases for all registers, and a number of integer symbols.
+    for r in range(32):
+        lines.append('.register r{0} Reg_{0}'.format(r))
+    for s in range(32):
+        lines.append('.register s{0} Mask_{0}'.format(s))
+    for t in range(64):
+        lines.append('.register t{0} Pairs_{0}'.format(t))
+    for i in range(nrOfBlocks):
+        lines.append('.def_sym Constant_{0} {0}'.format(i))
+
+    lines.append('')
+
+    for i in range(nrOfBlocks):
+        r1 = 'reg_{0}'.format(i % 32)
+        r2 = 'REG_{0}'.format((i + 1) % 32)
+        r3 = 'Reg_{0}'.format((i + 2) % 32)
+        s = 'mask_{0}'.format(i % 32)
+        t = 'PAIRS_{0}'.format(i % 64)
+
+        lines.append('Block_{0}:'.format(i))
+        lines.append('  ldi {0}, constant_{1}'.format(r1, i))
+        lines.append('  Add {0}, {1}, {2}'.format(r1, r2, r3))
+        lines.append('  XOR {0}, {1}, {2}'.format(r2, r3, r1))
+        lines.append('  smis {0}, {{{1}}}'.format(s, i % 7))
+        lines.append('  SMIT {0}, {{(3, 1)}}'.format(t))
+        lines.append('  bs 1 cw_01 {0} | Cnot {1}'.format(s, t))
+        lines.append('  qwait 10')
+
+        # Mix of backward and forward branches.
+        if i > 0:
+            lines.append('  cmp {0}, {1}'.format(r1, r2))
+            lines.append('  br eq, block_{0}'.format(i - 1))
+        if i + 1 < nrOfBlocks:
+            lines.append('  BR ALWAYS, BLOCK_{0}'.format(i + 1))
+
+    lines.append('  stop')
+    return '\n'.join(lines) + '\n'
+
+
+source = generateProgram(nrOfBlocks)
+
+fd, inputFilename = tempfile.mkstemp(suffix='.qisa')
+with os.fdopen(fd, 'w') as f:
+    f.write(source)
+
+try:
+    driver = QISA_Driver()
+
+    times = []
+    for run in range(nrOfRuns):
+        start = time.perf_counter()
+        success = driver.assemble(inputFilename)
+        times.append(time.perf_counter() - start)
+
+        if not success:
+            print("Assembly terminated with errors:")
+            print(driver.getLastErrorMessage())
+            sys.exit(1)
+
+    nrOfInstructions = len(driver.getInstructionsAsHexStrings(False))
+    best = min(times)
+
+    print("Source lines     : {0}".format(source.count('\n')))
+    print("Instructions     : {0}".format(nrOfInstructions))
+    print("Best of {0} runs  : {1:.3f} ms".format(nrOfRuns, best * 1000.0))
+    print("Throughput       : {0:.0f} lines/s".format(source.count('\n') / best))
+finally:
+    os.remove(inputFilename)
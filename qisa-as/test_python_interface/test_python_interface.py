@@ -1,3 +1,6 @@
+import gc
+import json
+
 # Note: We must import qisa_qmap, which is used to pass dictionaries to the
 # driver.
 from qisa_as import QISA_Driver, qisa_qmap
@@ -44,6 +47,181 @@ for inst in instHexBin:
   print ("  " + inst)
 print()
 
+print ("Generated instructions, through the buffer protocol:")
+instBuffer = driver.getInstructionsBuffer()
+for inst in instBuffer:
+  print ("  0x%08x" % inst)
+print()
+
+if ["0x%08x" % inst for inst in instBuffer] != list(instHex):
+  print ("The instructions in the buffer differ from the hex strings!")
+  exit()
+
+print ("Disassembling the instructions in the buffer, using another driver...")
+bufferDriver = QISA_Driver()
+success = bufferDriver.disassembleBuffer(instBuffer)
+if not success:
+  print ("Disassembly terminated with errors:")
+  print (bufferDriver.getLastErrorMessage())
+  exit()
+
+print(bufferDriver.getDisassemblyOutput())
+
+print ("Keeping the buffer while its driver assembles again, and after it is deleted...")
+keptDriver = QISA_Driver()
+keptDriver.read('qisa_test_assembly/surface7_topology.txt')
+success = keptDriver.assembleString("smis s0, {0, 1}\n" + "ldi r0, 1\n" * 1000 + "stop\n")
+keptBuffer = keptDriver.getInstructionsBuffer()
+keptInstructions = bytes(keptBuffer)
+
+success = success and keptDriver.assembleString("stop\n")
+if not success or bytes(keptBuffer) != keptInstructions or len(keptDriver.getInstructionsBuffer()) != 1:
+  print ("The buffer has changed when its driver assembled again!")
+  exit()
+
+del keptDriver
+gc.collect()
+
+if bytes(keptBuffer) != keptInstructions or len(keptBuffer) != 1002:
+  print ("The buffer has changed when its driver was deleted!")
+  exit()
+
+print ("Assembling source code with three errors, with error recovery enabled...")
+errorDriver = QISA_Driver()
+errorDriver.setErrorRecovery(True)
+success = errorDriver.assembleString("ldi r40, 1\nstop\nfoo r1\nbr always, nowhere\n")
+print (errorDriver.getLastErrorMessage())
+
+if success or [d['line'] for d in errorDriver.getDiagnostics()] != [1, 3, 4]:
+  print ("Not all errors have been reported!")
+  exit()
+
+print ("Assembling source code with a repeated mask, with mask deduplication enabled...")
+dedupDriver = QISA_Driver()
+dedupDriver.read('qisa_test_assembly/surface7_topology.txt')
+dedupDriver.setMaskDeduplication(True)
+success = dedupDriver.assembleString("smis s0, {0, 1}\nsmis s0, {0, 1}\nstop\n")
+
+if not success or dedupDriver.getNrOfRemovedMaskWords() != 1 or len(dedupDriver.getInstructionsBuffer()) != 2:
+  print ("The repeated mask has not been removed!")
+  print (dedupDriver.getLastErrorMessage())
+  exit()
+
+print ("Assembling bundles without wait time, with VLIW packing enabled...")
+packDriver = QISA_Driver()
+packDriver.read('qisa_test_assembly/surface7_topology.txt')
+packDriver.setVliwPacking(True)
+success = packDriver.assembleString("bs 1 CW_01 s0\nbs 0 CW_02 s0\nbs 0 CW_03 s0 | QNOP\n")
+
+if not success or len(packDriver.getInstructionsBuffer()) != 2:
+  print ("The bundles have not been packed into two VLIWs!")
+  print (packDriver.getLastErrorMessage())
+  exit()
+
+print ("Assembling a loop that is too long for a single branch...")
+relaxDriver = QISA_Driver()
+longLoop = "loop: ldi r0, 1\n" + "nop\n" * (1 << 20) + "bne r0, r1, loop\nstop\n"
+success = relaxDriver.assembleString(longLoop)
+
+if not success or relaxDriver.getNrOfRelaxedBranches() != 1:
+  print ("The branch back to the start of the loop has not been rewritten!")
+  print (relaxDriver.getLastErrorMessage())
+  exit()
+
+relaxDriver.setBranchRelaxation(False)
+if relaxDriver.assembleString(longLoop):
+  print ("Without branch relaxation, the branch back to the start of the loop must be an error!")
+  exit()
+
+print ("Assembling long branches in both directions, and following them through their islands...")
+
+# Encoding of the classic instructions used to follow the rewritten branches.
+def ldiInstruction(register, value):
+  return (0x16 << 25) | (register << 20) | value
+
+def isBranchInstruction(inst):
+  return not (inst >> 31) and ((inst >> 25) & 0x3f) == 0x01
+
+def isCmpInstruction(inst):
+  return not (inst >> 31) and ((inst >> 25) & 0x3f) == 0x0d
+
+def branchOffset(inst):
+  offset = (inst >> 4) & 0x1fffff
+  return offset - (1 << 21) if offset & (1 << 20) else offset
+
+# Follow the unconditional branches (condition 0) from the given address, and check where they end.
+def chainEndsAt(instructions, address, inst):
+  for hop in range(100):
+    if not isBranchInstruction(instructions[address]) or (instructions[address] & 0xf) != 0:
+      return instructions[address] == inst
+    address += branchOffset(instructions[address])
+  return False
+
+# Branch number n is preceded by 'ldi r6, n' and followed by 'ldi r7, n'. Its label is at 'ldi r5, n'.
+# Each bundle takes two VLIWs; no island may be placed between them. The bundles start at
+# an odd address, such that the second VLIW of a bundle is at an even address, like the
+# places where the islands would be without bundles.
+bundles = "bs 1 CW_01 s0 | CW_02 s0 | CW_03 s0\n" * (1 << 18)
+longBranches = ("back: ldi r5, 1\n"
+                "ldi r6, 0\nbr always, forward\nldi r7, 0\nnop\n" +
+                bundles + "smis s0, {0}\nsmis s0, {0}\n" + bundles +
+                "forward: ldi r5, 0\n"
+                "ldi r6, 2\nbr eq, conditional\nldi r7, 2\n" +
+                bundles + bundles +
+                "conditional: ldi r5, 2\n"
+                "ldi r6, 1\nbne r0, r1, back\nldi r7, 1\n"
+                "stop\n")
+
+for maskDeduplication in [False, True]:
+  longBranchDriver = QISA_Driver()
+  longBranchDriver.read('qisa_test_assembly/surface7_topology.txt')
+  longBranchDriver.setMaskDeduplication(maskDeduplication)
+  success = longBranchDriver.assembleString(longBranches)
+
+  if not success or longBranchDriver.getNrOfRelaxedBranches() != 3 or \
+     longBranchDriver.getNrOfRemovedMaskWords() != (1 if maskDeduplication else 0):
+    print ("The long branches have not been rewritten!")
+    print (longBranchDriver.getLastErrorMessage())
+    exit()
+
+  instructions = list(longBranchDriver.getInstructionsBuffer())
+  addresses = {}
+  for address, inst in enumerate(instructions):
+    addresses.setdefault(inst, address)
+
+  for address, inst in enumerate(instructions):
+    if (inst >> 31) and (inst & 0x7) == 0 and not (instructions[address - 1] >> 31):
+      print ("An island has been placed between the VLIWs of a bundle, at address", address)
+      exit()
+
+  for branch in range(3):
+    # The branch follows its 'ldi r6', and the CMP instruction of 'bne'.
+    address = addresses[ldiInstruction(6, branch)] + 1
+    if isCmpInstruction(instructions[address]):
+      address += 1
+
+    if (instructions[address] & 0xf) == 0:
+      taken, notTaken = address, None
+    else:
+      # A conditional branch is inverted, to branch over the start of the chain.
+      taken, notTaken = address + 1, address + branchOffset(instructions[address])
+
+    if not chainEndsAt(instructions, taken, ldiInstruction(5, branch)) or \
+       (notTaken is not None and not chainEndsAt(instructions, notTaken, ldiInstruction(7, branch))):
+      print ("Long branch", branch, "does not reach its label, or does not continue after itself when not taken!")
+      exit()
+
+print ("Determining the timeline of a loop...")
+timelineDriver = QISA_Driver()
+timelineDriver.read('qisa_test_assembly/surface7_topology.txt')
+success = timelineDriver.assembleString("ldi r0, 3\nloop: bs 1 CW_01 s0\nqwait 4\nbs 2 CW_02 s0\nbr always, loop\n")
+timeline = json.loads(timelineDriver.getTimelineOutput('json')) if success else None
+
+if timeline is None or [loop['cycles'] for loop in timeline['loops']] != [7] or timeline['program']['idle_cycles'] != 5:
+  print ("The timeline of the loop is not correct!")
+  print (timelineDriver.getLastErrorMessage())
+  exit()
+
 print ("Saving instructions to file: ", outputFilename)
 success = driver.save(outputFilename)
 
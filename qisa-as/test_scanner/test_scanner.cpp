@@ -0,0 +1,364 @@
+/**
+ * Differential test of the hand-written scanner (qisa_scanner.cpp) against
+ * the flex scanner (qisa_lexer.l).
+ *
+ * Each given input file is scanned by both scanners, and the resulting
+ * tokens (kind, value and location) and error messages are compared; these
+ * must be identical.
+ * To also cover malformed input, a number of mutations of each input file
+ * (bytes removed, duplicated, replaced or changed in case, and fragments of
+ * tokens inserted) is scanned in the same way.
+ *
+ * Usage: qisa-as-test-scanner [-n NR_OF_MUTATIONS] [-s SEED] INPUT_FILE...
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+#include <set>
+
+#include "qisa_driver.h"
+#include "qisa_scanner.h"
+
+// Kinds of tokens, grouped by the type of their value.
+struct TokenKinds
+{
+  TokenKinds()
+  {
+    QISA::location loc;
+
+    end = QISA::QISA_Parser::make_END(loc).type_get();
+
+    integer = QISA::QISA_Parser::make_INTEGER(0, loc).type_get();
+
+    text.insert(QISA::QISA_Parser::make_IDENTIFIER("", loc).type_get());
+    text.insert(QISA::QISA_Parser::make_STRING("", loc).type_get());
+    text.insert(QISA::QISA_Parser::make_JUNK("", loc).type_get());
+
+    registers.insert(QISA::QISA_Parser::make_Q_REGISTER(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_R_REGISTER(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_S_REGISTER(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_T_REGISTER(0, loc).type_get());
+
+    // The branch conditions also carry a value.
+    registers.insert(QISA::QISA_Parser::make_COND_ALWAYS(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_NEVER(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_EQ(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_NE(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_EQZ(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_NEZ(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_LT(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_LE(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_GT(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_GE(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_LTU(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_LEU(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_GTU(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_GEU(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_LTZ(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_GEZ(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_CARRY(0, loc).type_get());
+    registers.insert(QISA::QISA_Parser::make_COND_NOTCARRY(0, loc).type_get());
+  }
+
+  int end;
+  int integer;
+
+  // Kinds with a std::string value.
+  std::set<int> text;
+
+  // Kinds with an uint8_t value.
+  std::set<int> registers;
+};
+
+static const TokenKinds tokenKinds;
+
+// Returns a description of the given token: its kind, value and location.
+static std::string
+describeToken(const QISA::QISA_Parser::symbol_type& token)
+{
+  std::ostringstream ss;
+
+  const int kind = token.type_get();
+
+  ss << "kind " << kind;
+
+  if (kind == tokenKinds.integer)
+  {
+    ss << ", value " << token.value.as<int64_t>();
+  }
+  else if (tokenKinds.registers.count(kind))
+  {
+    ss << ", value " << static_cast<int>(token.value.as<uint8_t>());
+  }
+  else if (tokenKinds.text.count(kind))
+  {
+    ss << ", value '";
+    for (unsigned char c : token.value.as<std::string>())
+    {
+      if (isprint(c))
+      {
+        ss << c;
+      }
+      else
+      {
+        ss << "\\x" << std::hex << static_cast<int>(c) << std::dec;
+      }
+    }
+    ss << "'";
+  }
+
+  ss << ", at " << token.location;
+
+  return ss.str();
+}
+
+// The outcome of scanning one input file.
+struct Result
+{
+  bool started;
+  std::vector<std::string> tokens;
+  std::string errorMessage;
+};
+
+static Result
+scanWithFlex(const std::string& inputFilename)
+{
+  QISA::QISA_Driver driver;
+  Result result;
+
+  driver._filename = inputFilename;
+
+  yyscan_t scanner;
+  result.started = driver.flexScanBegin(&scanner);
+
+  if (result.started)
+  {
+    for (;;)
+    {
+      QISA::QISA_Parser::symbol_type token = qisa_flex_lex(driver, scanner);
+      result.tokens.push_back(describeToken(token));
+
+      if (token.type_get() == tokenKinds.end)
+      {
+        break;
+      }
+    }
+
+    driver.flexScanEnd(scanner);
+  }
+
+  result.errorMessage = driver.getLastErrorMessage();
+  return result;
+}
+
+static Result
+scanWithFastScanner(const std::string& inputFilename)
+{
+  QISA::QISA_Driver driver;
+  Result result;
+
+  driver._filename = inputFilename;
+
+  yyscan_t scanner;
+  result.started = driver.fastScanBegin(&scanner);
+
+  if (result.started)
+  {
+    for (;;)
+    {
+      QISA::QISA_Parser::symbol_type token = static_cast<QISA::QISA_Scanner*>(scanner)->next();
+      result.tokens.push_back(describeToken(token));
+
+      if (token.type_get() == tokenKinds.end)
+      {
+        break;
+      }
+    }
+
+    driver.fastScanEnd(scanner);
+  }
+
+  result.errorMessage = driver.getLastErrorMessage();
+  return result;
+}
+
+// Scan the given file with both scanners, and report the first difference found.
+// Returns true if the results are identical.
+static bool
+compareScanners(const std::string& inputFilename, const std::string& description)
+{
+  const Result flexResult = scanWithFlex(inputFilename);
+  const Result fastResult = scanWithFastScanner(inputFilename);
+
+  if (flexResult.started != fastResult.started)
+  {
+    std::cerr << description << ": the scanners disagree on whether the input can be scanned." << std::endl;
+    return false;
+  }
+
+  const size_t nrOfTokens = std::max(flexResult.tokens.size(), fastResult.tokens.size());
+
+  for (size_t i = 0; i < nrOfTokens; i++)
+  {
+    const std::string flexToken = (i < flexResult.tokens.size()) ? flexResult.tokens[i] : "<none>";
+    const std::string fastToken = (i < fastResult.tokens.size()) ? fastResult.tokens[i] : "<none>";
+
+    if (flexToken != fastToken)
+    {
+      std::cerr << description << ": token " << i << " differs." << std::endl
+                << "  flex scanner        : " << flexToken << std::endl
+                << "  hand-written scanner: " << fastToken << std::endl;
+      return false;
+    }
+  }
+
+  if (flexResult.errorMessage != fastResult.errorMessage)
+  {
+    std::cerr << description << ": the error messages differ." << std::endl
+              << "  flex scanner        : " << flexResult.errorMessage << std::endl
+              << "  hand-written scanner: " << fastResult.errorMessage << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// Apply a number of random changes to the given source text.
+static std::string
+mutate(std::string source, std::mt19937& rng)
+{
+  // Fragments that are likely to hit the corner cases of the scanner rules.
+  static const char* const FRAGMENTS[] =
+  {
+    " ", "\t", "\n", "\r", "#", "-", "0", "9", "0x", "0B", "ff", "q", "R", "s", "T",
+    "c", "C,", ",", ":", "|", "{", "}", "(", ")", "\"", ".def_sym", ".REGISTER",
+    ".reg", ".", "_", "$", "\xff", "256", "9223372036854775808", "0x8000000000000000"
+  };
+  const size_t nrOfFragments = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+  const unsigned nrOfChanges = 1 + rng() % 8;
+
+  for (unsigned change = 0; change < nrOfChanges; change++)
+  {
+    const size_t pos = source.empty() ? 0 : rng() % source.size();
+    const size_t length = std::min<size_t>(1 + rng() % 16, source.size() - pos);
+
+    switch (rng() % 5)
+    {
+      case 0:
+        source.erase(pos, length);
+        break;
+
+      case 1:
+        source.insert(pos, source.substr(pos, length));
+        break;
+
+      case 2:
+        if (!source.empty())
+        {
+          source[pos] = static_cast<char>(rng() % 256);
+        }
+        break;
+
+      case 3:
+        for (size_t i = pos; i < pos + length; i++)
+        {
+          source[i] = isupper(static_cast<unsigned char>(source[i])) ? tolower(source[i]) : toupper(source[i]);
+        }
+        break;
+
+      default:
+        source.insert(pos, FRAGMENTS[rng() % nrOfFragments]);
+        break;
+    }
+  }
+
+  return source;
+}
+
+int
+main(const int argc, const char **argv)
+{
+  unsigned nrOfMutations = 100;
+  unsigned seed = 1;
+  std::vector<std::string> inputFilenames;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+    {
+      nrOfMutations = atoi(argv[++i]);
+    }
+    else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+    {
+      seed = atoi(argv[++i]);
+    }
+    else
+    {
+      inputFilenames.push_back(argv[i]);
+    }
+  }
+
+  if (inputFilenames.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " [-n NR_OF_MUTATIONS] [-s SEED] INPUT_FILE..." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string mutationFilename = "test_scanner_mutation.qisa";
+
+  std::mt19937 rng(seed);
+  unsigned nrOfFailures = 0;
+
+  for (const auto& inputFilename : inputFilenames)
+  {
+    if (!compareScanners(inputFilename, "'" + inputFilename + "'"))
+    {
+      nrOfFailures++;
+    }
+
+    std::ifstream in(inputFilename, std::ios::binary);
+    std::stringstream source;
+    source << in.rdbuf();
+
+    for (unsigned mutation = 0; mutation < nrOfMutations; mutation++)
+    {
+      {
+        std::ofstream out(mutationFilename, std::ios::binary);
+        out << mutate(source.str(), rng);
+      }
+
+      std::ostringstream description;
+      description << "'" << inputFilename << "', mutation " << mutation
+                  << " (saved in '" << mutationFilename << "')";
+
+      if (!compareScanners(mutationFilename, description.str()))
+      {
+        // Keep the mutated file, to be able to reproduce the problem.
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if (nrOfFailures != 0)
+  {
+    std::cerr << nrOfFailures << " differences found." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "====================" << std::endl;
+  std::cout << "=                  =" << std::endl;
+  std::cout << "= ALL TESTS PASSED =" << std::endl;
+  std::cout << "=                  =" << std::endl;
+  std::cout << "====================" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+/**
+ * Stress test for using several QISA_Driver instances concurrently.
+ *
+ * Each given input file is first assembled (and, on success, disassembled)
+ * serially, to obtain the reference results. The generated code is
+ * disassembled straight from memory, so no files are written.
+ * Then a number of threads is started, each with its own QISA_Driver
+ * instance, that process all input files a number of times.
+ * The results of each run are compared with the reference results;
+ * these must be identical. At least one of the input files must assemble
+ * without errors, such that the generated code is compared as well.
+ * Finally, the source code of all input files is assembled a number of times
+ * by QISA_Driver::assembleMany(), which must give the same results as
+ * assembling the source code serially.
+ *
+ * Usage: qisa-as-test-threads [-j NR_OF_THREADS] [-n NR_OF_ITERATIONS]
+ *                             [--topology TOPOLOGY_FILE] INPUT_FILE...
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "qisa_driver.h"
+
+// The outcome of processing one input file.
+struct Result
+{
+  bool assembled;
+  std::vector<std::string> instructions;
+  std::string disassembly;
+  std::string errorMessage;
+
+  bool operator==(const Result& other) const
+  {
+    return (assembled == other.assembled) &&
+           (instructions == other.instructions) &&
+           (disassembly == other.disassembly) &&
+           (errorMessage == other.errorMessage);
+  }
+
+  bool operator!=(const Result& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+static Result
+process(QISA::QISA_Driver& driver,
+        const std::string& inputFilename)
+{
+  Result result;
+
+  result.assembled = driver.assemble(inputFilename);
+
+  if (!result.assembled)
+  {
+    result.errorMessage = driver.getLastErrorMessage();
+    return result;
+  }
+
+  result.instructions = driver.getInstructionsAsHexStrings(false);
+
+  // The disassembly resets the driver, which discards its instructions.
+  const std::vector<QISA::QISA_Driver::qisa_instruction_type> instructions = driver.getInstructions();
+
+  if (!driver.disassembleBuffer(reinterpret_cast<const char*>(instructions.data()),
+                                instructions.size() * sizeof(QISA::QISA_Driver::qisa_instruction_type)))
+  {
+    result.errorMessage = driver.getLastErrorMessage();
+    return result;
+  }
+
+  result.disassembly = driver.getDisassemblyOutput();
+
+  return result;
+}
+
+// Check that QISA_Driver::assembleMany() gives the same results as assembling serially.
+// Returns the number of differences found.
+static unsigned
+checkAssembleMany(QISA::QISA_Driver& driver,
+                  const std::vector<std::string>& inputFilenames,
+                  unsigned nrOfThreads,
+                  unsigned nrOfIterations)
+{
+  std::vector<std::string> sources;
+  for (const auto& inputFilename : inputFilenames)
+  {
+    std::ifstream in(inputFilename, std::ios::binary);
+    std::stringstream source;
+    source << in.rdbuf();
+    sources.push_back(source.str());
+  }
+
+  // Get the reference results, by assembling the sources serially.
+  std::vector<QISA::QISA_Driver::AssemblyResult> referenceResults;
+  for (const auto& source : sources)
+  {
+    QISA::QISA_Driver::AssemblyResult result;
+    result.success = driver.assembleString(source);
+    if (result.success)
+    {
+      result.instructions = driver.getInstructions();
+    }
+    else
+    {
+      result.errorMessage = driver.getLastErrorMessage();
+    }
+    referenceResults.push_back(result);
+  }
+
+  // Give each thread some work.
+  std::vector<std::string> allSources;
+  for (unsigned iteration = 0; iteration < nrOfIterations; iteration++)
+  {
+    allSources.insert(allSources.end(), sources.begin(), sources.end());
+  }
+
+  const std::vector<QISA::QISA_Driver::AssemblyResult> results = driver.assembleMany(allSources, nrOfThreads);
+
+  unsigned nrOfDifferences = 0;
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const QISA::QISA_Driver::AssemblyResult& reference = referenceResults[i % sources.size()];
+
+    if ((results[i].success != reference.success) ||
+        (results[i].instructions != reference.instructions) ||
+        (results[i].errorMessage != reference.errorMessage))
+    {
+      nrOfDifferences++;
+      std::cerr << "assembleMany(): results for '" << inputFilenames[i % sources.size()]
+                << "' differ from the serial run." << std::endl;
+    }
+  }
+
+  return nrOfDifferences;
+}
+
+int
+main(const int argc, const char **argv)
+{
+  unsigned nrOfThreads = 8;
+  unsigned nrOfIterations = 25;
+  const char* topologyFilename = 0;
+  std::vector<std::string> inputFilenames;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc))
+    {
+      nrOfThreads = atoi(argv[++i]);
+    }
+    else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+    {
+      nrOfIterations = atoi(argv[++i]);
+    }
+    else if ((strcmp(argv[i], "--topology") == 0) && (i + 1 < argc))
+    {
+      topologyFilename = argv[++i];
+    }
+    else
+    {
+      inputFilenames.push_back(argv[i]);
+    }
+  }
+
+  if (inputFilenames.empty() || (nrOfThreads == 0))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " [-j NR_OF_THREADS] [-n NR_OF_ITERATIONS] [--topology TOPOLOGY_FILE] INPUT_FILE..." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Get the reference results, by processing all input files serially.
+  std::vector<Result> referenceResults;
+  {
+    QISA::QISA_Driver driver;
+    if (topologyFilename != 0)
+    {
+      driver.read(topologyFilename);
+    }
+
+    for (const auto& inputFilename : inputFilenames)
+    {
+      referenceResults.push_back(process(driver, inputFilename));
+    }
+  }
+
+  // Comparing only error messages says nothing about the generated code,
+  // so at least one input file must assemble (e.g. the topology must be given).
+  size_t nrOfAssembledFiles = 0;
+  for (const auto& referenceResult : referenceResults)
+  {
+    if (referenceResult.assembled && !referenceResult.instructions.empty())
+    {
+      nrOfAssembledFiles++;
+    }
+  }
+
+  if (nrOfAssembledFiles == 0)
+  {
+    std::cerr << "None of the input files could be assembled:" << std::endl
+              << referenceResults.front().errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::atomic<unsigned> nrOfFailures(0);
+  std::mutex reportMutex;
+  std::vector<std::thread> threads;
+
+  for (unsigned threadId = 0; threadId < nrOfThreads; threadId++)
+  {
+    threads.emplace_back([&, threadId]()
+    {
+      QISA::QISA_Driver driver;
+      if (topologyFilename != 0)
+      {
+        driver.read(topologyFilename);
+      }
+
+      for (unsigned iteration = 0; iteration < nrOfIterations; iteration++)
+      {
+        // Let each thread start with a different file, to mix the workload.
+        for (size_t i = 0; i < inputFilenames.size(); i++)
+        {
+          size_t fileIndex = (i + threadId) % inputFilenames.size();
+
+          Result result = process(driver, inputFilenames[fileIndex]);
+
+          if (result != referenceResults[fileIndex])
+          {
+            nrOfFailures++;
+
+            std::lock_guard<std::mutex> lock(reportMutex);
+            std::cerr << "Thread " << threadId << ", iteration " << iteration
+                      << ": results for '" << inputFilenames[fileIndex]
+                      << "' differ from the serial run." << std::endl;
+          }
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  {
+    QISA::QISA_Driver driver;
+    if (topologyFilename != 0)
+    {
+      driver.read(topologyFilename);
+    }
+
+    nrOfFailures += checkAssembleMany(driver, inputFilenames, nrOfThreads, nrOfIterations);
+  }
+
+  if (nrOfFailures != 0)
+  {
+    std::cerr << nrOfFailures << " differences found." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "====================" << std::endl;
+  std::cout << "=                  =" << std::endl;
+  std::cout << "= ALL TESTS PASSED =" << std::endl;
+  std::cout << "=                  =" << std::endl;
+  std::cout << "====================" << std::endl;
+
+  return EXIT_SUCCESS;
+}